@@ -1,18 +1,40 @@
+#include "tb/arena.hpp"
 #include "tb/bucket_engine.hpp"
+#include "tb/checkpoint.hpp"
+#include "tb/collector.hpp"
+#include "tb/distributed.hpp"
+#include "tb/ingest.hpp"
+#include "tb/memory.hpp"
+#include "tb/metrics.hpp"
+#include "tb/metrics_server.hpp"
+#include "tb/parallel.hpp"
+#include "tb/perf_counters.hpp"
+#include "tb/presets.hpp"
+#include "tb/process_memory.hpp"
+#include "tb/profile.hpp"
+#include "tb/sampling.hpp"
+#include "tb/snapshot_file.hpp"
 #include "tb/stats.hpp"
+#include "tb/timeseries.hpp"
+#include "tb/tuning_file.hpp"
 #include "tb/utils.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cstdint>
 #include <exception>
+#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <vector>
-#include <cctype>
 
 namespace {
     // ---------- Helper per stampa usage ----------
@@ -21,10 +43,20 @@ namespace {
         << "Usage:\n"
         << "  tb_cli --demo <N> [options]\n"
         << "  tb_cli --from-file <path> [options]\n"
+        << "  tb_cli --collect <port> [options]\n"
+        << "  tb_cli --coordinator <port> --from-file <path> [options]\n"
+        << "  tb_cli --ts-query <dir> [--from <unix>] [--to <unix>] [--last <sec>] [options]\n"
+        << "  tb_cli --worker <host:port>\n"
+        << "  tb_cli --calibrate [--tuning <path>] [--threads <max>]\n"
         << "\n"
         << "Modes:\n"
         << "  --demo <N>           Analyze IPv4 range [0, N) as 32-bit integers\n"
-        << "  --from-file <path>   Read IPv4 addresses (one per line, dotted form)\n"
+        << "  --from-file <path>   Read IPv4 addresses (see --format; gzip decompressed transparently)\n"
+        << "  --collect <port>     Receive NetFlow v5 / IPFIX on UDP <port>, print stats per window\n"
+        << "  --coordinator <port> Split --from-file into byte-range tasks served to workers over TCP\n"
+        << "  --worker <host:port> Process tasks from a coordinator (input path must be reachable)\n"
+        << "  --calibrate          Time thread counts and histogram strategies per k and input size,\n"
+        << "                       and save the fastest as this CPU model's tuning profile\n"
         << "\n"
         << "Options:\n"
         << "  --k <bits>           Number of bucket bits (default: 12 => 4096 buckets)\n"
@@ -33,11 +65,71 @@ namespace {
         << "  --preset <name>      Preset parameters: default | wang\n"
         << "                       (overridden by --a/--b if provided)\n"
         << "  --show-buckets [N]   Print per-bucket counts (optionally limited to N buckets)\n"
+        << "  --profile            Per-stage wall/CPU time, items, bytes and throughput, plus perf counters\n"
+        << "                       per element (--demo, --from-file)\n"
+        << "  --save-snapshot <p>  Write the histogram as a mergeable snapshot (see tb_merge)\n"
+        << "                       (--demo, --from-file, --coordinator)\n"
+        << "  --mem-limit <size>   Refuse runs whose estimated footprint exceeds <size> (K/M/G suffixes);\n"
+        << "                       --from-file streams its input instead when the histogram fits\n"
+        << "                       (--demo, --from-file; the estimate is printed with --profile too)\n"
+        << "  --huge-pages <mode>  Pages of the arena holding the addresses: off | thp | explicit\n"
+        << "                       (default: thp; explicit falls back to thp without reserved pages)\n"
+        << "                       (--from-file)\n"
+        << "  --trace <path>       Write a Chrome trace / Perfetto timeline of every stage call per thread\n"
+        << "                       (--demo, --from-file, --worker)\n"
         << "  --help               Show this help and exit\n"
         << "\n"
+        << "Collector options (--collect):\n"
+        << "  --bind <ipv4>        Listen address, also for --coordinator (default: 0.0.0.0)\n"
+        << "  --window <sec>       Stats window length in seconds (default: 10)\n"
+        << "  --flow-key <k>       Address to bucketize: src | dst | both (default: both)\n"
+        << "  --flow-weight <w>    Weight per flow: bytes | packets | flows (default: bytes)\n"
+        << "  --batch <n>          Datagrams per recvmmsg call (default: 64)\n"
+        << "  --max-windows <n>    Exit after <n> windows (default: run until Ctrl-C)\n"
+        << "  --metrics-port <n>   Serve Prometheus/OpenMetrics on http://<bind>:<n>/metrics\n"
+        << "  --metrics-top <n>    Per-bucket series exported for the top <n> buckets (default: 20)\n"
+        << "  --ts-store <dir>     Append every window to a time-series store (hourly/daily rollups)\n"
+        << "\n"
+        << "Time-series queries (--ts-query <dir>, same --k/--a/--b as the store):\n"
+        << "  --from <unix>        First window start included (default: oldest)\n"
+        << "  --to <unix>          First window start excluded (default: newest + 1)\n"
+        << "  --last <sec>         Only the last <sec> seconds before the newest window\n"
+        << "\n"
+        << "Input options (--from-file):\n"
+        << "  --format <fmt>       text | csv | log | binary (default: text, one dotted quad per line)\n"
+        << "                       log = first address of each line, binary = 4-byte network order\n"
+        << "  --csv-column <n>     0-based CSV field holding the address (default: 0)\n"
+        << "  --csv-delimiter <c>  CSV field separator (default: ',')\n"
+        << "  --checkpoint <path>  Stream the input and save the histogram and input offset to <path>\n"
+        << "                       (atomically, snapshot format) periodically and on Ctrl-C / SIGTERM\n"
+        << "  --checkpoint-every <sec> Seconds between checkpoints (default: 60)\n"
+        << "  --resume             Continue from the --checkpoint file, skipping the input already counted\n"
+        << "                       (starts from scratch if there is none; removed when the run completes)\n"
+        << "  --sample <method>    Estimate the distribution from a sample, stopping once it converges:\n"
+        << "                       stride | hash | reservoir (see Sampling options)\n"
+        << "  --threads <n>        Histogram threads (parallel_distribution, per-thread; default: chosen\n"
+        << "                       by the tuning profile, or built-in defaults without one)\n"
+        << "  --tuning <path>      Tuning profile to use, also for --calibrate to write\n"
+        << "                       (default: ~/.cache/turbo-bucketizer/tuning-<cpu model>.txt)\n"
+        << "\n"
+        << "Sampling options (--sample):\n"
+        << "  --tolerance <x>      Stop when every bucket share is known within +-x of max(share, 1/buckets)\n"
+        << "                       (default: 0.05; 0 reads the whole input)\n"
+        << "  --confidence <x>     Confidence level of the intervals (default: 0.95)\n"
+        << "  --sample-rate <x>    hash: fraction of addresses kept; stride: 1 line in 1/x (default: 1/64)\n"
+        << "  --reservoir <n>      reservoir: sample size, reads the whole input (default: 1048576)\n"
+        << "\n"
+        << "Coordinator options (--coordinator):\n"
+        << "  --chunk-mb <n>       Task size in MiB (default: 64)\n"
+        << "  --task-timeout <sec> Reassign a task if its worker is silent this long (default: 600)\n"
+        << "\n"
         << "Examples:\n"
         << "  tb_cli --demo 1000000 --k 12 --preset default\n"
-        << "  tb_cli --from-file data/ips.txt --k 16 --preset wang --show-buckets 32\n";
+        << "  tb_cli --from-file data/ips.txt --k 16 --preset wang --show-buckets 32\n"
+        << "  tb_cli --from-file data/huge.txt.gz --k 10 --sample stride --tolerance 0.1\n"
+        << "  tb_cli --collect 2055 --k 10 --window 5 --flow-key dst\n"
+        << "  tb_cli --collect 2055 --k 10 --window 60 --ts-store /var/lib/tb && tb_cli --ts-query /var/lib/tb --k 10 --last 86400\n"
+        << "  tb_cli --coordinator 7070 --from-file /shared/ips.txt --k 16 & tb_cli --worker host:7070\n";
     }
 
     // ---------- Parse helpers ----------
@@ -55,6 +147,20 @@ namespace {
         return value;
     }
 
+    double parse_double(const std::string& s, const std::string& what) {
+        std::size_t pos = 0;
+        double value = 0.0;
+        try {
+            value = std::stod(s, &pos);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid " + what + " value: '" + s + "'");
+        }
+        if (pos != s.size()) {
+            throw std::runtime_error("Invalid " + what + " value (trailing chars): '" + s + "'");
+        }
+        return value;
+    }
+
     unsigned int parse_uint(const std::string& s, const std::string& what) {
         const std::uint64_t v = parse_u64(s, what);
         if (v > std::numeric_limits<unsigned int>::max()) {
@@ -63,6 +169,26 @@ namespace {
         return static_cast<unsigned int>(v);
     }
 
+    // "4096", "512K", "64M", "2G" (multipli binari)
+    std::uint64_t parse_size(const std::string& s, const std::string& what) {
+        if (s.empty()) throw std::runtime_error("Invalid " + what + " value: ''");
+        unsigned shift = 0;
+        std::string digits = s;
+        switch (s.back()) {
+            case 'K': case 'k': shift = 10; break;
+            case 'M': case 'm': shift = 20; break;
+            case 'G': case 'g': shift = 30; break;
+            case 'T': case 't': shift = 40; break;
+            default: break;
+        }
+        if (shift > 0) digits.pop_back();
+        const std::uint64_t v = parse_u64(digits, what);
+        if (v > (std::numeric_limits<std::uint64_t>::max() >> shift)) {
+            throw std::runtime_error(what + " out of range: " + s);
+        }
+        return v << shift;
+    }
+
     std::uint32_t parse_hex32(const std::string& s, const std::string& what) {
         std::size_t pos = 0;
         std::string txt = s;
@@ -88,32 +214,55 @@ namespace {
     enum class Mode {
         None,
         Demo,
-        FromFile
+        FromFile,
+        Collect,
+        Coordinator,
+        Worker,
+        TsQuery,
+        Calibrate
     };
 
     struct Options {
         Mode mode = Mode::None;
         std::uint64_t demo_count = 0;
         std::string file_path;
+        tb::IngestOptions ingest{};       // --format, --csv-*
 
         tb::Config cfg{};
         bool preset_used = false;
 
         bool show_buckets = false;
         std::size_t show_buckets_limit = 0; // 0 = no limit
-    };
 
-    void apply_preset(tb::Config& cfg, const std::string& name) {
-        if (name == "default") {
-            cfg.a = 0x9E3779B1u;
-            cfg.b = 0x85EBCA77u;
-        } else if (name == "wang") {
-            cfg.a = 0x27D4EB2Du;
-            cfg.b = 0x165667B1u;
-        } else {
-            throw std::runtime_error("Unknown preset: '" + name + "'");
-        }
-    }
+        std::string snapshot_path;        // --save-snapshot
+        bool profile = false;             // --profile
+        std::string trace_path;           // --trace
+        std::uint64_t mem_limit = 0;      // --mem-limit, byte (0 = nessun limite)
+        tb::HugePages huge_pages = tb::HugePages::Transparent;   // --huge-pages
+        bool huge_pages_set = false;
+        unsigned threads = 0;             // --threads (--from-file; 0 = profilo di tuning)
+        std::string tuning_path;          // --tuning (vuoto = percorso di default)
+        std::string checkpoint_path;      // --checkpoint
+        std::uint64_t checkpoint_every = 60;   // --checkpoint-every, secondi
+        bool resume = false;              // --resume
+        bool sample = false;              // --sample
+        tb::SampleOptions sampling{};     // --sample, --tolerance, --confidence, --sample-rate, --reservoir
+        bool sampling_set = false;
+
+        tb::CollectorOptions collector{};
+        bool metrics = false;
+        tb::MetricsServerOptions metrics_server{};
+        std::size_t metrics_top = 20;
+
+        bool coordinate = false;          // --coordinator: distribute the --from-file job
+        tb::CoordinatorOptions coordinator{};
+        tb::WorkerOptions worker{};
+
+        std::string ts_dir;               // --ts-store / --ts-query
+        std::int64_t ts_from = std::numeric_limits<std::int64_t>::min();
+        std::int64_t ts_to = std::numeric_limits<std::int64_t>::max();
+        std::uint64_t ts_last = 0;        // 0 = no limit
+    };
 
     Options parse_args(int argc, char** argv) {
         Options opt;
@@ -137,6 +286,130 @@ namespace {
                 }
                 opt.mode = Mode::FromFile;
                 opt.file_path = argv[++i];
+            } else if (arg == "--collect") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--collect requires a UDP port");
+                }
+                opt.mode = Mode::Collect;
+                const unsigned int port = parse_uint(argv[++i], "collect port");
+                if (port > 65535u) {
+                    throw std::runtime_error("collect port out of range: " + std::to_string(port));
+                }
+                opt.collector.port = static_cast<std::uint16_t>(port);
+            } else if (arg == "--bind") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--bind requires an IPv4 address");
+                }
+                opt.collector.bind_address = argv[++i];
+            } else if (arg == "--window") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--window requires a number of seconds");
+                }
+                const std::uint64_t secs = parse_u64(argv[++i], "window");
+                if (secs == 0) {
+                    throw std::runtime_error("--window must be > 0");
+                }
+                opt.collector.window = std::chrono::seconds(secs);
+            } else if (arg == "--flow-key") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--flow-key requires src | dst | both");
+                }
+                const std::string key = argv[++i];
+                if (key == "src") {
+                    opt.collector.key = tb::FlowKey::Src;
+                } else if (key == "dst") {
+                    opt.collector.key = tb::FlowKey::Dst;
+                } else if (key == "both") {
+                    opt.collector.key = tb::FlowKey::Both;
+                } else {
+                    throw std::runtime_error("Unknown flow key: '" + key + "'");
+                }
+            } else if (arg == "--flow-weight") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--flow-weight requires bytes | packets | flows");
+                }
+                const std::string w = argv[++i];
+                if (w == "bytes") {
+                    opt.collector.weight = tb::FlowWeight::Bytes;
+                } else if (w == "packets") {
+                    opt.collector.weight = tb::FlowWeight::Packets;
+                } else if (w == "flows") {
+                    opt.collector.weight = tb::FlowWeight::Flows;
+                } else {
+                    throw std::runtime_error("Unknown flow weight: '" + w + "'");
+                }
+            } else if (arg == "--batch") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--batch requires an integer argument");
+                }
+                opt.collector.batch = parse_u64(argv[++i], "batch");
+            } else if (arg == "--max-windows") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--max-windows requires an integer argument");
+                }
+                opt.collector.max_windows = parse_u64(argv[++i], "max-windows");
+            } else if (arg == "--metrics-port") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--metrics-port requires a TCP port");
+                }
+                const unsigned int port = parse_uint(argv[++i], "metrics port");
+                if (port > 65535u) {
+                    throw std::runtime_error("metrics port out of range: " + std::to_string(port));
+                }
+                opt.metrics = true;
+                opt.metrics_server.port = static_cast<std::uint16_t>(port);
+            } else if (arg == "--metrics-top") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--metrics-top requires an integer argument");
+                }
+                opt.metrics_top = parse_u64(argv[++i], "metrics-top");
+            } else if (arg == "--coordinator") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--coordinator requires a TCP port");
+                }
+                const unsigned int port = parse_uint(argv[++i], "coordinator port");
+                if (port > 65535u) {
+                    throw std::runtime_error("coordinator port out of range: " + std::to_string(port));
+                }
+                opt.coordinate = true;
+                opt.coordinator.port = static_cast<std::uint16_t>(port);
+            } else if (arg == "--chunk-mb") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--chunk-mb requires an integer argument");
+                }
+                const std::uint64_t mb = parse_u64(argv[++i], "chunk-mb");
+                if (mb == 0) {
+                    throw std::runtime_error("--chunk-mb must be > 0");
+                }
+                opt.coordinator.chunk_bytes = mb * 1024ULL * 1024ULL;
+            } else if (arg == "--task-timeout") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--task-timeout requires a number of seconds");
+                }
+                opt.coordinator.task_timeout = std::chrono::seconds(parse_u64(argv[++i], "task-timeout"));
+            } else if (arg == "--calibrate") {
+                opt.mode = Mode::Calibrate;
+            } else if (arg == "--tuning") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--tuning requires a path");
+                }
+                opt.tuning_path = argv[++i];
+            } else if (arg == "--worker") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--worker requires <host:port>");
+                }
+                const std::string endpoint = argv[++i];
+                const auto colon = endpoint.rfind(':');
+                if (colon == std::string::npos || colon == 0) {
+                    throw std::runtime_error("Invalid worker endpoint (expected host:port): '" + endpoint + "'");
+                }
+                const unsigned int port = parse_uint(endpoint.substr(colon + 1), "worker port");
+                if (port == 0 || port > 65535u) {
+                    throw std::runtime_error("worker port out of range: " + endpoint);
+                }
+                opt.mode = Mode::Worker;
+                opt.worker.host = endpoint.substr(0, colon);
+                opt.worker.port = static_cast<std::uint16_t>(port);
             } else if (arg == "--k") {
                 if (i + 1 >= argc) {
                     throw std::runtime_error("--k requires an integer argument");
@@ -157,7 +430,7 @@ namespace {
                     throw std::runtime_error("--preset requires a name");
                 }
                 const std::string name = argv[++i];
-                apply_preset(cfg, name);
+                tb::apply_preset(cfg, name);
                 opt.preset_used = true;
             } else if (arg == "--show-buckets") {
                 opt.show_buckets = true;
@@ -169,19 +442,529 @@ namespace {
                         ++i;
                     }
                 }
+            } else if (arg == "--ts-store") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--ts-store requires a directory");
+                }
+                opt.ts_dir = argv[++i];
+            } else if (arg == "--ts-query") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--ts-query requires a directory");
+                }
+                opt.mode = Mode::TsQuery;
+                opt.ts_dir = argv[++i];
+            } else if (arg == "--from") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--from requires a unix timestamp");
+                }
+                opt.ts_from = static_cast<std::int64_t>(parse_u64(argv[++i], "from"));
+            } else if (arg == "--to") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--to requires a unix timestamp");
+                }
+                opt.ts_to = static_cast<std::int64_t>(parse_u64(argv[++i], "to"));
+            } else if (arg == "--last") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--last requires a number of seconds");
+                }
+                opt.ts_last = parse_u64(argv[++i], "last");
+            } else if (arg == "--format") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--format requires text | csv | log | binary");
+                }
+                opt.ingest.format = tb::parse_input_format(argv[++i]);
+            } else if (arg == "--csv-column") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--csv-column requires a field index");
+                }
+                opt.ingest.csv_column = static_cast<std::size_t>(parse_u64(argv[++i], "csv-column"));
+            } else if (arg == "--csv-delimiter") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--csv-delimiter requires a character");
+                }
+                const std::string d = argv[++i];
+                if (d.size() != 1) {
+                    throw std::runtime_error("--csv-delimiter must be a single character: '" + d + "'");
+                }
+                opt.ingest.csv_delimiter = d[0];
+            } else if (arg == "--profile") {
+                opt.profile = true;
+            } else if (arg == "--mem-limit") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--mem-limit requires a size");
+                }
+                opt.mem_limit = parse_size(argv[++i], "mem-limit");
+                if (opt.mem_limit == 0) {
+                    throw std::runtime_error("mem-limit must be > 0");
+                }
+            } else if (arg == "--huge-pages") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--huge-pages requires a mode");
+                }
+                opt.huge_pages = tb::parse_huge_pages(argv[++i]);
+                opt.huge_pages_set = true;
+            } else if (arg == "--trace") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--trace requires a path");
+                }
+                opt.trace_path = argv[++i];
+            } else if (arg == "--threads") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--threads requires a number");
+                }
+                opt.threads = parse_uint(argv[++i], "threads");
+                if (opt.threads == 0 || opt.threads > 1024) {
+                    throw std::runtime_error("threads out of range [1, 1024]: " + std::to_string(opt.threads));
+                }
+            } else if (arg == "--checkpoint") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--checkpoint requires a path");
+                }
+                opt.checkpoint_path = argv[++i];
+            } else if (arg == "--checkpoint-every") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--checkpoint-every requires a number of seconds");
+                }
+                opt.checkpoint_every = parse_u64(argv[++i], "checkpoint-every");
+                if (opt.checkpoint_every == 0) {
+                    throw std::runtime_error("checkpoint-every must be > 0");
+                }
+            } else if (arg == "--resume") {
+                opt.resume = true;
+            } else if (arg == "--sample") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--sample requires a method (stride, hash, reservoir)");
+                }
+                opt.sampling.method = tb::parse_sample_method(argv[++i]);
+                opt.sample = true;
+            } else if (arg == "--tolerance") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--tolerance requires a number");
+                }
+                opt.sampling.tolerance = parse_double(argv[++i], "tolerance");
+                if (!(opt.sampling.tolerance >= 0.0 && opt.sampling.tolerance < 1.0)) {
+                    throw std::runtime_error("tolerance out of range [0, 1): " + std::string{argv[i]});
+                }
+                opt.sampling_set = true;
+            } else if (arg == "--confidence") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--confidence requires a number");
+                }
+                opt.sampling.confidence = parse_double(argv[++i], "confidence");
+                if (!(opt.sampling.confidence > 0.0 && opt.sampling.confidence < 1.0)) {
+                    throw std::runtime_error("confidence out of range (0, 1): " + std::string{argv[i]});
+                }
+                opt.sampling_set = true;
+            } else if (arg == "--sample-rate") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--sample-rate requires a number");
+                }
+                opt.sampling.rate = parse_double(argv[++i], "sample-rate");
+                if (!(opt.sampling.rate > 0.0 && opt.sampling.rate <= 1.0)) {
+                    throw std::runtime_error("sample-rate out of range (0, 1]: " + std::string{argv[i]});
+                }
+                opt.sampling_set = true;
+            } else if (arg == "--reservoir") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--reservoir requires a sample size");
+                }
+                opt.sampling.reservoir = static_cast<std::size_t>(parse_u64(argv[++i], "reservoir"));
+                if (opt.sampling.reservoir == 0) {
+                    throw std::runtime_error("reservoir must be > 0");
+                }
+                opt.sampling_set = true;
+            } else if (arg == "--save-snapshot") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("--save-snapshot requires a path");
+                }
+                opt.snapshot_path = argv[++i];
             } else {
                 throw std::runtime_error("Unknown argument: " + arg);
             }
         }
 
+        if (opt.coordinate) {
+            if (opt.mode != Mode::FromFile) {
+                throw std::runtime_error("--coordinator requires --from-file <path>");
+            }
+            opt.mode = Mode::Coordinator;
+        }
         if (opt.mode == Mode::None) {
-            throw std::runtime_error("No mode specified. Use --demo or --from-file.");
+            throw std::runtime_error("No mode specified. Use --demo, --from-file, --collect, --worker or --ts-query.");
+        }
+
+        if (opt.metrics && opt.mode != Mode::Collect) {
+            throw std::runtime_error("--metrics-port is only available with --collect");
+        }
+        if (!opt.ts_dir.empty() && opt.mode != Mode::Collect && opt.mode != Mode::TsQuery) {
+            throw std::runtime_error("--ts-store is only available with --collect");
+        }
+        if (opt.mode == Mode::Coordinator && opt.ingest.format != tb::InputFormat::Text) {
+            throw std::runtime_error("--coordinator only supports --format text");
+        }
+        if (opt.profile && opt.mode != Mode::Demo && opt.mode != Mode::FromFile) {
+            throw std::runtime_error("--profile is only available with --demo or --from-file");
+        }
+        if (!opt.trace_path.empty() && opt.mode != Mode::Demo && opt.mode != Mode::FromFile &&
+            opt.mode != Mode::Worker) {
+            throw std::runtime_error("--trace is only available with --demo, --from-file or --worker");
+        }
+        if (opt.mem_limit > 0 && opt.mode != Mode::Demo && opt.mode != Mode::FromFile) {
+            throw std::runtime_error("--mem-limit is only available with --demo or --from-file");
+        }
+        if (opt.huge_pages_set && opt.mode != Mode::FromFile) {
+            throw std::runtime_error("--huge-pages is only available with --from-file");
+        }
+        if (opt.threads > 1 && opt.mode != Mode::FromFile && opt.mode != Mode::Calibrate) {
+            throw std::runtime_error("--threads is only available with --from-file or --calibrate");
+        }
+        if (!opt.tuning_path.empty() && opt.mode != Mode::FromFile && opt.mode != Mode::Calibrate) {
+            throw std::runtime_error("--tuning is only available with --from-file or --calibrate");
+        }
+        if (!opt.checkpoint_path.empty() && opt.mode != Mode::FromFile) {
+            throw std::runtime_error("--checkpoint is only available with --from-file");
+        }
+        if (opt.resume && opt.checkpoint_path.empty()) {
+            throw std::runtime_error("--resume requires --checkpoint <path>");
+        }
+        if (opt.sample && opt.mode != Mode::FromFile) {
+            throw std::runtime_error("--sample is only available with --from-file");
+        }
+        if (opt.sample && (!opt.checkpoint_path.empty() || !opt.snapshot_path.empty())) {
+            // un istogramma campionato non si può fondere con quelli completi
+            throw std::runtime_error("--sample cannot be combined with --checkpoint or --save-snapshot");
+        }
+        if (opt.sampling_set && !opt.sample) {
+            throw std::runtime_error("--tolerance, --confidence, --sample-rate and --reservoir require --sample");
+        }
+        if (!opt.snapshot_path.empty() && (opt.mode == Mode::Collect || opt.mode == Mode::Worker)) {
+            throw std::runtime_error("--save-snapshot is only available with --demo, --from-file or --coordinator");
         }
 
         opt.cfg = cfg;
+        opt.metrics_server.bind_address = opt.collector.bind_address;
+        opt.coordinator.bind_address = opt.collector.bind_address;
         return opt;
     }
 
+    // ---------- Output helpers ----------
+    void print_config(const tb::Config& cfg) {
+        std::cout << "Config:\n"
+                << "  a = 0x" << std::hex << std::uppercase << cfg.a << std::dec << "\n"
+                << "  b = 0x" << std::hex << std::uppercase << cfg.b << std::dec << "\n"
+                << "  k = " << cfg.k << " (buckets = " << cfg.bucket_count() << ")\n\n";
+    }
+
+    void print_stats(const tb::StatsResult& stats, const char* title = "Stats") {
+        std::cout << title << ":\n"
+                << std::fixed << std::setprecision(4)
+                << "  sample_count = " << stats.sample_count << "\n"
+                << "  bucket_count = " << stats.bucket_count << "\n"
+                << "  mean         = " << stats.mean << "\n"
+                << "  stddev       = " << stats.stddev << "\n"
+                << "  chi2         = " << stats.chi2 << "\n"
+                << "  p_value      = " << stats.p_value << "\n"
+                << "  uniformity   = " << stats.uniformity << " %\n"
+                << "  max_load     = " << stats.max_load << "\n";
+    }
+
+    void print_buckets(const Options& opt, const std::vector<std::size_t>& counts) {
+        if (!opt.show_buckets) return;
+        const std::size_t limit = (opt.show_buckets_limit == 0)
+            ? counts.size()
+            : std::min<std::size_t>(opt.show_buckets_limit, counts.size());
+
+        std::cout << "\nBucket counts (first " << limit << "):\n";
+        for (std::size_t i = 0; i < limit; ++i) {
+            std::cout << "  [" << i << "] = " << counts[i] << "\n";
+        }
+    }
+
+    // ---------- Profiling (--profile) ----------
+    // tempi per stadio registrati dalla libreria (tb/profile.hpp) + contatori perf per fase
+    std::string format_fixed(double v, int precision) {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(precision) << v;
+        return os.str();
+    }
+
+    class Profiler {
+    public:
+        explicit Profiler(bool enabled) {
+            if (!enabled) return;
+            counters_ = std::make_unique<tb::PerfCounters>();
+            tb::set_stage_profile(&stages_);
+        }
+        ~Profiler() {
+            if (counters_) tb::set_stage_profile(nullptr);
+        }
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        void begin() {
+            if (!counters_) return;
+            t0_ = std::chrono::steady_clock::now();
+            counters_->start();
+        }
+
+        void end(const std::string& name, std::uint64_t elements) {
+            if (!counters_) return;
+            Phase p;
+            p.perf = counters_->stop();
+            p.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0_).count();
+            p.name = name;
+            p.elements = elements;
+            phases_.push_back(std::move(p));
+        }
+
+        void print() const {
+            if (!counters_) return;
+            std::cout << "\nProfile:\n";
+            print_stages();
+            std::cout << "\n";
+            if (!counters_->hardware_available()) {
+                std::cout << "  (hardware counters unavailable: " << counters_->status() << ")\n";
+            }
+            // celle formattate prima, poi ogni colonna larga quanto il suo valore più lungo:
+            // su input piccoli ns/elem e i contatori per elemento crescono di molte cifre
+            const bool ipc = counters_->supported(tb::PerfEvent::Cycles) &&
+                             counters_->supported(tb::PerfEvent::Instructions);
+            std::vector<std::vector<std::string>> rows;
+            rows.push_back({"phase", "elements", "ms", "ns/elem"});
+            for (std::size_t e = 0; e < tb::kPerfEventCount; ++e) {
+                if (counters_->supported(static_cast<tb::PerfEvent>(e))) {
+                    rows.back().push_back(tb::perf_event_name(static_cast<tb::PerfEvent>(e)));
+                }
+            }
+            if (ipc) rows.back().push_back("IPC");
+
+            for (const Phase& p : phases_) {
+                const double n = static_cast<double>(std::max<std::uint64_t>(p.elements, 1));
+                std::vector<std::string> row{p.name, std::to_string(p.elements), format_fixed(p.seconds * 1e3, 3),
+                                             format_fixed(p.seconds * 1e9 / n, 3)};
+                for (std::size_t e = 0; e < tb::kPerfEventCount; ++e) {
+                    const auto ev = static_cast<tb::PerfEvent>(e);
+                    if (!counters_->supported(ev)) continue;
+                    row.push_back(p.perf.has(ev) ? format_fixed(p.perf.per(ev, p.elements), 4) : "-");
+                }
+                if (ipc) {
+                    const auto cycles = p.perf.get(tb::PerfEvent::Cycles);
+                    row.push_back(format_fixed(cycles ? static_cast<double>(p.perf.get(tb::PerfEvent::Instructions)) /
+                                                 static_cast<double>(cycles) : 0.0, 2));
+                }
+                rows.push_back(std::move(row));
+            }
+
+            std::vector<std::size_t> width(rows.front().size(), 0);
+            for (const auto& row : rows) {
+                for (std::size_t c = 0; c < row.size(); ++c) width[c] = std::max(width[c], row[c].size());
+            }
+            for (const auto& row : rows) {
+                std::cout << "  " << std::left << std::setw(static_cast<int>(width[0])) << row[0] << std::right;
+                for (std::size_t c = 1; c < row.size(); ++c) {
+                    std::cout << "  " << std::setw(static_cast<int>(width[c])) << row[c];
+                }
+                std::cout << "\n";
+            }
+            std::cout << "  (counters per element, user space only)\n";
+        }
+
+    private:
+        void print_stages() const {
+#if TB_PROFILING
+            std::uint64_t total_ns = 0;
+            for (std::size_t s = 0; s < tb::kStageCount; ++s) total_ns += stages_.totals(static_cast<tb::Stage>(s)).wall_ns;
+            std::cout << "  " << std::left << std::setw(11) << "stage" << std::right << std::setw(8) << "calls"
+                    << std::setw(12) << "wall ms" << std::setw(12) << "cpu ms" << std::setw(13) << "items"
+                    << std::setw(11) << "MiB" << std::setw(11) << "Mitems/s" << std::setw(10) << "MiB/s"
+                    << std::setw(8) << "wall%" << "\n";
+            for (std::size_t s = 0; s < tb::kStageCount; ++s) {
+                const auto stage = static_cast<tb::Stage>(s);
+                const tb::StageTotals t = stages_.totals(stage);
+                if (t.calls == 0) continue;
+                const double secs = static_cast<double>(t.wall_ns) / 1e9;
+                const double mib = static_cast<double>(t.bytes) / (1 << 20);
+                std::cout << "  " << std::left << std::setw(11) << tb::stage_name(stage) << std::right
+                        << std::setw(8) << t.calls << std::fixed << std::setprecision(3)
+                        << std::setw(12) << static_cast<double>(t.wall_ns) / 1e6
+                        << std::setw(12) << static_cast<double>(t.cpu_ns) / 1e6
+                        << std::setw(13) << t.items << std::setprecision(1) << std::setw(11) << mib;
+                if (secs > 0.0 && t.items > 0) {
+                    std::cout << std::setw(11) << static_cast<double>(t.items) / secs / 1e6;
+                } else {
+                    std::cout << std::setw(11) << "-";
+                }
+                if (secs > 0.0 && t.bytes > 0) {
+                    std::cout << std::setw(10) << mib / secs;
+                } else {
+                    std::cout << std::setw(10) << "-";
+                }
+                std::cout << std::setw(8)
+                        << (total_ns ? 100.0 * static_cast<double>(t.wall_ns) / static_cast<double>(total_ns) : 0.0)
+                        << "\n";
+            }
+            std::cout << "  (wall time summed over threads; items = addresses, buckets for stats/output)\n";
+#else
+            std::cout << "  (stage timers compiled out: TB_ENABLE_PROFILING=OFF)\n";
+#endif
+        }
+
+        struct Phase {
+            std::string name;
+            std::uint64_t elements = 0;
+            double seconds = 0.0;
+            tb::PerfReading perf{};
+        };
+
+        std::unique_ptr<tb::PerfCounters> counters_;
+        tb::StageProfile stages_;
+        std::chrono::steady_clock::time_point t0_{};
+        std::vector<Phase> phases_;
+    };
+
+    // ---------- Memory (--mem-limit) ----------
+    std::string mib(std::uint64_t bytes) {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / (1 << 20) << " MiB";
+        return os.str();
+    }
+
+    // il solo istogramma (più i buffer di streaming) non sta nel limite: niente da fare se non ridurre k
+    void check_fits(const Options& opt, const tb::Footprint& minimal) {
+        if (opt.mem_limit == 0 || minimal.total() <= opt.mem_limit) return;
+        throw std::runtime_error("Estimated footprint " + mib(minimal.total()) + " (histogram " +
+                                 mib(minimal.histogram_bytes) + " for k=" + std::to_string(opt.cfg.k) +
+                                 ") exceeds --mem-limit " + mib(opt.mem_limit) + "; lower --k");
+    }
+
+    void print_memory(const Options& opt, const tb::Footprint& f, bool streaming, const tb::Arena* arena = nullptr) {
+        if (opt.mem_limit == 0 && !opt.profile) return;
+        const tb::ProcessMemory pm = tb::process_memory();
+        std::cout << "\nMemory:\n"
+                << "  estimate     = " << mib(f.total()) << " (addresses " << mib(f.address_bytes)
+                << ", histogram " << mib(f.histogram_bytes) << ", buffers " << mib(f.buffer_bytes) << ")\n"
+                << "  mode         = " << (streaming ? "streaming" : "in-memory");
+        if (opt.mem_limit > 0) std::cout << " (--mem-limit " << mib(opt.mem_limit) << ")";
+        std::cout << "\n  tb allocs    = peak " << mib(tb::memory_peak_total());
+        for (std::size_t c = 0; c < tb::kMemCategoryCount; ++c) {
+            const auto cat = static_cast<tb::MemCategory>(c);
+            std::cout << (c == 0 ? " (" : ", ") << tb::memory_category_name(cat) << " " << mib(tb::memory_usage(cat).peak);
+        }
+        std::cout << ")\n";
+        if (arena != nullptr && arena->block_count() > 0) {
+            std::cout << "  arena        = peak " << mib(arena->peak()) << " used of " << mib(arena->mapped())
+                      << " mapped in " << arena->block_count() << " block(s), huge pages "
+                      << (arena->huge_pages() ? tb::huge_pages_name(opt.huge_pages) : "no") << "\n";
+        }
+        std::cout << "  peak RSS     = " << mib(pm.peak_rss) << " (now " << mib(pm.rss) << ")\n";
+    }
+
+    // ---------- Tuning (--calibrate, --tuning) ----------
+    std::string tuning_location(const Options& opt) {
+        const std::string path = opt.tuning_path.empty() ? tb::default_tuning_path() : opt.tuning_path;
+        if (path.empty()) {
+            throw std::runtime_error("No location for the tuning profile (set HOME, XDG_CACHE_HOME or "
+                                     "TB_TUNING_DIR, or pass --tuning)");
+        }
+        return path;
+    }
+
+    // installa il profilo (se c'è e combacia con la CPU) e restituisce da dove vengono le scelte
+    std::string install_tuning(const Options& opt) {
+        static std::optional<tb::TuningProfile> holder;   // installato fino all'uscita
+        if (opt.threads > 0) return "--threads";
+        const std::string path = opt.tuning_path.empty() ? tb::default_tuning_path() : opt.tuning_path;
+        if (path.empty()) return "built-in defaults";
+        holder = tb::load_tuning_profile(path);
+        if (!holder) {
+            if (!opt.tuning_path.empty()) throw std::runtime_error("Tuning profile not found: " + path);
+            return "built-in defaults";
+        }
+        const std::string cpu = tb::cpu_model();
+        if (holder->cpu != cpu) {
+            std::cerr << "Warning: ignoring tuning profile " << path << " measured on '" << holder->cpu
+                      << "' (this CPU: '" << cpu << "'); run --calibrate\n";
+            holder.reset();
+            return "built-in defaults";
+        }
+        tb::set_tuning_profile(&*holder);
+        return path;
+    }
+
+    void run_calibrate(const Options& opt) {
+        const std::string path = tuning_location(opt);
+        tb::CalibrationOptions copt;
+        copt.max_threads = opt.threads;
+        const std::string cpu = tb::cpu_model();
+        std::cout << "Calibrating on " << cpu << "...\n";
+        tb::TuningProfile profile = tb::calibrate(copt, &std::cout);
+        profile.cpu = cpu;
+        tb::save_tuning_profile(path, profile);
+        std::cout << "Tuning profile written to " << path << "\n";
+    }
+
+    // ---------- Tracing (--trace) ----------
+    // il file si scrive anche se il run fallisce: è lì che la timeline serve di più
+    class TraceSession {
+    public:
+        explicit TraceSession(const std::string& path) : path_{path} {
+            if (!path_.empty()) tb::start_tracing();
+        }
+        ~TraceSession() {
+            try {
+                finish();
+            } catch (const std::exception& e) {
+                std::cerr << "Warning: " << e.what() << "\n";
+            }
+        }
+        TraceSession(const TraceSession&) = delete;
+        TraceSession& operator=(const TraceSession&) = delete;
+
+        void finish() {
+            if (path_.empty()) return;
+            const std::string path = std::move(path_);
+            path_.clear();
+            tb::stop_tracing();
+            std::ofstream f{path};
+            if (!f) throw std::runtime_error("Cannot write trace file: " + path);
+            tb::write_chrome_trace(f);
+            if (!f) throw std::runtime_error("Cannot write trace file: " + path);
+            std::cerr << "Trace: " << path;
+            if (tb::trace_dropped() > 0) std::cerr << " (" << tb::trace_dropped() << " events dropped, buffers full)";
+            std::cerr << "\n";
+        }
+
+    private:
+        std::string path_;
+    };
+
+    void save_snapshot(const Options& opt, const std::vector<std::size_t>& counts,
+                       const tb::StatsResult& stats, const std::string& source) {
+        if (opt.snapshot_path.empty()) return;
+        tb::HistogramSnapshot snap;
+        snap.cfg = opt.cfg;
+        snap.counts = counts;
+        snap.metadata = "source=" + source + "\nsamples=" + std::to_string(stats.sample_count) + "\n";
+        tb::write_snapshot_file(opt.snapshot_path, snap);
+        std::cout << "\nSnapshot: " << opt.snapshot_path << "\n";
+    }
+
+    // ---------- Stop signals (--collect, --checkpoint) ----------
+    tb::FlowCollector* g_collector = nullptr;
+    std::atomic<bool> g_stop_ingest{false};   // lock-free: si può scrivere dal gestore del segnale
+
+    // esecuzione fermata da un segnale con lo stato salvato: non è un errore d'uso
+    struct Interrupted : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    extern "C" void on_stop_signal(int) {
+        if (g_collector != nullptr) {
+            g_collector->stop();
+        }
+        g_stop_ingest.store(true);
+    }
+
     // ---------- Run modes ----------
     void run_demo(const Options& opt) {
         const std::uint64_t N = opt.demo_count;
@@ -197,109 +980,389 @@ namespace {
         const auto start = static_cast<tb::IPv4>(0u);
         const auto end   = static_cast<tb::IPv4>(clamped);
 
+        // l'intervallo non si materializza: conta solo l'istogramma
+        const tb::Footprint footprint = tb::estimate_footprint(opt.cfg, 0, 1);
+        check_fits(opt, footprint);
+
+        Profiler prof{opt.profile};
+        prof.begin();
         const auto counts = engine.distribution(start, end);
+        prof.end("distribution", clamped);
+        prof.begin();
         const tb::StatsResult stats = tb::compute_stats(counts);
+        prof.end("stats", counts.size());
 
-        std::cout << "Mode: demo\n"
-                << "Range: [0, " << clamped << ") ("
-                << stats.sample_count << " samples)\n\n";
+        {
+            tb::ScopedStage output{tb::Stage::Output};
+            output.add(counts.size(), 0);
+            std::cout << "Mode: demo\n"
+                    << "Range: [0, " << clamped << ") ("
+                    << stats.sample_count << " samples)\n\n";
 
-        std::cout << "Config:\n"
-                << "  a = 0x" << std::hex << std::uppercase << opt.cfg.a << std::dec << "\n"
-                << "  b = 0x" << std::hex << std::uppercase << opt.cfg.b << std::dec << "\n"
-                << "  k = " << opt.cfg.k << " (buckets = " << opt.cfg.bucket_count() << ")\n\n";
+            print_config(opt.cfg);
+            print_stats(stats);
+            print_buckets(opt, counts);
+            save_snapshot(opt, counts, stats, "demo:" + std::to_string(clamped));
+            print_memory(opt, footprint, true);
+        }
+        prof.print();
+    }
 
-        std::cout << "Stats:\n"
-                << std::fixed << std::setprecision(4)
-                << "  sample_count = " << stats.sample_count << "\n"
-                << "  bucket_count = " << stats.bucket_count << "\n"
-                << "  mean         = " << stats.mean << "\n"
-                << "  stddev       = " << stats.stddev << "\n"
-                << "  chi2         = " << stats.chi2 << "\n"
-                << "  uniformity   = " << stats.uniformity << " %\n";
+    // --sample: stima dal campione, fermandosi appena converge; legge il file in streaming
+    void run_sample(const Options& opt) {
+        const tb::BucketEngine engine{opt.cfg};
+        const tb::Footprint footprint = tb::estimate_footprint(opt.cfg, 0, 1);
+        check_fits(opt, footprint);
+
+        Profiler prof{opt.profile};
+        std::uint64_t bytes_read = 0;
+        tb::Dataset data = tb::ipv4_file_dataset(opt.file_path, opt.ingest, tb::Dataset::kDefaultChunk, &bytes_read);
+        prof.begin();
+        tb::SampleEstimate est = tb::sample_distribution(engine, data, opt.sampling);
+        prof.end("sample", est.scanned);
+        if (est.sampled == 0) {
+            throw std::runtime_error("No valid IPv4 addresses found in file: " + opt.file_path);
+        }
+
+        // fermata in anticipo: popolazione stimata dai byte letti, intervalli riferiti a tutto il file
+        const std::uint64_t file_size = std::filesystem::file_size(opt.file_path);
+        const double fraction = file_size > 0
+            ? std::min(1.0, static_cast<double>(bytes_read) / static_cast<double>(file_size))
+            : 1.0;
+        if (fraction < 1.0) {
+            const auto population = static_cast<std::uint64_t>(static_cast<double>(est.scanned) / fraction);
+            tb::SampleEstimate whole = tb::estimate_from_sample(est.counts, population, opt.sampling.confidence);
+            whole.scanned = est.scanned;
+            whole.fraction_read = fraction;
+            whole.converged = est.converged;
+            est = std::move(whole);
+        }
+
+        tb::ScopedStage output{tb::Stage::Output};
+        output.add(est.counts.size(), 0);
+        std::cout << "Mode: from-file (sample)\n"
+                << "File: " << opt.file_path << " (" << tb::input_format_name(opt.ingest.format) << ")\n"
+                << "Method: " << tb::sample_method_name(opt.sampling.method);
+        if (opt.sampling.method == tb::SampleMethod::Reservoir) {
+            std::cout << " (" << opt.sampling.reservoir << " addresses)";
+        } else {
+            std::cout << " (rate " << opt.sampling.rate << ")";
+        }
+        std::cout << "\n"
+                << "Sampled: " << est.sampled << " of " << est.scanned << " addresses read\n"
+                << std::fixed << std::setprecision(1)
+                << "Input read: " << 100.0 * fraction << " % (" << bytes_read << " of " << file_size << " bytes";
+        if (fraction < 1.0) {
+            std::cout << ", ~" << est.population << " addresses in all";
+        }
+        std::cout << ")\n"
+                << std::setprecision(4)
+                << "Converged: " << (est.converged ? "yes" : "no") << " (max error " << est.max_error
+                << ", tolerance " << opt.sampling.tolerance << ", confidence " << opt.sampling.confidence << ")\n"
+                << std::setprecision(2)
+                << "Estimated chi2: " << est.chi2 << " [" << est.chi2_lower << ", " << est.chi2_upper
+                << "] (whole input, " << est.counts.size() - 1 << " degrees of freedom)\n\n";
 
+        print_config(opt.cfg);
+        print_stats(est.sample_stats, "Sample stats");
         if (opt.show_buckets) {
             const std::size_t limit = (opt.show_buckets_limit == 0)
-                ? counts.size()
-                : std::min<std::size_t>(opt.show_buckets_limit, counts.size());
-
-            std::cout << "\nBucket counts (first " << limit << "):\n";
+                ? est.counts.size()
+                : std::min<std::size_t>(opt.show_buckets_limit, est.counts.size());
+            std::cout << "\nBucket shares (first " << limit << ", % with "
+                      << std::setprecision(0) << opt.sampling.confidence * 100.0 << " % interval):\n"
+                      << std::setprecision(4);
             for (std::size_t i = 0; i < limit; ++i) {
-                std::cout << "  [" << i << "] = " << counts[i] << "\n";
+                std::cout << "  [" << i << "] = " << 100.0 * est.share[i] << " [" << 100.0 * est.lower[i] << ", "
+                          << 100.0 * est.upper[i] << "] (" << est.counts[i] << " sampled)\n";
             }
         }
+        print_memory(opt, footprint, true);
+        prof.print();
     }
 
     void run_from_file(const Options& opt) {
-        std::ifstream in{opt.file_path};
-        if (!in) {
-            throw std::runtime_error("Cannot open input file: " + opt.file_path);
-        }
-
-        std::vector<tb::IPv4> ips;
-        ips.reserve(1024);
-
-        std::string line;
-        std::size_t line_no = 0;
-        while (std::getline(in, line)) {
-            ++line_no;
-            // trim minimo
-            auto is_space = [](unsigned char c){ return std::isspace(c) != 0; };
-            line.erase(line.begin(),
-                    std::find_if(line.begin(), line.end(),
-                                    [&](char c){ return !is_space(static_cast<unsigned char>(c)); }));
-            line.erase(std::find_if(line.rbegin(), line.rend(),
-                                    [&](char c){ return !is_space(static_cast<unsigned char>(c)); }).base(),
-                    line.end());
-
-            if (line.empty()) continue;
-            if (!line.empty() && line[0] == '#') continue;
+        if (opt.sample) {
+            run_sample(opt);
+            return;
+        }
+        const std::string tuning_source = install_tuning(opt);
 
-            try {
-                tb::IPv4 ip = tb::parse_ipv4(line);
-                ips.push_back(ip);
-            } catch (const std::exception& e) {
-                std::ostringstream oss;
-                oss << "Error parsing IPv4 at line " << line_no << ": " << e.what();
-                throw std::runtime_error(oss.str());
+        // stima prima di allocare: tutto in memoria se sta nel limite, altrimenti streaming.
+        // Il limite superiore degli indirizzi dimensiona anche l'arena, una volta sola;
+        // per il gzip non c'è limite (rapporto di compressione ignoto)
+        const std::optional<std::uint64_t> max_addr = tb::max_address_count(opt.file_path, opt.ingest);
+        // la strategia decide la memoria di lavoro: si sceglie prima e la si usa per la stima
+        tb::TuningChoice choice = opt.threads > 0 ? tb::TuningChoice{opt.threads, tb::HistogramStrategy::PerThread}
+                                                  : tb::choose_tuning(opt.cfg.k, max_addr.value_or(0));
+        tb::Footprint footprint = tb::estimate_footprint(opt.cfg, max_addr.value_or(0), choice.threads,
+                                                         /*presized=*/true, choice.strategy);
+        bool streaming = false;
+        // con --checkpoint sempre in streaming: la posizione nel file è lo stato da salvare;
+        // con --mem-limit anche un input senza limite superiore
+        if (!opt.checkpoint_path.empty() ||
+            (opt.mem_limit > 0 && (!max_addr || footprint.total() > opt.mem_limit))) {
+            footprint = tb::estimate_footprint(opt.cfg, 0, 1);
+            check_fits(opt, footprint);
+            streaming = true;
+        }
+
+        Profiler prof{opt.profile};
+        tb::BucketEngine engine{opt.cfg};
+        std::vector<std::size_t> counts;
+        tb::ArenaOptions arena_opt;
+        arena_opt.huge_pages = opt.huge_pages;
+        // nell'arena va la stima meno ciò che resta sull'heap (blocco di lettura, istogramma risultato):
+        // l'arena non mappa, né conta, più di quanto il controllo del limite ha ammesso
+        const std::uint64_t heap_bytes =
+            tb::kReadBlock + static_cast<std::uint64_t>(opt.cfg.bucket_count()) * sizeof(std::size_t);
+        const std::size_t arena_bytes =
+            static_cast<std::size_t>(footprint.total() > heap_bytes ? footprint.total() - heap_bytes : 0);
+        if (max_addr) arena_opt.block_bytes = arena_bytes;
+        tb::Arena arena{arena_opt};
+        std::string resumed_note;
+        std::string tuning_note;   // con --profile, dopo l'intestazione accanto a memoria e profilo
+        if (!opt.checkpoint_path.empty()) {
+            counts.assign(engine.config().bucket_count(), 0);
+            tb::CheckpointOptions ck;
+            ck.path = opt.checkpoint_path;
+            ck.interval_seconds = static_cast<double>(opt.checkpoint_every);
+            ck.resume = opt.resume;
+            ck.stop = &g_stop_ingest;
+            ck.on_checkpoint = [](const tb::IngestCheckpoint& c) {
+                std::cerr << "Checkpoint " << c.sequence << ": offset " << c.offset << ", " << c.samples
+                          << " samples\n";
+                return true;
+            };
+            std::signal(SIGINT, on_stop_signal);
+            std::signal(SIGTERM, on_stop_signal);
+            prof.begin();
+            const tb::ResumableRun run = tb::accumulate_ipv4_file_resumable(opt.file_path, opt.ingest, engine,
+                                                                            counts, ck);
+            prof.end("stream", run.samples - run.resumed_samples);
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            if (!run.complete) {
+                throw Interrupted("stopped after " + std::to_string(run.input_bytes) + " input bytes (" +
+                                  std::to_string(run.samples) + " samples); progress saved to " +
+                                  opt.checkpoint_path + ", rerun with --resume to continue");
+            }
+            if (run.resumed) {
+                std::ostringstream os;
+                os << "Resumed: " << run.resumed_offset << " of " << run.input_bytes << " input bytes ("
+                   << run.resumed_samples << " samples) from " << opt.checkpoint_path << "\n";
+                resumed_note = os.str();
+            }
+            if (run.samples == 0) {
+                throw std::runtime_error("No valid IPv4 addresses found in file: " + opt.file_path);
+            }
+        } else if (streaming) {
+            // un thread: l'istogramma per thread moltiplicherebbe la parte che non si può ridurre
+            counts.assign(engine.config().bucket_count(), 0);
+            prof.begin();
+            const std::uint64_t n = tb::accumulate_ipv4_file(opt.file_path, opt.ingest, engine, counts);
+            prof.end("stream", n);
+            if (n == 0) {
+                throw std::runtime_error("No valid IPv4 addresses found in file: " + opt.file_path);
+            }
+        } else {
+            // indirizzi e istogrammi per thread nell'arena: nessuna copia da riallocazione,
+            // nessuna contesa sull'heap fra thread; le pagine mai scritte non occupano memoria
+            if (max_addr) {
+                arena.reserve(arena_bytes);
+            }
+            prof.begin();
+            const std::pmr::vector<tb::IPv4> ips =
+                tb::read_ipv4_file(opt.file_path, opt.ingest, &arena, max_addr.value_or(0));
+            prof.end("read+parse", ips.size());
+            if (ips.empty()) {
+                throw std::runtime_error("No valid IPv4 addresses found in file: " + opt.file_path);
+            }
+            if (!max_addr) {
+                // gzip: scelta e stima sugli indirizzi letti, in un vettore cresciuto per raddoppio
+                if (opt.threads == 0) choice = tb::choose_tuning(opt.cfg.k, ips.size());
+                footprint = tb::estimate_footprint(opt.cfg, ips.size(), choice.threads, false, choice.strategy);
+            }
+
+            prof.begin();
+            counts.assign(engine.config().bucket_count(), 0);
+            tb::parallel_accumulate(engine, ips.data(), ips.size(), counts.data(), counts.size(), choice.threads,
+                                    choice.strategy, &arena);
+            prof.end("distribution", ips.size());
+            if (opt.profile) {
+                std::ostringstream os;
+                os << "\nTuning: " << choice.threads << " thread(s), " << tb::histogram_strategy_name(choice.strategy)
+                   << " (" << tuning_source << ")\n";
+                tuning_note = os.str();
             }
         }
+        prof.begin();
+        const tb::StatsResult stats = tb::compute_stats(counts);
+        prof.end("stats", counts.size());
+
+        {
+            tb::ScopedStage output{tb::Stage::Output};
+            output.add(counts.size(), 0);
+            std::cout << "Mode: from-file\n"
+                    << "File: " << opt.file_path << " (" << tb::input_format_name(opt.ingest.format) << ")\n"
+                    << resumed_note << "\n";
 
-        if (ips.empty()) {
+            print_config(opt.cfg);
+            print_stats(stats);
+            print_buckets(opt, counts);
+            save_snapshot(opt, counts, stats, "file:" + opt.file_path);
+            std::cout << tuning_note;
+            print_memory(opt, footprint, streaming, &arena);
+        }
+        prof.print();
+    }
+
+    void run_coordinator(const Options& opt) {
+        tb::CoordinatorOptions copt = opt.coordinator;
+        copt.path = opt.file_path;
+        tb::Coordinator coordinator{opt.cfg, copt};
+
+        std::cout << "Mode: coordinator\n"
+                << "File: " << opt.file_path << "\n"
+                << "Listening: tcp " << copt.bind_address << ":" << coordinator.port() << "\n" << std::flush;
+
+        const auto t0 = std::chrono::steady_clock::now();
+        const tb::JobResult res = coordinator.run();
+        const std::chrono::duration<double> secs = std::chrono::steady_clock::now() - t0;
+        if (res.samples == 0) {
             throw std::runtime_error("No valid IPv4 addresses found in file: " + opt.file_path);
         }
 
-        tb::BucketEngine engine{opt.cfg};
-        const auto counts = engine.distribution(ips);
-        const tb::StatsResult stats = tb::compute_stats(counts);
+        std::cout << "Tasks: " << res.tasks << " (retries: " << res.retries
+                << ", workers: " << res.workers << ", " << std::fixed << std::setprecision(3)
+                << secs.count() << " s)\n\n";
 
-        std::cout << "Mode: from-file\n"
-                << "File: " << opt.file_path << "\n\n";
+        print_config(opt.cfg);
+        print_stats(res.stats);
+        print_buckets(opt, res.counts);
+        save_snapshot(opt, res.counts, res.stats, "file:" + opt.file_path);
+    }
 
-        std::cout << "Config:\n"
-                << "  a = 0x" << std::hex << std::uppercase << opt.cfg.a << std::dec << "\n"
-                << "  b = 0x" << std::hex << std::uppercase << opt.cfg.b << std::dec << "\n"
-                << "  k = " << opt.cfg.k << " (buckets = " << opt.cfg.bucket_count() << ")\n\n";
+    void run_worker(const Options& opt) {
+        std::cout << "Mode: worker\n"
+                << "Coordinator: " << opt.worker.host << ":" << opt.worker.port << "\n" << std::flush;
+        const tb::WorkerSummary sum = tb::run_worker(opt.worker);
+        std::cout << "Done: " << sum.tasks << " tasks, " << sum.samples << " samples\n";
+    }
 
-        std::cout << "Stats:\n"
-                << std::fixed << std::setprecision(4)
-                << "  sample_count = " << stats.sample_count << "\n"
-                << "  bucket_count = " << stats.bucket_count << "\n"
-                << "  mean         = " << stats.mean << "\n"
-                << "  stddev       = " << stats.stddev << "\n"
-                << "  chi2         = " << stats.chi2 << "\n"
-                << "  uniformity   = " << stats.uniformity << " %\n";
+    void run_ts_query(const Options& opt) {
+        const tb::TimeSeriesStore store{opt.ts_dir, opt.cfg};
+        if (store.interval_count() == 0) {
+            throw std::runtime_error("Time-series store is empty: " + opt.ts_dir);
+        }
+        std::int64_t from = opt.ts_from;
+        std::int64_t to = opt.ts_to;
+        if (opt.ts_last > 0) {
+            to = std::min(to, store.last_timestamp() + 1);
+            from = std::max(from, to - static_cast<std::int64_t>(opt.ts_last));
+        }
 
-        if (opt.show_buckets) {
-            const std::size_t limit = (opt.show_buckets_limit == 0)
-                ? counts.size()
-                : std::min<std::size_t>(opt.show_buckets_limit, counts.size());
+        const auto t0 = std::chrono::steady_clock::now();
+        const tb::TimeSeriesRange r = store.query(from, to);
+        const std::chrono::duration<double> secs = std::chrono::steady_clock::now() - t0;
 
-            std::cout << "\nBucket counts (first " << limit << "):\n";
-            for (std::size_t i = 0; i < limit; ++i) {
-                std::cout << "  [" << i << "] = " << counts[i] << "\n";
+        std::cout << "Mode: ts-query\n"
+                << "Store: " << opt.ts_dir << " [" << store.first_timestamp() << ", "
+                << store.last_timestamp() << "]\n"
+                << "Intervals: " << r.intervals << " (" << r.records_read << " records read, "
+                << std::fixed << std::setprecision(3) << secs.count() * 1000.0 << " ms)\n\n";
+
+        print_config(opt.cfg);
+        print_stats(tb::compute_stats(r.counts));
+        print_buckets(opt, r.counts);
+    }
+
+    void run_collect(const Options& opt) {
+        tb::FlowCollector collector{opt.cfg, opt.collector};
+        g_collector = &collector;
+        std::signal(SIGINT, on_stop_signal);
+        std::signal(SIGTERM, on_stop_signal);
+
+        // endpoint metriche opzionale: il thread HTTP è l'unico lettore dell'exchange
+        tb::SnapshotExchange exchange;
+        std::unique_ptr<tb::MetricsServer> server;
+        if (opt.metrics) {
+            server = std::make_unique<tb::MetricsServer>(exchange, opt.metrics_server);
+        }
+        std::unique_ptr<tb::TimeSeriesStore> store;
+        if (!opt.ts_dir.empty()) {
+            store = std::make_unique<tb::TimeSeriesStore>(opt.ts_dir, opt.cfg);
+        }
+        tb::MetricsSnapshot totals;
+        totals.cfg = opt.cfg;
+        totals.stats.bucket_count = opt.cfg.bucket_count();
+        exchange.publish(totals);
+
+        std::cout << "Mode: collect\n"
+                << "Listening: udp " << opt.collector.bind_address << ":" << collector.port() << "\n";
+        if (server) {
+            std::cout << "Metrics: http://" << opt.metrics_server.bind_address << ":" << server->port() << "/metrics\n";
+        }
+        if (store) {
+            std::cout << "Time-series store: " << opt.ts_dir << " (" << store->interval_count() << " intervals)\n";
+        }
+        std::cout << "\n";
+
+        print_config(opt.cfg);
+        std::cout << std::flush;
+
+        collector.run([&](const tb::WindowReport& w) {
+            const double rate = (w.seconds > 0.0) ? static_cast<double>(w.records) / w.seconds : 0.0;
+            if (store) {
+                // timestamp = inizio della finestra (secondi unix), strettamente crescente
+                const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                std::int64_t ts = static_cast<std::int64_t>(now) - static_cast<std::int64_t>(w.seconds);
+                if (store->interval_count() > 0) ts = std::max(ts, store->last_timestamp() + 1);
+                store->append(ts, w.counts);
+            }
+            if (server) {
+                totals.stats = w.stats;
+                totals.top_buckets = tb::top_buckets(w.counts, opt.metrics_top);
+                totals.windows_total += 1;
+                totals.records_total += w.records;
+                totals.datagrams_total += w.datagrams;
+                totals.payload_bytes_total += w.payload_bytes;
+                totals.decode_errors_total += w.decode_errors;
+                totals.records_per_second = rate;
+                totals.window_seconds = w.seconds;
+                exchange.publish(totals);
             }
+            std::cout << std::fixed << std::setprecision(4)
+                    << "Window " << w.index << " (" << w.seconds << " s):"
+                    << " datagrams=" << w.datagrams
+                    << " records=" << w.records
+                    << " errors=" << w.decode_errors
+                    << " records/s=" << rate << "\n"
+                    << "  load_total   = " << w.stats.sample_count << "\n"
+                    << "  mean         = " << w.stats.mean << "\n"
+                    << "  stddev       = " << w.stats.stddev << "\n"
+                    << "  chi2         = " << w.stats.chi2 << "\n"
+                    << "  uniformity   = " << w.stats.uniformity << " %\n"
+                    << "  max_load     = " << w.stats.max_load << "\n";
+
+            if (opt.show_buckets) {
+                const std::size_t limit = (opt.show_buckets_limit == 0)
+                    ? w.counts.size()
+                    : std::min<std::size_t>(opt.show_buckets_limit, w.counts.size());
+                for (std::size_t i = 0; i < limit; ++i) {
+                    std::cout << "  [" << i << "] = " << w.counts[i] << "\n";
+                }
+            }
+            std::cout << std::flush;
+        });
+
+        g_collector = nullptr;
+        if (store) {
+            store->flush();
         }
+        std::cout << "Templates cached: " << collector.decoder().template_count()
+                << ", records skipped: " << collector.decoder().skipped_records() << "\n";
     }
 
 }
@@ -313,6 +1376,7 @@ int main(int argc, char** argv) {
         }
 
         Options opt = parse_args(argc, argv);
+        TraceSession trace{opt.trace_path};
 
         switch (opt.mode) {
             case Mode::Demo:
@@ -321,12 +1385,31 @@ int main(int argc, char** argv) {
             case Mode::FromFile:
                 run_from_file(opt);
                 break;
+            case Mode::Collect:
+                run_collect(opt);
+                break;
+            case Mode::Coordinator:
+                run_coordinator(opt);
+                break;
+            case Mode::Worker:
+                run_worker(opt);
+                break;
+            case Mode::TsQuery:
+                run_ts_query(opt);
+                break;
+            case Mode::Calibrate:
+                run_calibrate(opt);
+                break;
             case Mode::None:
             default:
                 throw std::runtime_error("Internal error: no mode selected");
         }
 
+        trace.finish();
         return 0;
+    } catch (const Interrupted& e) {
+        std::cerr << "Interrupted: " << e.what() << "\n";
+        return 130;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n\n";
         print_usage(std::cerr);
@@ -0,0 +1,181 @@
+#include "tb/snapshot.hpp"
+#include "tb/snapshot_file.hpp"
+#include "tb/stats.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    // ---------- Helper per stampa usage ----------
+    void print_usage(std::ostream& os) {
+        os << "Turbo-Bucketizer histogram merge\n"
+        << "Usage:\n"
+        << "  tb_merge -o <out.tbh> [options] <in.tbh>...\n"
+        << "  tb_merge --info <file.tbh>...\n"
+        << "\n"
+        << "Options:\n"
+        << "  -o, --output <path>  Merged snapshot to write (atomically)\n"
+        << "  --threads <n>        Merge threads (default: hardware concurrency)\n"
+        << "  --encoding <e>       auto | raw | varint | packed (default: auto = smallest)\n"
+        << "  --info               Print header, metadata and stats of each input instead of merging\n"
+        << "  --help               Show this help and exit\n"
+        << "\n"
+        << "All inputs must have been produced with the same a, b and k.\n";
+    }
+
+    tb::SnapshotEncoding parse_encoding(const std::string& s) {
+        if (s == "auto") return tb::SnapshotEncoding::Auto;
+        if (s == "raw") return tb::SnapshotEncoding::Raw;
+        if (s == "varint") return tb::SnapshotEncoding::DeltaVarint;
+        if (s == "packed") return tb::SnapshotEncoding::BitPacked;
+        throw std::runtime_error("Unknown encoding: '" + s + "'");
+    }
+
+    const char* encoding_name(tb::SnapshotEncoding e) {
+        switch (e) {
+            case tb::SnapshotEncoding::Raw: return "raw";
+            case tb::SnapshotEncoding::DeltaVarint: return "varint";
+            case tb::SnapshotEncoding::BitPacked: return "packed";
+            default: return "?";
+        }
+    }
+
+    std::uint64_t parse_u64(const std::string& s, const std::string& what) {
+        std::size_t pos = 0;
+        std::uint64_t value = 0;
+        try {
+            value = std::stoull(s, &pos, 10);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid " + what + " value: '" + s + "'");
+        }
+        if (pos != s.size()) {
+            throw std::runtime_error("Invalid " + what + " value (trailing chars): '" + s + "'");
+        }
+        return value;
+    }
+
+    struct Options {
+        std::string output;
+        std::vector<std::string> inputs;
+        unsigned threads = 0;
+        tb::SnapshotEncoding encoding = tb::SnapshotEncoding::Auto;
+        bool info = false;
+    };
+
+    Options parse_args(int argc, char** argv) {
+        Options opt;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                print_usage(std::cout);
+                std::exit(0);
+            } else if (arg == "-o" || arg == "--output") {
+                if (i + 1 >= argc) throw std::runtime_error(arg + " requires a path");
+                opt.output = argv[++i];
+            } else if (arg == "--threads") {
+                if (i + 1 >= argc) throw std::runtime_error("--threads requires an integer argument");
+                const std::uint64_t threads = parse_u64(argv[++i], "threads");
+                if (threads == 0 || threads > 1024) {
+                    throw std::runtime_error("threads out of range [1, 1024]: " + std::to_string(threads));
+                }
+                opt.threads = static_cast<unsigned>(threads);
+            } else if (arg == "--encoding") {
+                if (i + 1 >= argc) throw std::runtime_error("--encoding requires a name");
+                opt.encoding = parse_encoding(argv[++i]);
+            } else if (arg == "--info") {
+                opt.info = true;
+            } else if (!arg.empty() && arg[0] == '-') {
+                throw std::runtime_error("Unknown argument: " + arg);
+            } else {
+                opt.inputs.push_back(arg);
+            }
+        }
+        if (opt.inputs.empty()) {
+            throw std::runtime_error("No input snapshots given");
+        }
+        if (!opt.info && opt.output.empty()) {
+            throw std::runtime_error("Missing -o <output>");
+        }
+        return opt;
+    }
+
+    void print_stats(const tb::StatsResult& stats) {
+        std::cout << std::fixed << std::setprecision(4)
+                << "  sample_count = " << stats.sample_count << "\n"
+                << "  bucket_count = " << stats.bucket_count << "\n"
+                << "  mean         = " << stats.mean << "\n"
+                << "  stddev       = " << stats.stddev << "\n"
+                << "  chi2         = " << stats.chi2 << "\n"
+                << "  p_value      = " << stats.p_value << "\n"
+                << "  uniformity   = " << stats.uniformity << " %\n"
+                << "  max_load     = " << stats.max_load << "\n";
+    }
+
+    void run_info(const Options& opt) {
+        for (const auto& path : opt.inputs) {
+            const tb::MappedSnapshot snap{path};
+            const tb::SnapshotView& v = snap.view();
+            std::cout << path << ":\n"
+                    << "  a = 0x" << std::hex << std::uppercase << v.config().a
+                    << ", b = 0x" << v.config().b << std::dec
+                    << ", k = " << v.config().k << "\n"
+                    << "  fingerprint  = 0x" << std::hex << v.fingerprint() << std::dec << "\n"
+                    << "  encoding     = " << encoding_name(v.encoding());
+            if (v.random_access()) {
+                std::cout << " (" << v.counter_bits() << " bit counters)";
+            }
+            std::cout << ", " << v.payload_size() << " payload bytes\n";
+            const std::string meta = v.metadata();
+            if (!meta.empty()) {
+                std::cout << "  metadata:\n";
+                std::size_t start = 0;
+                while (start < meta.size()) {
+                    const auto nl = meta.find('\n', start);
+                    std::cout << "    " << meta.substr(start, nl - start) << "\n";
+                    if (nl == std::string::npos) break;
+                    start = nl + 1;
+                }
+            }
+            print_stats(tb::compute_stats(v.decode().counts));
+        }
+    }
+
+    void run_merge(const Options& opt) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const tb::HistogramSnapshot merged = tb::merge_snapshot_files(opt.inputs, opt.threads);
+        tb::write_snapshot_file(opt.output, merged, opt.encoding);
+        const std::chrono::duration<double> secs = std::chrono::steady_clock::now() - t0;
+
+        std::cout << "Merged " << opt.inputs.size() << " snapshots into " << opt.output
+                << " (" << std::fixed << std::setprecision(3) << secs.count() << " s)\n";
+        print_stats(tb::compute_stats(merged.counts));
+    }
+}
+
+// ---------- main ----------
+int main(int argc, char** argv) {
+    try {
+        if (argc <= 1) {
+            print_usage(std::cout);
+            return 1;
+        }
+        const Options opt = parse_args(argc, argv);
+        if (opt.info) {
+            run_info(opt);
+        } else {
+            run_merge(opt);
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n";
+        print_usage(std::cerr);
+        return 1;
+    }
+}
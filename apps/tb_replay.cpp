@@ -0,0 +1,174 @@
+#include "tb/pcap.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+    // ---------- Helper per stampa usage ----------
+    void print_usage(std::ostream& os) {
+        os << "Turbo-Bucketizer flow replay\n"
+        << "Usage:\n"
+        << "  tb_replay <capture.pcap> [options]\n"
+        << "\n"
+        << "Sends the UDP payloads found in a pcap capture (NetFlow v5 / IPFIX exports)\n"
+        << "to a running collector, e.g. `tb_cli --collect 2055`.\n"
+        << "\n"
+        << "Options:\n"
+        << "  --host <ipv4>        Destination address (default: 127.0.0.1)\n"
+        << "  --port <n>           Destination UDP port (default: 2055)\n"
+        << "  --only-port <n>      Replay only datagrams originally sent to this port\n"
+        << "  --rate <pps>         Pace at most <pps> datagrams per second (default: unlimited)\n"
+        << "  --loop <n>           Replay the capture <n> times (default: 1)\n"
+        << "  --help               Show this help and exit\n";
+    }
+
+    std::uint64_t parse_u64(const std::string& s, const std::string& what) {
+        std::size_t pos = 0;
+        std::uint64_t value = 0;
+        try {
+            value = std::stoull(s, &pos, 10);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid " + what + " value: '" + s + "'");
+        }
+        if (pos != s.size()) {
+            throw std::runtime_error("Invalid " + what + " value (trailing chars): '" + s + "'");
+        }
+        return value;
+    }
+
+    std::uint16_t parse_port(const std::string& s, const std::string& what) {
+        const std::uint64_t v = parse_u64(s, what);
+        if (v > std::numeric_limits<std::uint16_t>::max()) {
+            throw std::runtime_error(what + " out of range: " + s);
+        }
+        return static_cast<std::uint16_t>(v);
+    }
+
+    struct Options {
+        std::string capture;
+        std::string host = "127.0.0.1";
+        std::uint16_t port = 2055;
+        std::uint16_t only_port = 0; // 0 = all
+        std::uint64_t rate = 0;      // 0 = unlimited
+        std::uint64_t loops = 1;
+    };
+
+    Options parse_args(int argc, char** argv) {
+        Options opt;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&](const char* what) -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error(arg + " requires " + what);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--help" || arg == "-h") {
+                print_usage(std::cout);
+                std::exit(0);
+            } else if (arg == "--host") {
+                opt.host = value("an IPv4 address");
+            } else if (arg == "--port") {
+                opt.port = parse_port(value("a port"), "port");
+            } else if (arg == "--only-port") {
+                opt.only_port = parse_port(value("a port"), "only-port");
+            } else if (arg == "--rate") {
+                opt.rate = parse_u64(value("a rate"), "rate");
+            } else if (arg == "--loop") {
+                opt.loops = parse_u64(value("a count"), "loop");
+            } else if (!arg.empty() && arg[0] == '-') {
+                throw std::runtime_error("Unknown argument: " + arg);
+            } else if (opt.capture.empty()) {
+                opt.capture = arg;
+            } else {
+                throw std::runtime_error("Unexpected argument: " + arg);
+            }
+        }
+        if (opt.capture.empty()) {
+            throw std::runtime_error("No capture file given");
+        }
+        return opt;
+    }
+
+    void replay(const Options& opt) {
+        const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("Cannot create UDP socket: ") + std::strerror(errno));
+        }
+        sockaddr_in dst{};
+        dst.sin_family = AF_INET;
+        dst.sin_port = htons(opt.port);
+        if (::inet_pton(AF_INET, opt.host.c_str(), &dst.sin_addr) != 1) {
+            ::close(fd);
+            throw std::runtime_error("Invalid host: '" + opt.host + "'");
+        }
+
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        std::uint64_t sent = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t skipped = 0;
+
+        tb::UdpDatagram dg;
+        for (std::uint64_t loop = 0; loop < opt.loops; ++loop) {
+            tb::PcapReader reader{opt.capture};
+            while (reader.next(dg)) {
+                if (opt.only_port != 0 && dg.dst_port != opt.only_port) {
+                    ++skipped;
+                    continue;
+                }
+                if (opt.rate != 0) {
+                    // pacing: il datagramma n parte non prima di n/rate secondi dall'inizio
+                    const auto due = start + std::chrono::nanoseconds(sent * 1000000000ULL / opt.rate);
+                    std::this_thread::sleep_until(due);
+                }
+                const auto n = ::sendto(fd, dg.payload.data(), dg.payload.size(), 0,
+                                        reinterpret_cast<const sockaddr*>(&dst), sizeof(dst));
+                if (n < 0) {
+                    const std::string err = std::strerror(errno);
+                    ::close(fd);
+                    throw std::runtime_error("sendto failed: " + err);
+                }
+                ++sent;
+                bytes += dg.payload.size();
+            }
+            skipped += reader.skipped();
+        }
+        ::close(fd);
+
+        const std::chrono::duration<double> secs = clock::now() - start;
+        std::cout << "Replayed " << sent << " datagrams (" << bytes << " bytes) to "
+                  << opt.host << ":" << opt.port << " in " << secs.count() << " s"
+                  << " (" << skipped << " skipped)\n";
+    }
+}
+
+// ---------- main ----------
+int main(int argc, char** argv) {
+    try {
+        if (argc <= 1) {
+            print_usage(std::cout);
+            return 1;
+        }
+        replay(parse_args(argc, argv));
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n";
+        print_usage(std::cerr);
+        return 1;
+    }
+}
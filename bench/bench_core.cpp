@@ -0,0 +1,132 @@
+#include "suites.hpp"
+
+#include "tb/bucket_engine.hpp"
+#include "tb/dataset.hpp"
+#include "tb/stats.hpp"
+#include "tb/utils.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace tb::bench {
+
+    namespace {
+        std::vector<IPv4> random_ips(std::size_t n, std::uint32_t seed) {
+            std::mt19937 rng{seed};
+            std::vector<IPv4> ips(n);
+            for (auto& ip : ips) ip = rng();
+            return ips;
+        }
+
+        std::vector<std::string> dotted(const std::vector<IPv4>& ips) {
+            std::vector<std::string> out;
+            out.reserve(ips.size());
+            for (const IPv4 v : ips) {
+                out.push_back(std::to_string(v >> 24) + "." + std::to_string((v >> 16) & 0xFFu) + "." +
+                              std::to_string((v >> 8) & 0xFFu) + "." + std::to_string(v & 0xFFu));
+            }
+            return out;
+        }
+
+        Params kn(unsigned k, std::size_t n) {
+            return {{"k", std::to_string(k)}, {"n", std::to_string(n)}};
+        }
+    }
+
+    void run_core_suite(Harness& h, const SuiteConfig& cfg) {
+        for (const std::size_t n : cfg.sizes) {
+            const std::vector<IPv4> ips = random_ips(n, 42);
+            std::vector<std::size_t> weights(n);
+            std::mt19937 rng{7};
+            for (auto& w : weights) w = 40 + rng() % 1460;
+
+            for (const unsigned k : cfg.ks) {
+                Config c{};
+                c.k = k;
+                const BucketEngine engine{c};
+
+                h.run("bucket_index", kn(k, n), n, [&] {
+                    BucketIndex acc = 0;
+                    for (const IPv4 ip : ips) acc += engine.bucket_index(ip);
+                    do_not_optimize(acc);
+                });
+                h.run("bucketize", kn(k, n), n, [&] {
+                    const auto out = engine.bucketize(ips);
+                    do_not_optimize(out.data());
+                });
+                std::vector<BucketIndex> out(n);
+                h.run("bucketize_into", kn(k, n), n, [&] {
+                    engine.bucketize(ips.data(), ips.size(), out.data());
+                    do_not_optimize(out.data());
+                });
+                // 1 o 2 byte per indice invece di 4
+                if (k <= 8) {
+                    std::vector<std::uint8_t> narrow(n);
+                    h.run("bucketize_u8", kn(k, n), n, [&] {
+                        engine.bucketize(ips.data(), ips.size(), narrow.data());
+                        do_not_optimize(narrow.data());
+                    });
+                } else if (k <= 16) {
+                    std::vector<std::uint16_t> narrow(n);
+                    h.run("bucketize_u16", kn(k, n), n, [&] {
+                        engine.bucketize(ips.data(), ips.size(), narrow.data());
+                        do_not_optimize(narrow.data());
+                    });
+                }
+                PackedBuckets packed{k, n};
+                h.run("bucketize_packed", kn(k, n), n, [&] {
+                    engine.bucketize(ips.data(), ips.size(), packed);
+                    do_not_optimize(packed.words());
+                });
+                h.run("unpack", kn(k, n), n, [&] {
+                    packed.unpack(0, n, out.data());
+                    do_not_optimize(out.data());
+                });
+                std::vector<std::size_t> counts(c.bucket_count(), 0);
+                h.run("accumulate", kn(k, n), n, [&] {
+                    engine.accumulate(ips.data(), ips.size(), counts.data(), counts.size());
+                    do_not_optimize(counts.data());
+                });
+                h.run("distribution", kn(k, n), n, [&] {
+                    const auto out = engine.distribution(ips);
+                    do_not_optimize(out.data());
+                });
+                // stessa mappatura, iterata a chunk di 64 Ki attraverso tb::Dataset
+                h.run("distribution_dataset", kn(k, n), n, [&] {
+                    auto data = Dataset::view(ips);
+                    const auto out = tb::distribution(engine, data);
+                    do_not_optimize(out.data());
+                });
+                h.run("distribution_weighted", kn(k, n), n, [&] {
+                    const auto out = engine.distribution(ips, weights);
+                    do_not_optimize(out.data());
+                });
+                h.run("distribution_range", kn(k, n), n, [&] {
+                    const auto out = engine.distribution(IPv4{0}, static_cast<IPv4>(n));
+                    do_not_optimize(out.data());
+                });
+            }
+
+            // parse_ipv4 non dipende da k
+            const std::vector<std::string> text = dotted(ips);
+            h.run("parse_ipv4", {{"n", std::to_string(n)}}, n, [&] {
+                IPv4 acc = 0;
+                for (const auto& s : text) acc ^= parse_ipv4(s);
+                do_not_optimize(acc);
+            });
+        }
+
+        // compute_stats lavora sui 2^k contatori, non sugli input
+        for (const unsigned k : cfg.ks) {
+            Config c{};
+            c.k = k;
+            const auto counts = BucketEngine{c}.distribution(random_ips(std::size_t{1} << 16, 9));
+            h.run("compute_stats", {{"k", std::to_string(k)}}, counts.size(), [&] {
+                const StatsResult s = compute_stats(counts);
+                do_not_optimize(s.chi2);
+            });
+        }
+    }
+
+}
@@ -0,0 +1,466 @@
+#include "ingest.hpp"
+
+#include "tb/bucket_engine.hpp"
+#include "tb/ingest.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+namespace tb::bench {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr std::size_t kBlock = 1u << 20;
+        constexpr std::size_t kPage = 4096;
+
+        double seconds(Clock::time_point a, Clock::time_point b) {
+            return std::chrono::duration<double>(b - a).count();
+        }
+
+        class Fd {
+        public:
+            explicit Fd(const std::string& path) : fd_{::open(path.c_str(), O_RDONLY | O_CLOEXEC)} {
+                if (fd_ < 0) throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+            }
+            ~Fd() { ::close(fd_); }
+            Fd(const Fd&) = delete;
+            Fd& operator=(const Fd&) = delete;
+            [[nodiscard]] int get() const noexcept { return fd_; }
+
+        private:
+            int fd_;
+        };
+
+        class Mapping {
+        public:
+            Mapping(int fd, std::uint64_t size) : size_{static_cast<std::size_t>(size)} {
+                if (size_ == 0) return;
+                void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) throw std::runtime_error(std::string("mmap: ") + std::strerror(errno));
+                data_ = static_cast<const char*>(p);
+            }
+            ~Mapping() {
+                if (data_ != nullptr) ::munmap(const_cast<char*>(data_), size_);
+            }
+            Mapping(const Mapping&) = delete;
+            Mapping& operator=(const Mapping&) = delete;
+            [[nodiscard]] const char* data() const noexcept { return data_; }
+
+        private:
+            const char* data_ = nullptr;
+            std::size_t size_;
+        };
+
+        // le pagine pulite (il corpus è fsync'ato) lasciano la page cache
+        void drop_cache(const std::string& path) {
+            const Fd fd{path};
+            ::posix_fadvise(fd.get(), 0, 0, POSIX_FADV_DONTNEED);
+        }
+
+        void warm_cache(const std::string& path) {
+            const Fd fd{path};
+            std::vector<char> buf(kBlock);
+            while (::read(fd.get(), buf.data(), buf.size()) > 0) {}
+        }
+
+        // frazione del file presente in page cache
+        double residency(const std::string& path, std::uint64_t size) {
+            if (size == 0) return 1.0;
+            const Fd fd{path};
+            const Mapping map{fd.get(), size};
+            const std::size_t pages = static_cast<std::size_t>((size + kPage - 1) / kPage);
+            std::vector<unsigned char> vec(pages);
+            if (::mincore(const_cast<char*>(map.data()), static_cast<std::size_t>(size), vec.data()) != 0) return -1.0;
+            const auto resident = std::count_if(vec.begin(), vec.end(), [](unsigned char v) { return (v & 1u) != 0; });
+            return static_cast<double>(resident) / static_cast<double>(pages);
+        }
+
+        struct RunStats {
+            double wall_s = 0.0;
+            std::array<double, kIngestStages> stage_s{};
+            std::vector<std::size_t> counts;
+            std::uint64_t addresses = 0;
+        };
+
+        // stato di un thread: parse -> bucket_index -> istogramma locale, ogni fase cronometrata
+        class Pipeline {
+        public:
+            Pipeline(const BucketEngine& engine, const IngestOptions& opt)
+                : engine_{engine}, parser_{opt}, counts_(engine.config().bucket_count(), 0) {}
+
+            void consume(const char* data, std::size_t n) {
+                const auto t0 = Clock::now();
+                ips_.clear();
+                parser_.feed(data, n, ips_);
+                const auto t1 = Clock::now();
+                process(t0, t1);
+            }
+
+            void finish() {
+                const auto t0 = Clock::now();
+                ips_.clear();
+                parser_.finish(ips_);
+                const auto t1 = Clock::now();
+                process(t0, t1);
+            }
+
+            void add_io(Clock::time_point a, Clock::time_point b) { stage(IngestStage::Io) += seconds(a, b); }
+
+            std::array<double, kIngestStages> stage_s{};
+            std::uint64_t addresses = 0;
+            const std::vector<std::size_t>& counts() const noexcept { return counts_; }
+
+        private:
+            double& stage(IngestStage s) { return stage_s[static_cast<std::size_t>(s)]; }
+
+            void process(Clock::time_point t0, Clock::time_point t1) {
+                idx_.resize(ips_.size());
+                for (std::size_t i = 0; i < ips_.size(); ++i) idx_[i] = engine_.bucket_index(ips_[i]);
+                const auto t2 = Clock::now();
+                for (const BucketIndex b : idx_) counts_[b] += 1;
+                const auto t3 = Clock::now();
+                addresses += ips_.size();
+                stage(IngestStage::Parse) += seconds(t0, t1);
+                stage(IngestStage::Bucketize) += seconds(t1, t2);
+                stage(IngestStage::Aggregate) += seconds(t2, t3);
+            }
+
+            const BucketEngine& engine_;
+            Ipv4Parser parser_;
+            std::vector<IPv4> ips_;
+            std::vector<BucketIndex> idx_;
+            std::vector<std::size_t> counts_;
+        };
+
+        /// I record che iniziano in [begin, end): stessa regola di accumulate_ipv4_range.
+        /// `fetch(pos, n)` restituisce n byte del file a partire da pos.
+        template <class Fetch>
+        void process_range(Fetch& fetch, std::uint64_t begin, std::uint64_t end, std::uint64_t size,
+                           bool lines, Pipeline& pl) {
+            std::uint64_t pos = begin;
+            bool skip = lines && begin > 0;   // la riga a cavallo di begin appartiene al range precedente
+            if (skip) pos = begin - 1;
+            bool tail = false;                // range finito, manca la fine dell'ultimo record
+            while (pos < size) {
+                const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(kBlock, size - pos));
+                const auto t0 = Clock::now();
+                const char* const p = fetch(pos, n);
+                pl.add_io(t0, Clock::now());
+                const char* b = p;
+                const char* const e = p + n;
+
+                if (skip) {
+                    const auto* nl = static_cast<const char*>(std::memchr(b, '\n', n));
+                    if (nl == nullptr) {
+                        pos += n;
+                        continue;
+                    }
+                    b = nl + 1;
+                    skip = false;
+                }
+                if (tail) {
+                    const auto* nl = static_cast<const char*>(std::memchr(b, '\n', static_cast<std::size_t>(e - b)));
+                    if (nl != nullptr) {
+                        pl.consume(b, static_cast<std::size_t>(nl + 1 - b));
+                        break;
+                    }
+                    pl.consume(b, static_cast<std::size_t>(e - b));
+                    pos += n;
+                    continue;
+                }
+                if (pos + n >= end) {
+                    const char* const limit = p + (end - pos);
+                    if (b >= limit) break;
+                    if (!lines) {
+                        pl.consume(b, static_cast<std::size_t>(limit - b));
+                        break;
+                    }
+                    const auto* nl = static_cast<const char*>(
+                        std::memchr(limit - 1, '\n', static_cast<std::size_t>(e - (limit - 1))));
+                    if (nl != nullptr) {
+                        pl.consume(b, static_cast<std::size_t>(nl + 1 - b));
+                        break;
+                    }
+                    tail = true;
+                }
+                pl.consume(b, static_cast<std::size_t>(e - b));
+                pos += n;
+            }
+            pl.finish();
+        }
+
+        RunStats run_once(const CorpusFile& corpus, ReaderKind reader, unsigned threads, const BucketEngine& engine) {
+            const IngestOptions base = corpus_ingest_options(corpus.kind);
+            RunStats rs;
+            std::vector<std::unique_ptr<Pipeline>> pipes;
+            const auto t0 = Clock::now();
+
+            if (corpus.kind == CorpusKind::Gzip) {
+                // flusso compresso: un solo lettore sequenziale, I/O comprende l'inflate
+                pipes.push_back(std::make_unique<Pipeline>(engine, base));
+                Pipeline& pl = *pipes.back();
+                InputReader in{corpus.path};
+                std::vector<char> buf(kBlock);
+                for (;;) {
+                    const auto a = Clock::now();
+                    const std::size_t n = in.read(buf.data(), buf.size());
+                    pl.add_io(a, Clock::now());
+                    if (n == 0) break;
+                    pl.consume(buf.data(), n);
+                }
+                pl.finish();
+            } else {
+                const Fd fd{corpus.path};
+                const std::uint64_t size = corpus.bytes;
+                const bool lines = corpus.kind != CorpusKind::Binary;
+                std::unique_ptr<Mapping> map;
+                if (reader == ReaderKind::Mmap) {
+                    map = std::make_unique<Mapping>(fd.get(), size);
+                    if (size > 0) ::madvise(const_cast<char*>(map->data()), static_cast<std::size_t>(size), MADV_SEQUENTIAL);
+                }
+
+                // range contigui; per il binario allineati ai record da 4 byte
+                std::uint64_t chunk = (size + threads - 1) / threads;
+                if (!lines) chunk = (chunk + 3) & ~std::uint64_t{3};
+                std::vector<std::thread> workers;
+                std::vector<std::exception_ptr> errors(threads);
+                for (unsigned t = 0; t < threads; ++t) {
+                    IngestOptions opt = base;
+                    const std::uint64_t begin = std::min(size, t * chunk);
+                    const std::uint64_t end = std::min(size, begin + chunk);
+                    opt.csv_header = (begin == 0);
+                    pipes.push_back(std::make_unique<Pipeline>(engine, opt));
+                    Pipeline* pl = pipes.back().get();
+                    workers.emplace_back([&, pl, begin, end, t] {
+                        try {
+                            if (map) {
+                                const char* base_ptr = map->data();
+                                auto fetch = [base_ptr](std::uint64_t pos, std::size_t n) {
+                                    // I/O = fault delle pagine del blocco
+                                    const char* p = base_ptr + pos;
+                                    unsigned sum = 0;
+                                    for (std::size_t off = 0; off < n; off += kPage) sum += static_cast<unsigned char>(p[off]);
+                                    do_not_optimize(sum);
+                                    return p;
+                                };
+                                process_range(fetch, begin, end, size, lines, *pl);
+                            } else {
+                                std::vector<char> buf(kBlock);
+                                const int f = fd.get();
+                                auto fetch = [&buf, f](std::uint64_t pos, std::size_t n) -> const char* {
+                                    std::size_t got = 0;
+                                    while (got < n) {
+                                        const ssize_t r = ::pread(f, buf.data() + got, n - got,
+                                                                  static_cast<off_t>(pos + got));
+                                        if (r < 0 && errno == EINTR) continue;
+                                        if (r <= 0) throw std::runtime_error("pread: short read");
+                                        got += static_cast<std::size_t>(r);
+                                    }
+                                    return buf.data();
+                                };
+                                process_range(fetch, begin, end, size, lines, *pl);
+                            }
+                        } catch (...) {
+                            errors[t] = std::current_exception();
+                        }
+                    });
+                }
+                for (auto& w : workers) w.join();
+                for (const auto& e : errors) {
+                    if (e) std::rethrow_exception(e);
+                }
+            }
+
+            // riduzione degli istogrammi per thread
+            const auto m0 = Clock::now();
+            rs.counts.assign(engine.config().bucket_count(), 0);
+            for (const auto& pl : pipes) {
+                const auto& c = pl->counts();
+                for (std::size_t i = 0; i < c.size(); ++i) rs.counts[i] += c[i];
+                rs.addresses += pl->addresses;
+                for (std::size_t s = 0; s < kIngestStages; ++s) rs.stage_s[s] += pl->stage_s[s];
+            }
+            const auto m1 = Clock::now();
+            rs.stage_s[static_cast<std::size_t>(IngestStage::Aggregate)] += seconds(m0, m1);
+            rs.wall_s = seconds(t0, m1);
+            return rs;
+        }
+
+        std::vector<unsigned> default_threads() {
+            const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+            return hw > 1 ? std::vector<unsigned>{1, hw} : std::vector<unsigned>{1};
+        }
+    }
+
+    const char* reader_kind_name(ReaderKind r) noexcept {
+        return r == ReaderKind::Read ? "read" : "mmap";
+    }
+
+    ReaderKind parse_reader_kind(const std::string& name) {
+        if (name == "read") return ReaderKind::Read;
+        if (name == "mmap") return ReaderKind::Mmap;
+        throw std::runtime_error("Unknown reader: '" + name + "' (expected read or mmap)");
+    }
+
+    const char* cache_mode_name(CacheMode c) noexcept {
+        return c == CacheMode::Cold ? "cold" : "warm";
+    }
+
+    CacheMode parse_cache_mode(const std::string& name) {
+        if (name == "cold") return CacheMode::Cold;
+        if (name == "warm") return CacheMode::Warm;
+        throw std::runtime_error("Unknown cache mode: '" + name + "' (expected cold or warm)");
+    }
+
+    std::string IngestResult::id() const {
+        return std::string("ingest/") + corpus_kind_name(kind) + "/" + reader_kind_name(reader) +
+               "/t=" + std::to_string(threads) + "/" + cache_mode_name(cache);
+    }
+
+    std::vector<IngestResult> run_ingest_suite(const IngestConfig& cfg, std::ostream& log) {
+        const BucketEngine engine{cfg.engine};
+        const std::vector<unsigned> threads = cfg.threads.empty() ? default_threads() : cfg.threads;
+        std::vector<IngestResult> results;
+
+        for (const CorpusKind kind : cfg.kinds) {
+            // si genera il corpus solo se almeno una combinazione è selezionata
+            std::vector<IngestResult> todo;
+            for (const ReaderKind reader : cfg.readers) {
+                for (const unsigned t : threads) {
+                    for (const CacheMode cache : cfg.caches) {
+                        IngestResult r;
+                        r.kind = kind;
+                        r.reader = reader;
+                        r.threads = t;
+                        r.cache = cache;
+                        if (!cfg.filter.empty() && r.id().find(cfg.filter) == std::string::npos) continue;
+                        if (kind == CorpusKind::Gzip && (reader != ReaderKind::Read || t != 1)) {
+                            log << "skip " << r.id() << ": gzip is decoded by one sequential reader\n";
+                            continue;
+                        }
+                        todo.push_back(r);
+                    }
+                }
+            }
+            if (todo.empty()) continue;
+            if (kind == CorpusKind::Gzip && !gzip_supported()) {
+                log << "skip ingest/gzip: tb_io built without zlib\n";
+                continue;
+            }
+
+            log << "corpus " << corpus_kind_name(kind) << " (" << (cfg.corpus_bytes >> 20) << " MiB) ..." << std::flush;
+            const CorpusFile corpus = ensure_corpus(cfg.corpus_dir, kind, cfg.corpus_bytes);
+            log << " " << corpus.path << "\n";
+
+            std::vector<std::size_t> reference;
+            for (IngestResult& r : todo) {
+                r.file_bytes = corpus.bytes;
+                r.addresses = corpus.addresses;
+                if (r.cache == CacheMode::Warm) warm_cache(corpus.path);
+
+                std::vector<RunStats> runs;
+                std::vector<double> resident;
+                for (unsigned rep = 0; rep < std::max(1u, cfg.repetitions); ++rep) {
+                    if (r.cache == CacheMode::Cold) drop_cache(corpus.path);
+                    resident.push_back(residency(corpus.path, corpus.bytes));
+                    RunStats rs = run_once(corpus, r.reader, r.threads, engine);
+                    if (rs.addresses != corpus.addresses) {
+                        throw std::runtime_error(r.id() + ": read " + std::to_string(rs.addresses) +
+                                                 " addresses, corpus has " + std::to_string(corpus.addresses));
+                    }
+                    if (reference.empty()) {
+                        reference = rs.counts;
+                    } else if (rs.counts != reference) {
+                        throw std::runtime_error(r.id() + ": histogram differs from the first run");
+                    }
+                    rs.counts.clear();
+                    r.wall_s.push_back(rs.wall_s);
+                    runs.push_back(std::move(rs));
+                }
+
+                // fasi e residenza della ripetizione mediana
+                std::vector<std::size_t> order(runs.size());
+                for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+                std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return runs[a].wall_s < runs[b].wall_s; });
+                const std::size_t mid = order[order.size() / 2];
+                r.median_wall_s = median(r.wall_s);
+                r.stage_s = runs[mid].stage_s;
+                r.resident = resident[mid];
+                results.push_back(r);
+            }
+        }
+        return results;
+    }
+
+    void print_ingest_table(std::ostream& os, const std::vector<IngestResult>& results) {
+        std::size_t width = 9;
+        for (const auto& r : results) width = std::max(width, r.id().size());
+
+        os << std::left << std::setw(static_cast<int>(width)) << "benchmark" << std::right
+           << std::setw(9) << "MiB" << std::setw(8) << "cache%" << std::setw(10) << "wall s"
+           << std::setw(9) << "GB/s" << std::setw(10) << "Maddr/s"
+           << std::setw(7) << "io%" << std::setw(8) << "parse%" << std::setw(9) << "bucket%" << std::setw(8) << "aggr%"
+           << "\n";
+        for (const auto& r : results) {
+            double total = 0.0;
+            for (const double s : r.stage_s) total += s;
+            auto pct = [&](IngestStage s) { return total > 0.0 ? 100.0 * r.stage_s[static_cast<std::size_t>(s)] / total : 0.0; };
+            os << std::left << std::setw(static_cast<int>(width)) << r.id() << std::right << std::fixed
+               << std::setprecision(0) << std::setw(9) << static_cast<double>(r.file_bytes) / (1 << 20)
+               << std::setw(8) << 100.0 * r.resident
+               << std::setprecision(3) << std::setw(10) << r.median_wall_s
+               << std::setprecision(2) << std::setw(9) << r.gb_per_second()
+               << std::setprecision(1) << std::setw(10) << r.addresses_per_second() / 1e6
+               << std::setw(7) << pct(IngestStage::Io) << std::setw(8) << pct(IngestStage::Parse)
+               << std::setw(9) << pct(IngestStage::Bucketize) << std::setw(8) << pct(IngestStage::Aggregate)
+               << "\n";
+        }
+    }
+
+    void write_ingest_json(std::ostream& os, const RunContext& ctx, const std::vector<IngestResult>& results) {
+        static const char* const kStageNames[kIngestStages] = {"io", "parse", "bucketize", "aggregate"};
+        os << "{\n"
+           << "  \"tool\": \"tb_bench\",\n"
+           << "  \"format\": 1,\n"
+           << "  \"mode\": \"ingest\",\n";
+        write_json_context(os, ctx);
+        os << "  \"ingest\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const IngestResult& r = results[i];
+            os << (i ? "," : "") << "\n    {\n"
+               << "      \"id\": \"" << json_escape(r.id()) << "\",\n"
+               << "      \"format\": \"" << corpus_kind_name(r.kind) << "\",\n"
+               << "      \"reader\": \"" << reader_kind_name(r.reader) << "\",\n"
+               << "      \"threads\": " << r.threads << ",\n"
+               << "      \"cache\": \"" << cache_mode_name(r.cache) << "\",\n"
+               << "      \"file_bytes\": " << r.file_bytes << ",\n"
+               << "      \"addresses\": " << r.addresses << ",\n"
+               << "      \"resident\": " << json_number(r.resident) << ",\n"
+               << "      \"median_wall_s\": " << json_number(r.median_wall_s) << ",\n"
+               << "      \"gb_per_second\": " << json_number(r.gb_per_second()) << ",\n"
+               << "      \"addresses_per_second\": " << json_number(r.addresses_per_second()) << ",\n"
+               << "      \"stage_thread_s\": {";
+            for (std::size_t s = 0; s < kIngestStages; ++s) {
+                os << (s ? ", " : "") << "\"" << kStageNames[s] << "\": " << json_number(r.stage_s[s]);
+            }
+            os << "},\n"
+               << "      \"samples_wall_s\": ";
+            write_json_array(os, r.wall_s);
+            os << "\n    }";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+}
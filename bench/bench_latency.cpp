@@ -0,0 +1,298 @@
+#include "latency.hpp"
+
+#include "tb/bucket_engine.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace tb::bench {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr std::size_t kPool = 1024;   // batch di input per thread, riusati a rotazione
+
+        // inizio/fine della regione misurata, in tick della sorgente scelta a compile time
+        inline std::uint64_t tick_begin() noexcept {
+#if TB_BENCH_HAVE_TSC
+            return read_tsc();
+#else
+            return static_cast<std::uint64_t>(Clock::now().time_since_epoch().count());
+#endif
+        }
+
+        inline std::uint64_t tick_end() noexcept {
+#if TB_BENCH_HAVE_TSC
+            return read_tscp();
+#else
+            return static_cast<std::uint64_t>(Clock::now().time_since_epoch().count());
+#endif
+        }
+
+        // stesso hash di BucketEngine::bucket_index, visibile al compilatore (k <= 24 nel bench)
+        struct InlineAffine {
+            std::uint32_t a;
+            std::uint32_t b;
+            unsigned shift;
+
+            explicit InlineAffine(const Config& c) : a{c.a}, b{c.b}, shift{32u - c.k} {}
+
+            BucketIndex operator()(IPv4 ip) const noexcept {
+                return static_cast<BucketIndex>(static_cast<std::uint64_t>(a * ip + b) >> shift);
+            }
+        };
+
+        template <class Fn>
+        void time_calls(HdrHistogram& hist, std::uint64_t warmup, std::uint64_t samples, Fn&& fn) {
+            for (std::uint64_t i = 0; i < warmup + samples; ++i) {
+                const std::uint64_t t0 = tick_begin();
+                fn(i);
+                const std::uint64_t t1 = tick_end();
+                if (i >= warmup) hist.record(t1 - t0);
+            }
+        }
+
+        struct Shared {
+            const BucketEngine* engine;
+            InlineAffine inline_hash;
+            std::unique_ptr<std::atomic<std::size_t>[]> histogram;
+            std::size_t buckets;
+        };
+
+        void run_worker(LatencyOp op, std::size_t batch, const LatencyConfig& cfg, Shared& shared,
+                        unsigned seed, HdrHistogram& hist) {
+            std::mt19937 rng{seed};
+            std::vector<std::vector<IPv4>> pool(kPool, std::vector<IPv4>(batch));
+            for (auto& v : pool) {
+                for (auto& ip : v) ip = rng();
+            }
+            std::vector<BucketIndex> out(batch);
+            std::vector<std::size_t> counts(shared.buckets, 0);
+            const BucketEngine& engine = *shared.engine;
+            const InlineAffine hash = shared.inline_hash;
+            const std::uint64_t warmup = std::clamp<std::uint64_t>(cfg.samples / 10, 100, 10000);
+
+            switch (op) {
+                case LatencyOp::Empty:
+                    time_calls(hist, warmup, cfg.samples, [&](std::uint64_t i) { do_not_optimize(i); });
+                    break;
+                case LatencyOp::Bucketize:
+                    time_calls(hist, warmup, cfg.samples, [&](std::uint64_t i) {
+                        const auto r = engine.bucketize(pool[i % kPool]);
+                        do_not_optimize(r.data());
+                    });
+                    break;
+                case LatencyOp::BucketizeInto:
+                    time_calls(hist, warmup, cfg.samples, [&](std::uint64_t i) {
+                        const auto& in = pool[i % kPool];
+                        engine.bucketize(in.data(), in.size(), out.data());
+                        do_not_optimize(out.data());
+                    });
+                    break;
+                case LatencyOp::BucketIndex:
+                    time_calls(hist, warmup, cfg.samples, [&](std::uint64_t i) {
+                        const auto& in = pool[i % kPool];
+                        for (std::size_t j = 0; j < batch; ++j) out[j] = engine.bucket_index(in[j]);
+                        do_not_optimize(out.data());
+                    });
+                    break;
+                case LatencyOp::Inline:
+                    time_calls(hist, warmup, cfg.samples, [&](std::uint64_t i) {
+                        const auto& in = pool[i % kPool];
+                        for (std::size_t j = 0; j < batch; ++j) out[j] = hash(in[j]);
+                        do_not_optimize(out.data());
+                    });
+                    break;
+                case LatencyOp::Distribution:
+                    time_calls(hist, warmup, cfg.samples, [&](std::uint64_t i) {
+                        const auto r = engine.distribution(pool[i % kPool]);
+                        do_not_optimize(r.data());
+                    });
+                    break;
+                case LatencyOp::Accumulate:
+                    time_calls(hist, warmup, cfg.samples, [&](std::uint64_t i) {
+                        const auto& in = pool[i % kPool];
+                        engine.accumulate(in.data(), in.size(), counts.data(), counts.size());
+                        do_not_optimize(counts.data());
+                    });
+                    break;
+                case LatencyOp::SharedAccumulate:
+                    time_calls(hist, warmup, cfg.samples, [&](std::uint64_t i) {
+                        for (const IPv4 ip : pool[i % kPool]) {
+                            shared.histogram[engine.bucket_index(ip)].fetch_add(1, std::memory_order_relaxed);
+                        }
+                    });
+                    break;
+                case LatencyOp::Count:
+                    break;
+            }
+        }
+
+        // t thread partono insieme: nessuno misura mentre gli altri stanno ancora preparando gli input
+        HdrHistogram run_combination(LatencyOp op, std::size_t batch, unsigned threads, const LatencyConfig& cfg,
+                                     Shared& shared) {
+            std::vector<HdrHistogram> hists(threads);
+            std::vector<std::exception_ptr> errors(threads);
+            std::atomic<unsigned> ready{0};
+            std::vector<std::thread> pool;
+            pool.reserve(threads);
+            for (unsigned t = 0; t < threads; ++t) {
+                pool.emplace_back([&, t] {
+                    try {
+                        ready.fetch_add(1);
+                        while (ready.load() < threads) std::this_thread::yield();
+                        run_worker(op, batch, cfg, shared, 1234u + t, hists[t]);
+                    } catch (...) {
+                        errors[t] = std::current_exception();
+                    }
+                });
+            }
+            for (auto& th : pool) th.join();
+            for (const auto& e : errors) {
+                if (e) std::rethrow_exception(e);
+            }
+            for (unsigned t = 1; t < threads; ++t) hists[0].merge(hists[t]);
+            return std::move(hists[0]);
+        }
+    }
+
+    const char* latency_op_name(LatencyOp op) noexcept {
+        switch (op) {
+            case LatencyOp::Empty: return "empty";
+            case LatencyOp::Bucketize: return "bucketize";
+            case LatencyOp::BucketizeInto: return "bucketize_into";
+            case LatencyOp::BucketIndex: return "bucket_index";
+            case LatencyOp::Inline: return "inline";
+            case LatencyOp::Distribution: return "distribution";
+            case LatencyOp::Accumulate: return "accumulate";
+            case LatencyOp::SharedAccumulate: return "shared_accumulate";
+            case LatencyOp::Count: break;
+        }
+        return "?";
+    }
+
+    bool latency_op_allocates(LatencyOp op) noexcept {
+        return op == LatencyOp::Bucketize || op == LatencyOp::Distribution;
+    }
+
+    std::string LatencyResult::id() const {
+        return std::string("latency/") + latency_op_name(op) + "/b=" + std::to_string(batch) +
+               "/t=" + std::to_string(threads);
+    }
+
+    LatencyClock latency_clock() {
+#if TB_BENCH_HAVE_TSC
+        // tick TSC contro steady_clock su ~50 ms
+        const auto w0 = Clock::now();
+        const std::uint64_t c0 = read_tsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const std::uint64_t c1 = read_tscp();
+        const auto w1 = Clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(w1 - w0).count();
+        if (c1 > c0) return {"rdtscp", ns / static_cast<double>(c1 - c0)};
+#endif
+        constexpr double kNsPerTick = 1e9 * Clock::period::num / Clock::period::den;
+        return {"steady_clock", kNsPerTick};
+    }
+
+    std::vector<LatencyResult> run_latency_suite(const LatencyConfig& cfg, const LatencyClock& clock) {
+        std::vector<unsigned> threads = cfg.threads;
+        if (threads.empty()) {
+            threads = {1u};
+            const unsigned hw = std::thread::hardware_concurrency();
+            if (hw > 1) threads.push_back(hw);
+        }
+
+        Config c{};
+        c.k = cfg.k;
+        const BucketEngine engine{c};
+        Shared shared{&engine, InlineAffine{c}, nullptr, c.bucket_count()};
+        // la variante inline deve calcolare esattamente lo stesso bucket
+        for (std::uint32_t ip = 0; ip < 4096; ++ip) {
+            const IPv4 x = ip * 0x9E3779B1u;
+            if (shared.inline_hash(x) != engine.bucket_index(x)) {
+                throw std::runtime_error("latency: inline hash disagrees with BucketEngine::bucket_index");
+            }
+        }
+
+        std::vector<LatencyResult> results;
+        for (std::size_t o = 0; o < kLatencyOps; ++o) {
+            const auto op = static_cast<LatencyOp>(o);
+            for (const std::size_t batch : cfg.batches) {
+                for (const unsigned t : threads) {
+                    LatencyResult r;
+                    r.op = op;
+                    r.batch = batch;
+                    r.threads = t;
+                    r.ns_per_tick = clock.ns_per_tick;
+                    if (!cfg.filter.empty() && r.id().find(cfg.filter) == std::string::npos) continue;
+
+                    shared.histogram.reset(new std::atomic<std::size_t>[shared.buckets]);
+                    for (std::size_t b = 0; b < shared.buckets; ++b) shared.histogram[b].store(0);
+                    r.ticks = run_combination(op, batch, t, cfg, shared);
+                    results.push_back(std::move(r));
+                }
+            }
+        }
+        return results;
+    }
+
+    void print_latency_table(std::ostream& os, const std::vector<LatencyResult>& results) {
+        std::size_t width = 9;
+        for (const auto& r : results) width = std::max(width, r.id().size());
+
+        os << std::left << std::setw(static_cast<int>(width)) << "benchmark" << std::right
+           << std::setw(7) << "alloc" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+           << std::setw(10) << "p99.9 ns" << std::setw(11) << "max ns" << std::setw(10) << "mean ns"
+           << std::setw(10) << "ns/addr" << std::setw(10) << "calls" << "\n";
+        for (const auto& r : results) {
+            os << std::left << std::setw(static_cast<int>(width)) << r.id() << std::right
+               << std::setw(7) << (latency_op_allocates(r.op) ? "yes" : "no") << std::fixed << std::setprecision(1)
+               << std::setw(10) << r.ns(50.0) << std::setw(10) << r.ns(99.0) << std::setw(10) << r.ns(99.9)
+               << std::setw(11) << static_cast<double>(r.ticks.max()) * r.ns_per_tick
+               << std::setw(10) << r.ticks.mean() * r.ns_per_tick
+               << std::setprecision(2) << std::setw(10) << r.ns(50.0) / static_cast<double>(r.batch)
+               << std::setw(10) << r.ticks.count() << "\n";
+        }
+    }
+
+    void write_latency_json(std::ostream& os, const RunContext& ctx, const LatencyClock& clock,
+                            const std::vector<LatencyResult>& results) {
+        os << "{\n"
+           << "  \"tool\": \"tb_bench\",\n"
+           << "  \"format\": 1,\n"
+           << "  \"mode\": \"latency\",\n";
+        write_json_context(os, ctx);
+        os << "  \"clock\": {\"source\": \"" << clock.source << "\", \"ns_per_tick\": "
+           << json_number(clock.ns_per_tick) << "},\n"
+           << "  \"latency\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const LatencyResult& r = results[i];
+            os << (i ? "," : "") << "\n    {\n"
+               << "      \"id\": \"" << json_escape(r.id()) << "\",\n"
+               << "      \"op\": \"" << latency_op_name(r.op) << "\",\n"
+               << "      \"allocates\": " << (latency_op_allocates(r.op) ? "true" : "false") << ",\n"
+               << "      \"batch\": " << r.batch << ",\n"
+               << "      \"threads\": " << r.threads << ",\n"
+               << "      \"calls\": " << r.ticks.count() << ",\n"
+               << "      \"min_ns\": " << json_number(static_cast<double>(r.ticks.min()) * r.ns_per_tick) << ",\n"
+               << "      \"p50_ns\": " << json_number(r.ns(50.0)) << ",\n"
+               << "      \"p90_ns\": " << json_number(r.ns(90.0)) << ",\n"
+               << "      \"p99_ns\": " << json_number(r.ns(99.0)) << ",\n"
+               << "      \"p999_ns\": " << json_number(r.ns(99.9)) << ",\n"
+               << "      \"max_ns\": " << json_number(static_cast<double>(r.ticks.max()) * r.ns_per_tick) << ",\n"
+               << "      \"mean_ns\": " << json_number(r.ticks.mean() * r.ns_per_tick) << "\n"
+               << "    }";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+}
@@ -0,0 +1,233 @@
+#include "suites.hpp"
+
+#include "tb/bucket_engine.hpp"
+#include "tb/ingest.hpp"
+#include "tb/presets.hpp"
+#include "tb/stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace tb::bench {
+
+    namespace {
+        struct Dataset {
+            std::string name;
+            std::vector<IPv4> ips;
+        };
+
+        // indirizzi distinti: duplicati renderebbero il chi² sbilanciato per qualsiasi hash
+        std::vector<Dataset> synthetic_datasets(std::size_t n) {
+            std::vector<Dataset> out;
+            std::mt19937 rng{42};
+
+            Dataset uniform{"uniform", std::vector<IPv4>(n)};
+            for (auto& ip : uniform.ips) ip = rng();
+            out.push_back(std::move(uniform));
+
+            Dataset sequential{"sequential", std::vector<IPv4>(n)};   // come --demo
+            for (std::size_t i = 0; i < n; ++i) sequential.ips[i] = static_cast<IPv4>(i);
+            out.push_back(std::move(sequential));
+
+            // /24 interamente popolate, blocchi distinti in ordine pseudo-casuale
+            Dataset subnets{"subnets", std::vector<IPv4>(n)};
+            for (std::size_t i = 0; i < n; ++i) {
+                const auto block = static_cast<IPv4>(((i >> 8) * 0x9E3779B1u) & 0xFFFFFFu);
+                subnets.ips[i] = (block << 8) | static_cast<IPv4>(i & 0xFFu);
+            }
+            out.push_back(std::move(subnets));
+
+            // solo gateway x.y.z.1: i bit bassi non variano
+            Dataset gateways{"gateways", std::vector<IPv4>(n)};
+            for (std::size_t i = 0; i < n; ++i) gateways.ips[i] = (static_cast<IPv4>(i) << 8) | 1u;
+            out.push_back(std::move(gateways));
+
+            // host distinti sparsi in 10.0.0.0/8 (fino a 2^24)
+            Dataset rfc1918{"rfc1918", std::vector<IPv4>(std::min<std::size_t>(n, std::size_t{1} << 24))};
+            for (std::size_t i = 0; i < rfc1918.ips.size(); ++i) {
+                rfc1918.ips[i] = 0x0A000000u | ((static_cast<IPv4>(i) * 0x2C1B3C6Du) & 0xFFFFFFu);
+            }
+            out.push_back(std::move(rfc1918));
+            return out;
+        }
+
+        Dataset user_dataset(const std::string& spec) {
+            std::string path = spec;
+            IngestOptions opt;
+            const auto colon = spec.rfind(':');
+            if (colon != std::string::npos) {
+                // "file:format" solo se il suffisso è un formato noto
+                try {
+                    opt.format = parse_input_format(spec.substr(colon + 1));
+                    path = spec.substr(0, colon);
+                } catch (const std::runtime_error&) {
+                }
+            }
+            Dataset d{path.substr(path.find_last_of('/') + 1), read_ipv4_file(path, opt)};
+            if (d.ips.empty()) throw std::runtime_error("Dataset has no addresses: " + path);
+            return d;
+        }
+
+        std::uint32_t fmix32(std::uint32_t h) noexcept {
+            h ^= h >> 16;
+            h *= 0x85EBCA6Bu;
+            h ^= h >> 13;
+            h *= 0xC2B2AE35u;
+            h ^= h >> 16;
+            return h;
+        }
+
+        // stessa forma di BucketEngine::distribution, per un confronto equo
+        template <class Hash>
+        std::vector<std::size_t> histogram(const std::vector<IPv4>& ips, unsigned k, Hash hash) {
+            std::vector<std::size_t> counts(std::size_t{1} << k, 0);
+            const unsigned shift = 32u - k;
+            for (const IPv4 ip : ips) counts[static_cast<std::uint64_t>(hash(ip)) >> shift] += 1;
+            return counts;
+        }
+
+        double geomean(const std::vector<double>& v) {
+            if (v.empty()) return 0.0;
+            double s = 0.0;
+            for (const double x : v) s += std::log(x);
+            return std::exp(s / static_cast<double>(v.size()));
+        }
+    }
+
+    std::vector<QualityRow> run_quality_suite(Harness& h, const QualityConfig& cfg) {
+        std::vector<Dataset> datasets = synthetic_datasets(cfg.size);
+        for (const auto& f : cfg.files) datasets.push_back(user_dataset(f));
+
+        std::vector<QualityRow> rows;
+        for (const Dataset& d : datasets) {
+            for (const unsigned k : cfg.ks) {
+                if (k == 0 || k > 24) throw std::runtime_error("quality: k must be in [1, 24]");
+                const Params p{{"dataset", d.name}, {"k", std::to_string(k)}, {"n", std::to_string(d.ips.size())}};
+
+                auto measure = [&](const std::string& candidate, bool library, auto&& distribution) {
+                    const std::string name = "quality/" + candidate;
+                    if (!h.selected(name, p)) return;
+                    h.run(name, p, d.ips.size(), [&] {
+                        const auto out = distribution();
+                        do_not_optimize(out.data());
+                    });
+                    QualityRow row;
+                    row.candidate = candidate;
+                    row.library = library;
+                    row.dataset = d.name;
+                    row.k = k;
+                    row.n = d.ips.size();
+                    row.stats = compute_stats(distribution());
+                    row.ns_per_elem = h.results().back().median_ns;
+                    rows.push_back(std::move(row));
+                };
+
+                // la famiglia della libreria, con ogni preset
+                for (const Preset& preset : presets()) {
+                    Config c{};
+                    c.k = k;
+                    apply_preset(c, preset.name);
+                    const BucketEngine engine{c};
+                    measure("affine/" + preset.name, true, [&] { return engine.distribution(d.ips); });
+                }
+                // riferimenti: senza offset, finalizer murmur3, nessun hash
+                const std::uint32_t a = presets().front().a;
+                measure("multiply-shift", false, [&] { return histogram(d.ips, k, [a](IPv4 x) { return a * x; }); });
+                measure("fmix32", false, [&] { return histogram(d.ips, k, [](IPv4 x) { return fmix32(x); }); });
+                measure("identity", false, [&] { return histogram(d.ips, k, [](IPv4 x) { return x; }); });
+            }
+        }
+        return rows;
+    }
+
+    void print_quality_report(std::ostream& os, const std::vector<QualityRow>& rows, const QualityConfig& cfg) {
+        os << "SLO: p-value >= " << cfg.slo_p << ", max_load <= " << cfg.slo_load << " x mean\n";
+
+        // una tabella per (dataset, k), dalla più veloce
+        std::map<std::pair<std::string, unsigned>, std::vector<const QualityRow*>> groups;
+        std::vector<std::pair<std::string, unsigned>> order;
+        for (const auto& r : rows) {
+            auto& g = groups[{r.dataset, r.k}];
+            if (g.empty()) order.emplace_back(r.dataset, r.k);
+            g.push_back(&r);
+        }
+        for (const auto& key : order) {
+            auto g = groups[key];
+            std::stable_sort(g.begin(), g.end(), [](const QualityRow* x, const QualityRow* y) { return x->ns_per_elem < y->ns_per_elem; });
+            os << "\n" << key.first << " (n=" << g.front()->n << ", k=" << key.second << ")\n"
+               << std::left << std::setw(18) << "  candidate" << std::right << std::setw(10) << "Melem/s"
+               << std::setw(14) << "chi2" << std::setw(11) << "p-value" << std::setw(10) << "max/mean"
+               << std::setw(11) << "uniform %" << "  SLO\n";
+            for (const QualityRow* r : g) {
+                os << "  " << std::left << std::setw(16) << r->candidate << std::right << std::fixed
+                   << std::setprecision(1) << std::setw(10) << (r->ns_per_elem > 0.0 ? 1e3 / r->ns_per_elem : 0.0)
+                   << std::setprecision(1) << std::setw(14) << r->stats.chi2
+                   << std::scientific << std::setprecision(2) << std::setw(11) << r->stats.p_value << std::fixed
+                   << std::setprecision(2) << std::setw(10) << r->load_ratio()
+                   << std::setprecision(1) << std::setw(11) << r->stats.uniformity
+                   << "  " << (r->meets(cfg) ? "ok" : "FAIL") << "\n";
+            }
+        }
+
+        struct Summary {
+            std::string candidate;
+            bool library = false;
+            std::size_t passed = 0;
+            std::size_t total = 0;
+            double worst_p = 1.0;
+            double worst_load = 0.0;
+            std::vector<double> rates;
+        };
+        std::vector<Summary> sums;
+        for (const auto& r : rows) {
+            auto it = std::find_if(sums.begin(), sums.end(), [&](const Summary& s) { return s.candidate == r.candidate; });
+            if (it == sums.end()) {
+                Summary s;
+                s.candidate = r.candidate;
+                s.library = r.library;
+                sums.push_back(std::move(s));
+                it = std::prev(sums.end());
+            }
+            it->total += 1;
+            it->passed += r.meets(cfg) ? 1 : 0;
+            it->worst_p = std::min(it->worst_p, r.stats.p_value);
+            it->worst_load = std::max(it->worst_load, r.load_ratio());
+            if (r.ns_per_elem > 0.0) it->rates.push_back(1e3 / r.ns_per_elem);
+        }
+        // prima chi rispetta lo SLO ovunque, poi per throughput (media geometrica sui dataset)
+        std::stable_sort(sums.begin(), sums.end(), [](const Summary& x, const Summary& y) {
+            const bool xa = x.passed == x.total;
+            const bool ya = y.passed == y.total;
+            if (xa != ya) return xa;
+            if (!xa && x.passed != y.passed) return x.passed > y.passed;
+            return geomean(x.rates) > geomean(y.rates);
+        });
+
+        os << "\nRanking (geometric mean throughput over datasets and k)\n"
+           << std::left << std::setw(22) << "  # candidate" << std::right << std::setw(10) << "Melem/s"
+           << std::setw(10) << "SLO met" << std::setw(11) << "worst p" << std::setw(12) << "worst load" << "\n";
+        for (std::size_t i = 0; i < sums.size(); ++i) {
+            const Summary& s = sums[i];
+            os << "  " << std::left << std::setw(2) << (i + 1) << std::setw(18) << s.candidate << std::right << std::fixed
+               << std::setprecision(1) << std::setw(10) << geomean(s.rates)
+               << std::setw(10) << (std::to_string(s.passed) + "/" + std::to_string(s.total))
+               << std::scientific << std::setprecision(2) << std::setw(11) << s.worst_p << std::fixed
+               << std::setprecision(2) << std::setw(12) << s.worst_load
+               << (s.library ? "" : "  (reference, not in tb_core)") << "\n";
+        }
+        const auto best = std::find_if(sums.begin(), sums.end(), [](const Summary& s) {
+            return s.library && s.passed == s.total;
+        });
+        if (best != sums.end()) {
+            os << "\nRecommended: " << best->candidate << "\n";
+        } else {
+            os << "\nNo library preset meets the SLO on every dataset\n";
+        }
+    }
+
+}
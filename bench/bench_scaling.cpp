@@ -0,0 +1,140 @@
+#include "suites.hpp"
+
+#include "tb/bucket_engine.hpp"
+#include "tb/parallel.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace tb::bench {
+
+    namespace {
+        // fn(begin, end) su parti contigue di [0, n), una per thread (il chiamante esegue la prima)
+        template <class Fn>
+        void parallel_for(unsigned threads, std::size_t n, Fn&& fn) {
+            auto part = [&](unsigned t) { return (n / threads) * t + (n % threads) * t / threads; };
+            std::vector<std::thread> pool;
+            pool.reserve(threads - 1);
+            for (unsigned t = 1; t < threads; ++t) {
+                pool.emplace_back([&, t] { fn(part(t), part(t + 1)); });
+            }
+            fn(part(0), part(1));
+            for (auto& th : pool) th.join();
+        }
+
+        std::vector<unsigned> default_threads() {
+            const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+            std::vector<unsigned> out;
+            for (unsigned t = 1; t < hw; t *= 2) out.push_back(t);
+            out.push_back(hw);
+            return out;
+        }
+
+        void run_stream(Harness& h, const std::vector<unsigned>& threads, std::size_t bytes) {
+            const std::size_t n = std::max<std::size_t>(1, bytes / sizeof(double));
+            // prima scrittura con la stessa partizione dei kernel: pagine sul nodo NUMA del thread
+            const unsigned init_threads = *std::max_element(threads.begin(), threads.end());
+            std::unique_ptr<double[]> a{new double[n]};
+            std::unique_ptr<double[]> b{new double[n]};
+            std::unique_ptr<double[]> c{new double[n]};
+            parallel_for(init_threads, n, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i) {
+                    a[i] = 1.0;
+                    b[i] = 2.0;
+                    c[i] = 0.5;
+                }
+            });
+
+            for (const unsigned t : threads) {
+                const Params p{{"t", std::to_string(t)}};
+                h.run("stream/copy", p, n, [&] {
+                    parallel_for(t, n, [&](std::size_t lo, std::size_t hi) {
+                        for (std::size_t i = lo; i < hi; ++i) c[i] = a[i];
+                    });
+                    do_not_optimize(c[n / 2]);
+                }, 2.0 * sizeof(double));
+                h.run("stream/read", p, n, [&] {
+                    parallel_for(t, n, [&](std::size_t lo, std::size_t hi) {
+                        // quattro accumulatori: la dipendenza della somma non limita la banda
+                        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+                        std::size_t i = lo;
+                        for (; i + 4 <= hi; i += 4) {
+                            s0 += a[i];
+                            s1 += a[i + 1];
+                            s2 += a[i + 2];
+                            s3 += a[i + 3];
+                        }
+                        for (; i < hi; ++i) s0 += a[i];
+                        do_not_optimize(s0 + s1 + s2 + s3);
+                    });
+                }, 1.0 * sizeof(double));
+                h.run("stream/triad", p, n, [&] {
+                    parallel_for(t, n, [&](std::size_t lo, std::size_t hi) {
+                        for (std::size_t i = lo; i < hi; ++i) a[i] = b[i] + 3.0 * c[i];
+                    });
+                    do_not_optimize(a[n / 2]);
+                }, 3.0 * sizeof(double));
+            }
+        }
+    }
+
+    void run_scaling_suite(Harness& h, const ScalingConfig& cfg) {
+        const std::vector<unsigned> threads = cfg.threads.empty() ? default_threads() : cfg.threads;
+        run_stream(h, threads, cfg.stream_bytes);
+
+        for (const std::size_t n : cfg.sizes) {
+            std::mt19937 rng{42};
+            std::vector<IPv4> ips(n);
+            for (auto& ip : ips) ip = rng();
+
+            for (const unsigned k : cfg.ks) {
+                Config c{};
+                c.k = k;
+                const BucketEngine engine{c};
+                for (const HistogramStrategy s : cfg.strategies) {
+                    for (const unsigned t : threads) {
+                        const Params p{{"k", std::to_string(k)}, {"n", std::to_string(n)}, {"t", std::to_string(t)}};
+                        // traffico obbligatorio: 4 byte di input per elemento
+                        h.run(std::string("parallel/") + histogram_strategy_name(s), p, n, [&] {
+                            const auto out = parallel_distribution(engine, ips, t, s);
+                            do_not_optimize(out.data());
+                        }, sizeof(IPv4));
+                    }
+                }
+            }
+        }
+    }
+
+    void write_scaling_csv(std::ostream& os, const std::vector<Result>& results) {
+        std::map<std::string, double> stream_read;   // t -> GB/s
+        for (const auto& r : results) {
+            if (r.name == "stream/read") stream_read[r.param("t")] = r.gb_per_second();
+        }
+
+        os << "benchmark,kind,threads,k,n,ns_per_elem,mad_pct,melem_per_s,bytes_per_elem,gb_per_s,"
+              "stream_read_gb_per_s,pct_of_stream_read\n";
+        for (const auto& r : results) {
+            const std::string t = r.param("t");
+            const std::string kind = r.name.substr(r.name.find('/') + 1);
+            const auto sr = stream_read.find(t);
+            const double ref = sr != stream_read.end() ? sr->second : 0.0;
+            const double mad_pct = r.median_ns > 0.0 ? 100.0 * r.mad_ns / r.median_ns : 0.0;
+            os << r.name.substr(0, r.name.find('/')) << "," << kind << "," << t << "," << r.param("k") << ","
+               << (r.param("n").empty() ? std::to_string(r.elements) : r.param("n")) << ","
+               << std::setprecision(6) << r.median_ns << "," << mad_pct << "," << r.elements_per_second() / 1e6 << ","
+               << r.bytes_per_elem << "," << r.gb_per_second() << ",";
+            if (ref > 0.0) {
+                os << ref << "," << 100.0 * r.gb_per_second() / ref;
+            } else {
+                os << ",";
+            }
+            os << "\n";
+        }
+    }
+
+}
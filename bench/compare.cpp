@@ -0,0 +1,292 @@
+#include "compare.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace tb::bench {
+
+    namespace {
+        // ---------- Parser JSON minimo (solo ciò che scrive write_json) ----------
+        struct Json {
+            enum class Type { Null, Bool, Number, String, Array, Object } type = Type::Null;
+            bool boolean = false;
+            double number = 0.0;
+            std::string str;
+            std::vector<Json> items;
+            std::map<std::string, Json> fields;
+
+            [[nodiscard]] const Json* get(const std::string& key) const {
+                const auto it = fields.find(key);
+                return it == fields.end() ? nullptr : &it->second;
+            }
+        };
+
+        class JsonParser {
+        public:
+            explicit JsonParser(const std::string& text) : s_{text} {}
+
+            Json parse() {
+                Json v = value();
+                skip_ws();
+                if (pos_ != s_.size()) fail("trailing characters");
+                return v;
+            }
+
+        private:
+            [[noreturn]] void fail(const std::string& what) const {
+                throw std::runtime_error("Invalid baseline JSON at offset " + std::to_string(pos_) + ": " + what);
+            }
+
+            void skip_ws() {
+                while (pos_ < s_.size() && std::isspace(static_cast<unsigned char>(s_[pos_]))) ++pos_;
+            }
+
+            bool consume(char c) {
+                skip_ws();
+                if (pos_ < s_.size() && s_[pos_] == c) {
+                    ++pos_;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(char c) {
+                if (!consume(c)) fail(std::string("expected '") + c + "'");
+            }
+
+            Json value() {
+                skip_ws();
+                if (pos_ >= s_.size()) fail("unexpected end");
+                Json v;
+                const char c = s_[pos_];
+                if (c == '{') {
+                    v.type = Json::Type::Object;
+                    ++pos_;
+                    if (consume('}')) return v;
+                    do {
+                        skip_ws();
+                        const std::string key = string();
+                        expect(':');
+                        v.fields[key] = value();
+                    } while (consume(','));
+                    expect('}');
+                } else if (c == '[') {
+                    v.type = Json::Type::Array;
+                    ++pos_;
+                    if (consume(']')) return v;
+                    do {
+                        v.items.push_back(value());
+                    } while (consume(','));
+                    expect(']');
+                } else if (c == '"') {
+                    v.type = Json::Type::String;
+                    v.str = string();
+                } else if (s_.compare(pos_, 4, "true") == 0 || s_.compare(pos_, 5, "false") == 0) {
+                    v.type = Json::Type::Bool;
+                    v.boolean = (c == 't');
+                    pos_ += v.boolean ? 4 : 5;
+                } else if (s_.compare(pos_, 4, "null") == 0) {
+                    pos_ += 4;
+                } else {
+                    v.type = Json::Type::Number;
+                    std::size_t used = 0;
+                    try {
+                        v.number = std::stod(s_.substr(pos_, 32), &used);
+                    } catch (const std::exception&) {
+                        fail("bad number");
+                    }
+                    pos_ += used;
+                }
+                return v;
+            }
+
+            std::string string() {
+                if (pos_ >= s_.size() || s_[pos_] != '"') fail("expected string");
+                ++pos_;
+                std::string out;
+                while (pos_ < s_.size() && s_[pos_] != '"') {
+                    char c = s_[pos_++];
+                    if (c == '\\') {
+                        if (pos_ >= s_.size()) fail("bad escape");
+                        const char e = s_[pos_++];
+                        switch (e) {
+                            case 'n': c = '\n'; break;
+                            case 't': c = '\t'; break;
+                            case 'u':
+                                // solo caratteri di controllo (\u00XX) vengono scritti da write_json
+                                if (pos_ + 4 > s_.size()) fail("bad escape");
+                                c = static_cast<char>(std::stoi(s_.substr(pos_, 4), nullptr, 16));
+                                pos_ += 4;
+                                break;
+                            default: c = e;
+                        }
+                    }
+                    out += c;
+                }
+                if (pos_ >= s_.size()) fail("unterminated string");
+                ++pos_;
+                return out;
+            }
+
+            const std::string& s_;
+            std::size_t pos_ = 0;
+        };
+
+        std::string field_string(const Json& obj, const std::string& key) {
+            const Json* v = obj.get(key);
+            return (v != nullptr && v->type == Json::Type::String) ? v->str : std::string{};
+        }
+
+        const char* verdict_name(Verdict v) {
+            switch (v) {
+                case Verdict::Unchanged: return "same";
+                case Verdict::Regression: return "REGRESSION";
+                case Verdict::Improvement: return "faster";
+                case Verdict::New: return "new";
+            }
+            return "?";
+        }
+
+        double median_of(std::vector<double> v) {
+            if (v.empty()) return 0.0;
+            const auto mid = v.begin() + static_cast<std::ptrdiff_t>(v.size() / 2);
+            std::nth_element(v.begin(), mid, v.end());
+            if (v.size() % 2 == 1) return *mid;
+            return 0.5 * (*mid + *std::max_element(v.begin(), mid));
+        }
+    }
+
+    Baseline load_baseline(const std::string& path) {
+        std::ifstream f{path};
+        if (!f) {
+            throw std::runtime_error("Cannot open baseline " + path);
+        }
+        std::stringstream ss;
+        ss << f.rdbuf();
+        const std::string text = ss.str();
+        const Json root = JsonParser{text}.parse();
+
+        if (field_string(root, "tool") != "tb_bench") {
+            throw std::runtime_error("Not a tb_bench result file: " + path);
+        }
+        Baseline b;
+        if (const Json* ctx = root.get("context")) {
+            b.ctx.cpu = field_string(*ctx, "cpu");
+            b.ctx.compiler = field_string(*ctx, "compiler");
+            b.ctx.build_type = field_string(*ctx, "build_type");
+            b.ctx.timestamp = field_string(*ctx, "timestamp");
+        }
+        const Json* list = root.get("benchmarks");
+        if (list == nullptr || list->type != Json::Type::Array) {
+            throw std::runtime_error("Baseline has no benchmarks array: " + path);
+        }
+        for (const Json& item : list->items) {
+            BaselineEntry e;
+            e.id = field_string(item, "id");
+            if (const Json* m = item.get("median_ns_per_elem")) e.median_ns = m->number;
+            if (const Json* s = item.get("samples_ns_per_elem")) {
+                for (const Json& x : s->items) e.samples.push_back(x.number);
+            }
+            if (e.id.empty()) {
+                throw std::runtime_error("Baseline entry without id: " + path);
+            }
+            b.entries.push_back(std::move(e));
+        }
+        return b;
+    }
+
+    std::vector<BaselineEntry> to_entries(const std::vector<Result>& results) {
+        std::vector<BaselineEntry> out;
+        out.reserve(results.size());
+        for (const Result& r : results) out.push_back(BaselineEntry{r.id(), r.median_ns, r.ns_per_elem});
+        return out;
+    }
+
+    std::vector<Comparison> compare(const Baseline& base, const std::vector<Result>& current,
+                                    const CompareOptions& opt) {
+        return compare_runs(base, {to_entries(current)}, opt);
+    }
+
+    std::vector<Comparison> compare_runs(const Baseline& base,
+                                         const std::vector<std::vector<BaselineEntry>>& runs,
+                                         const CompareOptions& opt) {
+        std::map<std::string, const BaselineEntry*> by_id;
+        for (const auto& e : base.entries) by_id[e.id] = &e;
+
+        std::vector<Comparison> rows;
+        if (runs.empty()) return rows;
+        for (const BaselineEntry& first : runs.front()) {
+            Comparison c;
+            c.id = first.id;
+            c.new_ns = first.median_ns;
+            c.runs = 1;
+            const auto it = by_id.find(c.id);
+            if (it == by_id.end() || it->second->median_ns <= 0.0) {
+                rows.push_back(c);
+                continue;
+            }
+            const BaselineEntry& b = *it->second;
+            c.base_ns = b.median_ns;
+
+            // ogni run è giudicata da sola; il verdetto vale solo se tutte concordano
+            std::vector<double> medians;
+            std::vector<double> changes;
+            unsigned slower = 0;
+            unsigned faster = 0;
+            c.p = 0.0;
+            for (const auto& run : runs) {
+                const auto r = std::find_if(run.begin(), run.end(),
+                                            [&](const BaselineEntry& e) { return e.id == c.id; });
+                if (r == run.end()) continue;
+                const double change = r->median_ns / b.median_ns - 1.0;
+                const double p = mann_whitney(r->samples, b.samples).p;
+                medians.push_back(r->median_ns);
+                changes.push_back(change);
+                c.p = std::max(c.p, p);
+                if (p < opt.alpha && change > opt.threshold) ++slower;
+                if (p < opt.alpha && change < -opt.threshold) ++faster;
+            }
+            c.runs = static_cast<unsigned>(changes.size());
+            c.new_ns = median_of(medians);
+            c.change = median_of(changes);
+
+            if (slower == c.runs) {
+                c.verdict = Verdict::Regression;
+            } else if (faster == c.runs) {
+                c.verdict = Verdict::Improvement;
+            } else {
+                c.verdict = Verdict::Unchanged;
+            }
+            rows.push_back(c);
+        }
+        return rows;
+    }
+
+    void print_comparison(std::ostream& os, const std::vector<Comparison>& rows) {
+        std::size_t width = 9;
+        for (const auto& r : rows) width = std::max(width, r.id.size());
+
+        os << std::left << std::setw(static_cast<int>(width)) << "benchmark" << std::right
+           << std::setw(12) << "base ns" << std::setw(12) << "new ns" << std::setw(10) << "change"
+           << std::setw(10) << "p" << "  verdict\n";
+        for (const auto& r : rows) {
+            os << std::left << std::setw(static_cast<int>(width)) << r.id << std::right << std::fixed;
+            if (r.verdict == Verdict::New) {
+                os << std::setw(12) << "-" << std::setprecision(3) << std::setw(12) << r.new_ns
+                   << std::setw(10) << "-" << std::setw(10) << "-";
+            } else {
+                os << std::setprecision(3) << std::setw(12) << r.base_ns << std::setw(12) << r.new_ns
+                   << std::setprecision(1) << std::setw(9) << 100.0 * r.change << "%"
+                   << std::setprecision(4) << std::setw(10) << r.p;
+            }
+            os << "  " << verdict_name(r.verdict) << "\n";
+        }
+    }
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// Baseline files and statistical comparison of tb_bench runs.
+
+#include "harness.hpp"
+#include "statistics.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tb::bench {
+
+    struct BaselineEntry {
+        std::string id;
+        double median_ns = 0.0;
+        std::vector<double> samples;   // ns per element, one per repetition
+    };
+
+    struct Baseline {
+        RunContext ctx;
+        std::vector<BaselineEntry> entries;
+    };
+
+    /// Load a file written by write_json (--json / --save). Throws std::runtime_error.
+    Baseline load_baseline(const std::string& path);
+
+    struct CompareOptions {
+        double threshold = 0.30;   // relative median change treated as noise
+        double alpha = 0.01;       // significance level of the U test
+    };
+
+    enum class Verdict { Unchanged, Regression, Improvement, New };
+
+    struct Comparison {
+        std::string id;
+        double base_ns = 0.0;
+        double new_ns = 0.0;
+        double change = 0.0;       // new / base - 1
+        double p = 1.0;
+        unsigned runs = 0;         // independent runs that measured the benchmark
+        Verdict verdict = Verdict::New;
+    };
+
+    /// The part of a run compare() looks at (id, median, samples).
+    std::vector<BaselineEntry> to_entries(const std::vector<Result>& results);
+
+    /// A benchmark regresses (improves) when its median is slower (faster) by more than
+    /// `threshold` and the U test rejects equal distributions at `alpha`.
+    std::vector<Comparison> compare(const Baseline& base, const std::vector<Result>& current,
+                                    const CompareOptions& opt);
+
+    /// Compares several independent runs (one process each) with the baseline. The samples
+    /// of one process share its frequency, placement and neighbours, so the U test of a single
+    /// run does not see the variation between processes: a benchmark regresses (improves) only
+    /// when every run does on its own. Rows follow the first run and report the median change
+    /// and the largest p over the runs.
+    std::vector<Comparison> compare_runs(const Baseline& base,
+                                         const std::vector<std::vector<BaselineEntry>>& runs,
+                                         const CompareOptions& opt);
+
+    void print_comparison(std::ostream& os, const std::vector<Comparison>& rows);
+
+}
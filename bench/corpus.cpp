@@ -0,0 +1,330 @@
+#include "corpus.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef TB_HAVE_ZLIB
+#define TB_HAVE_ZLIB 0
+#endif
+#if TB_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace tb::bench {
+
+    namespace {
+        constexpr std::size_t kBlock = 1u << 20;
+
+        std::uint64_t splitmix64(std::uint64_t& state) noexcept {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        // metà uniforme, metà concentrata su 1024 /24 "caldi": distribuzione plausibile per i log
+        class AddressStream {
+        public:
+            explicit AddressStream(std::uint64_t seed) : state_{seed} {}
+
+            std::uint64_t next_raw() noexcept { return splitmix64(state_); }
+
+            IPv4 next(std::uint64_t r) const noexcept {
+                if ((r & 1u) == 0) return static_cast<IPv4>(r >> 32);
+                std::uint64_t h = (r >> 1) & 1023u;
+                const auto prefix = static_cast<IPv4>(splitmix64(h) >> 32) & 0xFFFFFF00u;
+                return prefix | static_cast<IPv4>((r >> 20) & 0xFFu);
+            }
+
+        private:
+            std::uint64_t state_;
+        };
+
+        char* put_uint(char* p, std::uint64_t v) noexcept {
+            char tmp[20];
+            int n = 0;
+            do {
+                tmp[n++] = static_cast<char>('0' + v % 10);
+                v /= 10;
+            } while (v != 0);
+            while (n > 0) *p++ = tmp[--n];
+            return p;
+        }
+
+        char* put_ipv4(char* p, IPv4 ip) noexcept {
+            p = put_uint(p, ip >> 24);
+            *p++ = '.';
+            p = put_uint(p, (ip >> 16) & 0xFFu);
+            *p++ = '.';
+            p = put_uint(p, (ip >> 8) & 0xFFu);
+            *p++ = '.';
+            return put_uint(p, ip & 0xFFu);
+        }
+
+        char* put_str(char* p, const char* s) noexcept {
+            const std::size_t n = std::strlen(s);
+            std::memcpy(p, s, n);
+            return p + n;
+        }
+
+        char* put_2d(char* p, unsigned v) noexcept {
+            *p++ = static_cast<char>('0' + v / 10);
+            *p++ = static_cast<char>('0' + v % 10);
+            return p;
+        }
+
+        // scrittura a blocchi su fd, eventualmente attraverso deflate (gzip)
+        class FileSink {
+        public:
+            FileSink(const std::string& path, bool gzip) : path_{path} {
+                fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (fd_ < 0) throw std::runtime_error("Cannot create " + path + ": " + std::strerror(errno));
+                if (gzip) {
+#if TB_HAVE_ZLIB
+                    // livello 1: generare GB a velocità accettabile; l'inflate costa uguale
+                    if (::deflateInit2(&zs_, 1, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                        ::close(fd_);
+                        throw std::runtime_error("deflateInit2 failed for " + path);
+                    }
+                    gzip_ = true;
+                    zout_.resize(kBlock);
+#else
+                    ::close(fd_);
+                    throw std::runtime_error("gzip corpus requires zlib");
+#endif
+                }
+            }
+
+            ~FileSink() {
+#if TB_HAVE_ZLIB
+                if (gzip_) ::deflateEnd(&zs_);
+#endif
+                if (fd_ >= 0) ::close(fd_);
+            }
+
+            FileSink(const FileSink&) = delete;
+            FileSink& operator=(const FileSink&) = delete;
+
+            void write(const char* data, std::size_t n) {
+#if TB_HAVE_ZLIB
+                if (gzip_) {
+                    deflate_some(data, n, Z_NO_FLUSH);
+                    return;
+                }
+#endif
+                raw_write(data, n);
+            }
+
+            // chiude lo stream, fsync: pagine pulite, quindi scartabili con POSIX_FADV_DONTNEED
+            void close() {
+#if TB_HAVE_ZLIB
+                if (gzip_) deflate_some(nullptr, 0, Z_FINISH);
+#endif
+                if (::fsync(fd_) != 0 || ::close(fd_) != 0) {
+                    fd_ = -1;
+                    throw std::runtime_error("Cannot write " + path_ + ": " + std::strerror(errno));
+                }
+                fd_ = -1;
+            }
+
+        private:
+            void raw_write(const char* data, std::size_t n) {
+                while (n > 0) {
+                    const ssize_t w = ::write(fd_, data, n);
+                    if (w < 0) {
+                        if (errno == EINTR) continue;
+                        throw std::runtime_error("Cannot write " + path_ + ": " + std::strerror(errno));
+                    }
+                    data += w;
+                    n -= static_cast<std::size_t>(w);
+                }
+            }
+
+#if TB_HAVE_ZLIB
+            void deflate_some(const char* data, std::size_t n, int flush) {
+                zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                zs_.avail_in = static_cast<uInt>(n);
+                int rc = Z_OK;
+                do {
+                    zs_.next_out = reinterpret_cast<Bytef*>(zout_.data());
+                    zs_.avail_out = static_cast<uInt>(zout_.size());
+                    rc = ::deflate(&zs_, flush);
+                    if (rc == Z_STREAM_ERROR) throw std::runtime_error("deflate failed for " + path_);
+                    raw_write(zout_.data(), zout_.size() - zs_.avail_out);
+                } while (zs_.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+            }
+
+            z_stream zs_{};
+            std::vector<char> zout_;
+#endif
+            std::string path_;
+            int fd_ = -1;
+            bool gzip_ = false;
+        };
+
+        std::string corpus_path(const std::string& dir, CorpusKind kind, std::uint64_t content_bytes,
+                                std::uint64_t seed) {
+            static const char* const kExt[] = {"txt", "csv", "log", "bin", "txt.gz"};
+            return dir + "/corpus-" + corpus_kind_name(kind) + "-" + std::to_string(content_bytes >> 20) + "m-s" +
+                   std::to_string(seed) + "." + kExt[static_cast<int>(kind)];
+        }
+
+        // "<addresses> <bytes>" accanto al corpus; assente o incoerente = rigenera
+        bool load_meta(CorpusFile& f) {
+            std::ifstream in{f.path + ".meta"};
+            std::uint64_t addresses = 0;
+            std::uint64_t bytes = 0;
+            if (!(in >> addresses >> bytes)) return false;
+            struct stat st{};
+            if (::stat(f.path.c_str(), &st) != 0 || static_cast<std::uint64_t>(st.st_size) != bytes) return false;
+            f.addresses = addresses;
+            f.bytes = bytes;
+            return true;
+        }
+
+        CorpusFile generate(const CorpusFile& target, std::uint64_t content_bytes, std::uint64_t seed) {
+            CorpusFile f = target;
+            const std::string tmp = f.path + ".tmp";
+            FileSink sink{tmp, f.kind == CorpusKind::Gzip};
+            AddressStream stream{seed};
+
+            std::vector<char> buf(kBlock + 256);
+            char* p = buf.data();
+            std::uint64_t written = 0;
+            std::uint64_t line = 0;
+            if (f.kind == CorpusKind::Csv) p = put_str(p, "timestamp,src_ip,dst_port,bytes\n");
+
+            while (written + static_cast<std::uint64_t>(p - buf.data()) < content_bytes) {
+                const std::uint64_t r = stream.next_raw();
+                const IPv4 ip = stream.next(r);
+                switch (f.kind) {
+                    case CorpusKind::Text:
+                    case CorpusKind::Gzip:
+                        p = put_ipv4(p, ip);
+                        *p++ = '\n';
+                        ++f.addresses;
+                        break;
+                    case CorpusKind::Csv:
+                        p = put_uint(p, 1760000000 + line / 1000);
+                        *p++ = ',';
+                        p = put_ipv4(p, ip);
+                        *p++ = ',';
+                        p = put_uint(p, (r >> 8) & 0xFFFFu);
+                        *p++ = ',';
+                        p = put_uint(p, 40 + (r >> 24) % 1460);
+                        *p++ = '\n';
+                        ++f.addresses;
+                        break;
+                    case CorpusKind::Log: {
+                        const std::uint64_t sec = line / 64;
+                        p = put_str(p, "Oct 18 ");
+                        p = put_2d(p, static_cast<unsigned>(sec / 3600 % 24));
+                        *p++ = ':';
+                        p = put_2d(p, static_cast<unsigned>(sec / 60 % 60));
+                        *p++ = ':';
+                        p = put_2d(p, static_cast<unsigned>(sec % 60));
+                        if (line % 16 == 15) {
+                            // numeri puntati ma nessun indirizzo: il parser deve saltarla
+                            p = put_str(p, " gw kernel: [");
+                            p = put_uint(p, sec);
+                            p = put_str(p, ".250] eth0: link up 1000 Mbps full duplex\n");
+                        } else {
+                            p = put_str(p, " gw sshd[");
+                            p = put_uint(p, 1000 + (r >> 40) % 30000);
+                            p = put_str(p, "]: Failed password for invalid user admin from ");
+                            p = put_ipv4(p, ip);
+                            p = put_str(p, " port ");
+                            p = put_uint(p, (r >> 8) & 0xFFFFu);
+                            p = put_str(p, " ssh2\n");
+                            ++f.addresses;
+                        }
+                        break;
+                    }
+                    case CorpusKind::Binary:
+                        *p++ = static_cast<char>(ip >> 24);
+                        *p++ = static_cast<char>(ip >> 16);
+                        *p++ = static_cast<char>(ip >> 8);
+                        *p++ = static_cast<char>(ip);
+                        ++f.addresses;
+                        break;
+                }
+                ++line;
+                if (static_cast<std::size_t>(p - buf.data()) >= kBlock) {
+                    sink.write(buf.data(), static_cast<std::size_t>(p - buf.data()));
+                    written += static_cast<std::uint64_t>(p - buf.data());
+                    p = buf.data();
+                }
+            }
+            sink.write(buf.data(), static_cast<std::size_t>(p - buf.data()));
+            sink.close();
+
+            std::error_code ec;
+            std::filesystem::rename(tmp, f.path, ec);
+            if (ec) throw std::runtime_error("Cannot rename " + tmp + ": " + ec.message());
+            f.bytes = std::filesystem::file_size(f.path);
+
+            std::ofstream meta{f.path + ".meta"};
+            meta << f.addresses << " " << f.bytes << "\n";
+            if (!meta) throw std::runtime_error("Cannot write " + f.path + ".meta");
+            return f;
+        }
+    }
+
+    const char* corpus_kind_name(CorpusKind kind) noexcept {
+        switch (kind) {
+            case CorpusKind::Text: return "text";
+            case CorpusKind::Csv: return "csv";
+            case CorpusKind::Log: return "log";
+            case CorpusKind::Binary: return "binary";
+            case CorpusKind::Gzip: return "gzip";
+        }
+        return "?";
+    }
+
+    CorpusKind parse_corpus_kind(const std::string& name) {
+        for (const CorpusKind k : kCorpusKinds) {
+            if (name == corpus_kind_name(k)) return k;
+        }
+        throw std::runtime_error("Unknown corpus format: '" + name + "' (expected text, csv, log, binary or gzip)");
+    }
+
+    IngestOptions corpus_ingest_options(CorpusKind kind) {
+        IngestOptions opt;
+        switch (kind) {
+            case CorpusKind::Text:
+            case CorpusKind::Gzip: opt.format = InputFormat::Text; break;
+            case CorpusKind::Csv:
+                opt.format = InputFormat::Csv;
+                opt.csv_column = 1;
+                break;
+            case CorpusKind::Log: opt.format = InputFormat::Log; break;
+            case CorpusKind::Binary: opt.format = InputFormat::Binary; break;
+        }
+        return opt;
+    }
+
+    CorpusFile ensure_corpus(const std::string& dir, CorpusKind kind, std::uint64_t content_bytes,
+                             std::uint64_t seed) {
+        if (kind == CorpusKind::Gzip && !gzip_supported()) {
+            throw std::runtime_error("gzip corpus requires zlib");
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) throw std::runtime_error("Cannot create corpus directory " + dir + ": " + ec.message());
+
+        CorpusFile f;
+        f.kind = kind;
+        f.path = corpus_path(dir, kind, content_bytes, seed);
+        if (load_meta(f)) return f;
+        return generate(f, content_bytes, seed);
+    }
+
+}
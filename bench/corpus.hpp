@@ -0,0 +1,45 @@
+#pragma once
+
+// Deterministic input corpora for the ingestion benchmark.
+
+#include "tb/ingest.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace tb::bench {
+
+    enum class CorpusKind {
+        Text,     // "a.b.c.d\n"
+        Csv,      // "timestamp,src_ip,dst_port,bytes" with a header line
+        Log,      // sshd-style syslog lines, 1 in 16 without an address
+        Binary,   // 4-byte records, network byte order
+        Gzip,     // the text corpus, gzip-compressed
+    };
+
+    inline constexpr CorpusKind kCorpusKinds[] = {
+        CorpusKind::Text, CorpusKind::Csv, CorpusKind::Log, CorpusKind::Binary, CorpusKind::Gzip,
+    };
+
+    const char* corpus_kind_name(CorpusKind kind) noexcept;   // "text", "csv", "log", "binary", "gzip"
+    CorpusKind parse_corpus_kind(const std::string& name);    // throws std::runtime_error
+
+    /// How tb_io must parse a corpus of this kind.
+    IngestOptions corpus_ingest_options(CorpusKind kind);
+
+    struct CorpusFile {
+        CorpusKind kind = CorpusKind::Text;
+        std::string path;
+        std::uint64_t bytes = 0;        // size on disk (compressed for gzip)
+        std::uint64_t addresses = 0;    // addresses a correct reader must find
+    };
+
+    /// Generate (or reuse, if already in `dir` with matching metadata) a corpus holding at
+    /// least `content_bytes` bytes of content before compression. Every kind encodes the same
+    /// address sequence for a given seed, so equal-length prefixes produce equal histograms.
+    /// The file is fsync'ed so that its page-cache pages can be dropped for cold runs.
+    /// Throws std::runtime_error on I/O errors, or for gzip without zlib.
+    CorpusFile ensure_corpus(const std::string& dir, CorpusKind kind, std::uint64_t content_bytes,
+                             std::uint64_t seed = 1);
+
+}
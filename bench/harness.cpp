@@ -0,0 +1,267 @@
+#include "harness.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifndef TB_BUILD_TYPE
+#define TB_BUILD_TYPE ""
+#endif
+
+namespace tb::bench {
+
+    namespace {
+        double ipc(const Result& r) {
+            if (!r.perf.has(PerfEvent::Cycles) || !r.perf.has(PerfEvent::Instructions)) return -1.0;
+            const auto cycles = r.perf.get(PerfEvent::Cycles);
+            return cycles == 0 ? -1.0 : static_cast<double>(r.perf.get(PerfEvent::Instructions)) / static_cast<double>(cycles);
+        }
+    }
+
+    std::string json_escape(const std::string& s) {
+        std::string out;
+        out.reserve(s.size());
+        for (const char c : s) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                        out += buf;
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        return out;
+    }
+
+    // numeri JSON: niente NaN/inf, precisione sufficiente per il confronto tra run
+    std::string json_number(double v) {
+        if (!std::isfinite(v)) return "null";
+        std::ostringstream os;
+        os << std::setprecision(9) << v;
+        return os.str();
+    }
+
+    void write_json_array(std::ostream& os, const std::vector<double>& v) {
+        os << "[";
+        for (std::size_t i = 0; i < v.size(); ++i) os << (i ? ", " : "") << json_number(v[i]);
+        os << "]";
+    }
+
+    void write_json_context(std::ostream& os, const RunContext& ctx) {
+        os << "  \"context\": {\n"
+           << "    \"cpu\": \"" << json_escape(ctx.cpu) << "\",\n"
+           << "    \"compiler\": \"" << json_escape(ctx.compiler) << "\",\n"
+           << "    \"build_type\": \"" << json_escape(ctx.build_type) << "\",\n"
+           << "    \"timestamp\": \"" << json_escape(ctx.timestamp) << "\",\n"
+           << "    \"tsc\": " << (TB_BENCH_HAVE_TSC ? "true" : "false") << ",\n"
+           << "    \"perf\": \"" << json_escape(ctx.perf) << "\"\n"
+           << "  },\n";
+    }
+
+    std::string Result::id() const {
+        std::string s = name;
+        for (const auto& [k, v] : params) s += "/" + k + "=" + v;
+        return s;
+    }
+
+    std::string Result::param(const std::string& key) const {
+        for (const auto& [k, v] : params) {
+            if (k == key) return v;
+        }
+        return {};
+    }
+
+    double median(std::vector<double> v) {
+        if (v.empty()) return 0.0;
+        const std::size_t mid = v.size() / 2;
+        std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(mid), v.end());
+        const double hi = v[mid];
+        if (v.size() % 2 == 1) return hi;
+        const double lo = *std::max_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(mid));
+        return (lo + hi) / 2.0;
+    }
+
+    double mad(const std::vector<double>& v) {
+        const double m = median(v);
+        std::vector<double> dev;
+        dev.reserve(v.size());
+        for (const double x : v) dev.push_back(std::fabs(x - m));
+        return median(std::move(dev));
+    }
+
+    bool Harness::selected(const std::string& name, const Params& params) const {
+        if (opt_.filter.empty()) return true;
+        Result probe;
+        probe.name = name;
+        probe.params = params;
+        return probe.id().find(opt_.filter) != std::string::npos;
+    }
+
+    void Harness::finish(Result& r) {
+        r.median_ns = median(r.ns_per_elem);
+        r.mad_ns = mad(r.ns_per_elem);
+        r.median_cycles = median(r.cycles_per_elem);
+        results_.push_back(std::move(r));
+    }
+
+    RunContext current_context(const PerfCounters* counters) {
+        RunContext ctx;
+        if (counters == nullptr) {
+            ctx.perf = "disabled";
+        } else if (counters->hardware_available()) {
+            ctx.perf = "ok";
+        } else {
+            ctx.perf = counters->status();
+        }
+        std::ifstream cpuinfo{"/proc/cpuinfo"};
+        std::string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.rfind("model name", 0) == 0) {
+                const auto colon = line.find(':');
+                if (colon != std::string::npos) ctx.cpu = line.substr(colon + 2);
+                break;
+            }
+        }
+#if defined(__clang__)
+        ctx.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+        ctx.compiler = "gcc " __VERSION__;
+#endif
+        ctx.build_type = TB_BUILD_TYPE;
+
+        const std::time_t now = std::time(nullptr);
+        std::tm tm{};
+        gmtime_r(&now, &tm);
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        ctx.timestamp = buf;
+        return ctx;
+    }
+
+    void print_table(std::ostream& os, const std::vector<Result>& results) {
+        std::size_t width = 9;
+        for (const auto& r : results) width = std::max(width, r.id().size());
+
+        const bool show_gbs = std::any_of(results.begin(), results.end(), [](const Result& r) { return r.bytes_per_elem > 0.0; });
+
+        os << std::left << std::setw(static_cast<int>(width)) << "benchmark" << std::right
+           << std::setw(12) << "ns/elem" << std::setw(10) << "MAD %"
+           << std::setw(12) << "cyc/elem" << std::setw(14) << "Melem/s";
+        if (show_gbs) os << std::setw(10) << "GB/s";
+        os << "\n";
+        for (const auto& r : results) {
+            const double mad_pct = r.median_ns > 0.0 ? 100.0 * r.mad_ns / r.median_ns : 0.0;
+            os << std::left << std::setw(static_cast<int>(width)) << r.id() << std::right << std::fixed
+               << std::setprecision(3) << std::setw(12) << r.median_ns
+               << std::setprecision(1) << std::setw(10) << mad_pct
+               << std::setprecision(2) << std::setw(12) << r.median_cycles
+               << std::setprecision(1) << std::setw(14) << r.elements_per_second() / 1e6;
+            if (show_gbs) {
+                if (r.bytes_per_elem > 0.0) {
+                    os << std::setprecision(2) << std::setw(10) << r.gb_per_second();
+                } else {
+                    os << std::setw(10) << "-";
+                }
+            }
+            os << "\n";
+        }
+    }
+
+    void print_counters(std::ostream& os, const std::vector<Result>& results) {
+        // solo le colonne con almeno un valore
+        std::vector<PerfEvent> cols;
+        for (std::size_t e = 0; e < kPerfEventCount; ++e) {
+            const auto ev = static_cast<PerfEvent>(e);
+            for (const auto& r : results) {
+                if (r.perf.has(ev)) {
+                    cols.push_back(ev);
+                    break;
+                }
+            }
+        }
+        if (cols.empty()) return;
+        const bool show_ipc = std::any_of(results.begin(), results.end(), [](const Result& r) { return ipc(r) >= 0.0; });
+
+        std::size_t width = 9;
+        for (const auto& r : results) width = std::max(width, r.id().size());
+        os << std::left << std::setw(static_cast<int>(width)) << "per element" << std::right;
+        for (const auto ev : cols) os << std::setw(15) << perf_event_name(ev);
+        if (show_ipc) os << std::setw(8) << "IPC";
+        os << "\n";
+        for (const auto& r : results) {
+            os << std::left << std::setw(static_cast<int>(width)) << r.id() << std::right << std::fixed
+               << std::setprecision(4);
+            for (const auto ev : cols) {
+                if (r.perf.has(ev)) {
+                    os << std::setw(15) << r.perf.per(ev, r.perf_elements);
+                } else {
+                    os << std::setw(15) << "-";
+                }
+            }
+            if (show_ipc) {
+                if (ipc(r) >= 0.0) {
+                    os << std::setprecision(2) << std::setw(8) << ipc(r);
+                } else {
+                    os << std::setw(8) << "-";
+                }
+            }
+            os << "\n";
+        }
+    }
+
+    void write_json(std::ostream& os, const RunContext& ctx, const std::vector<Result>& results) {
+        os << "{\n"
+           << "  \"tool\": \"tb_bench\",\n"
+           << "  \"format\": 1,\n";
+        write_json_context(os, ctx);
+        os << "  \"benchmarks\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            os << (i ? "," : "") << "\n    {\n"
+               << "      \"id\": \"" << json_escape(r.id()) << "\",\n"
+               << "      \"name\": \"" << json_escape(r.name) << "\",\n"
+               << "      \"params\": {";
+            for (std::size_t p = 0; p < r.params.size(); ++p) {
+                os << (p ? ", " : "") << "\"" << json_escape(r.params[p].first) << "\": \""
+                   << json_escape(r.params[p].second) << "\"";
+            }
+            os << "},\n"
+               << "      \"elements\": " << r.elements << ",\n"
+               << "      \"iterations\": " << r.iterations << ",\n"
+               << "      \"median_ns_per_elem\": " << json_number(r.median_ns) << ",\n"
+               << "      \"mad_ns_per_elem\": " << json_number(r.mad_ns) << ",\n"
+               << "      \"cycles_per_elem\": " << (r.cycles_per_elem.empty() ? "null" : json_number(r.median_cycles))
+               << ",\n"
+               << "      \"elements_per_second\": " << json_number(r.elements_per_second()) << ",\n";
+            if (r.bytes_per_elem > 0.0) os << "      \"gb_per_second\": " << json_number(r.gb_per_second()) << ",\n";
+            os
+               << "      \"counters_per_elem\": {";
+            bool first = true;
+            for (std::size_t e = 0; e < kPerfEventCount; ++e) {
+                const auto ev = static_cast<PerfEvent>(e);
+                if (!r.perf.has(ev)) continue;
+                os << (first ? "" : ", ") << "\"" << perf_event_name(ev) << "\": "
+                   << json_number(r.perf.per(ev, r.perf_elements));
+                first = false;
+            }
+            if (ipc(r) >= 0.0) os << (first ? "" : ", ") << "\"ipc\": " << json_number(ipc(r));
+            os << "},\n"
+               << "      \"samples_ns_per_elem\": ";
+            write_json_array(os, r.ns_per_elem);
+            os << "\n    }";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+// Minimal, dependency-free microbenchmark harness used by tb_bench.
+
+#include "tb/perf_counters.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TB_BENCH_HAVE_TSC 1
+#else
+#define TB_BENCH_HAVE_TSC 0
+#endif
+
+namespace tb::bench {
+
+    // keep the optimizer from discarding a computed value
+    template <class T>
+    inline void do_not_optimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // timestamp counter (reference cycles); 0 where unavailable
+    inline std::uint64_t read_tsc() noexcept {
+#if TB_BENCH_HAVE_TSC
+        _mm_lfence();
+        const std::uint64_t t = __rdtsc();
+        _mm_lfence();
+        return t;
+#else
+        return 0;
+#endif
+    }
+
+    // end of a timed region: rdtscp waits for the preceding instructions, the fence keeps
+    // later ones from starting before the read; pairs with read_tsc() at the start
+    inline std::uint64_t read_tscp() noexcept {
+#if TB_BENCH_HAVE_TSC
+        unsigned aux = 0;
+        const std::uint64_t t = __rdtscp(&aux);
+        _mm_lfence();
+        return t;
+#else
+        return 0;
+#endif
+    }
+
+    struct Options {
+        unsigned repetitions = 15;   // measured repetitions per benchmark
+        unsigned warmup = 2;         // unmeasured repetitions after calibration
+        double min_rep_ms = 20.0;    // iterations per repetition are scaled up to at least this
+        std::string filter;          // run only benchmarks whose id contains this substring
+        bool counters = true;        // collect perf_event counters around the measured repetitions
+    };
+
+    using Params = std::vector<std::pair<std::string, std::string>>;
+
+    struct Result {
+        std::string name;                     // e.g. "bucketize"
+        Params params;                        // e.g. {{"k","12"},{"n","65536"}}
+        std::uint64_t elements = 0;           // elements processed per iteration
+        double bytes_per_elem = 0.0;          // memory traffic per element for GB/s (0 = not reported)
+        std::uint64_t iterations = 0;         // iterations per repetition
+        std::vector<double> ns_per_elem;      // one sample per repetition
+        std::vector<double> cycles_per_elem;  // idem (empty without a TSC)
+
+        double median_ns = 0.0;               // median ns per element
+        double mad_ns = 0.0;                  // median absolute deviation of ns per element
+        double median_cycles = 0.0;           // median TSC cycles per element
+
+        PerfReading perf{};                   // summed over all measured repetitions
+        std::uint64_t perf_elements = 0;      // elements covered by `perf`
+
+        [[nodiscard]] std::string id() const;            // "name/k=12/n=65536"
+        [[nodiscard]] double elements_per_second() const noexcept {
+            return median_ns > 0.0 ? 1e9 / median_ns : 0.0;
+        }
+        [[nodiscard]] double gb_per_second() const noexcept {
+            return median_ns > 0.0 ? bytes_per_elem / median_ns : 0.0;
+        }
+        [[nodiscard]] std::string param(const std::string& key) const;   // "" if absent
+    };
+
+    double median(std::vector<double> v);
+    double mad(const std::vector<double>& v);   // median(|x - median(x)|)
+
+    class Harness {
+    public:
+        explicit Harness(Options opt) : opt_{std::move(opt)} {
+            if (opt_.counters) counters_ = std::make_unique<PerfCounters>();
+        }
+
+        [[nodiscard]] bool selected(const std::string& name, const Params& params) const;
+
+        /// Time `fn` (one iteration over `elements` elements). Skipped when filtered out.
+        template <class Fn>
+        void run(const std::string& name, const Params& params, std::uint64_t elements, Fn&& fn,
+                 double bytes_per_elem = 0.0) {
+            if (!selected(name, params)) return;
+            Result r;
+            r.name = name;
+            r.params = params;
+            r.elements = elements == 0 ? 1 : elements;
+            r.bytes_per_elem = bytes_per_elem;
+
+            // calibrazione: raddoppia le iterazioni finché una ripetizione dura min_rep_ms
+            std::uint64_t iters = 1;
+            for (;;) {
+                const double ms = time_ns(fn, iters).first / 1e6;
+                if (ms >= opt_.min_rep_ms || iters >= (std::uint64_t{1} << 40)) break;
+                iters *= (ms < opt_.min_rep_ms / 16.0) ? 8 : 2;
+            }
+            r.iterations = iters;
+            for (unsigned i = 0; i < opt_.warmup; ++i) time_ns(fn, iters);
+
+            const double per = static_cast<double>(iters) * static_cast<double>(r.elements);
+            const bool count = counters_ && counters_->available();
+            if (count) counters_->start();
+            for (unsigned i = 0; i < opt_.repetitions; ++i) {
+                const auto [ns, cycles] = time_ns(fn, iters);
+                r.ns_per_elem.push_back(ns / per);
+                if (TB_BENCH_HAVE_TSC) r.cycles_per_elem.push_back(static_cast<double>(cycles) / per);
+            }
+            if (count) {
+                r.perf = counters_->stop();
+                r.perf_elements = iters * r.elements * opt_.repetitions;
+            }
+            finish(r);
+        }
+
+        [[nodiscard]] const std::vector<Result>& results() const noexcept { return results_; }
+        [[nodiscard]] const Options& options() const noexcept { return opt_; }
+        [[nodiscard]] const PerfCounters* counters() const noexcept { return counters_.get(); }
+
+    private:
+        template <class Fn>
+        static std::pair<double, std::uint64_t> time_ns(Fn& fn, std::uint64_t iters) {
+            const auto t0 = std::chrono::steady_clock::now();
+            const std::uint64_t c0 = read_tsc();
+            for (std::uint64_t i = 0; i < iters; ++i) fn();
+            const std::uint64_t c1 = read_tsc();
+            const auto t1 = std::chrono::steady_clock::now();
+            return {std::chrono::duration<double, std::nano>(t1 - t0).count(), c1 - c0};
+        }
+
+        void finish(Result& r);
+
+        Options opt_;
+        std::unique_ptr<PerfCounters> counters_;
+        std::vector<Result> results_;
+    };
+
+    // ---------- Reporting ----------
+
+    struct RunContext {
+        std::string cpu;         // /proc/cpuinfo model name
+        std::string compiler;
+        std::string build_type;
+        std::string timestamp;   // ISO 8601 UTC
+        std::string perf;        // "ok", "disabled" or why hardware counters are unavailable
+    };
+
+    RunContext current_context(const PerfCounters* counters);
+
+    void print_table(std::ostream& os, const std::vector<Result>& results);
+    void print_counters(std::ostream& os, const std::vector<Result>& results);  // per-element rates
+    void write_json(std::ostream& os, const RunContext& ctx, const std::vector<Result>& results);
+
+    // shared by the JSON writers of every tb_bench mode
+    std::string json_escape(const std::string& s);
+    std::string json_number(double v);                                    // null for NaN/inf
+    void write_json_array(std::ostream& os, const std::vector<double>& v);
+    void write_json_context(std::ostream& os, const RunContext& ctx);     // "context": {...},
+
+}
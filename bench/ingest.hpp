@@ -0,0 +1,80 @@
+#pragma once
+
+// End-to-end ingestion benchmark: file -> parser -> bucket_index -> histogram.
+
+#include "corpus.hpp"
+#include "harness.hpp"
+
+#include "tb/types.hpp"
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tb::bench {
+
+    enum class ReaderKind {
+        Read,   // pread() into a 1 MiB buffer (gzip: read + inflate)
+        Mmap,   // mmap() of the whole file; I/O = faulting each block in
+    };
+
+    enum class CacheMode {
+        Cold,   // POSIX_FADV_DONTNEED before every repetition
+        Warm,   // file read once before the measured repetitions
+    };
+
+    const char* reader_kind_name(ReaderKind r) noexcept;    // "read", "mmap"
+    ReaderKind parse_reader_kind(const std::string& name);
+    const char* cache_mode_name(CacheMode c) noexcept;      // "cold", "warm"
+    CacheMode parse_cache_mode(const std::string& name);
+
+    enum class IngestStage : std::size_t { Io, Parse, Bucketize, Aggregate, Count };
+    inline constexpr std::size_t kIngestStages = static_cast<std::size_t>(IngestStage::Count);
+
+    struct IngestConfig {
+        std::string corpus_dir = "tb_corpus";
+        std::uint64_t corpus_bytes = 1024ULL << 20;     // content per corpus (before compression)
+        std::vector<CorpusKind> kinds{std::begin(kCorpusKinds), std::end(kCorpusKinds)};
+        std::vector<ReaderKind> readers{ReaderKind::Read, ReaderKind::Mmap};
+        std::vector<unsigned> threads;                  // empty = {1, hardware_concurrency}
+        std::vector<CacheMode> caches{CacheMode::Cold, CacheMode::Warm};
+        unsigned repetitions = 3;
+        Config engine{};
+        std::string filter;                             // substring of IngestResult::id()
+    };
+
+    struct IngestResult {
+        CorpusKind kind = CorpusKind::Text;
+        ReaderKind reader = ReaderKind::Read;
+        unsigned threads = 1;
+        CacheMode cache = CacheMode::Cold;
+
+        std::uint64_t file_bytes = 0;
+        std::uint64_t addresses = 0;
+        double resident = 0.0;                   // page-cache residency before the median run (mincore)
+        std::vector<double> wall_s;              // one sample per repetition
+        double median_wall_s = 0.0;
+        std::array<double, kIngestStages> stage_s{};   // thread-seconds per stage, median run
+
+        [[nodiscard]] std::string id() const;  // "ingest/text/read/t=4/cold"
+        [[nodiscard]] double gb_per_second() const noexcept {
+            return median_wall_s > 0.0 ? static_cast<double>(file_bytes) / median_wall_s / 1e9 : 0.0;
+        }
+        [[nodiscard]] double addresses_per_second() const noexcept {
+            return median_wall_s > 0.0 ? static_cast<double>(addresses) / median_wall_s : 0.0;
+        }
+    };
+
+    /// Generate/reuse the corpora and time every kind x reader x threads x cache combination.
+    /// Every run is checked against the corpus address count and the first run's histogram.
+    /// Combinations that do not apply (gzip with mmap or several threads) are skipped with a
+    /// note on `log`. Throws std::runtime_error on I/O errors or mismatching results.
+    std::vector<IngestResult> run_ingest_suite(const IngestConfig& cfg, std::ostream& log);
+
+    void print_ingest_table(std::ostream& os, const std::vector<IngestResult>& results);
+    void write_ingest_json(std::ostream& os, const RunContext& ctx, const std::vector<IngestResult>& results);
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// Per-call latency benchmark: small batches timed one call at a time into HDR histograms.
+
+#include "harness.hpp"
+#include "statistics.hpp"
+
+#include "tb/types.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tb::bench {
+
+    enum class LatencyOp {
+        Empty,            // timer floor: rdtscp pair around nothing
+        Bucketize,        // BucketEngine::bucketize, returns a new vector (allocating)
+        BucketizeInto,    // BucketEngine::bucketize(in, n, out) into a caller buffer
+        BucketIndex,      // BucketEngine::bucket_index into a caller buffer (inline, shift read from the engine)
+        Inline,           // same hash written out in the benchmark into a caller buffer (baseline)
+        Distribution,     // BucketEngine::distribution, new 2^k histogram per call (allocating)
+        Accumulate,       // BucketEngine::accumulate into a persistent per-thread histogram
+        SharedAccumulate, // bucket_index into one histogram shared by all threads (atomic adds)
+        Count
+    };
+
+    inline constexpr std::size_t kLatencyOps = static_cast<std::size_t>(LatencyOp::Count);
+
+    /// "empty", "bucketize", "bucketize_into", "bucket_index", "inline", "distribution", "accumulate",
+    /// "shared_accumulate"
+    const char* latency_op_name(LatencyOp op) noexcept;
+    bool latency_op_allocates(LatencyOp op) noexcept;
+
+    struct LatencyConfig {
+        std::vector<std::size_t> batches{1, 4, 16, 64};   // addresses per call
+        std::vector<unsigned> threads;                    // empty = {1, hardware_concurrency}
+        std::uint64_t samples = 200000;                   // timed calls per thread and combination
+        unsigned k = 12;
+        std::string filter;                               // substring of LatencyResult::id()
+    };
+
+    struct LatencyResult {
+        LatencyOp op = LatencyOp::Empty;
+        std::size_t batch = 1;
+        unsigned threads = 1;
+        HdrHistogram ticks;        // one sample per call, all threads merged
+        double ns_per_tick = 1.0;
+
+        [[nodiscard]] std::string id() const;   // "latency/bucketize/b=16/t=4"
+        [[nodiscard]] double ns(double percentile) const noexcept {
+            return static_cast<double>(ticks.percentile(percentile)) * ns_per_tick;
+        }
+    };
+
+    struct LatencyClock {
+        std::string source;        // "rdtscp" or "steady_clock"
+        double ns_per_tick = 1.0;
+    };
+
+    /// Tick source used by run_latency_suite; the TSC rate is calibrated against steady_clock.
+    LatencyClock latency_clock();
+
+    /// Time every op x batch x threads combination call by call. With t threads, all t run the
+    /// same op at once from a common start, each on its own inputs (contention on the allocator,
+    /// on shared cache lines for SharedAccumulate, and on the cores when t exceeds them).
+    std::vector<LatencyResult> run_latency_suite(const LatencyConfig& cfg, const LatencyClock& clock);
+
+    void print_latency_table(std::ostream& os, const std::vector<LatencyResult>& results);
+    void write_latency_json(std::ostream& os, const RunContext& ctx, const LatencyClock& clock,
+                            const std::vector<LatencyResult>& results);
+
+}
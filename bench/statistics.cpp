@@ -0,0 +1,109 @@
+#include "statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace tb::bench {
+
+    MannWhitney mann_whitney(const std::vector<double>& a, const std::vector<double>& b) {
+        MannWhitney r;
+        const std::size_t n1 = a.size();
+        const std::size_t n2 = b.size();
+        if (n1 < 3 || n2 < 3) return r;
+
+        // ranghi medi sul campione unito; i pareggi ricevono il rango medio
+        std::vector<std::pair<double, int>> all;
+        all.reserve(n1 + n2);
+        for (const double x : a) all.emplace_back(x, 0);
+        for (const double x : b) all.emplace_back(x, 1);
+        std::sort(all.begin(), all.end(), [](const auto& l, const auto& rr) { return l.first < rr.first; });
+
+        const double n = static_cast<double>(n1 + n2);
+        double rank_sum_a = 0.0;
+        double tie_term = 0.0;
+        for (std::size_t i = 0; i < all.size();) {
+            std::size_t j = i;
+            while (j < all.size() && all[j].first == all[i].first) ++j;
+            const double avg_rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+            for (std::size_t t = i; t < j; ++t) {
+                if (all[t].second == 0) rank_sum_a += avg_rank;
+            }
+            const double t = static_cast<double>(j - i);
+            tie_term += t * t * t - t;
+            i = j;
+        }
+
+        const double d1 = static_cast<double>(n1);
+        const double d2 = static_cast<double>(n2);
+        r.u = rank_sum_a - d1 * (d1 + 1.0) / 2.0;
+        const double mean = d1 * d2 / 2.0;
+        const double var = d1 * d2 / 12.0 * ((n + 1.0) - tie_term / (n * (n - 1.0)));
+        if (var <= 0.0) return r;
+
+        const double diff = r.u - mean;
+        const double corrected = std::max(0.0, std::fabs(diff) - 0.5);
+        r.z = std::copysign(corrected / std::sqrt(var), diff);
+        r.p = std::erfc(std::fabs(r.z) / std::sqrt(2.0));
+        return r;
+    }
+
+    HdrHistogram::HdrHistogram(std::uint64_t highest, unsigned digits) : highest_{highest} {
+        if (digits < 1 || digits > 5) throw std::invalid_argument("HdrHistogram: digits must be in [1, 5]");
+        if (highest < 2 || highest > (std::uint64_t{1} << 62)) {
+            throw std::invalid_argument("HdrHistogram: highest out of range");
+        }
+        // risoluzione unitaria fino a 2 * 10^digits, poi buckets che raddoppiano
+        std::uint64_t single = 2;
+        for (unsigned d = 0; d < digits; ++d) single *= 10;
+        unsigned magnitude = 0;
+        while ((std::uint64_t{1} << magnitude) < single) ++magnitude;
+        half_magnitude_ = magnitude - 1;
+        half_count_ = std::uint64_t{1} << half_magnitude_;
+        sub_mask_ = (std::uint64_t{1} << magnitude) - 1;
+
+        std::size_t buckets = 1;
+        for (std::uint64_t untrackable = std::uint64_t{1} << magnitude; untrackable <= highest; untrackable <<= 1) {
+            ++buckets;
+        }
+        counts_.assign((buckets + 1) * half_count_, 0);
+    }
+
+    void HdrHistogram::merge(const HdrHistogram& other) {
+        if (other.counts_.size() != counts_.size() || other.highest_ != highest_ ||
+            other.half_magnitude_ != half_magnitude_) {
+            throw std::invalid_argument("HdrHistogram::merge: different layouts");
+        }
+        for (std::size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    std::uint64_t HdrHistogram::highest_equivalent(std::size_t index) const noexcept {
+        std::size_t bucket = index >> half_magnitude_;
+        std::uint64_t sub = (index & (half_count_ - 1)) + half_count_;
+        if (bucket == 0) {
+            sub -= half_count_;
+        } else {
+            bucket -= 1;
+        }
+        return (sub << bucket) + (std::uint64_t{1} << bucket) - 1;
+    }
+
+    std::uint64_t HdrHistogram::percentile(double percentile) const noexcept {
+        if (total_ == 0) return 0;
+        const double p = std::clamp(percentile, 0.0, 100.0);
+        const auto target = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total_))));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= target) return std::min(highest_equivalent(i), max_);
+        }
+        return max_;
+    }
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// Statistics shared by tb_bench reports: the Mann–Whitney test of --compare and the HDR
+// histogram of --latency. No dependency on the harness, so tb_tests covers them directly.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tb::bench {
+
+    struct MannWhitney {
+        double u = 0.0;     // U statistic of the first sample
+        double z = 0.0;     // normal approximation (tie and continuity corrected)
+        double p = 1.0;     // two-sided p-value
+    };
+
+    /// Two-sided Mann–Whitney U test. Needs at least 3 samples per side, otherwise p = 1.
+    MannWhitney mann_whitney(const std::vector<double>& a, const std::vector<double>& b);
+
+    /// High-dynamic-range histogram (HdrHistogram layout): values up to `highest` are kept
+    /// with `digits` significant decimal digits in a fixed array, so recording is O(1) and
+    /// never allocates. Larger values are clamped to `highest`; max() stays exact.
+    class HdrHistogram {
+    public:
+        explicit HdrHistogram(std::uint64_t highest = std::uint64_t{1} << 36, unsigned digits = 3);
+
+        void record(std::uint64_t value) noexcept {
+            if (value > max_) max_ = value;
+            if (value < min_) min_ = value;
+            sum_ += static_cast<double>(value);
+            ++total_;
+            counts_[index_of(value < highest_ ? value : highest_)] += 1;
+        }
+
+        /// Add another histogram with the same layout. Throws std::invalid_argument otherwise.
+        void merge(const HdrHistogram& other);
+
+        /// Highest value equivalent (within the precision) to the value at `percentile` (0..100).
+        [[nodiscard]] std::uint64_t percentile(double percentile) const noexcept;
+
+        [[nodiscard]] std::uint64_t count() const noexcept { return total_; }
+        [[nodiscard]] std::uint64_t min() const noexcept { return total_ ? min_ : 0; }
+        [[nodiscard]] std::uint64_t max() const noexcept { return max_; }
+        [[nodiscard]] double mean() const noexcept { return total_ ? sum_ / static_cast<double>(total_) : 0.0; }
+
+    private:
+        [[nodiscard]] std::size_t index_of(std::uint64_t value) const noexcept {
+            const unsigned pow2 = 64u - static_cast<unsigned>(__builtin_clzll(value | sub_mask_));
+            const unsigned bucket = pow2 - (half_magnitude_ + 1);
+            const std::uint64_t sub = value >> bucket;
+            return (static_cast<std::size_t>(bucket + 1) << half_magnitude_) + static_cast<std::size_t>(sub - half_count_);
+        }
+        [[nodiscard]] std::uint64_t highest_equivalent(std::size_t index) const noexcept;
+
+        std::uint64_t highest_;
+        unsigned half_magnitude_ = 0;   // log2(sub-bucket count) - 1
+        std::uint64_t half_count_ = 0;
+        std::uint64_t sub_mask_ = 0;
+        std::vector<std::uint64_t> counts_;
+        std::uint64_t total_ = 0;
+        std::uint64_t min_ = ~std::uint64_t{0};
+        std::uint64_t max_ = 0;
+        double sum_ = 0.0;
+    };
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "harness.hpp"
+
+#include "tb/parallel.hpp"
+#include "tb/types.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tb::bench {
+
+    struct SuiteConfig {
+        std::vector<unsigned> ks{8, 12, 16, 20};
+        std::vector<std::size_t> sizes{std::size_t{1} << 10, std::size_t{1} << 16, std::size_t{1} << 20};
+    };
+
+    /// bucket_index, bucketize, distribution (vector, weighted, range), compute_stats, parse_ipv4
+    void run_core_suite(Harness& h, const SuiteConfig& cfg);
+
+    struct ScalingConfig {
+        std::vector<unsigned> ks{8, 12, 16, 20};
+        std::vector<std::size_t> sizes{std::size_t{1} << 16, std::size_t{1} << 20, std::size_t{1} << 24};
+        std::vector<unsigned> threads;        // empty = 1, 2, 4, ... and the number of CPUs
+        std::vector<HistogramStrategy> strategies{
+            HistogramStrategy::SharedAtomic, HistogramStrategy::PerThread, HistogramStrategy::Partitioned};
+        std::size_t stream_bytes = std::size_t{64} << 20;   // per STREAM array, well above the LLC
+    };
+
+    /// STREAM-like copy/read/triad bandwidth per thread count ("stream/<kernel>/t=N"), then
+    /// parallel_distribution for every strategy x k x size x threads ("parallel/<strategy>/...").
+    void run_scaling_suite(Harness& h, const ScalingConfig& cfg);
+
+    /// One row per result, for plotting: GB/s and its share of STREAM read at the same thread count.
+    void write_scaling_csv(std::ostream& os, const std::vector<Result>& results);
+
+    struct QualityConfig {
+        std::vector<unsigned> ks{12, 16};
+        std::size_t size = std::size_t{1} << 22;   // addresses per synthetic dataset
+        std::vector<std::string> files;           // user datasets, "path" or "path:format"
+        double slo_p = 1e-3;                      // minimum chi² p-value
+        double slo_load = 2.0;                    // maximum max_load / mean
+    };
+
+    struct QualityRow {
+        std::string candidate;   // "affine/default", "fmix32", ...
+        bool library = false;    // selectable through tb::Config; the others are reference points
+        std::string dataset;
+        unsigned k = 0;
+        std::size_t n = 0;
+        StatsResult stats{};
+        double ns_per_elem = 0.0;
+
+        [[nodiscard]] double load_ratio() const noexcept {
+            return stats.mean > 0.0 ? static_cast<double>(stats.max_load) / stats.mean : 0.0;
+        }
+        [[nodiscard]] bool meets(const QualityConfig& cfg) const noexcept {
+            return stats.p_value >= cfg.slo_p && load_ratio() <= cfg.slo_load;
+        }
+    };
+
+    /// Histogram throughput and compute_stats of every hash candidate (the library's affine
+    /// hash with each preset, plus reference families) on every dataset and k.
+    /// Throws std::runtime_error if a user dataset cannot be read or is empty.
+    std::vector<QualityRow> run_quality_suite(Harness& h, const QualityConfig& cfg);
+
+    /// Per-dataset tables, then candidates ranked by throughput among those meeting the SLO everywhere.
+    void print_quality_report(std::ostream& os, const std::vector<QualityRow>& rows, const QualityConfig& cfg);
+
+}
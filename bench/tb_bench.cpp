@@ -0,0 +1,532 @@
+#include "compare.hpp"
+#include "harness.hpp"
+#include "ingest.hpp"
+#include "latency.hpp"
+#include "suites.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+    // ---------- Helper per stampa usage ----------
+    void print_usage(std::ostream& os) {
+        os << "Turbo-Bucketizer microbenchmarks\n"
+        << "Usage:\n"
+        << "  tb_bench [options]\n"
+        << "  tb_bench --scaling [scaling options] [options]\n"
+        << "  tb_bench --quality [quality options] [options]\n"
+        << "  tb_bench --ingest [ingest options] [--filter] [--k] [--repetitions] [--json]\n"
+        << "  tb_bench --latency [latency options] [--filter] [--k] [--json]\n"
+        << "\n"
+        << "Options:\n"
+        << "  --filter <text>      Run only benchmarks whose id contains <text> (e.g. bucketize/k=12)\n"
+        << "  --k <list>           Comma-separated k values (default: 8,12,16,20)\n"
+        << "  --sizes <list>       Comma-separated input sizes (default: 1024,65536,1048576)\n"
+        << "  --repetitions <n>    Measured repetitions per benchmark (default: 15)\n"
+        << "  --warmup <n>         Unmeasured repetitions after calibration (default: 2)\n"
+        << "  --min-time-ms <ms>   Minimum duration of one repetition (default: 20)\n"
+        << "  --quick              Shorthand for --k 12 --sizes 65536 --repetitions 10 --min-time-ms 5\n"
+        << "  --no-counters        Do not collect perf_event counters\n"
+        << "  --json <path>        Also write results as JSON ('-' = stdout, table suppressed)\n"
+        << "  --csv <path>         Also write results as CSV, one row per benchmark (GB/s, % of STREAM read)\n"
+        << "  --save <path>        Write results as a baseline (same format as --json)\n"
+        << "  --compare <path>     Compare against a baseline; exit code 2 on regressions\n"
+        << "  --runs <n>           Independent processes measured by --compare; a regression must\n"
+        << "                       show up in every one of them (default: 3)\n"
+        << "  --threshold <pct>    Median slowdown tolerated as noise (default: 30)\n"
+        << "  --alpha <p>          Significance level of the Mann-Whitney U test (default: 0.01)\n"
+        << "  --help               Show this help and exit\n"
+        << "\n"
+        << "Thread scaling (--scaling): STREAM-like baseline + parallel_distribution matrix\n"
+        << "  --threads <list>     Thread counts (default: 1, 2, 4, ... and the number of CPUs)\n"
+        << "  --strategies <list>  shared-atomic,per-thread,partitioned (default: all)\n"
+        << "  --stream-mb <n>      Size of each STREAM array in MiB (default: 64)\n"
+        << "  --k / --sizes        As above (default sizes: 65536,1048576,16777216)\n"
+        << "\n"
+        << "Hash quality (--quality): throughput + compute_stats per preset / hash family and dataset\n"
+        << "  --dataset <p[:fmt]>  Add a user dataset (format: text, csv, log, binary; repeatable)\n"
+        << "  --slo-p <p>          Minimum chi-square p-value (default: 0.001)\n"
+        << "  --slo-load <x>       Maximum max_load / mean (default: 2)\n"
+        << "  --k / --sizes        k values (default: 12,16); first size = synthetic dataset size (default: 4194304)\n"
+        << "\n"
+        << "Ingestion benchmark (--ingest): file -> parse -> bucket_index -> histogram\n"
+        << "  --corpus-dir <dir>   Where corpora are generated and reused (default: tb_corpus)\n"
+        << "  --corpus-mb <n>      Content per corpus in MiB, before compression (default: 1024, --quick: 64)\n"
+        << "  --formats <list>     text,csv,log,binary,gzip (default: all)\n"
+        << "  --readers <list>     read,mmap (default: both)\n"
+        << "  --threads <list>     Thread counts (default: 1 and the number of CPUs)\n"
+        << "  --cache <list>       cold,warm page cache (default: both)\n"
+        << "  Repetitions default to 3; cold runs need a file system honouring POSIX_FADV_DONTNEED.\n"
+        << "\n"
+        << "Per-call latency (--latency): small batches timed one call at a time (HDR histogram)\n"
+        << "  --batches <list>     Addresses per call (default: 1,4,16,64)\n"
+        << "  --samples <n>        Timed calls per thread and combination (default: 200000, --quick: 20000)\n"
+        << "  --threads <list>     Threads running the same op at once (default: 1 and the number of CPUs)\n"
+        << "  --k <n>              Engine k (first value; default: 12)\n"
+        << "\n"
+        << "Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.\n";
+    }
+
+    std::uint64_t parse_u64(const std::string& s, const std::string& what) {
+        std::size_t pos = 0;
+        std::uint64_t value = 0;
+        try {
+            value = std::stoull(s, &pos, 10);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid " + what + " value: '" + s + "'");
+        }
+        if (pos != s.size()) {
+            throw std::runtime_error("Invalid " + what + " value (trailing chars): '" + s + "'");
+        }
+        return value;
+    }
+
+    double parse_double(const std::string& s, const std::string& what) {
+        std::size_t pos = 0;
+        double value = 0.0;
+        try {
+            value = std::stod(s, &pos);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid " + what + " value: '" + s + "'");
+        }
+        if (pos != s.size() || value < 0.0) {
+            throw std::runtime_error("Invalid " + what + " value: '" + s + "'");
+        }
+        return value;
+    }
+
+    void write_json_file(const std::string& path, const tb::bench::RunContext& ctx,
+                         const std::vector<tb::bench::Result>& results) {
+        std::ofstream f{path};
+        if (!f) throw std::runtime_error("Cannot write " + path);
+        tb::bench::write_json(f, ctx, results);
+    }
+
+    // ---------- Run indipendenti per --compare ----------
+    // Le ripetizioni di un processo condividono frequenza, placement e vicini: per vedere la
+    // variazione fra run si rilancia questo stesso binario e si confrontano le run una per una.
+
+    // Argomenti del figlio: quelli del padre senza confronto né output, più --save <path>.
+    std::vector<std::string> child_args(int argc, char** argv, const std::string& save_path) {
+        std::vector<std::string> args{argv[0]};
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--compare" || arg == "--runs" || arg == "--threshold" || arg == "--alpha" ||
+                arg == "--save" || arg == "--json" || arg == "--csv") {
+                ++i;   // salta anche il valore
+                continue;
+            }
+            args.push_back(arg);
+        }
+        args.push_back("--save");
+        args.push_back(save_path);
+        return args;
+    }
+
+    // Misura una run in un processo separato (stdout scartato) e ne restituisce i risultati.
+    std::vector<tb::bench::BaselineEntry> run_in_child(int argc, char** argv) {
+        const char* dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir != nullptr && *dir != '\0' ? dir : "/tmp") + "/tb_bench_XXXXXX";
+        const int tmp_fd = ::mkstemp(path.data());
+        if (tmp_fd < 0) throw std::runtime_error("Cannot create temporary file: " + std::string(std::strerror(errno)));
+        ::close(tmp_fd);
+
+        const std::vector<std::string> args = child_args(argc, argv, path);
+        std::vector<char*> cargs;
+        for (const auto& a : args) cargs.push_back(const_cast<char*>(a.c_str()));
+        cargs.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        pid_t pid = 0;
+        const int rc = ::posix_spawn(&pid, "/proc/self/exe", &actions, nullptr, cargs.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        int status = 0;
+        if (rc == 0) {
+            while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        }
+        if (rc != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::remove(path.c_str());
+            throw std::runtime_error(rc != 0 ? "Cannot start tb_bench: " + std::string(std::strerror(rc))
+                                             : std::string("Independent tb_bench run failed"));
+        }
+        tb::bench::Baseline run = tb::bench::load_baseline(path);
+        std::remove(path.c_str());
+        return std::move(run.entries);
+    }
+
+    std::vector<std::uint64_t> parse_list(const std::string& s, const std::string& what) {
+        std::vector<std::uint64_t> out;
+        std::size_t start = 0;
+        while (start <= s.size()) {
+            const auto comma = s.find(',', start);
+            out.push_back(parse_u64(s.substr(start, comma - start), what));
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+        return out;
+    }
+
+    std::vector<std::string> split_names(const std::string& s) {
+        std::vector<std::string> out;
+        std::size_t start = 0;
+        while (start <= s.size()) {
+            const auto comma = s.find(',', start);
+            out.push_back(s.substr(start, comma - start));
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+        return out;
+    }
+
+    struct Options {
+        tb::bench::Options harness{};
+        tb::bench::SuiteConfig suite{};
+        bool ingest = false;              // --ingest
+        tb::bench::IngestConfig ingest_cfg{};
+        bool scaling = false;             // --scaling
+        tb::bench::ScalingConfig scaling_cfg{};
+        bool quality = false;             // --quality
+        tb::bench::QualityConfig quality_cfg{};
+        bool latency = false;             // --latency
+        tb::bench::LatencyConfig latency_cfg{};
+        std::string csv_path;
+        std::string json_path;
+        std::string save_path;
+        std::string compare_path;
+        tb::bench::CompareOptions compare{};
+        unsigned runs = 3;                // --runs: processes measured by --compare
+    };
+
+    Options parse_args(int argc, char** argv) {
+        Options opt;
+        bool k_given = false;
+        bool sizes_given = false;
+        bool reps_given = false;
+        bool corpus_given = false;
+        bool samples_given = false;
+        bool runs_given = false;
+        bool quick = false;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::runtime_error(arg + " requires an argument");
+                return argv[++i];
+            };
+            if (arg == "--help" || arg == "-h") {
+                print_usage(std::cout);
+                std::exit(0);
+            } else if (arg == "--filter") {
+                opt.harness.filter = value();
+            } else if (arg == "--k") {
+                k_given = true;
+                opt.suite.ks.clear();
+                for (const auto k : parse_list(value(), "k")) {
+                    if (k > 24) throw std::runtime_error("k out of range for benchmarks (max 24): " + std::to_string(k));
+                    opt.suite.ks.push_back(static_cast<unsigned>(k));
+                }
+            } else if (arg == "--sizes") {
+                sizes_given = true;
+                opt.suite.sizes.clear();
+                for (const auto n : parse_list(value(), "size")) {
+                    if (n == 0) throw std::runtime_error("sizes must be > 0");
+                    opt.suite.sizes.push_back(static_cast<std::size_t>(n));
+                }
+            } else if (arg == "--repetitions") {
+                opt.harness.repetitions = static_cast<unsigned>(parse_u64(value(), "repetitions"));
+                if (opt.harness.repetitions == 0) throw std::runtime_error("repetitions must be > 0");
+                reps_given = true;
+            } else if (arg == "--warmup") {
+                opt.harness.warmup = static_cast<unsigned>(parse_u64(value(), "warmup"));
+            } else if (arg == "--min-time-ms") {
+                opt.harness.min_rep_ms = static_cast<double>(parse_u64(value(), "min-time-ms"));
+            } else if (arg == "--quick") {
+                opt.suite.ks = {12};
+                opt.suite.sizes = {std::size_t{1} << 16};
+                opt.harness.repetitions = 10;
+                opt.harness.min_rep_ms = 5.0;
+                quick = true;
+            } else if (arg == "--no-counters") {
+                opt.harness.counters = false;
+            } else if (arg == "--json") {
+                opt.json_path = value();
+            } else if (arg == "--csv") {
+                opt.csv_path = value();
+            } else if (arg == "--scaling") {
+                opt.scaling = true;
+            } else if (arg == "--quality") {
+                opt.quality = true;
+            } else if (arg == "--latency") {
+                opt.latency = true;
+            } else if (arg == "--batches") {
+                opt.latency_cfg.batches.clear();
+                for (const auto b : parse_list(value(), "batch")) {
+                    if (b == 0 || b > 65536) throw std::runtime_error("batch out of range [1, 65536]: " + std::to_string(b));
+                    opt.latency_cfg.batches.push_back(static_cast<std::size_t>(b));
+                }
+            } else if (arg == "--samples") {
+                opt.latency_cfg.samples = parse_u64(value(), "samples");
+                if (opt.latency_cfg.samples == 0) throw std::runtime_error("samples must be > 0");
+                samples_given = true;
+            } else if (arg == "--dataset") {
+                opt.quality_cfg.files.push_back(value());
+            } else if (arg == "--slo-p") {
+                opt.quality_cfg.slo_p = parse_double(value(), "slo-p");
+            } else if (arg == "--slo-load") {
+                opt.quality_cfg.slo_load = parse_double(value(), "slo-load");
+            } else if (arg == "--strategies") {
+                opt.scaling_cfg.strategies.clear();
+                for (const auto& n : split_names(value())) {
+                    opt.scaling_cfg.strategies.push_back(tb::parse_histogram_strategy(n));
+                }
+            } else if (arg == "--stream-mb") {
+                const std::uint64_t mb = parse_u64(value(), "stream-mb");
+                if (mb == 0) throw std::runtime_error("stream-mb must be > 0");
+                opt.scaling_cfg.stream_bytes = static_cast<std::size_t>(mb << 20);
+            } else if (arg == "--save") {
+                opt.save_path = value();
+            } else if (arg == "--compare") {
+                opt.compare_path = value();
+            } else if (arg == "--runs") {
+                runs_given = true;
+                const auto n = parse_u64(value(), "runs");
+                if (n == 0 || n > 64) throw std::runtime_error("runs out of range [1, 64]: " + std::to_string(n));
+                opt.runs = static_cast<unsigned>(n);
+            } else if (arg == "--threshold") {
+                opt.compare.threshold = parse_double(value(), "threshold") / 100.0;
+            } else if (arg == "--alpha") {
+                opt.compare.alpha = parse_double(value(), "alpha");
+                if (opt.compare.alpha <= 0.0 || opt.compare.alpha >= 1.0) {
+                    throw std::runtime_error("alpha must be in (0, 1)");
+                }
+            } else if (arg == "--ingest") {
+                opt.ingest = true;
+            } else if (arg == "--corpus-dir") {
+                opt.ingest_cfg.corpus_dir = value();
+            } else if (arg == "--corpus-mb") {
+                const std::uint64_t mb = parse_u64(value(), "corpus-mb");
+                if (mb == 0) throw std::runtime_error("corpus-mb must be > 0");
+                opt.ingest_cfg.corpus_bytes = mb << 20;
+                corpus_given = true;
+            } else if (arg == "--formats") {
+                opt.ingest_cfg.kinds.clear();
+                for (const auto& n : split_names(value())) opt.ingest_cfg.kinds.push_back(tb::bench::parse_corpus_kind(n));
+            } else if (arg == "--readers") {
+                opt.ingest_cfg.readers.clear();
+                for (const auto& n : split_names(value())) opt.ingest_cfg.readers.push_back(tb::bench::parse_reader_kind(n));
+            } else if (arg == "--threads") {
+                opt.ingest_cfg.threads.clear();
+                for (const auto t : parse_list(value(), "threads")) {
+                    if (t == 0 || t > 1024) throw std::runtime_error("threads out of range [1, 1024]: " + std::to_string(t));
+                    opt.ingest_cfg.threads.push_back(static_cast<unsigned>(t));
+                }
+                opt.scaling_cfg.threads = opt.ingest_cfg.threads;
+                opt.latency_cfg.threads = opt.ingest_cfg.threads;
+            } else if (arg == "--cache") {
+                opt.ingest_cfg.caches.clear();
+                for (const auto& n : split_names(value())) opt.ingest_cfg.caches.push_back(tb::bench::parse_cache_mode(n));
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+
+        if (static_cast<int>(opt.ingest) + static_cast<int>(opt.scaling) + static_cast<int>(opt.quality) +
+            static_cast<int>(opt.latency) > 1) {
+            throw std::runtime_error("--ingest, --scaling, --quality and --latency are separate runs");
+        }
+        if (runs_given && opt.compare_path.empty()) {
+            throw std::runtime_error("--runs needs --compare");
+        }
+        if (opt.latency) {
+            if (!opt.csv_path.empty()) throw std::runtime_error("--csv is not available with --latency");
+            if (!opt.save_path.empty() || !opt.compare_path.empty()) {
+                throw std::runtime_error("--save/--compare are not available with --latency");
+            }
+            if (k_given) opt.latency_cfg.k = opt.suite.ks.front();
+            if (quick && !samples_given) opt.latency_cfg.samples = 20000;
+            opt.latency_cfg.filter = opt.harness.filter;
+        }
+        if (opt.quality) {
+            if (k_given) opt.quality_cfg.ks = opt.suite.ks;
+            if (sizes_given) {
+                opt.quality_cfg.size = opt.suite.sizes.front();
+            } else if (quick) {
+                opt.quality_cfg.size = std::size_t{1} << 18;
+            }
+            if (quick && !k_given) opt.quality_cfg.ks = {12};
+        }
+        if (opt.scaling) {
+            if (k_given || quick) opt.scaling_cfg.ks = opt.suite.ks;
+            if (sizes_given) {
+                opt.scaling_cfg.sizes = opt.suite.sizes;
+            } else if (quick) {
+                opt.scaling_cfg.sizes = {std::size_t{1} << 20};
+            }
+            if (quick) opt.scaling_cfg.stream_bytes = std::size_t{16} << 20;
+        }
+        if (opt.ingest) {
+            if (!opt.csv_path.empty()) throw std::runtime_error("--csv is not available with --ingest");
+            if (!opt.save_path.empty() || !opt.compare_path.empty()) {
+                throw std::runtime_error("--save/--compare are not available with --ingest");
+            }
+            if (k_given) opt.ingest_cfg.engine.k = opt.suite.ks.front();
+            if (reps_given) opt.ingest_cfg.repetitions = opt.harness.repetitions;
+            if (quick && !corpus_given) opt.ingest_cfg.corpus_bytes = 64ULL << 20;
+            opt.ingest_cfg.filter = opt.harness.filter;
+        }
+        return opt;
+    }
+}
+
+// ---------- main ----------
+int main(int argc, char** argv) {
+    try {
+        const Options opt = parse_args(argc, argv);
+        const bool json_stdout = (opt.json_path == "-");
+        // il baseline si legge prima di misurare: un file sbagliato fallisce subito
+        tb::bench::Baseline baseline;
+        if (!opt.compare_path.empty()) {
+            baseline = tb::bench::load_baseline(opt.compare_path);
+        }
+
+        if (opt.ingest) {
+            std::ostream& log = json_stdout ? std::cerr : std::cout;
+            const auto results = tb::bench::run_ingest_suite(opt.ingest_cfg, log);
+            if (results.empty()) {
+                throw std::runtime_error("No ingestion benchmark matches the selection");
+            }
+            const tb::bench::RunContext ctx = tb::bench::current_context(nullptr);
+            if (json_stdout) {
+                tb::bench::write_ingest_json(std::cout, ctx, results);
+            } else {
+                std::cout << "\nCPU: " << ctx.cpu << "\n"
+                        << "Build: " << (ctx.build_type.empty() ? "(none)" : ctx.build_type)
+                        << ", " << ctx.compiler << "\n"
+                        << "Engine: k=" << opt.ingest_cfg.engine.k << "; stage shares are of summed thread time\n\n";
+                tb::bench::print_ingest_table(std::cout, results);
+                if (!opt.json_path.empty()) {
+                    std::ofstream f{opt.json_path};
+                    if (!f) throw std::runtime_error("Cannot write " + opt.json_path);
+                    tb::bench::write_ingest_json(f, ctx, results);
+                }
+            }
+            return 0;
+        }
+
+        if (opt.latency) {
+            std::ostream& log = json_stdout ? std::cerr : std::cout;
+            const tb::bench::LatencyClock clock = tb::bench::latency_clock();
+            log << "Timer: " << clock.source << " (" << clock.ns_per_tick << " ns/tick)\n" << std::flush;
+            const auto results = tb::bench::run_latency_suite(opt.latency_cfg, clock);
+            if (results.empty()) {
+                throw std::runtime_error("No latency benchmark matches filter '" + opt.latency_cfg.filter + "'");
+            }
+            const tb::bench::RunContext ctx = tb::bench::current_context(nullptr);
+            if (json_stdout) {
+                tb::bench::write_latency_json(std::cout, ctx, clock, results);
+            } else {
+                std::cout << "CPU: " << ctx.cpu << "\n"
+                        << "Build: " << (ctx.build_type.empty() ? "(none)" : ctx.build_type)
+                        << ", " << ctx.compiler << "\n"
+                        << "Engine: k=" << opt.latency_cfg.k << "; latencies per call, timer overhead in latency/empty\n\n";
+                tb::bench::print_latency_table(std::cout, results);
+                if (!opt.json_path.empty()) {
+                    std::ofstream f{opt.json_path};
+                    if (!f) throw std::runtime_error("Cannot write " + opt.json_path);
+                    tb::bench::write_latency_json(f, ctx, clock, results);
+                }
+            }
+            return 0;
+        }
+
+        tb::bench::Harness harness{opt.harness};
+        std::vector<tb::bench::QualityRow> quality;
+        if (opt.scaling) {
+            tb::bench::run_scaling_suite(harness, opt.scaling_cfg);
+        } else if (opt.quality) {
+            quality = tb::bench::run_quality_suite(harness, opt.quality_cfg);
+        } else {
+            tb::bench::run_core_suite(harness, opt.suite);
+        }
+        if (harness.results().empty()) {
+            throw std::runtime_error("No benchmark matches filter '" + opt.harness.filter + "'");
+        }
+
+        const tb::bench::RunContext ctx = tb::bench::current_context(harness.counters());
+        if (!json_stdout) {
+            std::cout << "CPU: " << ctx.cpu << "\n"
+                    << "Build: " << (ctx.build_type.empty() ? "(none)" : ctx.build_type)
+                    << ", " << ctx.compiler << "\n"
+                    << "Perf counters: " << ctx.perf << "\n\n";
+            tb::bench::print_table(std::cout, harness.results());
+            std::cout << "\n";
+            tb::bench::print_counters(std::cout, harness.results());
+            if (opt.quality) {
+                std::cout << "\n";
+                tb::bench::print_quality_report(std::cout, quality, opt.quality_cfg);
+            }
+        }
+        if (json_stdout) {
+            tb::bench::write_json(std::cout, ctx, harness.results());
+        } else if (!opt.json_path.empty()) {
+            write_json_file(opt.json_path, ctx, harness.results());
+        }
+        if (!opt.save_path.empty()) {
+            write_json_file(opt.save_path, ctx, harness.results());
+        }
+        if (!opt.csv_path.empty()) {
+            std::ofstream f{opt.csv_path};
+            if (!f) throw std::runtime_error("Cannot write " + opt.csv_path);
+            tb::bench::write_scaling_csv(f, harness.results());
+        }
+
+        if (!opt.compare_path.empty()) {
+            std::ostream& os = json_stdout ? std::cerr : std::cout;
+            os << "\nBaseline: " << opt.compare_path << " (" << baseline.ctx.timestamp << ")\n";
+            if (baseline.ctx.cpu != ctx.cpu || baseline.ctx.build_type != ctx.build_type) {
+                os << "Warning: baseline recorded on '" << baseline.ctx.cpu << "' ("
+                   << (baseline.ctx.build_type.empty() ? "(none)" : baseline.ctx.build_type)
+                   << "), results may not be comparable\n";
+            }
+            // questa run è la prima; le altre girano ciascuna in un processo nuovo
+            std::vector<std::vector<tb::bench::BaselineEntry>> runs{tb::bench::to_entries(harness.results())};
+            for (unsigned r = 1; r < opt.runs; ++r) {
+                os << "Independent run " << r + 1 << "/" << opt.runs << "...\n" << std::flush;
+                runs.push_back(run_in_child(argc, argv));
+            }
+            const auto rows = tb::bench::compare_runs(baseline, runs, opt.compare);
+            tb::bench::print_comparison(os, rows);
+            const auto regressions = std::count_if(rows.begin(), rows.end(), [](const auto& r) {
+                return r.verdict == tb::bench::Verdict::Regression;
+            });
+            if (regressions > 0) {
+                os << "\n" << regressions << " regression(s) above " << 100.0 * opt.compare.threshold
+                   << "% (alpha = " << opt.compare.alpha << ") in all " << opt.runs << " run(s)\n";
+                return 2;
+            }
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n";
+        print_usage(std::cerr);
+        return 1;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    enum class HugePages {
+        Off,           // regular pages
+        Transparent,   // madvise(MADV_HUGEPAGE): the kernel backs the block with 2 MiB pages when it can
+        Explicit,      // MAP_HUGETLB from the reserved pool, Transparent when the pool is empty
+    };
+
+    /// "off", "thp", "explicit"
+    const char* huge_pages_name(HugePages h) noexcept;
+    /// Throws std::runtime_error on unknown names.
+    HugePages parse_huge_pages(const std::string& name);
+
+    struct ArenaOptions {
+        std::size_t block_bytes = std::size_t{64} << 20;   // minimum size of each mapping
+        HugePages huge_pages = HugePages::Transparent;     // only for blocks of at least one huge page
+    };
+
+    /// Monotonic std::pmr::memory_resource over anonymous mmap'd blocks (tb_io).
+    /// Allocation bumps a pointer under a lock, so one arena can serve every thread of a run.
+    /// Deallocation is a no-op, except that freeing the most recent allocation rolls it back;
+    /// blocks are unmapped by release() or the destructor. Pages are committed on first write,
+    /// so reserving for an upper bound (max_address_count) costs address space, not memory.
+    /// Mapped bytes are accounted under MemCategory::Arena.
+    class Arena final : public std::pmr::memory_resource {
+    public:
+        explicit Arena(const ArenaOptions& opt = {});
+        ~Arena() override;
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        /// Make the next `bytes` bytes of allocations fit in one mapping, mapping a new block
+        /// of at least that size if the current one is too small: presized containers are then
+        /// contiguous and never need a second block. std::bad_alloc if mmap fails.
+        void reserve(std::size_t bytes);
+
+        /// Unmap every block; memory handed out before becomes invalid.
+        void release() noexcept;
+
+        [[nodiscard]] std::size_t allocated() const noexcept;   // bytes handed out since the last release()
+        [[nodiscard]] std::size_t peak() const noexcept;        // highest allocated() (rollbacks lower allocated())
+        [[nodiscard]] std::size_t mapped() const noexcept;      // bytes of address space mapped
+        [[nodiscard]] std::size_t block_count() const noexcept;
+        /// True if some block is backed (or was advised to be backed) by huge pages.
+        [[nodiscard]] bool huge_pages() const noexcept;
+
+    private:
+        struct Block {
+            char* base;
+            std::size_t size;
+        };
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        void map_block(std::size_t min_bytes);   // mutex_ held
+
+        ArenaOptions opt_;
+        mutable std::mutex mutex_;
+        std::vector<Block> blocks_;
+        char* cur_ = nullptr;    // next free byte of the last block
+        char* end_ = nullptr;
+        char* last_ = nullptr;   // start of the most recent allocation (rollback)
+        std::size_t allocated_ = 0;
+        std::size_t peak_ = 0;
+        std::size_t mapped_ = 0;
+        bool huge_ = false;
+    };
+
+}
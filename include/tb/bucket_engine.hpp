@@ -1,15 +1,27 @@
 #pragma once
 
+#include "packed.hpp"
 #include "types.hpp"
+
+#include <cstdint>
+#include <memory_resource>
 #include <vector>
 
 namespace tb {
 
+    namespace detail {
+        struct BatchKernels;   // batch loops specialized for one k (bucket_engine.cpp)
+    }
+
     class BucketEngine {
     public:
         explicit BucketEngine(const Config& cfg);
 
-        [[nodiscard]] BucketIndex bucket_index(IPv4 ip) const noexcept;
+        // inline and branch-free: shift_ = 32 - min(k, 32), done on 64 bits so k = 0 gives 0
+        [[nodiscard]] BucketIndex bucket_index(IPv4 ip) const noexcept {
+            const auto y = static_cast<std::uint32_t>(static_cast<std::uint64_t>(cfg_.a) * ip + cfg_.b);
+            return static_cast<BucketIndex>(static_cast<std::uint64_t>(y) >> shift_);
+        }
 
         // bucketize arbitrary dataset
         std::vector<BucketIndex> bucketize(const std::vector<IPv4>& ips) const;
@@ -17,13 +29,42 @@ namespace tb {
         // histogram on arbitrary dataset
         std::vector<std::size_t> distribution(const std::vector<IPv4>& ips) const;
 
+        // weighted histogram: bucket of ips[i] receives weights[i] (e.g. flow bytes)
+        std::vector<std::size_t> distribution(const std::vector<IPv4>& ips,
+                                              const std::vector<std::size_t>& weights) const;
+
         // histogram on range [start, end)
         std::vector<std::size_t> distribution(IPv4 start, IPv4 end) const;
 
+        // Allocation-free batch forms over any contiguous range (vector, array, mmap'd file...).
+        // bucketize writes n indices to `out`; accumulate adds to the histogram already in
+        // `counts`, which must hold exactly config().bucket_count() entries (std::invalid_argument).
+        void bucketize(const IPv4* ips, std::size_t n, BucketIndex* out) const noexcept;
+        void accumulate(const IPv4* ips, std::size_t n, std::size_t* counts, std::size_t counts_size) const;
+        // weighted: bucket of ips[i] receives weights[i]
+        void accumulate(const IPv4* ips, const std::size_t* weights, std::size_t n,
+                        std::size_t* counts, std::size_t counts_size) const;
+
+        // Narrow outputs (1/4 and 1/2 of the bandwidth of BucketIndex): std::invalid_argument
+        // unless k <= 8, respectively k <= 16.
+        void bucketize(const IPv4* ips, std::size_t n, std::uint8_t* out) const;
+        void bucketize(const IPv4* ips, std::size_t n, std::uint16_t* out) const;
+        // overwrite each address with its bucket index
+        void bucketize_in_place(IPv4* data, std::size_t n) const noexcept;
+        // k-bit indices of ips[0, n) into out[offset, offset + n); needs out.bits() >= k
+        // (std::invalid_argument) and room for n indices (std::out_of_range)
+        void bucketize(const IPv4* ips, std::size_t n, PackedBuckets& out, std::size_t offset = 0) const;
+
+        // std::pmr forms: the result is allocated from `mr` (e.g. a tb::Arena) instead of the heap
+        std::pmr::vector<BucketIndex> bucketize(const IPv4* ips, std::size_t n, std::pmr::memory_resource* mr) const;
+        std::pmr::vector<std::size_t> distribution(const IPv4* ips, std::size_t n, std::pmr::memory_resource* mr) const;
+
         const Config& config() const noexcept { return cfg_; }
 
     private:
         Config cfg_;
+        unsigned shift_;
+        const detail::BatchKernels* kernels_;   // chosen once from k (BucketEngineFixed<k> when instantiated)
     };
 
 }
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tb {
+
+    /// BucketEngine with k fixed at compile time, header-only and fully inlinable:
+    /// bucket_index is one multiply, one add and one constant shift, with no branch on k.
+    /// The constructor is constexpr, so a `constexpr` engine also makes a and b constants:
+    ///
+    ///     constexpr tb::BucketEngineFixed<12> engine{0x9E3779B1u, 0x85EBCA77u};
+    ///     static_assert(engine.bucket_index(0) == 0x85EBCA77u >> 20);
+    ///
+    /// Results are identical to BucketEngine with the same Config.
+    template <unsigned K>
+    class BucketEngineFixed {
+        static_assert(K <= 32, "k must be <= 32");
+
+    public:
+        static constexpr unsigned k = K;
+        static constexpr std::size_t bucket_count = K >= 32 ? std::size_t{1} << 32 : std::size_t{1} << K;
+
+        constexpr BucketEngineFixed() noexcept = default;
+        constexpr BucketEngineFixed(std::uint32_t a, std::uint32_t b) noexcept : a_{a}, b_{b} {}
+        constexpr explicit BucketEngineFixed(const Config& cfg) noexcept : a_{cfg.a}, b_{cfg.b} {}
+
+        [[nodiscard]] constexpr BucketIndex bucket_index(IPv4 ip) const noexcept {
+            const auto y = static_cast<std::uint32_t>(static_cast<std::uint64_t>(a_) * ip + b_);
+            if constexpr (K == 0) {
+                return 0;
+            } else if constexpr (K >= 32) {
+                return y;
+            } else {
+                return y >> (32 - K);
+            }
+        }
+
+        void bucketize(const IPv4* ips, std::size_t n, BucketIndex* out) const noexcept {
+            for (std::size_t i = 0; i < n; ++i) out[i] = bucket_index(ips[i]);
+        }
+
+        /// Add ips[0, n) to `counts`, which must hold bucket_count entries (not checked).
+        void accumulate(const IPv4* ips, std::size_t n, std::size_t* counts) const noexcept {
+            for (std::size_t i = 0; i < n; ++i) counts[bucket_index(ips[i])] += 1;
+        }
+
+        void accumulate(const IPv4* ips, const std::size_t* weights, std::size_t n,
+                        std::size_t* counts) const noexcept {
+            for (std::size_t i = 0; i < n; ++i) counts[bucket_index(ips[i])] += weights[i];
+        }
+
+        [[nodiscard]] constexpr Config config() const noexcept { return Config{a_, b_, K}; }
+
+    private:
+        std::uint32_t a_ = Config{}.a;
+        std::uint32_t b_ = Config{}.b;
+    };
+
+}
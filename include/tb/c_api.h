@@ -0,0 +1,97 @@
+/*
+ * Stable C ABI of the bucketizer core, exported by the tb_core_shared library (libtb.so.1).
+ *
+ * Only this header is the contract: the C++ API behind it is not exported. Symbols carry the
+ * TB_1 version node; an incompatible change bumps TB_ABI_VERSION, the version node and the
+ * library SOVERSION together, so old callers keep loading the old library.
+ *
+ * Engines are immutable after tb_engine_create and can be shared by any number of threads.
+ * tb_engine_create is the only call that allocates; the batch functions work in place on caller
+ * memory and never throw, allocate or lock. Functions returning tb_status leave their outputs
+ * untouched on failure.
+ */
+#ifndef TB_C_API_H
+#define TB_C_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(TB_C_API_BUILD) && defined(__GNUC__)
+#define TB_API __attribute__((visibility("default")))
+#else
+#define TB_API
+#endif
+
+#define TB_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque engine handle. */
+typedef struct tb_engine tb_engine;
+
+typedef struct tb_config {
+    uint32_t a; /* affine multiplier (odd) */
+    uint32_t b; /* additive offset */
+    uint32_t k; /* bucket bits: 2^k buckets, k <= 32 */
+} tb_config;
+
+typedef struct tb_stats {
+    uint64_t sample_count;
+    uint64_t bucket_count;
+    double mean;
+    double stddev;
+    double chi2;
+    double p_value;    /* P(chi2 >= observed) with m - 1 degrees of freedom */
+    double uniformity; /* 0-100 % */
+    uint64_t max_load;
+} tb_stats;
+
+typedef enum tb_status {
+    TB_OK = 0,
+    TB_ERR_NULL = 1,     /* required pointer is NULL */
+    TB_ERR_CONFIG = 2,   /* k > 32 */
+    TB_ERR_SIZE = 3,     /* histogram size differs from the bucket count */
+    TB_ERR_NOMEM = 4,
+    TB_ERR_INTERNAL = 5
+} tb_status;
+
+/* TB_ABI_VERSION the library was built with: compare with the header at load time. */
+TB_API uint32_t tb_abi_version(void);
+/* Library version, e.g. "0.1.0". Static storage. */
+TB_API const char* tb_version(void);
+/* Short description of a status. Static storage. */
+TB_API const char* tb_status_string(tb_status status);
+
+/* The library defaults (same as tb::Config). */
+TB_API void tb_config_default(tb_config* cfg);
+
+TB_API tb_status tb_engine_create(const tb_config* cfg, tb_engine** out);
+/* NULL is ignored. */
+TB_API void tb_engine_destroy(tb_engine* engine);
+TB_API tb_status tb_engine_config(const tb_engine* engine, tb_config* out);
+/* 2^k; 0 for a NULL engine. */
+TB_API uint64_t tb_engine_bucket_count(const tb_engine* engine);
+
+/* Bucket of one address; 0 for a NULL engine. */
+TB_API uint32_t tb_bucket_index(const tb_engine* engine, uint32_t ip);
+
+/* out[i] = bucket of ips[i] for i < n (host byte order addresses). */
+TB_API tb_status tb_bucketize(const tb_engine* engine, const uint32_t* ips, size_t n, uint32_t* out);
+
+/* Add ips[0, n) to counts, which must hold counts_size == tb_engine_bucket_count() entries. */
+TB_API tb_status tb_accumulate(const tb_engine* engine, const uint32_t* ips, size_t n,
+                               size_t* counts, size_t counts_size);
+/* Same, the bucket of ips[i] receiving weights[i]. */
+TB_API tb_status tb_accumulate_weighted(const tb_engine* engine, const uint32_t* ips, const size_t* weights,
+                                        size_t n, size_t* counts, size_t counts_size);
+
+/* Statistics of a histogram of m buckets. */
+TB_API tb_status tb_stats_compute(const size_t* counts, size_t m, tb_stats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TB_C_API_H */
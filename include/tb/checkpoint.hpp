@@ -0,0 +1,75 @@
+#pragma once
+
+#include "bucket_engine.hpp"
+#include "ingest.hpp"
+#include "snapshot.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    /// Ingestion state of one input file: the histogram of its first `offset` bytes.
+    ///
+    /// Stored as a snapshot file (tb/snapshot.hpp) whose metadata carries the position, so
+    /// tb_merge can inspect it. `offset` always ends on a record boundary and counts and position
+    /// are written in one atomic rename: resuming from any checkpoint counts every record once.
+    struct IngestCheckpoint {
+        HistogramSnapshot histogram;       // counts of the records before `offset`
+        std::string input;                 // input path as given
+        std::uint64_t input_size = 0;      // identity of the input when the run started:
+        std::int64_t input_mtime_ns = 0;   //   size and modification time
+        InputFormat format = InputFormat::Text;
+        std::size_t csv_column = 0;
+        char csv_delimiter = ',';
+        std::uint64_t offset = 0;          // (decompressed) input bytes consumed
+        std::uint64_t lines = 0;           // records before `offset` (text formats)
+        std::uint64_t samples = 0;         // addresses counted
+        std::uint64_t sequence = 0;        // checkpoints written by this and previous runs
+    };
+
+    /// Write atomically (temporary file, fsync, rename) in the snapshot format.
+    void write_checkpoint_file(const std::string& path, const IngestCheckpoint& ck);
+
+    /// Throws std::runtime_error if the file is unreadable, corrupt or not a checkpoint.
+    IngestCheckpoint read_checkpoint_file(const std::string& path);
+
+    struct CheckpointOptions {
+        std::string path;                  // checkpoint file (required)
+        double interval_seconds = 60.0;    // write a checkpoint this often (0 = only on byte interval)
+        std::uint64_t interval_bytes = 0;  // and/or every this many input bytes (0 = off)
+        bool resume = false;               // continue from `path` if it exists
+        /// Called after every checkpoint written (progress reports); returning false stops the
+        /// run there, to be resumed later.
+        std::function<bool(const IngestCheckpoint&)> on_checkpoint;
+        /// Checked after every read block: when set, checkpoint and stop (set it from a signal handler).
+        const std::atomic<bool>* stop = nullptr;
+    };
+
+    // outcome of a resumable run
+    struct ResumableRun {
+        std::uint64_t samples = 0;          // addresses counted, including the resumed ones
+        std::uint64_t resumed_offset = 0;   // input bytes skipped thanks to the checkpoint
+        std::uint64_t resumed_samples = 0;
+        std::uint64_t input_bytes = 0;      // (decompressed) bytes consumed in total
+        std::uint64_t checkpoints = 0;      // written by this run
+        bool resumed = false;
+        bool complete = false;              // false if on_checkpoint or `stop` ended the run
+    };
+
+    /// Streaming accumulate_ipv4_file that checkpoints its progress to `ck.path`.
+    ///
+    /// With ck.resume and an existing checkpoint, `counts` is replaced by the checkpointed
+    /// histogram and parsing restarts at its offset (a seek, or decompress-and-discard for gzip).
+    /// The checkpoint must match the engine configuration, the ingest options and the input's
+    /// size and mtime, otherwise std::runtime_error. Once the input is exhausted the checkpoint
+    /// file is removed. Single threaded: parsing bounds the throughput of streamed input anyway.
+    /// `counts` must hold engine.config().bucket_count() entries.
+    ResumableRun accumulate_ipv4_file_resumable(const std::string& path, const IngestOptions& opt,
+                                                const BucketEngine& engine, std::vector<std::size_t>& counts,
+                                                const CheckpointOptions& ck);
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "flow.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace tb {
+
+    struct CollectorOptions {
+        std::string bind_address = "0.0.0.0";
+        std::uint16_t port = 2055;                    // 0 = ephemeral (see FlowCollector::port())
+        std::size_t batch = 64;                       // datagrams per recvmmsg call
+        std::chrono::milliseconds window{10000};      // stats publication period
+        FlowKey key = FlowKey::Both;
+        FlowWeight weight = FlowWeight::Bytes;
+        std::uint64_t max_windows = 0;                // 0 = run until stop()
+    };
+
+    /// UDP NetFlow v5 / IPFIX collector feeding a weighted bucket histogram.
+    /// Datagrams are received in batches (recvmmsg on Linux), decoded and
+    /// accumulated; every `window` a WindowReport is handed to the publisher.
+    class FlowCollector {
+    public:
+        using Publisher = std::function<void(const WindowReport&)>;
+
+        /// Binds the UDP socket. Throws std::runtime_error if the socket cannot be created or bound.
+        FlowCollector(const Config& cfg, const CollectorOptions& opt);
+        ~FlowCollector();
+
+        FlowCollector(const FlowCollector&) = delete;
+        FlowCollector& operator=(const FlowCollector&) = delete;
+
+        // actual bound port (useful when CollectorOptions::port == 0)
+        [[nodiscard]] std::uint16_t port() const noexcept { return port_; }
+
+        /// Receive loop; returns after max_windows windows or once stop() is called
+        /// (the partial window is published before returning).
+        void run(const Publisher& publish);
+
+        // thread-safe / async-signal-safe request to leave run()
+        void stop() noexcept { stop_.store(true, std::memory_order_relaxed); }
+
+        const FlowDecoder& decoder() const noexcept { return decoder_; }
+
+    private:
+        struct Batch; // recvmmsg scratch (headers, iovecs, peer addresses), allocated once
+
+        std::size_t receive_batch();
+
+        CollectorOptions opt_;
+        FlowDecoder decoder_;
+        FlowWindow window_;
+        std::vector<FlowRecord> records_;
+        std::vector<std::uint8_t> buffers_;
+        std::unique_ptr<Batch> batch_;
+        int fd_ = -1;
+        std::uint16_t port_ = 0;
+        std::atomic<bool> stop_{false};
+    };
+
+}
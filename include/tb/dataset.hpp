@@ -0,0 +1,111 @@
+#pragma once
+
+#include "bucket_engine.hpp"
+#include "stats.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace tb {
+
+    /// Rows [first, first + size) of a Dataset. `weights` is nullptr for unweighted datasets
+    /// (every row counts 1). Pointers stay valid only during the callback that receives the chunk.
+    struct Chunk {
+        const IPv4* ips = nullptr;
+        const std::size_t* weights = nullptr;
+        std::size_t size = 0;
+        std::uint64_t first = 0;
+    };
+
+    /// Decoder behind a streamed Dataset: writes up to `capacity` rows to `ips` (and to `weights`,
+    /// only when the dataset is weighted) and returns how many; 0 ends the dataset.
+    /// Called from one thread at a time.
+    using ChunkReader = std::function<std::size_t(IPv4* ips, std::size_t* weights, std::size_t capacity)>;
+
+    /// Sequence of fixed-size address chunks with an optional weight column, iterated the same way
+    /// whatever holds the rows:
+    ///  - views over memory (vectors, arrays, mmap'd files) hand out chunks in place, no copy;
+    ///  - streams pull rows from a ChunkReader into 64-byte aligned buffers, one per thread.
+    /// Every chunk has chunk_size() rows except the last one. Views can be iterated any number of
+    /// times; a stream is consumed by its first iteration.
+    class Dataset {
+    public:
+        static constexpr std::size_t kDefaultChunk = std::size_t{1} << 16;   // 256 KiB of addresses
+
+        /// View of ips[0, n) and, if not nullptr, weights[0, n). `owner` is kept alive with the
+        /// dataset (e.g. the mapping behind the pointers).
+        /// Chunk sizes are rounded up to a multiple of 16 rows (64 bytes of addresses).
+        static Dataset view(const IPv4* ips, std::size_t n, const std::size_t* weights = nullptr,
+                            std::size_t chunk = kDefaultChunk, std::shared_ptr<const void> owner = {});
+        /// View of a vector, which must outlive the dataset.
+        static Dataset view(const std::vector<IPv4>& ips, std::size_t chunk = kDefaultChunk);
+        /// Weighted view; std::invalid_argument if the sizes differ.
+        static Dataset view(const std::vector<IPv4>& ips, const std::vector<std::size_t>& weights,
+                            std::size_t chunk = kDefaultChunk);
+        /// Rows decoded on demand by `reader`.
+        static Dataset stream(ChunkReader reader, bool weighted = false, std::size_t chunk = kDefaultChunk);
+
+        Dataset(Dataset&&) noexcept;
+        Dataset& operator=(Dataset&&) noexcept;
+        ~Dataset();
+
+        [[nodiscard]] bool weighted() const noexcept;
+        [[nodiscard]] std::size_t chunk_size() const noexcept;
+        /// True for views: size() is known up front and chunks can be visited again.
+        [[nodiscard]] bool is_view() const noexcept;
+        /// Rows of a view; for a stream, the rows read so far.
+        [[nodiscard]] std::uint64_t size() const noexcept;
+
+        /// Call fn(chunk, thread) for every chunk. With threads == 1 chunks arrive in order on the
+        /// calling thread; otherwise `threads` workers (0: hardware_concurrency) each take the next
+        /// chunk as soon as they are done with the previous one, and `thread` in [0, threads) lets
+        /// fn keep per-thread state. Stream chunks are decoded under a lock, processed in parallel.
+        /// The first exception thrown by fn or the reader stops the iteration and is rethrown.
+        /// std::logic_error when iterating a stream a second time.
+        void for_each_chunk(const std::function<void(const Chunk&, unsigned thread)>& fn,
+                            unsigned threads = 1);
+
+        /// Worker count for_each_chunk(fn, threads) will start.
+        [[nodiscard]] unsigned worker_count(unsigned threads) const noexcept;
+
+    private:
+        struct Source;
+        explicit Dataset(std::unique_ptr<Source> src) noexcept;
+        std::unique_ptr<Source> src_;
+    };
+
+    /// engine.bucketize over the dataset: out[r] = bucket of row r. `out` must hold `capacity`
+    /// entries; std::out_of_range (after the rows that fit were written) if the dataset is larger.
+    /// Returns the rows written.
+    std::uint64_t bucketize(const BucketEngine& engine, Dataset& data, BucketIndex* out,
+                            std::size_t capacity, unsigned threads = 1);
+
+    /// Add the dataset (weighted when it has weights) to `counts`, which must hold
+    /// engine.config().bucket_count() entries. threads > 1 keeps one private histogram per worker.
+    /// Returns the rows counted.
+    std::uint64_t accumulate(const BucketEngine& engine, Dataset& data, std::vector<std::size_t>& counts,
+                             unsigned threads = 1);
+
+    /// Histogram of the dataset: the Dataset counterpart of BucketEngine::distribution.
+    std::vector<std::size_t> distribution(const BucketEngine& engine, Dataset& data, unsigned threads = 1);
+
+    /// compute_stats(distribution(engine, data, threads)).
+    StatsResult compute_stats(const BucketEngine& engine, Dataset& data, unsigned threads = 1);
+
+    /// Split the addresses into `parts` groups of contiguous bucket ranges, e.g. to route them to
+    /// shards: bucket b of m goes to part floor(b * parts / m). Weights are dropped.
+    /// Rows keep their order within a chunk; with threads > 1 the order of chunks within a part
+    /// is unspecified. std::invalid_argument if parts == 0.
+    std::vector<std::vector<IPv4>> partition(const BucketEngine& engine, Dataset& data, unsigned parts,
+                                             unsigned threads = 1);
+    /// Same, with the per-worker buffers and the parts allocated from `mr` (must be thread-safe
+    /// when threads > 1, as tb::Arena is).
+    std::vector<std::pmr::vector<IPv4>> partition(const BucketEngine& engine, Dataset& data, unsigned parts,
+                                                  unsigned threads, std::pmr::memory_resource* mr);
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    // one map task: the lines of `path` starting in [begin, end)
+    struct FileTask {
+        std::uint32_t id = 0;
+        std::uint64_t begin = 0;
+        std::uint64_t end = 0;
+    };
+
+    /// Split [0, file_size) into consecutive tasks of at most `chunk_bytes` bytes.
+    std::vector<FileTask> split_file(std::uint64_t file_size, std::uint64_t chunk_bytes);
+
+    struct CoordinatorOptions {
+        std::string bind_address = "0.0.0.0";
+        std::uint16_t port = 7070;                         // 0 = ephemeral (see Coordinator::port())
+        std::string path;                                  // input file, same path on every worker
+        std::uint64_t chunk_bytes = 64ULL * 1024 * 1024;
+        std::chrono::milliseconds task_timeout{std::chrono::minutes(10)};
+        unsigned max_attempts = 3;                         // per task, before the job fails
+    };
+
+    struct JobResult {
+        std::vector<std::size_t> counts;   // merged histogram, identical to a single-node run
+        StatsResult stats{};
+        std::uint64_t samples = 0;
+        std::uint64_t bytes = 0;
+        std::size_t tasks = 0;
+        std::size_t retries = 0;           // tasks reassigned after a worker failure/timeout
+        std::size_t workers = 0;           // distinct workers that connected
+    };
+
+    /// Map-reduce coordinator over TCP. Workers connect, receive byte-range tasks
+    /// of one text file, and return partial histograms that are summed exactly once
+    /// per task. Tasks of a dead or timed-out worker are reassigned.
+    class Coordinator {
+    public:
+        /// Binds the listening socket. Throws std::runtime_error on failure, or if cfg.k > 28
+        /// (a histogram that large does not fit one result message).
+        Coordinator(const Config& cfg, const CoordinatorOptions& opt);
+        ~Coordinator();
+
+        Coordinator(const Coordinator&) = delete;
+        Coordinator& operator=(const Coordinator&) = delete;
+
+        [[nodiscard]] std::uint16_t port() const noexcept { return port_; }
+
+        /// Runs the job to completion. Tasks whose worker fails to read the input (e.g. the file
+        /// is not visible yet on that host) are retried like those of lost workers. Throws
+        /// std::runtime_error if a task fails `max_attempts` times, tb::InputError (tb/ingest.hpp)
+        /// as soon as a worker reports an invalid line. Empty and gzip inputs (whose byte offsets
+        /// cannot be split) are refused with std::runtime_error before any worker is served.
+        JobResult run();
+
+    private:
+        Config cfg_;
+        CoordinatorOptions opt_;
+        int fd_ = -1;
+        std::uint16_t port_ = 0;
+    };
+
+    struct WorkerOptions {
+        std::string host = "127.0.0.1";
+        std::uint16_t port = 7070;
+        std::chrono::milliseconds connect_timeout{std::chrono::seconds(30)};
+    };
+
+    struct WorkerSummary {
+        std::size_t tasks = 0;
+        std::uint64_t samples = 0;
+    };
+
+    /// Connects to a coordinator (retrying until connect_timeout) and processes
+    /// tasks until the coordinator signals completion. Throws std::runtime_error on
+    /// connection failure or protocol errors; input errors are reported to the coordinator.
+    WorkerSummary run_worker(const WorkerOptions& opt);
+
+}
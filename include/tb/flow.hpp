@@ -0,0 +1,129 @@
+#pragma once
+
+#include "types.hpp"
+#include "bucket_engine.hpp"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace tb {
+
+    // one IPv4 flow extracted from a NetFlow v5 or IPFIX datagram
+    struct FlowRecord {
+        IPv4 src = 0;
+        IPv4 dst = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t packets = 0;
+        bool has_src = true;   // false for IPFIX templates without sourceIPv4Address
+        bool has_dst = true;   // false for IPFIX templates without destinationIPv4Address
+    };
+
+    /// Stateful decoder for NetFlow v5 and IPFIX (v10) export datagrams.
+    /// IPFIX templates are cached per (exporter, observation domain, template id);
+    /// data sets that arrive before their template are skipped and counted.
+    class FlowDecoder {
+    public:
+        /// Decode one datagram, appending every IPv4 flow to `out`. Returns the number of records appended.
+        /// Throws std::runtime_error on truncated or malformed datagrams and unsupported versions.
+        std::size_t decode(const std::uint8_t* data, std::size_t len,
+                           std::vector<FlowRecord>& out,
+                           std::uint64_t exporter = 0);
+
+        [[nodiscard]] std::size_t template_count() const noexcept { return templates_.size(); }
+
+        // data records dropped because the template was unknown or carried no IPv4 addresses
+        [[nodiscard]] std::uint64_t skipped_records() const noexcept { return skipped_; }
+
+    private:
+        struct Field {
+            std::uint16_t id = 0;
+            std::uint16_t length = 0;   // 0xFFFF = variable length
+            bool enterprise = false;
+        };
+
+        struct Template {
+            std::vector<Field> fields;
+            std::size_t min_len = 0;     // minimum bytes per record (variable fields count 1)
+        };
+
+        struct TemplateKey {
+            std::uint64_t exporter;
+            std::uint32_t domain;
+            std::uint16_t id;
+            bool operator<(const TemplateKey& o) const noexcept {
+                if (exporter != o.exporter) return exporter < o.exporter;
+                if (domain != o.domain) return domain < o.domain;
+                return id < o.id;
+            }
+        };
+
+        std::size_t decode_v5(const std::uint8_t* data, std::size_t len, std::vector<FlowRecord>& out);
+        std::size_t decode_ipfix(const std::uint8_t* data, std::size_t len,
+                                 std::vector<FlowRecord>& out, std::uint64_t exporter);
+        void parse_templates(const std::uint8_t* p, std::size_t len,
+                             std::uint64_t exporter, std::uint32_t domain, bool options);
+        std::size_t parse_data(const Template& t, const std::uint8_t* p, std::size_t len,
+                               std::vector<FlowRecord>& out);
+
+        std::map<TemplateKey, Template> templates_;
+        std::uint64_t skipped_ = 0;
+    };
+
+    // which address of a flow is bucketized
+    enum class FlowKey {
+        Src,
+        Dst,
+        Both
+    };
+
+    // weight added to the bucket for each flow
+    enum class FlowWeight {
+        Bytes,
+        Packets,
+        Flows
+    };
+
+    // histogram and stats of one collection window
+    struct WindowReport {
+        std::uint64_t index = 0;
+        double seconds = 0.0;             // wall-clock length of the window
+        std::vector<std::size_t> counts;  // weighted per-bucket load
+        StatsResult stats{};
+        std::uint64_t datagrams = 0;
+        std::uint64_t records = 0;
+        std::uint64_t decode_errors = 0;
+        std::uint64_t payload_bytes = 0;
+    };
+
+    /// Weighted histogram of flows over one window.
+    /// Equivalent to BucketEngine::distribution(ips, weights) over the selected key/weight columns.
+    class FlowWindow {
+    public:
+        FlowWindow(const Config& cfg, FlowKey key, FlowWeight weight);
+
+        /// Count the key addresses of `r`; a side the record does not carry is skipped.
+        void add(const FlowRecord& r) noexcept;
+        void add(const std::vector<FlowRecord>& records) noexcept;
+
+        void note_datagram(std::size_t payload_bytes) noexcept;
+        void note_decode_error() noexcept { ++errors_; }
+
+        // computes stats for the current window and starts a new one
+        WindowReport flush(double seconds);
+
+        const BucketEngine& engine() const noexcept { return engine_; }
+
+    private:
+        BucketEngine engine_;
+        FlowKey key_;
+        FlowWeight weight_;
+        std::vector<std::size_t> counts_;
+        std::uint64_t index_ = 0;
+        std::uint64_t datagrams_ = 0;
+        std::uint64_t records_ = 0;
+        std::uint64_t errors_ = 0;
+        std::uint64_t payload_bytes_ = 0;
+    };
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "bucket_engine.hpp"
+#include "dataset.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    /// Invalid record in the input, with its position. Unlike I/O errors it is deterministic:
+    /// reading the same input again fails the same way.
+    struct InputError : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    /// Bytes read from an input file per I/O call (one heap buffer per reader; estimate_footprint counts it).
+    inline constexpr std::size_t kReadBlock = std::size_t{1} << 20;
+
+    /// Trim `line` in place and parse it as a dotted-quad IPv4.
+    /// Returns false for blank lines and '#' comments; throws std::runtime_error on invalid addresses.
+    bool parse_ipv4_line(std::string& line, IPv4& out);
+
+    enum class InputFormat {
+        Text,     // one dotted quad per line, blank lines and '#' comments ignored
+        Csv,      // one field of each delimited line; an unparsable first line is a header
+        Log,      // first dotted-quad token of each line (syslog/web logs); lines without one are skipped
+        Binary,   // 4-byte records in network byte order
+    };
+
+    /// "text", "csv", "log", "binary". Throws std::runtime_error on unknown names.
+    InputFormat parse_input_format(const std::string& name);
+    const char* input_format_name(InputFormat f) noexcept;
+
+    struct IngestOptions {
+        InputFormat format = InputFormat::Text;
+        std::size_t csv_column = 0;      // 0-based field index
+        char csv_delimiter = ',';
+        bool csv_header = true;          // allow the first line to be a header (false for mid-file ranges)
+    };
+
+    /// True when gzip input can be decompressed (tb_io built with zlib).
+    bool gzip_supported() noexcept;
+
+    /// Sequential byte source over one file. Gzip files (detected by their magic number,
+    /// concatenated members allowed) are decompressed transparently.
+    class InputReader {
+    public:
+        /// Throws std::runtime_error if the file cannot be opened, or is gzip without zlib support.
+        explicit InputReader(const std::string& path);
+        ~InputReader();
+
+        InputReader(const InputReader&) = delete;
+        InputReader& operator=(const InputReader&) = delete;
+
+        /// Up to `n` bytes of (decompressed) content; 0 at end of input. Throws std::runtime_error on errors.
+        std::size_t read(char* buf, std::size_t n);
+
+        /// Skip the next `n` bytes of content: a seek for plain files, decompress-and-discard for gzip.
+        /// Returns the bytes skipped (fewer at end of input). Throws std::runtime_error on errors.
+        std::uint64_t skip(std::uint64_t n);
+
+        [[nodiscard]] bool compressed() const noexcept;
+        [[nodiscard]] std::uint64_t file_bytes() const noexcept;   // bytes consumed from the file so far
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    /// Incremental parser for every InputFormat: chunks may split records anywhere.
+    class Ipv4Parser {
+    public:
+        explicit Ipv4Parser(const IngestOptions& opt = {});
+
+        /// Append the addresses of the records completed by [data, data + n) to `out`.
+        /// Throws InputError on invalid records (with their line number).
+        void feed(const char* data, std::size_t n, std::vector<IPv4>& out);
+        void feed(const char* data, std::size_t n, std::pmr::vector<IPv4>& out);
+
+        /// Parse the final record when the input does not end with a newline.
+        /// Throws InputError if binary input ends with a partial record.
+        void finish(std::vector<IPv4>& out);
+        void finish(std::pmr::vector<IPv4>& out);
+
+        [[nodiscard]] std::uint64_t lines() const noexcept { return line_no_; }    // text formats
+        [[nodiscard]] std::uint64_t skipped() const noexcept { return skipped_; }  // headers, log lines without address
+        /// Bytes fed but not parsed yet (incomplete last record): the input consumed so far
+        /// ends on a record boundary `pending_bytes()` bytes before the end of what was fed.
+        [[nodiscard]] std::size_t pending_bytes() const noexcept { return carry_.size(); }
+
+        /// Continue numbering after `lines` records parsed elsewhere (resumed input): error
+        /// messages keep their line numbers and a CSV header is only looked for on line 1.
+        void restart_at(std::uint64_t lines) noexcept { line_no_ = lines; }
+
+    private:
+        // Out: std::vector<IPv4> or std::pmr::vector<IPv4> (ingest.cpp)
+        template <class Out>
+        void feed_into(const char* data, std::size_t n, Out& out);
+        template <class Out>
+        void finish_into(Out& out);
+        template <class Out>
+        void feed_block(const char* data, std::size_t n, Out& out);
+        template <class Out>
+        void parse_record(const char* begin, const char* end, Out& out);
+
+        IngestOptions opt_;
+        std::string carry_;              // incomplete record from the previous chunk
+        std::uint64_t line_no_ = 0;
+        std::uint64_t skipped_ = 0;
+    };
+
+    /// Read every address of a text file (one per line, blank lines and '#' comments ignored).
+    /// Throws std::runtime_error if the file cannot be opened or a line is invalid (with its line number).
+    std::vector<IPv4> read_ipv4_file(const std::string& path);
+
+    /// Read every address of a file in the given format (gzip decompressed transparently).
+    std::vector<IPv4> read_ipv4_file(const std::string& path, const IngestOptions& opt);
+
+    /// Same, into a vector allocated from `mr` and reserved for `expected` addresses up front
+    /// (e.g. max_address_count(): with a tb::Arena only the pages actually filled are committed),
+    /// so no reallocation copies the addresses while the file is parsed.
+    std::pmr::vector<IPv4> read_ipv4_file(const std::string& path, const IngestOptions& opt,
+                                          std::pmr::memory_resource* mr, std::uint64_t expected = 0);
+
+    /// Upper bound on the addresses in a file, from its size and format (shortest text record
+    /// "1.1.1.1\n", 4 bytes per binary record). std::nullopt for gzip files: their decompressed
+    /// size has no bound short of decompressing them (the trailer only keeps it modulo 2^32).
+    /// Throws std::runtime_error if the file cannot be opened.
+    std::optional<std::uint64_t> max_address_count(const std::string& path, const IngestOptions& opt);
+
+    /// Streamed Dataset over a file in any format (gzip decompressed transparently), decoded one
+    /// read block at a time as chunks are requested: memory stays bounded whatever the input size.
+    /// Parse errors surface from the iteration. Throws std::runtime_error if the file cannot be opened.
+    /// If `file_bytes` is not nullptr it tracks the file bytes (compressed for gzip) behind the rows
+    /// delivered so far, pro rata of the rows decoded ahead, e.g. to report how much of the file an
+    /// early-stopped iteration read; it must outlive the dataset.
+    Dataset ipv4_file_dataset(const std::string& path, const IngestOptions& opt,
+                              std::size_t chunk = Dataset::kDefaultChunk, std::uint64_t* file_bytes = nullptr);
+
+    /// Streaming counterpart of read_ipv4_file + distribution: accumulate() over
+    /// ipv4_file_dataset(path, opt), so memory stays bounded whatever the input size.
+    /// `counts` must hold engine.config().bucket_count() entries. Returns the addresses counted.
+    std::uint64_t accumulate_ipv4_file(const std::string& path, const IngestOptions& opt,
+                                       const BucketEngine& engine, std::vector<std::size_t>& counts);
+
+    // outcome of processing one byte range of a text file
+    struct RangeCounts {
+        std::uint64_t samples = 0;   // addresses accumulated
+        std::uint64_t bytes = 0;     // bytes of the lines owned by the range (the last one may cross `end`)
+    };
+
+    /// Accumulate into `counts` the addresses of every line whose first byte lies in [begin, end).
+    /// Ranges that tile a file therefore see each line exactly once, whatever the split points.
+    /// `counts` must hold engine.config().bucket_count() entries.
+    /// Throws InputError on invalid lines (with their byte offset), std::runtime_error on I/O failure.
+    RangeCounts accumulate_ipv4_range(const std::string& path,
+                                      std::uint64_t begin, std::uint64_t end,
+                                      const BucketEngine& engine,
+                                      std::vector<std::size_t>& counts);
+
+}
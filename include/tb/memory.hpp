@@ -0,0 +1,105 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace tb {
+
+    /// What accounted memory is used for.
+    enum class MemCategory : std::size_t {
+        Histogram,   // per-thread counters
+        Buffers,     // read blocks, scatter buffers
+        Arena,       // address space mapped by tb::Arena (tb_io), committed on first write
+        Count
+    };
+
+    inline constexpr std::size_t kMemCategoryCount = static_cast<std::size_t>(MemCategory::Count);
+
+    /// "histogram", "buffers", "arena"
+    const char* memory_category_name(MemCategory c) noexcept;
+
+    struct MemoryUsage {
+        std::uint64_t current = 0;       // bytes allocated now
+        std::uint64_t peak = 0;          // highest `current` since the last reset
+        std::uint64_t allocations = 0;   // allocate() calls since the last reset
+    };
+
+    /// Process-wide totals of the memory allocated through CountingAllocator.
+    [[nodiscard]] MemoryUsage memory_usage(MemCategory c) noexcept;
+    /// Peak of the sum over all categories (not the sum of per-category peaks).
+    [[nodiscard]] std::uint64_t memory_peak_total() noexcept;
+    /// Restart peaks and allocation counts from the current usage.
+    void reset_memory_peaks() noexcept;
+
+    namespace detail {
+        void note_alloc(MemCategory c, std::size_t bytes) noexcept;
+        void note_free(MemCategory c, std::size_t bytes) noexcept;
+    }
+
+    /// std::allocator replacement that accounts every byte under a category. Allocators of
+    /// different categories compare unequal, so memory is always freed under its own category.
+    template <class T>
+    class CountingAllocator {
+    public:
+        using value_type = T;
+
+        explicit CountingAllocator(MemCategory c = MemCategory::Buffers) noexcept : category_{c} {}
+        template <class U>
+        CountingAllocator(const CountingAllocator<U>& other) noexcept : category_{other.category()} {}
+
+        T* allocate(std::size_t n) {
+            if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+            T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+            detail::note_alloc(category_, n * sizeof(T));
+            return p;
+        }
+        void deallocate(T* p, std::size_t n) noexcept {
+            detail::note_free(category_, n * sizeof(T));
+            ::operator delete(p);
+        }
+
+        [[nodiscard]] MemCategory category() const noexcept { return category_; }
+
+        template <class U>
+        bool operator==(const CountingAllocator<U>& o) const noexcept { return category_ == o.category(); }
+        template <class U>
+        bool operator!=(const CountingAllocator<U>& o) const noexcept { return category_ != o.category(); }
+
+    private:
+        MemCategory category_;
+    };
+
+    template <class T>
+    using counted_vector = std::vector<T, CountingAllocator<T>>;
+
+    /// std::pmr counterpart of CountingAllocator: new/delete, accounted under `c`. The default
+    /// scratch resource of the std::pmr overloads; one process-wide instance per category.
+    [[nodiscard]] std::pmr::memory_resource* counting_resource(MemCategory c) noexcept;
+
+    /// Expected peak heap usage of one in-memory run (addresses held in a growing vector).
+    struct Footprint {
+        std::uint64_t addresses = 0;         // upper bound on the addresses of the input
+        std::uint64_t address_bytes = 0;     // vector of addresses during its last reallocation (or one block)
+        std::uint64_t histogram_bytes = 0;   // result + per-thread histograms
+        std::uint64_t buffer_bytes = 0;      // read block, parser state and Partitioned scatter buffers
+
+        [[nodiscard]] std::uint64_t total() const noexcept { return address_bytes + histogram_bytes + buffer_bytes; }
+    };
+
+    /// Footprint of bucketing `addresses` addresses held in memory with `threads` histogram
+    /// threads and `strategy`: PerThread adds a histogram per thread, Partitioned one bucket
+    /// index per address in its scatter buffers. Pass addresses = 0 for runs that stream their
+    /// input one block at a time (accumulate_ipv4_file). `presized`: the address vector is
+    /// reserved once for `addresses` (e.g. in a tb::Arena) instead of growing by reallocation.
+    Footprint estimate_footprint(const Config& cfg, std::uint64_t addresses, unsigned threads,
+                                 bool presized = false,
+                                 HistogramStrategy strategy = HistogramStrategy::PerThread) noexcept;
+
+}
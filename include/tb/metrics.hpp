@@ -0,0 +1,62 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tb {
+
+    // (bucket, load) pairs, heaviest first
+    using BucketLoads = std::vector<std::pair<BucketIndex, std::size_t>>;
+
+    // everything a metrics scrape needs, precomputed by the producer
+    struct MetricsSnapshot {
+        Config cfg{};
+        StatsResult stats{};
+        BucketLoads top_buckets;              // top-N only: scrape cost does not depend on k
+        std::uint64_t windows_total = 0;
+        std::uint64_t records_total = 0;
+        std::uint64_t datagrams_total = 0;
+        std::uint64_t payload_bytes_total = 0;
+        std::uint64_t decode_errors_total = 0;
+        double records_per_second = 0.0;      // ingest rate of the last window
+        double window_seconds = 0.0;
+    };
+
+    /// The `n` heaviest buckets of a histogram (ties broken by lower index), O(m log n).
+    BucketLoads top_buckets(const std::vector<std::size_t>& counts, std::size_t n);
+
+    /// Render a snapshot in Prometheus text format 0.0.4, or OpenMetrics 1.0 when `openmetrics` is true.
+    std::string render_metrics(const MetricsSnapshot& s, bool openmetrics);
+
+    /// Single-producer / single-consumer triple buffer.
+    /// publish() and latest() never block each other and never allocate
+    /// beyond the snapshot's own copy; the consumer always sees a complete snapshot.
+    class SnapshotExchange {
+    public:
+        // producer side
+        void publish(MetricsSnapshot s);
+
+        // consumer side: most recent published snapshot (stays valid until the next latest() call)
+        const MetricsSnapshot& latest();
+
+        [[nodiscard]] std::uint64_t generation() const noexcept {
+            return generation_.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr unsigned kFresh = 0x4u;
+
+        std::array<MetricsSnapshot, 3> slots_{};
+        std::atomic<unsigned> middle_{1};
+        unsigned back_ = 0;   // owned by the producer
+        unsigned front_ = 2;  // owned by the consumer
+        std::atomic<std::uint64_t> generation_{0};
+    };
+
+}
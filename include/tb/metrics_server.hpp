@@ -0,0 +1,47 @@
+#pragma once
+
+#include "metrics.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace tb {
+
+    struct MetricsServerOptions {
+        std::string bind_address = "0.0.0.0";
+        std::uint16_t port = 9464;   // 0 = ephemeral (see MetricsServer::port())
+    };
+
+    /// Minimal HTTP/1.1 endpoint serving GET /metrics from a SnapshotExchange.
+    /// One background thread handles one connection at a time (Connection: close);
+    /// it is the exchange's only consumer. No dependencies beyond POSIX sockets.
+    class MetricsServer {
+    public:
+        /// Binds and starts listening. Throws std::runtime_error if the socket cannot be bound.
+        MetricsServer(SnapshotExchange& exchange, const MetricsServerOptions& opt);
+        ~MetricsServer();
+
+        MetricsServer(const MetricsServer&) = delete;
+        MetricsServer& operator=(const MetricsServer&) = delete;
+
+        [[nodiscard]] std::uint16_t port() const noexcept { return port_; }
+        [[nodiscard]] std::uint64_t scrapes() const noexcept { return scrapes_.load(std::memory_order_relaxed); }
+
+        // stops the server thread (also done by the destructor)
+        void stop() noexcept;
+
+    private:
+        void serve();
+        void handle(int client);
+
+        SnapshotExchange& exchange_;
+        int fd_ = -1;
+        std::uint16_t port_ = 0;
+        std::atomic<bool> stop_{false};
+        std::atomic<std::uint64_t> scrapes_{0};
+        std::thread thread_;
+    };
+
+}
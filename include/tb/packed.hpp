@@ -0,0 +1,69 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tb {
+
+    /// Fixed-size array of `bits`-bit bucket indices (bits = k), packed back to back in
+    /// little-endian 64-bit words: 2^32 indices at k = 12 take 6 GiB instead of 16.
+    /// Values are stored in blocks of 64 (exactly `bits` words per block), so bulk pack/unpack
+    /// runs one fixed-shift kernel per block and random access never crosses a block.
+    class PackedBuckets {
+    public:
+        PackedBuckets() = default;
+        /// `n` zero indices of `bits` bits each; std::invalid_argument if bits > 32.
+        PackedBuckets(unsigned bits, std::size_t n);
+
+        [[nodiscard]] unsigned bits() const noexcept { return bits_; }
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+        [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+        /// Random access; i < size() is not checked.
+        [[nodiscard]] BucketIndex operator[](std::size_t i) const noexcept {
+            if (bits_ == 0) return 0;
+            const std::uint64_t bit = static_cast<std::uint64_t>(i) * bits_;
+            const std::size_t w = static_cast<std::size_t>(bit / 64);
+            const unsigned shift = static_cast<unsigned>(bit % 64);
+            std::uint64_t v = words_[w] >> shift;
+            if (shift + bits_ > 64) v |= words_[w + 1] << (64 - shift);
+            return static_cast<BucketIndex>(v & mask());
+        }
+
+        /// Store the low `bits` bits of `v` at index i (i < size() is not checked).
+        void set(std::size_t i, BucketIndex v) noexcept {
+            if (bits_ == 0) return;
+            const std::uint64_t value = v & mask();
+            const std::uint64_t bit = static_cast<std::uint64_t>(i) * bits_;
+            const std::size_t w = static_cast<std::size_t>(bit / 64);
+            const unsigned shift = static_cast<unsigned>(bit % 64);
+            words_[w] = (words_[w] & ~(mask() << shift)) | (value << shift);
+            if (shift + bits_ > 64) {
+                const unsigned spill = 64 - shift;
+                words_[w + 1] = (words_[w + 1] & ~(mask() >> spill)) | (value >> spill);
+            }
+        }
+
+        /// Store in[0, n) at indices [offset, offset + n); std::out_of_range past size().
+        void pack(std::size_t offset, const BucketIndex* in, std::size_t n);
+        /// Load indices [offset, offset + n) into out; std::out_of_range past size().
+        void unpack(std::size_t offset, std::size_t n, BucketIndex* out) const;
+
+        [[nodiscard]] const std::uint64_t* words() const noexcept { return words_.data(); }
+        [[nodiscard]] std::size_t word_count() const noexcept { return words_.size(); }
+        [[nodiscard]] std::size_t bytes() const noexcept { return words_.size() * sizeof(std::uint64_t); }
+
+    private:
+        [[nodiscard]] std::uint64_t mask() const noexcept {
+            return bits_ >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits_) - 1;
+        }
+
+        unsigned bits_ = 0;
+        std::size_t size_ = 0;
+        std::vector<std::uint64_t> words_;
+    };
+
+}
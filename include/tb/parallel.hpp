@@ -0,0 +1,48 @@
+#pragma once
+
+#include "bucket_engine.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    /// How threads share the histogram in parallel_distribution.
+    enum class HistogramStrategy {
+        SharedAtomic,   // one histogram of atomic counters, relaxed fetch_add from every thread
+        PerThread,      // private histogram per thread, reduced by bucket ranges at the end
+        Partitioned,    // pass 1 scatters bucket indices by owner thread, pass 2 counts owned ranges
+    };
+
+    /// "shared-atomic", "per-thread", "partitioned"
+    const char* histogram_strategy_name(HistogramStrategy s) noexcept;
+    /// Throws std::runtime_error on unknown names.
+    HistogramStrategy parse_histogram_strategy(const std::string& name);
+
+    /// Multi-threaded BucketEngine::distribution(ips): identical counts for every strategy and
+    /// thread count. `threads` = 0 uses std::thread::hardware_concurrency(); it is capped at
+    /// ips.size(). Threads are started per call, so small inputs are dominated by their startup.
+    std::vector<std::size_t> parallel_distribution(const BucketEngine& engine,
+                                                   const std::vector<IPv4>& ips,
+                                                   unsigned threads,
+                                                   HistogramStrategy strategy);
+
+    /// Add ips[0, n) to `counts` (counts_size must be engine.config().bucket_count(), else
+    /// std::invalid_argument) with `threads` threads. Per-thread histograms and the Partitioned
+    /// scatter buffers come from `scratch`, which must be thread-safe (tb::Arena is); nullptr
+    /// uses the accounted heap (counting_resource).
+    void parallel_accumulate(const BucketEngine& engine, const IPv4* ips, std::size_t n,
+                             std::size_t* counts, std::size_t counts_size,
+                             unsigned threads, HistogramStrategy strategy,
+                             std::pmr::memory_resource* scratch = nullptr);
+
+    /// parallel_distribution with the result and every buffer allocated from `mr`.
+    std::pmr::vector<std::size_t> parallel_distribution(const BucketEngine& engine, const IPv4* ips,
+                                                        std::size_t n, unsigned threads,
+                                                        HistogramStrategy strategy,
+                                                        std::pmr::memory_resource* mr);
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    // UDP/IPv4 datagram extracted from a capture record
+    struct UdpDatagram {
+        std::uint32_t ts_sec = 0;
+        std::uint32_t ts_usec = 0;
+        IPv4 src = 0;
+        IPv4 dst = 0;
+        std::uint16_t src_port = 0;
+        std::uint16_t dst_port = 0;
+        std::vector<std::uint8_t> payload;
+    };
+
+    /// Sequential reader for classic libpcap capture files (both byte orders,
+    /// micro/nanosecond timestamps). Supported link types: Ethernet (with 802.1Q),
+    /// raw IPv4, Linux cooked (SLL) and BSD loopback. Non UDP/IPv4 and
+    /// fragmented packets are skipped.
+    class PcapReader {
+    public:
+        /// Opens the capture and validates the global header. Throws std::runtime_error on failure.
+        explicit PcapReader(const std::string& path);
+
+        /// Reads the next UDP datagram; returns false at end of file.
+        /// Throws std::runtime_error on a truncated record.
+        bool next(UdpDatagram& out);
+
+        [[nodiscard]] std::uint32_t link_type() const noexcept { return link_type_; }
+        [[nodiscard]] std::uint64_t skipped() const noexcept { return skipped_; }
+
+    private:
+        bool extract(const std::uint8_t* p, std::size_t len, UdpDatagram& out) const;
+        std::uint32_t host32(const std::uint8_t* p) const noexcept;
+
+        std::ifstream in_;
+        std::string path_;
+        std::vector<std::uint8_t> record_;
+        std::uint32_t link_type_ = 0;
+        bool swapped_ = false;
+        bool nanos_ = false;
+        std::uint64_t skipped_ = 0;
+    };
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tb {
+
+    enum class PerfEvent : std::size_t {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1DMisses,      // L1 data cache read misses
+        LLCMisses,      // last-level cache read misses
+        DTLBMisses,     // data TLB read misses
+        PageFaults,     // software event, available even without a PMU
+        Count
+    };
+
+    inline constexpr std::size_t kPerfEventCount = static_cast<std::size_t>(PerfEvent::Count);
+
+    /// "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses", "dtlb_misses", "page_faults"
+    const char* perf_event_name(PerfEvent e) noexcept;
+
+    struct PerfReading {
+        std::array<std::uint64_t, kPerfEventCount> values{};  // scaled for multiplexing
+        std::array<bool, kPerfEventCount> valid{};
+
+        [[nodiscard]] bool has(PerfEvent e) const noexcept { return valid[static_cast<std::size_t>(e)]; }
+        [[nodiscard]] std::uint64_t get(PerfEvent e) const noexcept { return values[static_cast<std::size_t>(e)]; }
+        [[nodiscard]] double per(PerfEvent e, std::uint64_t elements) const noexcept {
+            return elements == 0 ? 0.0 : static_cast<double>(get(e)) / static_cast<double>(elements);
+        }
+    };
+
+    /// Hardware/software counters of the calling thread and of the threads it starts after
+    /// construction (user space only) via perf_event_open with `inherit`, so the readings of a
+    /// parallel phase cover all its threads. Threads that already existed are not counted.
+    ///
+    /// Events are opened in groups that are scheduled together (core: cycles, instructions, branch
+    /// misses; memory: L1D, LLC, dTLB misses; software: page faults), so ratios within a group are
+    /// consistent. Events the kernel refuses (no PMU, perf_event_paranoid, seccomp) are simply
+    /// missing from the readings; construction never throws.
+    class PerfCounters {
+    public:
+        PerfCounters();
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        [[nodiscard]] bool available() const noexcept;              // at least one event opened
+        [[nodiscard]] bool hardware_available() const noexcept;     // at least one PMU event opened
+        [[nodiscard]] bool supported(PerfEvent e) const noexcept;
+        [[nodiscard]] const std::string& status() const noexcept { return status_; }  // first open error
+
+        void start() noexcept;           // reset and enable all groups
+        PerfReading stop() noexcept;     // disable and read
+
+    private:
+        static constexpr std::size_t kGroups = 3;
+
+        std::array<int, kPerfEventCount> fds_{};
+        std::array<int, kGroups> leaders_{};
+        std::string status_;
+    };
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    /// Named (a, b) parameters of the affine hash.
+    struct Preset {
+        std::string name;
+        std::uint32_t a = 0;     // odd multiplier
+        std::uint32_t b = 0;
+        std::string note;
+    };
+
+    /// Every built-in preset, "default" first.
+    const std::vector<Preset>& presets();
+
+    /// nullptr if `name` is not a preset.
+    const Preset* find_preset(const std::string& name) noexcept;
+
+    /// Set cfg.a / cfg.b from a preset (k is left alone). Throws std::runtime_error on unknown names.
+    void apply_preset(Config& cfg, const std::string& name);
+
+}
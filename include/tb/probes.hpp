@@ -0,0 +1,103 @@
+#pragma once
+
+// Static tracepoints (USDT / SystemTap SDT) for attaching bpftrace, perf or SystemTap to a
+// running process. Self-contained: no <sys/sdt.h> needed.
+//
+// Each probe site compiles to a single NOP plus an ELF note (.note.stapsdt) that records
+// its address, the provider ("tb"), the probe name and where each argument lives. A tracer
+// patches the NOP with a breakpoint when it attaches; otherwise nothing executes. Arguments
+// are evaluated at the probe site even when no tracer is attached, so pass values that the
+// surrounding code already has at hand.
+//
+//   bpftrace -e 'usdt:./tb_cli:tb:bucketize__start { @items = hist(arg0); }'
+//
+// Every argument is passed as a 64-bit unsigned value; pointers are passed as addresses
+// (read them with str() / buf() in bpftrace).
+//
+// Set to 0 (CMake: -DTB_ENABLE_PROBES=OFF) to compile every probe down to nothing. Probes are
+// only emitted for ELF targets on x86-64 and AArch64; elsewhere they are always compiled out.
+
+#include <cstdint>
+#include <type_traits>
+
+#ifndef TB_PROBES
+#define TB_PROBES 1
+#endif
+
+#if TB_PROBES && defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+#define TB_PROBES_ENABLED 1
+#else
+#define TB_PROBES_ENABLED 0
+#endif
+
+namespace tb::detail {
+
+    template <class T>
+    [[nodiscard]] inline std::uint64_t probe_arg(T v) noexcept {
+        if constexpr (std::is_pointer_v<T>) {
+            return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(v));
+        } else {
+            return static_cast<std::uint64_t>(v);
+        }
+    }
+
+}
+
+#if TB_PROBES_ENABLED
+
+// Note layout (version 3): pc, link-time address of _.stapsdt.base (lets tools adjust for
+// prelink), semaphore address (0: none), provider, name, argument string "8@<operand> ...".
+#define TB_PROBE_ASM_(name, args, ...)                                                          \
+    __asm__ __volatile__("990: nop\n"                                                           \
+                         ".pushsection .note.stapsdt,\"?\",\"note\"\n"                          \
+                         ".balign 4\n"                                                          \
+                         ".4byte 992f-991f, 994f-993f, 3\n"                                     \
+                         "991: .asciz \"stapsdt\"\n"                                            \
+                         "992: .balign 4\n"                                                     \
+                         "993: .8byte 990b\n"                                                   \
+                         ".8byte _.stapsdt.base\n"                                              \
+                         ".8byte 0\n"                                                           \
+                         ".asciz \"tb\"\n"                                                      \
+                         ".asciz \"" #name "\"\n"                                               \
+                         ".asciz \"" args "\"\n"                                                \
+                         "994: .balign 4\n"                                                     \
+                         ".popsection\n"                                                        \
+                         ".ifndef _.stapsdt.base\n"                                             \
+                         ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+                         ".weak _.stapsdt.base\n"                                               \
+                         ".hidden _.stapsdt.base\n"                                             \
+                         "_.stapsdt.base: .space 1\n"                                           \
+                         ".size _.stapsdt.base, 1\n"                                            \
+                         ".popsection\n"                                                        \
+                         ".endif\n"                                                             \
+                         :                                                                      \
+                         : __VA_ARGS__)
+
+#define TB_PROBE_OP_(x) "nor"(::tb::detail::probe_arg(x))
+
+#define TB_PROBE1(name, a) TB_PROBE_ASM_(name, "8@%0", TB_PROBE_OP_(a))
+#define TB_PROBE2(name, a, b) TB_PROBE_ASM_(name, "8@%0 8@%1", TB_PROBE_OP_(a), TB_PROBE_OP_(b))
+#define TB_PROBE3(name, a, b, c) \
+    TB_PROBE_ASM_(name, "8@%0 8@%1 8@%2", TB_PROBE_OP_(a), TB_PROBE_OP_(b), TB_PROBE_OP_(c))
+#define TB_PROBE4(name, a, b, c, d)                                                             \
+    TB_PROBE_ASM_(name, "8@%0 8@%1 8@%2 8@%3", TB_PROBE_OP_(a), TB_PROBE_OP_(b), TB_PROBE_OP_(c), \
+                  TB_PROBE_OP_(d))
+
+#else
+
+#define TB_PROBE1(name, a) ((void)(a))
+#define TB_PROBE2(name, a, b) ((void)(a), (void)(b))
+#define TB_PROBE3(name, a, b, c) ((void)(a), (void)(b), (void)(c))
+#define TB_PROBE4(name, a, b, c, d) ((void)(a), (void)(b), (void)(c), (void)(d))
+
+#endif
+
+// Probes fired by the library (provider "tb"):
+//
+//   bucketize__start(items, k)              before a batch is mapped to buckets
+//   bucketize__end(items, k)                after it (pair with start for per-call latency)
+//   histogram__flush(counts, buckets, items) a batch of `items` was added to `counts[buckets]`
+//   stats__computed(buckets, samples, max_load, uniformity_permille)
+//   parse__error(line, format, message)     before an input error is thrown; `line` is the
+//                                           line number (byte offset for byte-range tasks),
+//                                           `format` the InputFormat value, `message` a C string
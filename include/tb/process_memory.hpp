@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace tb {
+
+    struct ProcessMemory {
+        std::uint64_t rss = 0;        // resident set now (/proc/self/statm), 0 if unavailable
+        std::uint64_t peak_rss = 0;   // high-water mark of the resident set (getrusage)
+    };
+
+    /// Resident memory of the calling process, in bytes. Never throws.
+    ProcessMemory process_memory() noexcept;
+
+}
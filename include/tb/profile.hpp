@@ -0,0 +1,103 @@
+#pragma once
+
+#include "trace.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Set to 0 (CMake: -DTB_ENABLE_PROFILING=OFF) to compile every ScopedStage down to nothing.
+#ifndef TB_PROFILING
+#define TB_PROFILING 1
+#endif
+
+namespace tb {
+
+    /// Pipeline stages timed by the library (Output is recorded by applications).
+    enum class Stage : std::size_t { Open, Read, Parse, Bucketize, Histogram, Stats, Output, Count };
+
+    inline constexpr std::size_t kStageCount = static_cast<std::size_t>(Stage::Count);
+
+    /// "open", "read", "parse", "bucketize", "histogram", "stats", "output"
+    const char* stage_name(Stage s) noexcept;
+
+    struct StageTotals {
+        std::uint64_t calls = 0;
+        std::uint64_t wall_ns = 0;   // summed over threads
+        std::uint64_t cpu_ns = 0;    // CPU time of the recording threads
+        std::uint64_t bytes = 0;
+        std::uint64_t items = 0;     // addresses, or buckets for Stats / Output
+    };
+
+    /// Per-stage totals; may be updated from several threads at once.
+    class StageProfile {
+    public:
+        void add(Stage s, const StageTotals& delta) noexcept;
+        [[nodiscard]] StageTotals totals(Stage s) const noexcept;
+        void reset() noexcept;
+
+    private:
+        struct Slot {
+            std::atomic<std::uint64_t> calls{0};
+            std::atomic<std::uint64_t> wall_ns{0};
+            std::atomic<std::uint64_t> cpu_ns{0};
+            std::atomic<std::uint64_t> bytes{0};
+            std::atomic<std::uint64_t> items{0};
+        };
+        std::array<Slot, kStageCount> slots_{};
+    };
+
+    namespace detail {
+        inline std::atomic<StageProfile*> g_stage_profile{nullptr};
+    }
+
+    /// Profile that ScopedStage records into, process-wide; nullptr (the default) disables recording.
+    inline void set_stage_profile(StageProfile* profile) noexcept {
+        detail::g_stage_profile.store(profile, std::memory_order_release);
+    }
+    [[nodiscard]] inline StageProfile* stage_profile() noexcept {
+        return detail::g_stage_profile.load(std::memory_order_acquire);
+    }
+
+    /// Times the enclosing scope as one call of `stage` (wall clock + thread CPU time), and
+    /// records it as a trace event named after the stage while tracing is enabled.
+    /// With neither active it costs two loads and a branch; with TB_PROFILING=0, nothing.
+    class ScopedStage {
+    public:
+#if TB_PROFILING
+        explicit ScopedStage(Stage stage) noexcept
+        : profile_{stage_profile()}, tracing_{tracing_enabled()}, stage_{stage} {
+            if (profile_ != nullptr || tracing_) start();
+        }
+        ~ScopedStage() {
+            if (profile_ != nullptr || tracing_) stop();
+        }
+        void add(std::uint64_t items, std::uint64_t bytes) noexcept {
+            items_ += items;
+            bytes_ += bytes;
+        }
+#else
+        explicit ScopedStage(Stage) noexcept {}
+        void add(std::uint64_t, std::uint64_t) noexcept {}
+#endif
+
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+
+#if TB_PROFILING
+    private:
+        void start() noexcept;
+        void stop() noexcept;
+
+        StageProfile* profile_;
+        bool tracing_;
+        Stage stage_;
+        std::uint64_t wall0_ = 0;
+        std::uint64_t cpu0_ = 0;
+        std::uint64_t items_ = 0;
+        std::uint64_t bytes_ = 0;
+#endif
+    };
+
+}
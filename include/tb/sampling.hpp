@@ -0,0 +1,75 @@
+#pragma once
+
+#include "bucket_engine.hpp"
+#include "dataset.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    enum class SampleMethod {
+        Stride,      // systematic: coarse-to-fine strided passes over views, 1 row in 1/rate over streams
+        Hash,        // consistent: rows whose address hashes below rate (same addresses in every run)
+        Reservoir,   // uniform fixed-size sample of the whole input (reads everything, bounded memory)
+    };
+
+    /// "stride", "hash", "reservoir"
+    const char* sample_method_name(SampleMethod m) noexcept;
+    /// Throws std::runtime_error on unknown names.
+    SampleMethod parse_sample_method(const std::string& name);
+
+    struct SampleOptions {
+        SampleMethod method = SampleMethod::Stride;
+        /// Stop once every bucket's share is known within ±tolerance × max(share, 1/m) at
+        /// `confidence`: relative to the uniform share, or to their own for overloaded buckets.
+        /// 0 reads the whole input.
+        double tolerance = 0.05;
+        double confidence = 0.95;
+        double rate = 1.0 / 64;              // Hash: fraction kept; Stride over streams: 1 row in round(1/rate)
+        std::size_t reservoir = 1u << 20;    // Reservoir: sample size
+        std::uint64_t seed = 0x9E3779B97F4A7C15ull;   // Hash salt, Reservoir RNG
+    };
+
+    // estimates from a sample, with `confidence` intervals
+    struct SampleEstimate {
+        std::vector<std::size_t> counts;   // histogram of the sample
+        std::vector<double> share;         // per bucket: estimated fraction of the population,
+        std::vector<double> lower;         //   Wilson score interval (finite population corrected)
+        std::vector<double> upper;
+        std::uint64_t sampled = 0;         // rows in the sample
+        std::uint64_t scanned = 0;         // rows read to draw it
+        std::uint64_t population = 0;      // rows the estimates refer to
+        double fraction_read = 0.0;        // scanned / population
+        double max_error = 0.0;            // largest interval half-width, relative to max(share, 1/m)
+        bool converged = false;            // max_error <= tolerance (early stop)
+        StatsResult sample_stats{};        // statistics of the sample (its p_value tests uniformity)
+        double chi2 = 0.0;                 // chi² of the whole population, estimated, with interval
+        double chi2_lower = 0.0;
+        double chi2_upper = 0.0;
+    };
+
+    /// Estimates for a sample of `sampled_counts` drawn uniformly from `population` rows
+    /// (0: unknown, no finite population correction and chi² projected to the sample size).
+    /// Per-bucket shares get Wilson score intervals; the population chi² is m·N·Σ(p_b − 1/m)²,
+    /// estimated from the sample chi² with its noise term removed and a normal interval from
+    /// the noncentral chi² variance. A full sample (sampled == population) is exact.
+    /// std::invalid_argument unless 0 < confidence < 1.
+    SampleEstimate estimate_from_sample(std::vector<std::size_t> sampled_counts, std::uint64_t population,
+                                        double confidence);
+
+    /// Sample `data` and estimate its bucket distribution, stopping as soon as max_error <= tolerance.
+    ///  - Stride over a view reads only the sampled rows: rounds of strided passes that halve the
+    ///    stride each time, so every completed round is a systematic sample of the whole view and
+    ///    convergence is checked between rounds (at most twice the rows strictly needed).
+    ///  - Over streams (and Hash over views) rows are read in order and convergence is checked
+    ///    after every chunk, so an early stop describes the prefix read: ordered input (e.g. sorted
+    ///    addresses) needs Reservoir, which reads everything.
+    /// population is size() for views and the rows read for streams. Weighted datasets are not
+    /// supported (std::invalid_argument), nor rate outside (0, 1] or an empty reservoir.
+    SampleEstimate sample_distribution(const BucketEngine& engine, Dataset& data, const SampleOptions& opt = {});
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    // counts payload encodings
+    enum class SnapshotEncoding : std::uint8_t {
+        Raw = 0,          // little-endian fixed width (8/16/32/64 bit): random access straight from mmap
+        DeltaVarint = 1,  // zigzag(c[i] - c[i-1]) as LEB128: smallest for smooth histograms
+        BitPacked = 2,    // fixed bit width, LSB-first bit stream: random access, tight for small counts
+        Auto = 255        // pick the smallest of the above when encoding
+    };
+
+    // histogram plus the configuration it was computed with
+    struct HistogramSnapshot {
+        Config cfg{};
+        std::vector<std::size_t> counts;
+        std::string metadata;   // free-form "key=value" lines (source, host, interval, ...)
+    };
+
+    /// Identifies the bucketing function (hash family, a, b, k): snapshots can only be merged when equal.
+    std::uint64_t config_fingerprint(const Config& cfg) noexcept;
+
+    /// CRC-32 (IEEE 802.3), continuing from `crc` (0 for a fresh checksum).
+    std::uint32_t crc32(const std::uint8_t* data, std::size_t len, std::uint32_t crc = 0) noexcept;
+
+    /// Serialize a snapshot. Layout: 64-byte header, metadata, zero padding to 8 bytes, payload.
+    std::vector<std::uint8_t> encode_snapshot(const HistogramSnapshot& s,
+                                              SnapshotEncoding enc = SnapshotEncoding::Auto);
+
+    /// Zero-copy view over an encoded snapshot (e.g. an mmap'd file).
+    /// The constructor validates header, sizes and checksum; throws std::runtime_error on corruption.
+    class SnapshotView {
+    public:
+        SnapshotView(const std::uint8_t* data, std::size_t len);
+
+        [[nodiscard]] const Config& config() const noexcept { return cfg_; }
+        [[nodiscard]] std::uint64_t fingerprint() const noexcept { return fingerprint_; }
+        [[nodiscard]] std::size_t bucket_count() const noexcept { return buckets_; }
+        [[nodiscard]] std::uint64_t total() const noexcept { return total_; }
+        [[nodiscard]] SnapshotEncoding encoding() const noexcept { return enc_; }
+        [[nodiscard]] unsigned counter_bits() const noexcept { return bits_; }
+        [[nodiscard]] std::size_t payload_size() const noexcept { return payload_len_; }
+        [[nodiscard]] std::string metadata() const;
+
+        // Raw and BitPacked payloads support O(1) access to single buckets
+        [[nodiscard]] bool random_access() const noexcept { return enc_ != SnapshotEncoding::DeltaVarint; }
+
+        /// Add buckets [begin, end) into acc[begin, end). acc must hold bucket_count() entries.
+        void accumulate(std::vector<std::size_t>& acc, std::size_t begin, std::size_t end) const;
+        void accumulate(std::vector<std::size_t>& acc) const { accumulate(acc, 0, buckets_); }
+
+        [[nodiscard]] HistogramSnapshot decode() const;
+
+    private:
+        Config cfg_{};
+        std::uint64_t fingerprint_ = 0;
+        std::size_t buckets_ = 0;
+        std::uint64_t total_ = 0;
+        SnapshotEncoding enc_ = SnapshotEncoding::Raw;
+        unsigned bits_ = 0;
+        const std::uint8_t* meta_ = nullptr;
+        std::size_t meta_len_ = 0;
+        const std::uint8_t* payload_ = nullptr;
+        std::size_t payload_len_ = 0;
+    };
+
+    /// Decode an encoded snapshot into memory (validating it like SnapshotView).
+    HistogramSnapshot decode_snapshot(const std::uint8_t* data, std::size_t len);
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "snapshot.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    /// Write `bytes` to `path` atomically (temporary file, fsync, rename).
+    /// Readers see either the old or the new content, never a partial file.
+    void write_file_atomic(const std::string& path, const std::vector<std::uint8_t>& bytes);
+
+    /// Encode and atomically write a snapshot file.
+    void write_snapshot_file(const std::string& path, const HistogramSnapshot& s,
+                             SnapshotEncoding enc = SnapshotEncoding::Auto);
+
+    /// Read-only mmap of a snapshot file, validated on open. Throws std::runtime_error on failure.
+    class MappedSnapshot {
+    public:
+        explicit MappedSnapshot(const std::string& path);
+        ~MappedSnapshot();
+
+        MappedSnapshot(const MappedSnapshot&) = delete;
+        MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+        MappedSnapshot(MappedSnapshot&& other) noexcept;
+        MappedSnapshot& operator=(MappedSnapshot&&) = delete;
+
+        [[nodiscard]] const SnapshotView& view() const noexcept { return view_; }
+        [[nodiscard]] const std::string& path() const noexcept { return path_; }
+
+    private:
+        static SnapshotView map(const std::string& path, void*& addr, std::size_t& len);
+
+        std::string path_;
+        void* addr_ = nullptr;
+        std::size_t len_ = 0;
+        SnapshotView view_;
+    };
+
+    HistogramSnapshot read_snapshot_file(const std::string& path);
+
+    /// N-way merge of snapshot files with `threads` workers (0 = hardware concurrency).
+    /// All inputs must share the same config fingerprint; metadata of the result lists the inputs.
+    /// Throws std::runtime_error on unreadable, corrupt or incompatible inputs.
+    HistogramSnapshot merge_snapshot_files(const std::vector<std::string>& paths, unsigned threads = 0);
+
+}
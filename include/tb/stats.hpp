@@ -1,9 +1,15 @@
 #pragma once
 
 #include "types.hpp"
+#include <cstddef>
 #include <vector>
 
 namespace tb {
-    // compute standard deviation, chi², and uniformity %
+    // compute standard deviation, chi² (and its p-value), uniformity % and max load
     StatsResult compute_stats(const std::vector<std::size_t>& counts);
+    // same over counts[0, m), without allocating (C ABI, mmap'd snapshots...)
+    StatsResult compute_stats(const std::size_t* counts, std::size_t m) noexcept;
+
+    // upper tail of the chi-square distribution: P(X >= chi2) with `dof` degrees of freedom
+    double chi2_p_value(double chi2, double dof) noexcept;
 }
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    struct TimeSeriesOptions {
+        std::size_t segment_bytes = 16u * 1024u * 1024u;  // fixed size of every mmap'd segment file
+        std::size_t max_segments = 64;                    // ring size of the per-interval level
+        std::size_t rollup_max_segments = 16;             // ring size of the hourly and daily levels
+        std::size_t keyframe_every = 64;                  // full histogram every N records (bounds seek cost)
+    };
+
+    // result of a range query
+    struct TimeSeriesRange {
+        std::vector<std::size_t> counts;  // summed per-bucket load
+        std::uint64_t intervals = 0;      // appended intervals covered by the range
+        std::uint64_t records_read = 0;   // stored records decoded to answer (rollups count once)
+    };
+
+    /// Append-only on-disk store of per-interval histograms, one directory per store.
+    ///
+    /// Records are kept in three levels (interval, hourly rollup, daily rollup). Each level is a
+    /// ring of fixed-size mmap'd segment files: when the newest segment is full a new one is
+    /// created and the oldest beyond the ring size is deleted. Inside a segment every record is
+    /// encoded as zigzag varint deltas against the previous record, with periodic full keyframes;
+    /// an in-memory keyframe index (rebuilt on open) locates the start of any time range.
+    ///
+    /// Rollups are appended when an interval crosses an hour/day boundary, so range queries read
+    /// daily records for whole days, hourly records for whole hours and intervals only at the edges.
+    /// Not thread-safe. Throws std::runtime_error on I/O errors, corruption or config mismatch.
+    class TimeSeriesStore {
+    public:
+        /// Open `dir` (created if missing). An existing store must have been created with `cfg`.
+        TimeSeriesStore(const std::string& dir, const Config& cfg, TimeSeriesOptions opt = {});
+        ~TimeSeriesStore();
+
+        TimeSeriesStore(const TimeSeriesStore&) = delete;
+        TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+        /// Append the histogram of the interval starting at `ts` (unix seconds).
+        /// `ts` must be greater than the last appended timestamp; counts must hold 2^k entries.
+        void append(std::int64_t ts, const std::vector<std::size_t>& counts);
+
+        /// Sum of the intervals whose timestamp lies in [begin, end).
+        [[nodiscard]] TimeSeriesRange query(std::int64_t begin, std::int64_t end) const;
+
+        /// Timestamps of the oldest retained and newest interval (0 when empty).
+        [[nodiscard]] std::int64_t first_timestamp() const noexcept;
+        [[nodiscard]] std::int64_t last_timestamp() const noexcept;
+        [[nodiscard]] std::uint64_t interval_count() const noexcept;  // retained intervals
+        [[nodiscard]] const Config& config() const noexcept { return cfg_; }
+
+        /// msync all dirty segments.
+        void flush();
+
+    private:
+        struct Level;
+
+        void put(std::size_t level, std::int64_t ts, const std::vector<std::size_t>& counts, std::uint32_t intervals);
+        void open_segment(std::size_t level);
+        void roll_up(std::size_t level, std::int64_t ts, const std::vector<std::size_t>& counts,
+                     std::uint32_t intervals);
+
+        Config cfg_{};
+        TimeSeriesOptions opt_{};
+        std::string dir_;
+        std::vector<std::unique_ptr<Level>> levels_;
+    };
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Set to 0 (CMake: -DTB_ENABLE_TRACING=OFF) to compile every trace point down to nothing.
+#ifndef TB_TRACING
+#define TB_TRACING 1
+#endif
+
+namespace tb {
+
+    struct TraceEvent {
+        const char* name;          // static string (stage name, "task", ...)
+        std::uint64_t begin_ns;    // trace_clock_ns()
+        std::uint64_t end_ns;
+        std::uint64_t items;
+        std::uint64_t bytes;
+    };
+
+    namespace detail {
+        inline std::atomic<bool> g_tracing{false};
+    }
+
+    /// True between start_tracing() and stop_tracing(); always false with TB_TRACING=0.
+    [[nodiscard]] inline bool tracing_enabled() noexcept {
+#if TB_TRACING
+        return detail::g_tracing.load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
+
+    /// Discard previous events and start recording. Each thread gets its own buffer of
+    /// `events_per_thread` events on its first event; once full, further events of that
+    /// thread are counted in trace_dropped(). Call while no traced work is running.
+    /// Throws std::logic_error with TB_TRACING=0.
+    void start_tracing(std::size_t events_per_thread = std::size_t{1} << 16);
+    void stop_tracing() noexcept;
+
+    [[nodiscard]] std::uint64_t trace_dropped() noexcept;
+    [[nodiscard]] std::uint64_t trace_clock_ns() noexcept;   // CLOCK_MONOTONIC
+
+    /// Append one complete event to the calling thread's buffer (no locks after the first event).
+    void trace_event(const TraceEvent& e) noexcept;
+
+    /// Chrome trace JSON ("X" events, one track per thread) of everything recorded since
+    /// start_tracing(); open in chrome://tracing or ui.perfetto.dev. Call after stop_tracing().
+    void write_chrome_trace(std::ostream& os);
+
+    /// Records the enclosing scope as one event when tracing is enabled.
+    class ScopedTrace {
+    public:
+#if TB_TRACING
+        explicit ScopedTrace(const char* name) noexcept : name_{name}, on_{tracing_enabled()} {
+            if (on_) begin_ = trace_clock_ns();
+        }
+        ~ScopedTrace() {
+            if (on_) trace_event({name_, begin_, trace_clock_ns(), items_, bytes_});
+        }
+        void add(std::uint64_t items, std::uint64_t bytes) noexcept {
+            items_ += items;
+            bytes_ += bytes;
+        }
+#else
+        explicit ScopedTrace(const char*) noexcept {}
+        void add(std::uint64_t, std::uint64_t) noexcept {}
+#endif
+
+        ScopedTrace(const ScopedTrace&) = delete;
+        ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+#if TB_TRACING
+    private:
+        const char* name_;
+        bool on_;
+        std::uint64_t begin_ = 0;
+        std::uint64_t items_ = 0;
+        std::uint64_t bytes_ = 0;
+#endif
+    };
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "bucket_engine.hpp"
+#include "parallel.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tb {
+
+    /// How to run one distribution call.
+    struct TuningChoice {
+        unsigned threads = 1;   // 1: BucketEngine::distribution, otherwise parallel_distribution
+        HistogramStrategy strategy = HistogramStrategy::PerThread;
+    };
+
+    /// Best measured choice for inputs of at least `min_items` addresses at `k`.
+    struct TuningEntry {
+        unsigned k = 0;
+        std::uint64_t min_items = 0;
+        TuningChoice choice;
+        double mitems_per_s = 0.0;   // throughput measured for that choice
+    };
+
+    /// Calibration result of one machine (see calibrate()).
+    struct TuningProfile {
+        std::string cpu;                 // CPU model the profile was measured on
+        unsigned hardware_threads = 0;
+        std::vector<TuningEntry> entries;
+
+        /// Entry of the closest k, largest min_items <= items (the smallest one for tiny inputs).
+        /// Falls back to default_tuning() when there are no entries.
+        [[nodiscard]] TuningChoice choose(unsigned k, std::size_t items) const noexcept;
+    };
+
+    /// Built-in choice used without a profile: sequential below 64 Ki addresses, otherwise every
+    /// hardware thread with per-thread histograms, or partitioned ones once those exceed 1 MiB.
+    [[nodiscard]] TuningChoice default_tuning(unsigned k, std::size_t items) noexcept;
+
+    /// Line-based text form ("tb-tuning 1" header, one "entry" line per TuningEntry).
+    std::string encode_tuning_profile(const TuningProfile& p);
+    /// Throws std::runtime_error on malformed input.
+    TuningProfile decode_tuning_profile(const std::string& text);
+
+    namespace detail {
+        inline std::atomic<const TuningProfile*> g_tuning_profile{nullptr};
+    }
+
+    /// Profile consulted by choose_tuning / tuned_distribution, process-wide; not owned.
+    /// nullptr (the default) selects default_tuning().
+    inline void set_tuning_profile(const TuningProfile* profile) noexcept {
+        detail::g_tuning_profile.store(profile, std::memory_order_release);
+    }
+    [[nodiscard]] inline const TuningProfile* tuning_profile() noexcept {
+        return detail::g_tuning_profile.load(std::memory_order_acquire);
+    }
+
+    /// Choice of the installed profile, or default_tuning() without one.
+    [[nodiscard]] TuningChoice choose_tuning(unsigned k, std::size_t items) noexcept;
+
+    /// engine.distribution(ips), run the way choose_tuning() picks for this k and input size.
+    std::vector<std::size_t> tuned_distribution(const BucketEngine& engine, const std::vector<IPv4>& ips);
+
+    /// Add ips[0, n) to `counts` the way choose_tuning() picks, with the parallel scratch buffers
+    /// from `scratch` (see parallel_accumulate).
+    void tuned_accumulate(const BucketEngine& engine, const IPv4* ips, std::size_t n,
+                          std::size_t* counts, std::size_t counts_size,
+                          std::pmr::memory_resource* scratch = nullptr);
+
+    struct CalibrationOptions {
+        std::vector<unsigned> ks{8, 12, 16, 20};
+        std::vector<std::uint64_t> sizes{std::uint64_t{1} << 14, std::uint64_t{1} << 17,
+                                         std::uint64_t{1} << 20, std::uint64_t{1} << 22};
+        unsigned max_threads = 0;       // 0: hardware_concurrency
+        double min_time_ms = 20.0;      // per candidate, best of the repetitions that fit
+    };
+
+    /// Time every thread count (powers of two up to max_threads) and strategy for each k and
+    /// size, keeping the fastest. `progress` (optional) gets one line per (k, size).
+    /// The cpu field is left empty (tb_io: cpu_model()).
+    TuningProfile calibrate(const CalibrationOptions& opt, std::ostream* progress = nullptr);
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "tuning.hpp"
+
+#include <optional>
+#include <string>
+
+namespace tb {
+
+    /// "model name" of the first CPU in /proc/cpuinfo ("unknown" when unavailable).
+    std::string cpu_model();
+
+    /// Where the profile of this CPU model lives:
+    /// $TB_TUNING_DIR, else $XDG_CACHE_HOME/turbo-bucketizer, else ~/.cache/turbo-bucketizer,
+    /// followed by "tuning-<model, lowercased, non-alphanumerics as '-'>.txt".
+    /// Empty when no directory can be determined.
+    std::string default_tuning_path();
+
+    /// Write atomically, creating the parent directory if needed. Throws std::runtime_error.
+    void save_tuning_profile(const std::string& path, const TuningProfile& p);
+
+    /// std::nullopt if the file does not exist; throws std::runtime_error if it cannot be read
+    /// or is malformed.
+    std::optional<TuningProfile> load_tuning_profile(const std::string& path);
+
+}
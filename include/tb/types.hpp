@@ -26,7 +26,9 @@ namespace tb {
         double mean = 0.0;
         double stddev = 0.0;
         double chi2 = 0.0;
+        double p_value = 1.0;    // P(chi² >= chi2) for m-1 degrees of freedom; small = not uniform
         double uniformity = 0.0; // 0–100%
+        std::size_t max_load = 0; // largest bucket count
     };
 
 }
@@ -0,0 +1,176 @@
+#include "tb/arena.hpp"
+#include "tb/memory.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+namespace tb {
+
+    namespace {
+        constexpr std::size_t kHugePage = std::size_t{2} << 20;   // x86-64 / AArch64 con pagine da 4 KiB
+
+        std::size_t round_up(std::size_t n, std::size_t to) noexcept {
+            return (n + to - 1) / to * to;
+        }
+
+        char* align_up(char* p, std::size_t alignment) noexcept {
+            const auto addr = reinterpret_cast<std::uintptr_t>(p);
+            return reinterpret_cast<char*>((addr + alignment - 1) / alignment * alignment);
+        }
+
+        // mappatura anonima allineata a `alignment`: si mappa di più e si tagliano testa e coda.
+        // MAP_NORESERVE: riservare per un limite superiore non deve fallire per l'overcommit
+        char* map_aligned(std::size_t size, std::size_t alignment) noexcept {
+            const std::size_t span = size + alignment;
+            void* raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (raw == MAP_FAILED) return nullptr;
+            char* base = static_cast<char*>(raw);
+            char* aligned = align_up(base, alignment);
+            if (aligned > base) ::munmap(base, static_cast<std::size_t>(aligned - base));
+            char* tail = aligned + size;
+            if (tail < base + span) ::munmap(tail, static_cast<std::size_t>(base + span - tail));
+            return aligned;
+        }
+    }
+
+    const char* huge_pages_name(HugePages h) noexcept {
+        switch (h) {
+            case HugePages::Off: return "off";
+            case HugePages::Transparent: return "thp";
+            case HugePages::Explicit: return "explicit";
+        }
+        return "?";
+    }
+
+    HugePages parse_huge_pages(const std::string& name) {
+        for (const auto h : {HugePages::Off, HugePages::Transparent, HugePages::Explicit}) {
+            if (name == huge_pages_name(h)) return h;
+        }
+        throw std::runtime_error("Unknown huge page mode: '" + name + "' (expected off, thp or explicit)");
+    }
+
+    Arena::Arena(const ArenaOptions& opt) : opt_{opt} {}
+
+    Arena::~Arena() {
+        release();
+    }
+
+    void Arena::map_block(std::size_t min_bytes) {
+        const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const std::size_t wanted = std::max(opt_.block_bytes, min_bytes);
+        // un blocco più piccolo di una pagina enorme non ne userebbe una: pagine normali, niente arrotondamento
+        const bool huge = opt_.huge_pages != HugePages::Off && wanted >= kHugePage;
+        // blocchi multipli di 2 MiB: un blocco da pagine enormi non termina con un frammento da 4 KiB
+        const std::size_t size = round_up(wanted, huge ? kHugePage : page);
+
+        char* base = nullptr;
+        bool backed_huge = false;
+#ifdef MAP_HUGETLB
+        if (huge && opt_.huge_pages == HugePages::Explicit) {
+            // senza MAP_NORESERVE: con il pool vuoto mmap fallisce subito invece di un SIGBUS al primo accesso
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                base = static_cast<char*>(p);
+                backed_huge = true;
+            }
+        }
+#endif
+        if (base == nullptr) {
+            base = map_aligned(size, huge ? kHugePage : page);
+            if (base == nullptr) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            // senza THP (o con THP "never") madvise fallisce e restano le pagine normali
+            if (huge && ::madvise(base, size, MADV_HUGEPAGE) == 0) backed_huge = true;
+#endif
+        }
+
+        blocks_.push_back(Block{base, size});
+        detail::note_alloc(MemCategory::Arena, size);
+        mapped_ += size;
+        huge_ = huge_ || backed_huge;
+        cur_ = base;
+        end_ = base + size;
+        last_ = nullptr;
+    }
+
+    void Arena::reserve(std::size_t bytes) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (cur_ == nullptr || static_cast<std::size_t>(end_ - cur_) < bytes) {
+            map_block(bytes + alignof(std::max_align_t));
+        }
+    }
+
+    void Arena::release() noexcept {
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (const Block& b : blocks_) {
+            ::munmap(b.base, b.size);
+            detail::note_free(MemCategory::Arena, b.size);
+        }
+        blocks_.clear();
+        cur_ = end_ = last_ = nullptr;
+        allocated_ = 0;
+        peak_ = 0;
+        mapped_ = 0;
+    }
+
+    std::size_t Arena::allocated() const noexcept {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return allocated_;
+    }
+
+    std::size_t Arena::peak() const noexcept {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return peak_;
+    }
+
+    std::size_t Arena::mapped() const noexcept {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return mapped_;
+    }
+
+    std::size_t Arena::block_count() const noexcept {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return blocks_.size();
+    }
+
+    bool Arena::huge_pages() const noexcept {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return huge_;
+    }
+
+    void* Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        char* p = cur_ != nullptr ? align_up(cur_, alignment) : nullptr;
+        if (p == nullptr || p > end_ || static_cast<std::size_t>(end_ - p) < bytes) {
+            // il resto del blocco corrente si abbandona
+            map_block(bytes + alignment);
+            p = align_up(cur_, alignment);
+        }
+        last_ = p;
+        cur_ = p + bytes;
+        allocated_ += bytes;
+        peak_ = std::max(peak_, allocated_);
+        return p;
+    }
+
+    void Arena::do_deallocate(void* p, std::size_t bytes, std::size_t) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        // solo l'ultima allocazione si può restituire (es. un buffer temporaneo)
+        if (p != nullptr && p == last_ && last_ + bytes == cur_) {
+            cur_ = last_;
+            allocated_ -= bytes;
+            last_ = nullptr;
+        }
+    }
+
+    bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+}
@@ -1,63 +1,181 @@
 #include "tb/bucket_engine.hpp"
+#include "tb/bucket_engine_fixed.hpp"
+#include "tb/probes.hpp"
+#include "tb/profile.hpp"
 
 #include <algorithm>
+#include <array>
 #include <numeric>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 namespace tb {
 
+    namespace detail {
+        struct BatchKernels {
+            void (*bucketize)(const Config&, const IPv4*, std::size_t, BucketIndex*) noexcept;
+            void (*accumulate)(const Config&, const IPv4*, std::size_t, std::size_t*) noexcept;
+            void (*accumulate_weighted)(const Config&, const IPv4*, const std::size_t*, std::size_t,
+                                        std::size_t*) noexcept;
+        };
+    }
+
     namespace {
-        // calcola l’indice di bucket dai 32 bit alti di y
-        // y = a*x + b (overflow 32 bit voluto); shift robusto
-        inline BucketIndex bucket_from_y(std::uint32_t y, unsigned int k) noexcept {
-            if (k == 0)  return 0u;
-            if (k >= 32) return y; // nessuno shift: restituisce tutti i 32 bit
-            // shift effettuato su 64 bit per evitare UB quando (32 - k) == 32
-            const unsigned s = 32u - k;
-            return static_cast<BucketIndex>( static_cast<std::uint64_t>(y) >> s );
+        // un'istanza di BucketEngineFixed per ogni k: shift costante nei cicli
+        template <unsigned K>
+        struct FixedKernels {
+            static void bucketize(const Config& c, const IPv4* ips, std::size_t n, BucketIndex* out) noexcept {
+                BucketEngineFixed<K>{c}.bucketize(ips, n, out);
+            }
+            static void accumulate(const Config& c, const IPv4* ips, std::size_t n, std::size_t* counts) noexcept {
+                BucketEngineFixed<K>{c}.accumulate(ips, n, counts);
+            }
+            static void accumulate_weighted(const Config& c, const IPv4* ips, const std::size_t* weights,
+                                            std::size_t n, std::size_t* counts) noexcept {
+                BucketEngineFixed<K>{c}.accumulate(ips, weights, n, counts);
+            }
+        };
+
+        template <std::size_t... K>
+        constexpr std::array<detail::BatchKernels, sizeof...(K)> kernel_table(std::index_sequence<K...>) {
+            return {detail::BatchKernels{&FixedKernels<K>::bucketize, &FixedKernels<K>::accumulate,
+                                         &FixedKernels<K>::accumulate_weighted}...};
+        }
+
+        constexpr auto kKernels = kernel_table(std::make_index_sequence<33>{});   // k = 0..32
+
+        // k > 32 si comporta come k = 32 (Config::bucket_count)
+        const detail::BatchKernels& select_kernels(unsigned k) noexcept {
+            return kKernels[std::min(k, 32u)];
+        }
+
+        template <class T>
+        void bucketize_narrow(const BucketEngine& engine, const IPv4* ips, std::size_t n, T* out) noexcept {
+            ScopedStage stage{Stage::Bucketize};
+            stage.add(n, n * sizeof(IPv4));
+            TB_PROBE2(bucketize__start, n, engine.config().k);
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = static_cast<T>(engine.bucket_index(ips[i]));
+            }
+            TB_PROBE2(bucketize__end, n, engine.config().k);
         }
     }
 
     BucketEngine::BucketEngine(const Config& cfg)
-    : cfg_{cfg} {
-        // Nulla da fare: l’engine è immutabile dopo la config.
+    : cfg_{cfg}, shift_{32u - std::min(cfg.k, 32u)}, kernels_{&select_kernels(cfg.k)} {
+        // L’engine è immutabile dopo la config: i kernel si scelgono una volta sola.
         // Nota: assumiamo cfg_.a dispari per la permutazione completa su 2^32.
     }
 
-    BucketIndex BucketEngine::bucket_index(IPv4 ip) const noexcept {
-        // y = a*ip + b (overflow su 32 bit: comportamento definito per unsigned)
-        const std::uint32_t y = static_cast<std::uint32_t>(
-            static_cast<std::uint64_t>(cfg_.a) * static_cast<std::uint64_t>(ip)
-            + static_cast<std::uint64_t>(cfg_.b)
-        );
-        return bucket_from_y(y, cfg_.k);
-    }
-
     std::vector<BucketIndex> BucketEngine::bucketize(const std::vector<IPv4>& ips) const {
-        std::vector<BucketIndex> out;
-        out.reserve(ips.size());
-        for (IPv4 ip : ips) {
-            out.push_back(bucket_index(ip));
-        }
+        std::vector<BucketIndex> out(ips.size());
+        bucketize(ips.data(), ips.size(), out.data());
         return out;
     }
 
     std::vector<std::size_t> BucketEngine::distribution(const std::vector<IPv4>& ips) const {
-        const std::size_t m = cfg_.bucket_count();
-        std::vector<std::size_t> counts(m, 0);
-        if (m == 0) return counts;
+        std::vector<std::size_t> counts(cfg_.bucket_count(), 0);
+        accumulate(ips.data(), ips.size(), counts.data(), counts.size());
+        return counts;
+    }
 
-        for (IPv4 ip : ips) {
-            const auto b = bucket_index(ip);
-            // Difensivo: clamp se k>=32 e BucketIndex estende 32 bit pieni
-            if (b < counts.size()) {
-                counts[b] += 1;
-            }
+    std::pmr::vector<BucketIndex> BucketEngine::bucketize(const IPv4* ips, std::size_t n,
+                                                          std::pmr::memory_resource* mr) const {
+        std::pmr::vector<BucketIndex> out(n, mr);
+        bucketize(ips, n, out.data());
+        return out;
+    }
+
+    std::pmr::vector<std::size_t> BucketEngine::distribution(const IPv4* ips, std::size_t n,
+                                                             std::pmr::memory_resource* mr) const {
+        std::pmr::vector<std::size_t> counts(cfg_.bucket_count(), 0, mr);
+        accumulate(ips, n, counts.data(), counts.size());
+        return counts;
+    }
+
+    std::vector<std::size_t> BucketEngine::distribution(const std::vector<IPv4>& ips,
+                                                        const std::vector<std::size_t>& weights) const {
+        if (weights.size() != ips.size()) {
+            throw std::invalid_argument("distribution: ips and weights must have the same size");
         }
+        std::vector<std::size_t> counts(cfg_.bucket_count(), 0);
+        accumulate(ips.data(), weights.data(), ips.size(), counts.data(), counts.size());
         return counts;
     }
 
+    void BucketEngine::bucketize(const IPv4* ips, std::size_t n, BucketIndex* out) const noexcept {
+        ScopedStage stage{Stage::Bucketize};
+        stage.add(n, n * sizeof(IPv4));
+        TB_PROBE2(bucketize__start, n, cfg_.k);
+        kernels_->bucketize(cfg_, ips, n, out);
+        TB_PROBE2(bucketize__end, n, cfg_.k);
+    }
+
+    void BucketEngine::bucketize(const IPv4* ips, std::size_t n, std::uint8_t* out) const {
+        if (cfg_.k > 8) throw std::invalid_argument("bucketize: 8-bit output needs k <= 8");
+        bucketize_narrow(*this, ips, n, out);
+    }
+
+    void BucketEngine::bucketize(const IPv4* ips, std::size_t n, std::uint16_t* out) const {
+        if (cfg_.k > 16) throw std::invalid_argument("bucketize: 16-bit output needs k <= 16");
+        bucketize_narrow(*this, ips, n, out);
+    }
+
+    void BucketEngine::bucketize_in_place(IPv4* data, std::size_t n) const noexcept {
+        // IPv4 e BucketIndex hanno la stessa rappresentazione; ogni elemento è letto prima di essere scritto
+        bucketize(data, n, data);
+    }
+
+    void BucketEngine::bucketize(const IPv4* ips, std::size_t n, PackedBuckets& out, std::size_t offset) const {
+        if (out.bits() < std::min(cfg_.k, 32u)) {
+            throw std::invalid_argument("bucketize: packed output has " + std::to_string(out.bits()) +
+                                        " bits per index, k = " + std::to_string(cfg_.k));
+        }
+        if (offset > out.size() || n > out.size() - offset) {
+            throw std::out_of_range("bucketize: packed output too small");
+        }
+        // a pezzi da un buffer sullo stack: nessuna allocazione
+        constexpr std::size_t kChunk = 1024;
+        BucketIndex tmp[kChunk];
+        for (std::size_t i = 0; i < n; i += kChunk) {
+            const std::size_t len = std::min(kChunk, n - i);
+            bucketize(ips + i, len, tmp);
+            out.pack(offset + i, tmp, len);
+        }
+    }
+
+    void BucketEngine::accumulate(const IPv4* ips, std::size_t n,
+                                  std::size_t* counts, std::size_t counts_size) const {
+        if (counts_size != cfg_.bucket_count()) {
+            throw std::invalid_argument("accumulate: counts size does not match bucket count");
+        }
+        ScopedStage stage{Stage::Histogram};
+        stage.add(n, n * sizeof(IPv4));
+        TB_PROBE2(bucketize__start, n, cfg_.k);
+        // bucket_index < 2^k == counts_size: nessun controllo per elemento
+        kernels_->accumulate(cfg_, ips, n, counts);
+        TB_PROBE2(bucketize__end, n, cfg_.k);
+        TB_PROBE3(histogram__flush, counts, counts_size, n);
+    }
+
+    void BucketEngine::accumulate(const IPv4* ips, const std::size_t* weights, std::size_t n,
+                                  std::size_t* counts, std::size_t counts_size) const {
+        if (counts_size != cfg_.bucket_count()) {
+            throw std::invalid_argument("accumulate: counts size does not match bucket count");
+        }
+        ScopedStage stage{Stage::Histogram};
+        stage.add(n, n * (sizeof(IPv4) + sizeof(std::size_t)));
+        TB_PROBE2(bucketize__start, n, cfg_.k);
+        kernels_->accumulate_weighted(cfg_, ips, weights, n, counts);
+        TB_PROBE2(bucketize__end, n, cfg_.k);
+        TB_PROBE3(histogram__flush, counts, counts_size, n);
+    }
+
     std::vector<std::size_t> BucketEngine::distribution(IPv4 start, IPv4 end) const {
+        ScopedStage stage{Stage::Histogram};
+        if (start < end) stage.add(static_cast<std::uint64_t>(end) - start, 0);   // nessun input in memoria
         const std::size_t m = cfg_.bucket_count();
         std::vector<std::size_t> counts(m, 0);
         if (m == 0) return counts;
@@ -66,6 +184,8 @@ namespace tb {
         // (Se in futuro servirà supportare wrap mod 2^32, potremo aggiungere un flag)
         if (end <= start) return counts;
 
+        const std::uint64_t n = static_cast<std::uint64_t>(end) - start;
+        TB_PROBE2(bucketize__start, n, cfg_.k);
         // Iterazione semplice e prevedibile dal compilatore
         for (std::uint64_t v = static_cast<std::uint64_t>(start);
             v < static_cast<std::uint64_t>(end);
@@ -75,6 +195,8 @@ namespace tb {
                 counts[b] += 1;
             }
         }
+        TB_PROBE2(bucketize__end, n, cfg_.k);
+        TB_PROBE3(histogram__flush, counts.data(), m, n);
         return counts;
     }
 
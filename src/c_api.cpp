@@ -0,0 +1,132 @@
+#include "tb/c_api.h"
+#include "tb/bucket_engine.hpp"
+#include "tb/stats.hpp"
+
+#include <new>
+#include <type_traits>
+
+#ifndef TB_VERSION_STRING
+#define TB_VERSION_STRING "unknown"
+#endif
+
+// l'handle opaco è l'engine stesso: nessuna indirezione nelle chiamate batch
+struct tb_engine {
+    tb::BucketEngine engine;
+};
+
+namespace {
+    static_assert(std::is_same_v<tb::IPv4, std::uint32_t> && std::is_same_v<tb::BucketIndex, std::uint32_t>,
+                  "the C ABI passes addresses and bucket indices as uint32_t");
+
+    constexpr std::uint32_t kMaxK = 32;
+}
+
+extern "C" {
+
+TB_API uint32_t tb_abi_version(void) {
+    return TB_ABI_VERSION;
+}
+
+TB_API const char* tb_version(void) {
+    return TB_VERSION_STRING;
+}
+
+TB_API const char* tb_status_string(tb_status status) {
+    switch (status) {
+        case TB_OK: return "ok";
+        case TB_ERR_NULL: return "null pointer argument";
+        case TB_ERR_CONFIG: return "invalid configuration (k must be <= 32)";
+        case TB_ERR_SIZE: return "histogram size does not match the bucket count";
+        case TB_ERR_NOMEM: return "out of memory";
+        case TB_ERR_INTERNAL: return "internal error";
+    }
+    return "unknown status";
+}
+
+TB_API void tb_config_default(tb_config* cfg) {
+    if (cfg == nullptr) return;
+    const tb::Config d;
+    cfg->a = d.a;
+    cfg->b = d.b;
+    cfg->k = d.k;
+}
+
+TB_API tb_status tb_engine_create(const tb_config* cfg, tb_engine** out) {
+    if (cfg == nullptr || out == nullptr) return TB_ERR_NULL;
+    if (cfg->k > kMaxK) return TB_ERR_CONFIG;
+    tb::Config c;
+    c.a = cfg->a;
+    c.b = cfg->b;
+    c.k = cfg->k;
+    // nessuna eccezione oltre il confine C
+    try {
+        auto* e = new (std::nothrow) tb_engine{tb::BucketEngine{c}};
+        if (e == nullptr) return TB_ERR_NOMEM;
+        *out = e;
+        return TB_OK;
+    } catch (...) {
+        return TB_ERR_INTERNAL;
+    }
+}
+
+TB_API void tb_engine_destroy(tb_engine* engine) {
+    delete engine;
+}
+
+TB_API tb_status tb_engine_config(const tb_engine* engine, tb_config* out) {
+    if (engine == nullptr || out == nullptr) return TB_ERR_NULL;
+    const tb::Config& c = engine->engine.config();
+    out->a = c.a;
+    out->b = c.b;
+    out->k = c.k;
+    return TB_OK;
+}
+
+TB_API uint64_t tb_engine_bucket_count(const tb_engine* engine) {
+    return engine != nullptr ? engine->engine.config().bucket_count() : 0;
+}
+
+TB_API uint32_t tb_bucket_index(const tb_engine* engine, uint32_t ip) {
+    return engine != nullptr ? engine->engine.bucket_index(ip) : 0;
+}
+
+TB_API tb_status tb_bucketize(const tb_engine* engine, const uint32_t* ips, size_t n, uint32_t* out) {
+    if (engine == nullptr || ((ips == nullptr || out == nullptr) && n > 0)) return TB_ERR_NULL;
+    engine->engine.bucketize(ips, n, out);
+    return TB_OK;
+}
+
+TB_API tb_status tb_accumulate(const tb_engine* engine, const uint32_t* ips, size_t n,
+                               size_t* counts, size_t counts_size) {
+    if (engine == nullptr || counts == nullptr || (ips == nullptr && n > 0)) return TB_ERR_NULL;
+    if (counts_size != engine->engine.config().bucket_count()) return TB_ERR_SIZE;
+    // dimensione già verificata: accumulate non può lanciare
+    engine->engine.accumulate(ips, n, counts, counts_size);
+    return TB_OK;
+}
+
+TB_API tb_status tb_accumulate_weighted(const tb_engine* engine, const uint32_t* ips, const size_t* weights,
+                                        size_t n, size_t* counts, size_t counts_size) {
+    if (engine == nullptr || counts == nullptr || ((ips == nullptr || weights == nullptr) && n > 0)) {
+        return TB_ERR_NULL;
+    }
+    if (counts_size != engine->engine.config().bucket_count()) return TB_ERR_SIZE;
+    engine->engine.accumulate(ips, weights, n, counts, counts_size);
+    return TB_OK;
+}
+
+TB_API tb_status tb_stats_compute(const size_t* counts, size_t m, tb_stats* out) {
+    if (out == nullptr || (counts == nullptr && m > 0)) return TB_ERR_NULL;
+    const tb::StatsResult r = tb::compute_stats(counts, m);
+    out->sample_count = r.sample_count;
+    out->bucket_count = r.bucket_count;
+    out->mean = r.mean;
+    out->stddev = r.stddev;
+    out->chi2 = r.chi2;
+    out->p_value = r.p_value;
+    out->uniformity = r.uniformity;
+    out->max_load = r.max_load;
+    return TB_OK;
+}
+
+}
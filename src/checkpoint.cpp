@@ -0,0 +1,212 @@
+#include "tb/checkpoint.hpp"
+#include "tb/memory.hpp"
+#include "tb/snapshot_file.hpp"
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+namespace tb {
+
+    namespace {
+        // identità dell'input: un file cambiato fra due esecuzioni non si riprende
+        void input_identity(const std::string& path, std::uint64_t& size, std::int64_t& mtime_ns) {
+            struct stat st{};
+            if (::stat(path.c_str(), &st) != 0) {
+                throw std::runtime_error("Cannot open input file: " + path);
+            }
+            size = static_cast<std::uint64_t>(st.st_size);
+            mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+        }
+
+        std::uint64_t meta_u64(const std::string& path, const std::string& key, const std::string& value) {
+            std::size_t pos = 0;
+            std::uint64_t v = 0;
+            try {
+                v = std::stoull(value, &pos, 10);
+            } catch (const std::exception&) {
+                pos = 0;
+            }
+            if (pos == 0 || pos != value.size()) {
+                throw std::runtime_error("Corrupt checkpoint " + path + ": invalid " + key + " '" + value + "'");
+            }
+            return v;
+        }
+    }
+
+    void write_checkpoint_file(const std::string& path, const IngestCheckpoint& ck) {
+        std::ostringstream meta;
+        meta << "checkpoint=1\n"
+             << "source=file:" << ck.input << "\n"
+             << "input=" << ck.input << "\n"
+             << "input_size=" << ck.input_size << "\n"
+             << "input_mtime_ns=" << ck.input_mtime_ns << "\n"
+             << "format=" << input_format_name(ck.format) << "\n"
+             << "csv_column=" << ck.csv_column << "\n"
+             << "csv_delimiter=" << static_cast<unsigned>(static_cast<unsigned char>(ck.csv_delimiter)) << "\n"
+             << "offset=" << ck.offset << "\n"
+             << "lines=" << ck.lines << "\n"
+             << "samples=" << ck.samples << "\n"
+             << "sequence=" << ck.sequence << "\n";
+        // il resto dei metadati del chiamante si sostituisce: la posizione è l'unica fonte
+        const HistogramSnapshot snap{ck.histogram.cfg, ck.histogram.counts, meta.str()};
+        write_snapshot_file(path, snap);
+    }
+
+    IngestCheckpoint read_checkpoint_file(const std::string& path) {
+        IngestCheckpoint ck;
+        ck.histogram = read_snapshot_file(path);
+
+        bool marked = false;
+        std::istringstream in{ck.histogram.metadata};
+        std::string line;
+        while (std::getline(in, line)) {
+            const auto eq = line.find('=');
+            if (eq == std::string::npos) continue;
+            const std::string key = line.substr(0, eq);
+            const std::string value = line.substr(eq + 1);
+            if (key == "checkpoint") {
+                marked = value == "1";
+            } else if (key == "input") {
+                ck.input = value;
+            } else if (key == "input_size") {
+                ck.input_size = meta_u64(path, key, value);
+            } else if (key == "input_mtime_ns") {
+                ck.input_mtime_ns = static_cast<std::int64_t>(meta_u64(path, key, value));
+            } else if (key == "format") {
+                ck.format = parse_input_format(value);
+            } else if (key == "csv_column") {
+                ck.csv_column = static_cast<std::size_t>(meta_u64(path, key, value));
+            } else if (key == "csv_delimiter") {
+                ck.csv_delimiter = static_cast<char>(meta_u64(path, key, value));
+            } else if (key == "offset") {
+                ck.offset = meta_u64(path, key, value);
+            } else if (key == "lines") {
+                ck.lines = meta_u64(path, key, value);
+            } else if (key == "samples") {
+                ck.samples = meta_u64(path, key, value);
+            } else if (key == "sequence") {
+                ck.sequence = meta_u64(path, key, value);
+            }
+        }
+        if (!marked) {
+            throw std::runtime_error("Not an ingestion checkpoint: " + path);
+        }
+        std::uint64_t total = 0;
+        for (const std::size_t c : ck.histogram.counts) total += c;
+        if (total != ck.samples) {
+            throw std::runtime_error("Corrupt checkpoint " + path + ": histogram total differs from samples");
+        }
+        return ck;
+    }
+
+    ResumableRun accumulate_ipv4_file_resumable(const std::string& path, const IngestOptions& opt,
+                                                const BucketEngine& engine, std::vector<std::size_t>& counts,
+                                                const CheckpointOptions& ck_opt) {
+        if (counts.size() != engine.config().bucket_count()) {
+            throw std::invalid_argument("accumulate_ipv4_file_resumable: counts size does not match bucket count");
+        }
+        if (ck_opt.path.empty()) {
+            throw std::invalid_argument("accumulate_ipv4_file_resumable: checkpoint path is empty");
+        }
+
+        IngestCheckpoint ck;
+        ck.histogram.cfg = engine.config();
+        ck.input = path;
+        ck.format = opt.format;
+        ck.csv_column = opt.csv_column;
+        ck.csv_delimiter = opt.csv_delimiter;
+        input_identity(path, ck.input_size, ck.input_mtime_ns);
+
+        ResumableRun run;
+        InputReader reader{path};
+        Ipv4Parser parser{opt};
+
+        struct stat saved_st{};
+        if (ck_opt.resume && ::stat(ck_opt.path.c_str(), &saved_st) == 0) {
+            IngestCheckpoint saved = read_checkpoint_file(ck_opt.path);
+            const std::string where = "Checkpoint " + ck_opt.path;
+            if (config_fingerprint(saved.histogram.cfg) != config_fingerprint(engine.config())) {
+                throw std::runtime_error(where + " was written with a different bucket configuration");
+            }
+            if (saved.format != opt.format ||
+                (opt.format == InputFormat::Csv &&
+                 (saved.csv_column != opt.csv_column || saved.csv_delimiter != opt.csv_delimiter))) {
+                throw std::runtime_error(where + " was written with different input options (format " +
+                                         input_format_name(saved.format) + ")");
+            }
+            if (saved.input_size != ck.input_size || saved.input_mtime_ns != ck.input_mtime_ns) {
+                throw std::runtime_error(where + " does not match " + path +
+                                         " (the input changed since the checkpoint was written)");
+            }
+            if (reader.skip(saved.offset) != saved.offset) {
+                throw std::runtime_error(where + ": offset " + std::to_string(saved.offset) +
+                                         " lies beyond the end of " + path);
+            }
+            counts = saved.histogram.counts;
+            parser.restart_at(saved.lines);
+            ck.sequence = saved.sequence;
+            run.resumed = true;
+            run.resumed_offset = saved.offset;
+            run.resumed_samples = saved.samples;
+        }
+
+        std::uint64_t consumed = run.resumed_offset;   // byte dati al parser
+        std::uint64_t samples = run.resumed_samples;
+        std::uint64_t last_offset = consumed;
+        auto last_time = std::chrono::steady_clock::now();
+
+        // i conteggi, la posizione e il numero di riga vengono dallo stesso istante: la riga
+        // incompleta in coda al blocco resta fuori da tutti e tre
+        auto save = [&]() -> bool {
+            ck.histogram.counts = counts;
+            ck.offset = consumed - parser.pending_bytes();
+            ck.lines = parser.lines();
+            ck.samples = samples;
+            ck.sequence += 1;
+            write_checkpoint_file(ck_opt.path, ck);
+            run.checkpoints += 1;
+            last_offset = consumed;
+            last_time = std::chrono::steady_clock::now();
+            return !ck_opt.on_checkpoint || ck_opt.on_checkpoint(ck);
+        };
+
+        counted_vector<char> buf(kReadBlock, CountingAllocator<char>{MemCategory::Buffers});
+        std::vector<IPv4> ips;
+        ips.reserve(kReadBlock / 4 + 1);
+        for (;;) {
+            const std::size_t n = reader.read(buf.data(), buf.size());
+            if (n == 0) break;
+            ips.clear();
+            parser.feed(buf.data(), n, ips);
+            engine.accumulate(ips.data(), ips.size(), counts.data(), counts.size());
+            consumed += n;
+            samples += ips.size();
+
+            const bool by_bytes = ck_opt.interval_bytes > 0 && consumed - last_offset >= ck_opt.interval_bytes;
+            const std::chrono::duration<double> since = std::chrono::steady_clock::now() - last_time;
+            const bool by_time = ck_opt.interval_seconds > 0.0 && since.count() >= ck_opt.interval_seconds;
+            const bool stopping = ck_opt.stop != nullptr && ck_opt.stop->load(std::memory_order_relaxed);
+            if ((by_bytes || by_time || stopping) && (!save() || stopping)) {
+                run.samples = samples;
+                run.input_bytes = consumed - parser.pending_bytes();
+                return run;
+            }
+        }
+        ips.clear();
+        parser.finish(ips);
+        engine.accumulate(ips.data(), ips.size(), counts.data(), counts.size());
+        samples += ips.size();
+
+        // input esaurito: il checkpoint non serve più, una nuova esecuzione riparte da zero
+        std::remove(ck_opt.path.c_str());
+        run.samples = samples;
+        run.input_bytes = consumed;
+        run.complete = true;
+        return run;
+    }
+
+}
@@ -0,0 +1,189 @@
+#include "tb/collector.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace tb {
+
+    namespace {
+        // massima dimensione di un datagramma UDP su IPv4
+        constexpr std::size_t kMaxDatagram = 65535;
+
+        std::runtime_error sys_error(const std::string& what) {
+            return std::runtime_error(what + ": " + std::strerror(errno));
+        }
+
+        std::uint64_t exporter_key(const sockaddr_in& sa) noexcept {
+            return (static_cast<std::uint64_t>(ntohl(sa.sin_addr.s_addr)) << 16) | ntohs(sa.sin_port);
+        }
+    }
+
+    struct FlowCollector::Batch {
+#if defined(__linux__)
+        std::vector<mmsghdr> msgs;
+        std::vector<iovec> iovs;
+#endif
+        std::vector<sockaddr_in> from;
+        std::vector<std::size_t> lengths;
+    };
+
+    FlowCollector::FlowCollector(const Config& cfg, const CollectorOptions& opt)
+    : opt_{opt}, window_{cfg, opt.key, opt.weight} {
+        if (opt_.batch == 0) {
+            throw std::runtime_error("Collector batch size must be > 0");
+        }
+        if (opt_.window.count() <= 0) {
+            throw std::runtime_error("Collector window must be > 0 ms");
+        }
+
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) {
+            throw sys_error("Cannot create UDP socket");
+        }
+
+        // buffer kernel generoso: gli exporter inviano a raffiche
+        const int rcvbuf = 8 * 1024 * 1024;
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(opt_.port);
+        if (::inet_pton(AF_INET, opt_.bind_address.c_str(), &addr.sin_addr) != 1) {
+            ::close(fd_);
+            throw std::runtime_error("Invalid bind address: '" + opt_.bind_address + "'");
+        }
+        if (::bind(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            const auto err = sys_error("Cannot bind UDP " + opt_.bind_address + ":" + std::to_string(opt_.port));
+            ::close(fd_);
+            throw err;
+        }
+
+        sockaddr_in bound{};
+        socklen_t bound_len = sizeof(bound);
+        ::getsockname(fd_, reinterpret_cast<sockaddr*>(&bound), &bound_len);
+        port_ = ntohs(bound.sin_port);
+
+        buffers_.resize(opt_.batch * kMaxDatagram);
+        records_.reserve(30); // 30 = max record per datagramma v5
+
+        batch_ = std::make_unique<Batch>();
+        batch_->from.resize(opt_.batch);
+        batch_->lengths.resize(opt_.batch);
+#if defined(__linux__)
+        batch_->msgs.resize(opt_.batch);
+        batch_->iovs.resize(opt_.batch);
+#endif
+    }
+
+    FlowCollector::~FlowCollector() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    std::size_t FlowCollector::receive_batch() {
+        Batch& b = *batch_;
+        std::size_t received = 0;
+
+#if defined(__linux__)
+        for (std::size_t i = 0; i < opt_.batch; ++i) {
+            b.iovs[i].iov_base = buffers_.data() + i * kMaxDatagram;
+            b.iovs[i].iov_len = kMaxDatagram;
+            b.msgs[i] = mmsghdr{};
+            b.msgs[i].msg_hdr.msg_iov = &b.iovs[i];
+            b.msgs[i].msg_hdr.msg_iovlen = 1;
+            b.msgs[i].msg_hdr.msg_name = &b.from[i];
+            b.msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+
+        const int n = ::recvmmsg(fd_, b.msgs.data(), static_cast<unsigned>(opt_.batch), MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+            throw sys_error("recvmmsg failed");
+        }
+        received = static_cast<std::size_t>(n);
+        for (std::size_t i = 0; i < received; ++i) {
+            b.lengths[i] = b.msgs[i].msg_len;
+        }
+#else
+        // fallback portabile: un datagramma per syscall
+        for (; received < opt_.batch; ++received) {
+            socklen_t alen = sizeof(sockaddr_in);
+            const auto n = ::recvfrom(fd_, buffers_.data() + received * kMaxDatagram, kMaxDatagram, MSG_DONTWAIT,
+                                      reinterpret_cast<sockaddr*>(&b.from[received]), &alen);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+                throw sys_error("recvfrom failed");
+            }
+            b.lengths[received] = static_cast<std::size_t>(n);
+        }
+#endif
+
+        for (std::size_t i = 0; i < received; ++i) {
+            const std::uint8_t* data = buffers_.data() + i * kMaxDatagram;
+            window_.note_datagram(b.lengths[i]);
+            records_.clear();
+            try {
+                decoder_.decode(data, b.lengths[i], records_, exporter_key(b.from[i]));
+            } catch (const std::exception&) {
+                // un datagramma corrotto non deve fermare il collector: lo contiamo e andiamo avanti,
+                // scartando anche i record decodificati prima dell'errore
+                records_.clear();
+                window_.note_decode_error();
+            }
+            window_.add(records_);
+        }
+        return received;
+    }
+
+    void FlowCollector::run(const Publisher& publish) {
+        using clock = std::chrono::steady_clock;
+
+        std::uint64_t published = 0;
+        auto window_start = clock::now();
+        auto deadline = window_start + opt_.window;
+
+        while (!stop_.load(std::memory_order_relaxed)) {
+            const auto now = clock::now();
+            if (now >= deadline) {
+                const std::chrono::duration<double> len = now - window_start;
+                publish(window_.flush(len.count()));
+                window_start = now;
+                deadline += opt_.window;
+                if (deadline <= now) deadline = now + opt_.window; // publisher lento: niente raffiche di finestre vuote
+                if (opt_.max_windows != 0 && ++published >= opt_.max_windows) {
+                    return;
+                }
+                continue;
+            }
+
+            // poll con timeout limitato: stop() viene osservato entro ~100 ms
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+            const int timeout_ms = static_cast<int>(std::min<std::chrono::milliseconds::rep>(remaining.count() + 1, 100));
+            pollfd pfd{fd_, POLLIN, 0};
+            const int ready = ::poll(&pfd, 1, timeout_ms);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                throw sys_error("poll failed");
+            }
+            if (ready == 0) continue;
+
+            // svuota la coda del socket a batch finché ci sono datagrammi
+            while (receive_batch() == opt_.batch && clock::now() < deadline) {
+            }
+        }
+
+        const std::chrono::duration<double> len = clock::now() - window_start;
+        publish(window_.flush(len.count()));
+    }
+
+}
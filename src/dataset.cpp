@@ -0,0 +1,332 @@
+#include "tb/dataset.hpp"
+#include "tb/memory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace tb {
+
+    namespace {
+        constexpr std::size_t kAlign = 64;                            // byte: una riga di cache
+        constexpr std::size_t kAlignRows = kAlign / sizeof(IPv4);     // multiplo dei chunk
+
+        template <class T>
+        T* align_up(T* p) noexcept {
+            const auto addr = reinterpret_cast<std::uintptr_t>(p);
+            return reinterpret_cast<T*>((addr + kAlign - 1) / kAlign * kAlign);
+        }
+
+        // buffer di un worker per i chunk decodificati: righe allineate a 64 byte
+        struct ChunkBuffer {
+            counted_vector<IPv4> ip_store{CountingAllocator<IPv4>{MemCategory::Buffers}};
+            counted_vector<std::size_t> weight_store{CountingAllocator<std::size_t>{MemCategory::Buffers}};
+            IPv4* ips = nullptr;
+            std::size_t* weights = nullptr;
+
+            ChunkBuffer(std::size_t rows, bool weighted) {
+                ip_store.resize(rows + kAlign / sizeof(IPv4));
+                ips = align_up(ip_store.data());
+                if (weighted) {
+                    weight_store.resize(rows + kAlign / sizeof(std::size_t));
+                    weights = align_up(weight_store.data());
+                }
+            }
+        };
+
+        std::size_t round_chunk(std::size_t chunk) {
+            if (chunk == 0) throw std::invalid_argument("Dataset: chunk size must be > 0");
+            return (chunk + kAlignRows - 1) / kAlignRows * kAlignRows;
+        }
+
+        // esegue fn(t) per t in [0, workers) e rilancia la prima eccezione dopo il join
+        template <class Fn>
+        void run_workers(unsigned workers, std::atomic<bool>& stop, Fn&& fn) {
+            if (workers == 1) {
+                fn(0u);
+                return;
+            }
+            std::vector<std::exception_ptr> errors(workers);
+            auto guarded = [&](unsigned t) {
+                try {
+                    fn(t);
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                    stop.store(true, std::memory_order_relaxed);
+                }
+            };
+            std::vector<std::thread> pool;
+            pool.reserve(workers - 1);
+            for (unsigned t = 1; t < workers; ++t) pool.emplace_back(guarded, t);
+            guarded(0u);
+            for (auto& th : pool) th.join();
+            for (const auto& e : errors) {
+                if (e) std::rethrow_exception(e);
+            }
+        }
+
+        void check_counts(const BucketEngine& engine, const std::vector<std::size_t>& counts, const char* what) {
+            if (counts.size() != engine.config().bucket_count()) {
+                throw std::invalid_argument(std::string(what) + ": counts size does not match bucket count");
+            }
+        }
+    }
+
+    struct Dataset::Source {
+        std::size_t chunk = kDefaultChunk;
+        bool weighted = false;
+        std::atomic<std::uint64_t> rows{0};   // vista: righe totali; stream: righe lette finora
+
+        // vista
+        const IPv4* ips = nullptr;
+        const std::size_t* weights = nullptr;
+        std::shared_ptr<const void> owner;
+
+        // stream
+        ChunkReader reader;
+        bool consumed = false;
+
+        [[nodiscard]] bool streamed() const noexcept { return static_cast<bool>(reader); }
+    };
+
+    Dataset::Dataset(std::unique_ptr<Source> src) noexcept : src_{std::move(src)} {}
+    Dataset::Dataset(Dataset&&) noexcept = default;
+    Dataset& Dataset::operator=(Dataset&&) noexcept = default;
+    Dataset::~Dataset() = default;
+
+    Dataset Dataset::view(const IPv4* ips, std::size_t n, const std::size_t* weights,
+                          std::size_t chunk, std::shared_ptr<const void> owner) {
+        if (n > 0 && ips == nullptr) throw std::invalid_argument("Dataset::view: null addresses");
+        auto s = std::make_unique<Source>();
+        s->chunk = round_chunk(chunk);
+        s->weighted = weights != nullptr;
+        s->rows.store(n, std::memory_order_relaxed);
+        s->ips = ips;
+        s->weights = weights;
+        s->owner = std::move(owner);
+        return Dataset{std::move(s)};
+    }
+
+    Dataset Dataset::view(const std::vector<IPv4>& ips, std::size_t chunk) {
+        return view(ips.data(), ips.size(), nullptr, chunk);
+    }
+
+    Dataset Dataset::view(const std::vector<IPv4>& ips, const std::vector<std::size_t>& weights, std::size_t chunk) {
+        if (ips.size() != weights.size()) {
+            throw std::invalid_argument("Dataset::view: ips and weights must have the same size");
+        }
+        return view(ips.data(), ips.size(), weights.data(), chunk);
+    }
+
+    Dataset Dataset::stream(ChunkReader reader, bool weighted, std::size_t chunk) {
+        if (!reader) throw std::invalid_argument("Dataset::stream: empty reader");
+        auto s = std::make_unique<Source>();
+        s->chunk = round_chunk(chunk);
+        s->weighted = weighted;
+        s->reader = std::move(reader);
+        return Dataset{std::move(s)};
+    }
+
+    bool Dataset::weighted() const noexcept { return src_->weighted; }
+    std::size_t Dataset::chunk_size() const noexcept { return src_->chunk; }
+    bool Dataset::is_view() const noexcept { return !src_->streamed(); }
+    std::uint64_t Dataset::size() const noexcept { return src_->rows.load(std::memory_order_relaxed); }
+
+    unsigned Dataset::worker_count(unsigned threads) const noexcept {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        if (src_->streamed()) return threads;
+        // una vista non ha senso con più worker che chunk
+        const std::uint64_t chunks = (size() + src_->chunk - 1) / src_->chunk;
+        return static_cast<unsigned>(std::max<std::uint64_t>(1, std::min<std::uint64_t>(threads, chunks)));
+    }
+
+    void Dataset::for_each_chunk(const std::function<void(const Chunk&, unsigned)>& fn, unsigned threads) {
+        Source& s = *src_;
+        if (s.streamed()) {
+            if (s.consumed) throw std::logic_error("Dataset: a stream can only be iterated once");
+            s.consumed = true;
+        }
+        const unsigned workers = worker_count(threads);
+        std::atomic<bool> stop{false};
+
+        if (!s.streamed()) {
+            // vista: i worker si contendono solo l'indice del prossimo chunk
+            const std::uint64_t rows = size();
+            const std::uint64_t chunks = (rows + s.chunk - 1) / s.chunk;
+            std::atomic<std::uint64_t> next{0};
+            run_workers(workers, stop, [&](unsigned t) {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const std::uint64_t i = next.fetch_add(1, std::memory_order_relaxed);
+                    if (i >= chunks) return;
+                    Chunk c;
+                    c.first = i * s.chunk;
+                    c.size = static_cast<std::size_t>(std::min<std::uint64_t>(s.chunk, rows - c.first));
+                    c.ips = s.ips + c.first;
+                    c.weights = s.weights != nullptr ? s.weights + c.first : nullptr;
+                    fn(c, t);
+                }
+            });
+            return;
+        }
+
+        // stream: la decodifica è seriale (sotto lock), l'elaborazione dei chunk parallela
+        std::mutex read_mutex;
+        bool ended = false;
+        run_workers(workers, stop, [&](unsigned t) {
+            ChunkBuffer buf{s.chunk, s.weighted};
+            for (;;) {
+                Chunk c;
+                {
+                    std::lock_guard<std::mutex> lock{read_mutex};
+                    if (ended || stop.load(std::memory_order_relaxed)) return;
+                    try {
+                        c.size = s.reader(buf.ips, buf.weights, s.chunk);
+                    } catch (...) {
+                        ended = true;   // nessun altro worker deve richiamare un lettore fallito
+                        throw;
+                    }
+                    if (c.size == 0) {
+                        ended = true;
+                        return;
+                    }
+                    if (c.size > s.chunk) {
+                        throw std::logic_error("Dataset: reader returned more rows than the chunk size");
+                    }
+                    c.first = s.rows.fetch_add(c.size, std::memory_order_relaxed);
+                }
+                c.ips = buf.ips;
+                c.weights = buf.weights;
+                fn(c, t);
+            }
+        });
+    }
+
+    std::uint64_t bucketize(const BucketEngine& engine, Dataset& data, BucketIndex* out,
+                            std::size_t capacity, unsigned threads) {
+        std::atomic<std::uint64_t> written{0};
+        std::atomic<bool> overflow{false};
+        data.for_each_chunk([&](const Chunk& c, unsigned) {
+            // le righe oltre capacity si scartano; l'errore arriva a fine iterazione
+            const std::size_t n = c.first >= capacity
+                                      ? 0
+                                      : static_cast<std::size_t>(std::min<std::uint64_t>(c.size, capacity - c.first));
+            if (n < c.size) overflow.store(true, std::memory_order_relaxed);
+            engine.bucketize(c.ips, n, out + (n > 0 ? c.first : 0));
+            written.fetch_add(n, std::memory_order_relaxed);
+        }, threads);
+        if (overflow.load()) {
+            throw std::out_of_range("bucketize: dataset has more than " + std::to_string(capacity) + " rows");
+        }
+        return written.load();
+    }
+
+    std::uint64_t accumulate(const BucketEngine& engine, Dataset& data, std::vector<std::size_t>& counts,
+                             unsigned threads) {
+        check_counts(engine, counts, "accumulate");
+        const std::uint64_t before = data.is_view() ? 0 : data.size();
+        const unsigned workers = data.worker_count(threads);
+        auto add = [&](const Chunk& c, std::size_t* into) {
+            if (c.weights != nullptr) {
+                engine.accumulate(c.ips, c.weights, c.size, into, counts.size());
+            } else {
+                engine.accumulate(c.ips, c.size, into, counts.size());
+            }
+        };
+
+        if (workers == 1) {
+            data.for_each_chunk([&](const Chunk& c, unsigned) { add(c, counts.data()); }, 1);
+            return data.size() - before;
+        }
+
+        // un istogramma privato per worker, allocato solo se il worker riceve almeno un chunk
+        std::vector<counted_vector<std::size_t>> local(
+            workers, counted_vector<std::size_t>(CountingAllocator<std::size_t>{MemCategory::Histogram}));
+        data.for_each_chunk([&](const Chunk& c, unsigned t) {
+            auto& h = local[t];
+            if (h.empty()) h.assign(counts.size(), 0);
+            add(c, h.data());
+        }, workers);
+        for (const auto& h : local) {
+            for (std::size_t b = 0; b < h.size(); ++b) counts[b] += h[b];
+        }
+        return data.size() - before;
+    }
+
+    std::vector<std::size_t> distribution(const BucketEngine& engine, Dataset& data, unsigned threads) {
+        std::vector<std::size_t> counts(engine.config().bucket_count(), 0);
+        accumulate(engine, data, counts, threads);
+        return counts;
+    }
+
+    StatsResult compute_stats(const BucketEngine& engine, Dataset& data, unsigned threads) {
+        return compute_stats(distribution(engine, data, threads));
+    }
+
+    namespace {
+        // Part: std::vector<IPv4> o std::pmr::vector<IPv4>, costruite tutte da `alloc`
+        // (sul posto: la copia di un vettore pmr tornerebbe alla risorsa di default)
+        template <class Part>
+        std::vector<Part> make_parts(unsigned parts, const typename Part::allocator_type& alloc) {
+            std::vector<Part> v;
+            v.reserve(parts);
+            for (unsigned p = 0; p < parts; ++p) v.emplace_back(alloc);
+            return v;
+        }
+
+        template <class Part>
+        std::vector<Part> partition_into(const BucketEngine& engine, Dataset& data, unsigned parts,
+                                         unsigned threads, const typename Part::allocator_type& alloc) {
+            if (parts == 0) throw std::invalid_argument("partition: parts must be > 0");
+            const unsigned k = std::min(engine.config().k, 32u);
+            const unsigned workers = data.worker_count(threads);
+
+            // per worker: buffer degli indici del chunk e una lista per parte
+            std::vector<counted_vector<BucketIndex>> indices(
+                workers, counted_vector<BucketIndex>(CountingAllocator<BucketIndex>{MemCategory::Buffers}));
+            std::vector<std::vector<Part>> local;
+            local.reserve(workers);
+            for (unsigned t = 0; t < workers; ++t) local.push_back(make_parts<Part>(parts, alloc));
+            data.for_each_chunk([&](const Chunk& c, unsigned t) {
+                auto& idx = indices[t];
+                if (idx.size() < c.size) idx.resize(c.size);
+                engine.bucketize(c.ips, c.size, idx.data());
+                auto& out = local[t];
+                for (std::size_t i = 0; i < c.size; ++i) {
+                    const auto p = static_cast<unsigned>((static_cast<std::uint64_t>(idx[i]) * parts) >> k);
+                    out[p].push_back(c.ips[i]);
+                }
+            }, workers);
+
+            if (workers == 1) return std::move(local.front());
+            std::vector<Part> result = make_parts<Part>(parts, alloc);
+            for (unsigned p = 0; p < parts; ++p) {
+                std::size_t total = 0;
+                for (const auto& w : local) total += w[p].size();
+                result[p].reserve(total);
+                for (auto& w : local) {
+                    result[p].insert(result[p].end(), w[p].begin(), w[p].end());
+                    Part(alloc).swap(w[p]);
+                }
+            }
+            return result;
+        }
+    }
+
+    std::vector<std::vector<IPv4>> partition(const BucketEngine& engine, Dataset& data, unsigned parts,
+                                             unsigned threads) {
+        return partition_into<std::vector<IPv4>>(engine, data, parts, threads, {});
+    }
+
+    std::vector<std::pmr::vector<IPv4>> partition(const BucketEngine& engine, Dataset& data, unsigned parts,
+                                                  unsigned threads, std::pmr::memory_resource* mr) {
+        return partition_into<std::pmr::vector<IPv4>>(engine, data, parts, threads,
+                                                      std::pmr::polymorphic_allocator<IPv4>{mr});
+    }
+
+}
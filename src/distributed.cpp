@@ -0,0 +1,539 @@
+#include "tb/distributed.hpp"
+#include "tb/bucket_engine.hpp"
+#include "tb/ingest.hpp"
+#include "tb/stats.hpp"
+#include "tb/trace.hpp"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace tb {
+
+    namespace {
+        // ---------- Protocollo ----------
+        // frame = [u32 tipo][u32 lunghezza payload][payload], tutto big-endian
+        constexpr std::uint32_t kProtocolVersion = 2;   // 2: ERROR porta il tipo di errore
+        constexpr std::size_t kFrameHeader = 8;
+        constexpr std::uint32_t kMaxPayload = 1u << 30;   // frame di controllo; RESULT: vedi result_payload
+        constexpr std::size_t kResultHeader = 28;          // id, samples, bytes, m
+        // k più alto con un RESULT (28 + 2^k * 8 byte) rappresentabile nella lunghezza a 32 bit
+        constexpr unsigned kMaxDistributedK = 28;
+
+        std::uint64_t result_payload(std::size_t buckets) noexcept {
+            return kResultHeader + static_cast<std::uint64_t>(buckets) * 8;
+        }
+
+        enum MsgType : std::uint32_t {
+            kHello  = 1,   // worker -> coordinator: versione protocollo
+            kTask   = 2,   // coordinator -> worker: id, a, b, k, begin, end, path
+            kResult = 3,   // worker -> coordinator: id, samples, bytes, m, counts[m]
+            kError  = 4,   // worker -> coordinator: id, tipo (kInputError/kOtherError), messaggio
+            kDone   = 5    // coordinator -> worker: nessun altro task
+        };
+
+        // tipi di ERROR: solo un record non valido è deterministico
+        constexpr std::uint32_t kOtherError = 0;
+        constexpr std::uint32_t kInputError = 1;
+
+        struct Writer {
+            std::vector<std::uint8_t> buf;
+
+            explicit Writer(std::uint32_t type) {
+                buf.resize(kFrameHeader);
+                put32_at(0, type);
+            }
+            void put32_at(std::size_t off, std::uint32_t v) {
+                for (int i = 0; i < 4; ++i) buf[off + i] = static_cast<std::uint8_t>(v >> (24 - 8 * i));
+            }
+            void u32(std::uint32_t v) {
+                for (int i = 3; i >= 0; --i) buf.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+            }
+            void u64(std::uint64_t v) {
+                for (int i = 7; i >= 0; --i) buf.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+            }
+            void str(const std::string& s) {
+                u32(static_cast<std::uint32_t>(s.size()));
+                buf.insert(buf.end(), s.begin(), s.end());
+            }
+            const std::vector<std::uint8_t>& finish() {
+                put32_at(4, static_cast<std::uint32_t>(buf.size() - kFrameHeader));
+                return buf;
+            }
+        };
+
+        struct Reader {
+            const std::uint8_t* p;
+            std::size_t n;
+            std::size_t off = 0;
+
+            void need(std::size_t k) const {
+                if (off + k > n) throw std::runtime_error("Protocol error: truncated message");
+            }
+            std::uint32_t u32() {
+                need(4);
+                std::uint32_t v = 0;
+                for (int i = 0; i < 4; ++i) v = (v << 8) | p[off++];
+                return v;
+            }
+            std::uint64_t u64() {
+                need(8);
+                std::uint64_t v = 0;
+                for (int i = 0; i < 8; ++i) v = (v << 8) | p[off++];
+                return v;
+            }
+            std::string str() {
+                const std::uint32_t len = u32();
+                need(len);
+                std::string s(reinterpret_cast<const char*>(p + off), len);
+                off += len;
+                return s;
+            }
+        };
+
+        std::uint32_t be32(const std::uint8_t* p) noexcept {
+            return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+                (static_cast<std::uint32_t>(p[2]) << 8) | p[3];
+        }
+
+        bool send_all(int fd, const std::vector<std::uint8_t>& data) {
+            std::size_t off = 0;
+            while (off < data.size()) {
+                const auto n = ::send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                off += static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        bool recv_exact(int fd, std::uint8_t* dst, std::size_t len) {
+            std::size_t off = 0;
+            while (off < len) {
+                const auto n = ::recv(fd, dst + off, len - off, 0);
+                if (n == 0) return false;
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                off += static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        // frame bloccante (lato worker); false = connessione chiusa
+        bool recv_frame(int fd, std::uint32_t& type, std::vector<std::uint8_t>& payload) {
+            std::uint8_t hdr[kFrameHeader];
+            if (!recv_exact(fd, hdr, sizeof(hdr))) return false;
+            type = be32(hdr);
+            const std::uint32_t len = be32(hdr + 4);
+            if (len > kMaxPayload) throw std::runtime_error("Protocol error: oversized frame");
+            payload.resize(len);
+            return len == 0 || recv_exact(fd, payload.data(), len);
+        }
+
+        std::runtime_error sys_error(const std::string& what) {
+            return std::runtime_error(what + ": " + std::strerror(errno));
+        }
+
+        struct FdGuard {
+            int fd;
+            ~FdGuard() { ::close(fd); }
+        };
+
+        // stato di una connessione worker lato coordinator
+        struct Conn {
+            int fd = -1;
+            std::vector<std::uint8_t> in;
+            bool ready = false;                                  // HELLO ricevuto
+            long task = -1;                                      // task in corso, -1 = idle
+            std::chrono::steady_clock::time_point deadline{};
+        };
+    }
+
+    std::vector<FileTask> split_file(std::uint64_t file_size, std::uint64_t chunk_bytes) {
+        if (chunk_bytes == 0) {
+            throw std::invalid_argument("split_file: chunk size must be > 0");
+        }
+        std::vector<FileTask> tasks;
+        for (std::uint64_t off = 0; off < file_size; off += chunk_bytes) {
+            FileTask t;
+            t.id = static_cast<std::uint32_t>(tasks.size());
+            t.begin = off;
+            t.end = std::min(file_size, off + chunk_bytes);
+            tasks.push_back(t);
+        }
+        return tasks;
+    }
+
+    // ---------- Coordinator ----------
+
+    Coordinator::Coordinator(const Config& cfg, const CoordinatorOptions& opt)
+    : cfg_{cfg}, opt_{opt} {
+        if (opt_.max_attempts == 0) {
+            throw std::runtime_error("Coordinator max_attempts must be > 0");
+        }
+        if (cfg_.k > kMaxDistributedK) {
+            throw std::runtime_error("Distributed runs support k <= " + std::to_string(kMaxDistributedK) +
+                                     ": the histogram of k = " + std::to_string(cfg_.k) +
+                                     " does not fit a result message (run it on a single node)");
+        }
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            throw sys_error("Cannot create coordinator socket");
+        }
+        const int one = 1;
+        ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(opt_.port);
+        if (::inet_pton(AF_INET, opt_.bind_address.c_str(), &addr.sin_addr) != 1) {
+            ::close(fd_);
+            throw std::runtime_error("Invalid coordinator bind address: '" + opt_.bind_address + "'");
+        }
+        if (::bind(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd_, 64) != 0) {
+            const auto err = sys_error("Cannot listen on " + opt_.bind_address + ":" + std::to_string(opt_.port));
+            ::close(fd_);
+            throw err;
+        }
+        sockaddr_in bound{};
+        socklen_t bound_len = sizeof(bound);
+        ::getsockname(fd_, reinterpret_cast<sockaddr*>(&bound), &bound_len);
+        port_ = ntohs(bound.sin_port);
+    }
+
+    Coordinator::~Coordinator() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    JobResult Coordinator::run() {
+        using clock = std::chrono::steady_clock;
+
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(opt_.path, ec);
+        if (ec) {
+            throw std::runtime_error("Cannot stat input file: " + opt_.path + " (" + ec.message() + ")");
+        }
+        // senza task il job finirebbe prima che un worker si colleghi: i worker vedrebbero solo
+        // la connessione chiusa. Un input vuoto è un errore anche su un nodo solo
+        if (size == 0) {
+            throw std::runtime_error("Input file is empty: " + opt_.path);
+        }
+        // gli offset di un flusso gzip non sono confini di riga: non si può dividere
+        char magic[2] = {0, 0};
+        if (std::ifstream{opt_.path, std::ios::binary}.read(magic, 2) &&
+            static_cast<unsigned char>(magic[0]) == 0x1f && static_cast<unsigned char>(magic[1]) == 0x8b) {
+            throw std::runtime_error("Distributed runs cannot split gzip input: " + opt_.path +
+                                     " (decompress it first, or run it on a single node)");
+        }
+        const std::vector<FileTask> tasks = split_file(size, opt_.chunk_bytes);
+
+        JobResult res;
+        res.counts.assign(cfg_.bucket_count(), 0);
+        res.tasks = tasks.size();
+        const std::uint64_t max_result = result_payload(res.counts.size());
+
+        std::vector<unsigned> attempts(tasks.size(), 0);
+        std::vector<std::string> last_error(tasks.size());   // ultimo ERROR ritentabile del task
+        std::vector<bool> done(tasks.size(), false);
+        std::deque<std::uint32_t> pending;
+        for (const auto& t : tasks) pending.push_back(t.id);
+        std::size_t completed = 0;
+
+        std::vector<Conn> conns;
+        auto close_all = [&] {
+            for (auto& c : conns) ::close(c.fd);
+            conns.clear();
+        };
+
+        // worker perso: il suo task torna in coda (in testa, per non ritardare la fine del job)
+        auto drop = [&](std::size_t i) {
+            Conn& c = conns[i];
+            if (c.task >= 0 && !done[static_cast<std::size_t>(c.task)]) {
+                pending.push_front(static_cast<std::uint32_t>(c.task));
+                ++res.retries;
+            }
+            ::close(c.fd);
+            conns.erase(conns.begin() + static_cast<std::ptrdiff_t>(i));
+        };
+
+        try {
+            while (completed < tasks.size()) {
+                // assegnazione dei task ai worker liberi
+                for (std::size_t i = 0; i < conns.size();) {
+                    Conn& c = conns[i];
+                    if (!c.ready || c.task >= 0 || pending.empty()) { ++i; continue; }
+                    const std::uint32_t id = pending.front();
+                    if (attempts[id] >= opt_.max_attempts) {
+                        throw std::runtime_error("Task " + std::to_string(id) + " failed after " +
+                                                 std::to_string(attempts[id]) + " attempts" +
+                                                 (last_error[id].empty() ? "" : ": " + last_error[id]));
+                    }
+                    pending.pop_front();
+                    ++attempts[id];
+
+                    Writer w{kTask};
+                    w.u32(id);
+                    w.u32(cfg_.a);
+                    w.u32(cfg_.b);
+                    w.u32(cfg_.k);
+                    w.u64(tasks[id].begin);
+                    w.u64(tasks[id].end);
+                    w.str(opt_.path);
+                    c.task = id;
+                    c.deadline = clock::now() + opt_.task_timeout;
+                    if (!send_all(c.fd, w.finish())) {
+                        drop(i);
+                        continue;
+                    }
+                    ++i;
+                }
+
+                std::vector<pollfd> pfds;
+                pfds.push_back(pollfd{fd_, POLLIN, 0});
+                for (const auto& c : conns) pfds.push_back(pollfd{c.fd, POLLIN, 0});
+                const int ready = ::poll(pfds.data(), pfds.size(), 100);
+                if (ready < 0 && errno != EINTR) {
+                    throw sys_error("poll failed");
+                }
+
+                if (ready > 0 && (pfds[0].revents & POLLIN)) {
+                    const int client = ::accept(fd_, nullptr, nullptr);
+                    if (client >= 0) {
+                        const int one = 1;
+                        ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                        Conn c;
+                        c.fd = client;
+                        conns.push_back(std::move(c));
+                        ++res.workers;
+                    }
+                }
+
+                // lettura e parsing dei frame (pfds[i+1] <-> conns[i], solo quelli esistenti al poll)
+                const std::size_t polled = pfds.size() - 1;
+                for (std::size_t pi = polled; pi-- > 0;) {
+                    if (ready <= 0 || !(pfds[pi + 1].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                    Conn& c = conns[pi];
+                    std::uint8_t buf[65536];
+                    const auto n = ::recv(c.fd, buf, sizeof(buf), 0);
+                    if (n <= 0) {
+                        drop(pi);
+                        continue;
+                    }
+                    c.in.insert(c.in.end(), buf, buf + n);
+
+                    bool broken = false;
+                    while (!broken && c.in.size() >= kFrameHeader) {
+                        const std::uint32_t type = be32(c.in.data());
+                        const std::uint32_t len = be32(c.in.data() + 4);
+                        if (len > (type == kResult ? std::max<std::uint64_t>(kMaxPayload, max_result) : kMaxPayload)) {
+                            broken = true;
+                            break;
+                        }
+                        if (c.in.size() < kFrameHeader + len) break;
+
+                        Reader r{c.in.data() + kFrameHeader, len};
+                        try {
+                            if (type == kError) {
+                                const std::uint32_t id = r.u32();
+                                const std::uint32_t kind = r.u32();
+                                const std::string what = r.str();
+                                if (static_cast<long>(id) != c.task) {
+                                    broken = true;
+                                } else if (kind == kInputError) {
+                                    // riga non valida: deterministico, inutile ritentare
+                                    throw InputError("Worker failed on task " + std::to_string(id) + ": " + what);
+                                } else {
+                                    // I/O (file non ancora visibile, errore di lettura): il task torna
+                                    // in coda, in fondo, con i tentativi contati come per drop()
+                                    if (!done[id]) {
+                                        last_error[id] = what;
+                                        pending.push_back(id);
+                                        ++res.retries;
+                                    }
+                                    c.task = -1;
+                                }
+                            } else if (type == kHello) {
+                                if (r.u32() != kProtocolVersion) broken = true;
+                                c.ready = true;
+                            } else if (type == kResult) {
+                                const std::uint32_t id = r.u32();
+                                const std::uint64_t samples = r.u64();
+                                const std::uint64_t bytes = r.u64();
+                                const std::uint64_t m = r.u64();
+                                if (static_cast<long>(id) != c.task || m != res.counts.size()) {
+                                    broken = true;
+                                } else {
+                                    r.need(m * 8);
+                                    // exactly-once: un risultato tardivo di un task già fuso viene ignorato
+                                    if (!done[id]) {
+                                        for (std::size_t b = 0; b < m; ++b) {
+                                            res.counts[b] += static_cast<std::size_t>(r.u64());
+                                        }
+                                        done[id] = true;
+                                        ++completed;
+                                        res.samples += samples;
+                                        res.bytes += bytes;
+                                    }
+                                    c.task = -1;
+                                }
+                            } else {
+                                broken = true;
+                            }
+                        } catch (const InputError&) {
+                            throw;
+                        } catch (const std::runtime_error&) {
+                            broken = true; // frame troncato: worker non affidabile
+                        }
+                        c.in.erase(c.in.begin(), c.in.begin() + static_cast<std::ptrdiff_t>(kFrameHeader + len));
+                    }
+                    if (broken) drop(pi);
+                }
+
+                // worker troppo lenti: presunti morti
+                const auto now = clock::now();
+                for (std::size_t i = conns.size(); i-- > 0;) {
+                    if (conns[i].task >= 0 && now > conns[i].deadline) {
+                        drop(i);
+                    }
+                }
+            }
+
+            Writer bye{kDone};
+            const auto& frame = bye.finish();
+            for (auto& c : conns) send_all(c.fd, frame);
+            close_all();
+        } catch (...) {
+            close_all();
+            throw;
+        }
+
+        res.stats = compute_stats(res.counts);
+        return res;
+    }
+
+    // ---------- Worker ----------
+
+    namespace {
+        int connect_with_retry(const WorkerOptions& opt) {
+            using clock = std::chrono::steady_clock;
+            const auto give_up = clock::now() + opt.connect_timeout;
+
+            addrinfo hints{};
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* res = nullptr;
+            const std::string port = std::to_string(opt.port);
+            const int rc = ::getaddrinfo(opt.host.c_str(), port.c_str(), &hints, &res);
+            if (rc != 0) {
+                throw std::runtime_error("Cannot resolve coordinator '" + opt.host + "': " + ::gai_strerror(rc));
+            }
+            std::unique_ptr<addrinfo, decltype(&::freeaddrinfo)> guard{res, &::freeaddrinfo};
+
+            // il coordinator potrebbe non essere ancora su: riprova fino al timeout
+            for (;;) {
+                const int fd = ::socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+                if (fd < 0) throw sys_error("Cannot create worker socket");
+                if (::connect(fd, res->ai_addr, res->ai_addrlen) == 0) {
+                    const int one = 1;
+                    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    return fd;
+                }
+                ::close(fd);
+                if (clock::now() >= give_up) {
+                    throw sys_error("Cannot connect to coordinator " + opt.host + ":" + port);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+    }
+
+    WorkerSummary run_worker(const WorkerOptions& opt) {
+        const int fd = connect_with_retry(opt);
+        const FdGuard guard{fd};
+
+        Writer hello{kHello};
+        hello.u32(kProtocolVersion);
+        if (!send_all(fd, hello.finish())) {
+            throw sys_error("Cannot send hello to coordinator");
+        }
+
+        WorkerSummary summary;
+        std::unique_ptr<BucketEngine> engine;
+        std::vector<std::size_t> counts;
+        std::vector<std::uint8_t> payload;
+        std::uint32_t type = 0;
+
+        while (recv_frame(fd, type, payload)) {
+            if (type == kDone) {
+                return summary;
+            }
+            if (type != kTask) {
+                throw std::runtime_error("Protocol error: unexpected message " + std::to_string(type));
+            }
+
+            Reader r{payload.data(), payload.size()};
+            const std::uint32_t id = r.u32();
+            Config cfg;
+            cfg.a = r.u32();
+            cfg.b = r.u32();
+            cfg.k = r.u32();
+            const std::uint64_t begin = r.u64();
+            const std::uint64_t end = r.u64();
+            const std::string path = r.str();
+
+            if (!engine || engine->config().a != cfg.a || engine->config().b != cfg.b || engine->config().k != cfg.k) {
+                engine = std::make_unique<BucketEngine>(cfg);
+            }
+            counts.assign(cfg.bucket_count(), 0);
+
+            RangeCounts rc;
+            try {
+                ScopedTrace task{"task"};
+                rc = accumulate_ipv4_range(path, begin, end, *engine, counts);
+                task.add(rc.samples, rc.bytes);
+            } catch (const std::exception& e) {
+                Writer err{kError};
+                err.u32(id);
+                err.u32(dynamic_cast<const InputError*>(&e) != nullptr ? kInputError : kOtherError);
+                err.str(e.what());
+                send_all(fd, err.finish());
+                continue;
+            }
+
+            Writer w{kResult};
+            w.buf.reserve(kFrameHeader + result_payload(counts.size()));
+            w.u32(id);
+            w.u64(rc.samples);
+            w.u64(rc.bytes);
+            w.u64(counts.size());
+            for (const std::size_t c : counts) w.u64(c);
+            if (!send_all(fd, w.finish())) {
+                throw sys_error("Lost connection to coordinator");
+            }
+            ++summary.tasks;
+            summary.samples += rc.samples;
+        }
+        throw std::runtime_error("Coordinator closed the connection before the job completed");
+    }
+
+}
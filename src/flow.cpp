@@ -0,0 +1,306 @@
+#include "tb/flow.hpp"
+#include "tb/stats.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace tb {
+
+    namespace {
+        // tutti i campi NetFlow/IPFIX sono big-endian (network order)
+        inline std::uint16_t rd16(const std::uint8_t* p) noexcept {
+            return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+        }
+
+        inline std::uint32_t rd32(const std::uint8_t* p) noexcept {
+            return (static_cast<std::uint32_t>(p[0]) << 24) |
+                (static_cast<std::uint32_t>(p[1]) << 16) |
+                (static_cast<std::uint32_t>(p[2]) << 8)  |
+                (static_cast<std::uint32_t>(p[3]));
+        }
+
+        // interi unsigned con "reduced-size encoding" (RFC 7011 §6.2): 1..8 byte
+        inline std::uint64_t rd_uint(const std::uint8_t* p, std::size_t n) noexcept {
+            std::uint64_t v = 0;
+            for (std::size_t i = 0; i < n && i < 8; ++i) {
+                v = (v << 8) | p[i];
+            }
+            return v;
+        }
+
+        constexpr std::uint16_t kVersionV5    = 5;
+        constexpr std::uint16_t kVersionIpfix = 10;
+
+        constexpr std::size_t kV5HeaderLen = 24;
+        constexpr std::size_t kV5RecordLen = 48;
+
+        constexpr std::size_t kIpfixHeaderLen = 16;
+        constexpr std::size_t kSetHeaderLen   = 4;
+
+        constexpr std::uint16_t kSetTemplate        = 2;
+        constexpr std::uint16_t kSetOptionsTemplate = 3;
+        constexpr std::uint16_t kFirstDataSet       = 256;
+
+        // Information Elements IANA
+        constexpr std::uint16_t kIeOctetDelta   = 1;
+        constexpr std::uint16_t kIePacketDelta  = 2;
+        constexpr std::uint16_t kIeSrcIPv4      = 8;
+        constexpr std::uint16_t kIeDstIPv4      = 12;
+        constexpr std::uint16_t kIeOctetTotal   = 85;
+        constexpr std::uint16_t kIePacketTotal  = 86;
+
+        constexpr std::uint16_t kVarLen = 0xFFFF;
+
+        [[noreturn]] void malformed(const std::string& what) {
+            throw std::runtime_error("Malformed flow datagram: " + what);
+        }
+    }
+
+    std::size_t FlowDecoder::decode(const std::uint8_t* data, std::size_t len,
+                                    std::vector<FlowRecord>& out,
+                                    std::uint64_t exporter) {
+        if (len < 2) {
+            malformed("shorter than version field");
+        }
+        const std::uint16_t version = rd16(data);
+        if (version == kVersionV5) {
+            return decode_v5(data, len, out);
+        }
+        if (version == kVersionIpfix) {
+            return decode_ipfix(data, len, out, exporter);
+        }
+        throw std::runtime_error("Unsupported flow export version: " + std::to_string(version));
+    }
+
+    std::size_t FlowDecoder::decode_v5(const std::uint8_t* data, std::size_t len,
+                                       std::vector<FlowRecord>& out) {
+        if (len < kV5HeaderLen) {
+            malformed("truncated NetFlow v5 header");
+        }
+        const std::size_t count = rd16(data + 2);
+        if (len < kV5HeaderLen + count * kV5RecordLen) {
+            malformed("NetFlow v5 count " + std::to_string(count) + " exceeds datagram length");
+        }
+
+        const std::uint8_t* p = data + kV5HeaderLen;
+        for (std::size_t i = 0; i < count; ++i, p += kV5RecordLen) {
+            FlowRecord r;
+            r.src     = rd32(p + 0);
+            r.dst     = rd32(p + 4);
+            r.packets = rd32(p + 16);
+            r.bytes   = rd32(p + 20);
+            out.push_back(r);
+        }
+        return count;
+    }
+
+    std::size_t FlowDecoder::decode_ipfix(const std::uint8_t* data, std::size_t len,
+                                          std::vector<FlowRecord>& out, std::uint64_t exporter) {
+        if (len < kIpfixHeaderLen) {
+            malformed("truncated IPFIX message header");
+        }
+        const std::size_t msg_len = rd16(data + 2);
+        if (msg_len < kIpfixHeaderLen || msg_len > len) {
+            malformed("IPFIX message length " + std::to_string(msg_len) + " does not match datagram");
+        }
+        const std::uint32_t domain = rd32(data + 12);
+
+        std::size_t appended = 0;
+        std::size_t off = kIpfixHeaderLen;
+        while (off + kSetHeaderLen <= msg_len) {
+            const std::uint16_t set_id  = rd16(data + off);
+            const std::size_t   set_len = rd16(data + off + 2);
+            if (set_len < kSetHeaderLen || off + set_len > msg_len) {
+                malformed("IPFIX set length " + std::to_string(set_len) + " out of bounds");
+            }
+            const std::uint8_t* body = data + off + kSetHeaderLen;
+            const std::size_t body_len = set_len - kSetHeaderLen;
+
+            if (set_id == kSetTemplate || set_id == kSetOptionsTemplate) {
+                parse_templates(body, body_len, exporter, domain, set_id == kSetOptionsTemplate);
+            } else if (set_id >= kFirstDataSet) {
+                const auto it = templates_.find(TemplateKey{exporter, domain, set_id});
+                if (it == templates_.end()) {
+                    // template non ancora visto: il set viene scartato (non sappiamo quanti record contiene)
+                    ++skipped_;
+                } else {
+                    appended += parse_data(it->second, body, body_len, out);
+                }
+            }
+            // set id 0/1 (NetFlow v9) e 4..255 riservati: ignorati
+            off += set_len;
+        }
+        return appended;
+    }
+
+    void FlowDecoder::parse_templates(const std::uint8_t* p, std::size_t len,
+                                      std::uint64_t exporter, std::uint32_t domain, bool options) {
+        std::size_t off = 0;
+        const std::size_t hdr = options ? 6u : 4u;
+        while (off + hdr <= len) {
+            const std::uint16_t id = rd16(p + off);
+            const std::size_t field_count = rd16(p + off + 2);
+            off += hdr;
+
+            if (id < kFirstDataSet) {
+                // padding finale del set (tutti zeri) oppure id non valido
+                break;
+            }
+            if (field_count == 0) {
+                // template withdrawal (RFC 7011 §8.1)
+                templates_.erase(TemplateKey{exporter, domain, id});
+                continue;
+            }
+
+            Template t;
+            t.fields.reserve(field_count);
+            for (std::size_t f = 0; f < field_count; ++f) {
+                if (off + 4 > len) {
+                    malformed("truncated IPFIX template " + std::to_string(id));
+                }
+                Field fld;
+                const std::uint16_t raw_id = rd16(p + off);
+                fld.enterprise = (raw_id & 0x8000u) != 0;
+                fld.id = static_cast<std::uint16_t>(raw_id & 0x7FFFu);
+                fld.length = rd16(p + off + 2);
+                off += 4;
+                if (fld.enterprise) {
+                    if (off + 4 > len) {
+                        malformed("truncated enterprise number in template " + std::to_string(id));
+                    }
+                    off += 4;
+                }
+                t.min_len += (fld.length == kVarLen) ? 1u : fld.length;
+                t.fields.push_back(fld);
+            }
+            if (t.min_len == 0) {
+                malformed("IPFIX template " + std::to_string(id) + " has zero-length records");
+            }
+            templates_[TemplateKey{exporter, domain, id}] = std::move(t);
+        }
+    }
+
+    std::size_t FlowDecoder::parse_data(const Template& t, const std::uint8_t* p, std::size_t len,
+                                        std::vector<FlowRecord>& out) {
+        std::size_t appended = 0;
+        std::size_t off = 0;
+        // i byte residui < min_len sono padding del set
+        while (off + t.min_len <= len) {
+            FlowRecord r;
+            bool has_src = false;
+            bool has_dst = false;
+            bool has_octet_delta = false;
+            bool has_packet_delta = false;
+
+            for (const Field& f : t.fields) {
+                std::size_t flen = f.length;
+                if (flen == kVarLen) {
+                    if (off + 1 > len) malformed("truncated variable-length field");
+                    flen = p[off++];
+                    if (flen == 255) {
+                        if (off + 2 > len) malformed("truncated variable-length field");
+                        flen = rd16(p + off);
+                        off += 2;
+                    }
+                }
+                if (off + flen > len) {
+                    malformed("IPFIX data record exceeds set length");
+                }
+                const std::uint8_t* v = p + off;
+                off += flen;
+                if (f.enterprise) continue;
+
+                switch (f.id) {
+                    case kIeSrcIPv4:
+                        if (flen == 4) { r.src = rd32(v); has_src = true; }
+                        break;
+                    case kIeDstIPv4:
+                        if (flen == 4) { r.dst = rd32(v); has_dst = true; }
+                        break;
+                    case kIeOctetDelta:
+                        r.bytes = rd_uint(v, flen);
+                        has_octet_delta = true;
+                        break;
+                    case kIePacketDelta:
+                        r.packets = rd_uint(v, flen);
+                        has_packet_delta = true;
+                        break;
+                    case kIeOctetTotal:
+                        if (!has_octet_delta) r.bytes = rd_uint(v, flen);
+                        break;
+                    case kIePacketTotal:
+                        if (!has_packet_delta) r.packets = rd_uint(v, flen);
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            if (has_src || has_dst) {
+                r.has_src = has_src;
+                r.has_dst = has_dst;
+                out.push_back(r);
+                ++appended;
+            } else {
+                // es. flussi IPv6 o record di options template
+                ++skipped_;
+            }
+        }
+        return appended;
+    }
+
+    // ---------- FlowWindow ----------
+
+    FlowWindow::FlowWindow(const Config& cfg, FlowKey key, FlowWeight weight)
+    : engine_{cfg}, key_{key}, weight_{weight}, counts_(cfg.bucket_count(), 0) {}
+
+    void FlowWindow::add(const FlowRecord& r) noexcept {
+        std::size_t w = 1;
+        if (weight_ == FlowWeight::Bytes) {
+            w = static_cast<std::size_t>(r.bytes);
+        } else if (weight_ == FlowWeight::Packets) {
+            w = static_cast<std::size_t>(r.packets);
+        }
+
+        // il lato assente non è 0.0.0.0: non si conta
+        if (key_ != FlowKey::Dst && r.has_src) {
+            const auto b = engine_.bucket_index(r.src);
+            if (b < counts_.size()) counts_[b] += w;
+        }
+        if (key_ != FlowKey::Src && r.has_dst) {
+            const auto b = engine_.bucket_index(r.dst);
+            if (b < counts_.size()) counts_[b] += w;
+        }
+        ++records_;
+    }
+
+    void FlowWindow::add(const std::vector<FlowRecord>& records) noexcept {
+        for (const FlowRecord& r : records) {
+            add(r);
+        }
+    }
+
+    void FlowWindow::note_datagram(std::size_t payload_bytes) noexcept {
+        ++datagrams_;
+        payload_bytes_ += payload_bytes;
+    }
+
+    WindowReport FlowWindow::flush(double seconds) {
+        WindowReport rep;
+        rep.index = index_++;
+        rep.seconds = seconds;
+        rep.stats = compute_stats(counts_);
+        rep.datagrams = datagrams_;
+        rep.records = records_;
+        rep.decode_errors = errors_;
+        rep.payload_bytes = payload_bytes_;
+
+        rep.counts.assign(counts_.size(), 0);
+        rep.counts.swap(counts_);
+
+        datagrams_ = records_ = errors_ = payload_bytes_ = 0;
+        return rep;
+    }
+
+}
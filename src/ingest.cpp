@@ -0,0 +1,606 @@
+#include "tb/ingest.hpp"
+#include "tb/memory.hpp"
+#include "tb/probes.hpp"
+#include "tb/profile.hpp"
+#include "tb/utils.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef TB_HAVE_ZLIB
+#define TB_HAVE_ZLIB 0
+#endif
+#if TB_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace tb {
+
+    namespace {
+        bool is_space(char c) noexcept {
+            return std::isspace(static_cast<unsigned char>(c)) != 0;
+        }
+
+        bool is_digit(char c) noexcept {
+            return c >= '0' && c <= '9';
+        }
+
+        // percorso veloce: quattro ottetti decimali stretti, niente allocazioni
+        bool parse_dotted(const char* p, const char* end, IPv4& out) noexcept {
+            std::uint32_t v = 0;
+            for (int octet = 0; octet < 4; ++octet) {
+                if (octet > 0) {
+                    if (p == end || *p != '.') return false;
+                    ++p;
+                }
+                std::uint32_t x = 0;
+                int digits = 0;
+                while (p != end && is_digit(*p) && digits < 3) {
+                    x = x * 10 + static_cast<std::uint32_t>(*p - '0');
+                    ++p;
+                    ++digits;
+                }
+                if (digits == 0 || x > 255u) return false;
+                v = (v << 8) | x;
+            }
+            if (p != end) return false;
+            out = v;
+            return true;
+        }
+
+        // stessa semantica (e stessi messaggi) di parse_ipv4 anche sui casi limite
+        IPv4 parse_field(const char* begin, const char* end) {
+            IPv4 ip = 0;
+            if (parse_dotted(begin, end, ip)) return ip;
+            return parse_ipv4(std::string(begin, end));
+        }
+
+        void trim(const char*& begin, const char*& end) noexcept {
+            while (begin != end && is_space(*begin)) ++begin;
+            while (end != begin && is_space(end[-1])) --end;
+        }
+
+        // primo token a.b.c.d delimitato da non-alfanumerici
+        bool find_dotted(const char* p, const char* end, IPv4& out) noexcept {
+            auto is_alnum = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) != 0; };
+            const char* const begin = p;
+            while (p != end) {
+                if (!is_digit(*p)) {
+                    ++p;
+                    continue;
+                }
+                const char* run = p;
+                while (p != end && (is_digit(*p) || *p == '.')) ++p;
+                const bool bounded = (run == begin || !is_alnum(run[-1])) && (p == end || !is_alnum(*p));
+                const char* run_end = p;
+                while (run_end != run && run_end[-1] == '.') --run_end;   // "from 1.2.3.4."
+                if (bounded && parse_dotted(run, run_end, out)) return true;
+                while (p != end && is_alnum(*p)) ++p;                     // resto della parola
+            }
+            return false;
+        }
+
+        std::uint32_t load_be32(const char* p) noexcept {
+            const auto* u = reinterpret_cast<const unsigned char*>(p);
+            return (std::uint32_t{u[0]} << 24) | (std::uint32_t{u[1]} << 16) |
+                   (std::uint32_t{u[2]} << 8) | std::uint32_t{u[3]};
+        }
+    }
+
+    InputFormat parse_input_format(const std::string& name) {
+        if (name == "text") return InputFormat::Text;
+        if (name == "csv") return InputFormat::Csv;
+        if (name == "log") return InputFormat::Log;
+        if (name == "binary") return InputFormat::Binary;
+        throw std::runtime_error("Unknown input format: '" + name + "' (expected text, csv, log or binary)");
+    }
+
+    const char* input_format_name(InputFormat f) noexcept {
+        switch (f) {
+            case InputFormat::Text: return "text";
+            case InputFormat::Csv: return "csv";
+            case InputFormat::Log: return "log";
+            case InputFormat::Binary: return "binary";
+        }
+        return "?";
+    }
+
+    bool gzip_supported() noexcept {
+        return TB_HAVE_ZLIB != 0;
+    }
+
+    // ---------- InputReader ----------
+
+    struct InputReader::Impl {
+        std::string path;
+        int fd = -1;
+        bool gz = false;
+        std::uint64_t file_bytes = 0;
+#if TB_HAVE_ZLIB
+        z_stream zs{};
+        bool z_init = false;
+        bool eof = false;
+        bool done = false;
+        std::vector<unsigned char> in;
+
+        // ricarica il buffer compresso; false a fine file
+        bool fill() {
+            if (eof) return false;
+            const std::size_t n = raw_read(reinterpret_cast<char*>(in.data()), in.size());
+            if (n == 0) {
+                eof = true;
+                return false;
+            }
+            zs.next_in = in.data();
+            zs.avail_in = static_cast<uInt>(n);
+            return true;
+        }
+
+        std::size_t inflate_read(char* buf, std::size_t n) {
+            if (done) return 0;
+            zs.next_out = reinterpret_cast<Bytef*>(buf);
+            zs.avail_out = static_cast<uInt>(std::min<std::size_t>(n, 1u << 30));
+            const uInt want = zs.avail_out;
+            while (zs.avail_out > 0) {
+                if (zs.avail_in == 0 && !fill()) {
+                    throw std::runtime_error("Truncated gzip input: " + path);
+                }
+                const int rc = ::inflate(&zs, Z_NO_FLUSH);
+                if (rc == Z_STREAM_END) {
+                    // membri concatenati (gzip -c a >> b): si riparte se segue altro input
+                    if (zs.avail_in == 0 && !fill()) {
+                        done = true;
+                        break;
+                    }
+                    ::inflateReset(&zs);
+                } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                    throw std::runtime_error("Corrupt gzip input: " + path + " (" +
+                                             (zs.msg != nullptr ? zs.msg : "inflate error") + ")");
+                }
+            }
+            return want - zs.avail_out;
+        }
+#endif
+
+        std::size_t raw_read(char* buf, std::size_t n) {
+            for (;;) {
+                const ssize_t r = ::read(fd, buf, n);
+                if (r >= 0) {
+                    file_bytes += static_cast<std::uint64_t>(r);
+                    return static_cast<std::size_t>(r);
+                }
+                if (errno != EINTR) {
+                    throw std::runtime_error("Read error on input file: " + path + ": " + std::strerror(errno));
+                }
+            }
+        }
+    };
+
+    InputReader::InputReader(const std::string& path) : impl_{std::make_unique<Impl>()} {
+        ScopedStage stage{Stage::Open};
+        impl_->path = path;
+        impl_->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (impl_->fd < 0) {
+            throw std::runtime_error("Cannot open input file: " + path);
+        }
+        unsigned char magic[2] = {0, 0};
+        impl_->gz = ::pread(impl_->fd, magic, 2, 0) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+        if (impl_->gz) {
+#if TB_HAVE_ZLIB
+            // 15 + 16: solo formato gzip, niente zlib/raw deflate
+            if (::inflateInit2(&impl_->zs, 15 + 16) != Z_OK) {
+                ::close(impl_->fd);
+                throw std::runtime_error("inflateInit2 failed for " + path);
+            }
+            impl_->z_init = true;
+            impl_->in.resize(kReadBlock);
+#else
+            ::close(impl_->fd);
+            throw std::runtime_error("gzip input requires zlib (rebuild tb_io with zlib): " + path);
+#endif
+        }
+    }
+
+    InputReader::~InputReader() {
+#if TB_HAVE_ZLIB
+        if (impl_->z_init) ::inflateEnd(&impl_->zs);
+#endif
+        ::close(impl_->fd);
+    }
+
+    std::size_t InputReader::read(char* buf, std::size_t n) {
+        if (n == 0) return 0;
+        ScopedStage stage{Stage::Read};
+        std::size_t got = 0;
+#if TB_HAVE_ZLIB
+        if (impl_->gz) {
+            got = impl_->inflate_read(buf, n);
+            stage.add(0, got);   // byte decompressi
+            return got;
+        }
+#endif
+        got = impl_->raw_read(buf, n);
+        stage.add(0, got);
+        return got;
+    }
+
+    std::uint64_t InputReader::skip(std::uint64_t n) {
+        if (!impl_->gz) {
+            // oltre la fine: read() restituisce 0, come dopo un file consumato
+            struct stat st{};
+            if (::fstat(impl_->fd, &st) != 0) {
+                throw std::runtime_error("Cannot stat input file: " + impl_->path);
+            }
+            const auto size = static_cast<std::uint64_t>(st.st_size);
+            const std::uint64_t skipped = std::min(n, size > impl_->file_bytes ? size - impl_->file_bytes : 0);
+            if (::lseek(impl_->fd, static_cast<off_t>(impl_->file_bytes + skipped), SEEK_SET) < 0) {
+                throw std::runtime_error("Seek error on input file: " + impl_->path + ": " + std::strerror(errno));
+            }
+            impl_->file_bytes += skipped;
+            return skipped;
+        }
+        counted_vector<char> buf(std::min<std::uint64_t>(n, kReadBlock), CountingAllocator<char>{MemCategory::Buffers});
+        std::uint64_t skipped = 0;
+        while (skipped < n) {
+            const auto want = static_cast<std::size_t>(std::min<std::uint64_t>(n - skipped, buf.size()));
+            const std::size_t got = read(buf.data(), want);
+            if (got == 0) break;
+            skipped += got;
+        }
+        return skipped;
+    }
+
+    bool InputReader::compressed() const noexcept {
+        return impl_->gz;
+    }
+
+    std::uint64_t InputReader::file_bytes() const noexcept {
+        return impl_->file_bytes;
+    }
+
+    // ---------- Ipv4Parser ----------
+
+    Ipv4Parser::Ipv4Parser(const IngestOptions& opt) : opt_{opt} {}
+
+    template <class Out>
+    void Ipv4Parser::feed_into(const char* data, std::size_t n, Out& out) {
+        ScopedStage stage{Stage::Parse};
+        const std::size_t before = out.size();
+        feed_block(data, n, out);
+        stage.add(out.size() - before, n);
+    }
+
+    template <class Out>
+    void Ipv4Parser::feed_block(const char* data, std::size_t n, Out& out) {
+        const char* p = data;
+        const char* const end = data + n;
+
+        if (opt_.format == InputFormat::Binary) {
+            if (!carry_.empty()) {
+                const std::size_t take = std::min<std::size_t>(4 - carry_.size(), n);
+                carry_.append(p, take);
+                p += take;
+                if (carry_.size() < 4) return;
+                out.push_back(load_be32(carry_.data()));
+                carry_.clear();
+            }
+            const std::size_t whole = static_cast<std::size_t>(end - p) / 4;
+            if (out.capacity() - out.size() < whole) {
+                // crescita geometrica: una reserve esatta per blocco ricopierebbe tutto a ogni blocco
+                out.reserve(std::max(out.size() + whole, out.capacity() * 2));
+            }
+            for (std::size_t i = 0; i < whole; ++i, p += 4) {
+                out.push_back(load_be32(p));
+            }
+            carry_.assign(p, end);
+            return;
+        }
+
+        if (!carry_.empty()) {
+            const auto* nl = static_cast<const char*>(std::memchr(p, '\n', n));
+            if (nl == nullptr) {
+                carry_.append(p, n);
+                return;
+            }
+            carry_.append(p, nl);
+            parse_record(carry_.data(), carry_.data() + carry_.size(), out);
+            carry_.clear();
+            p = nl + 1;
+        }
+        while (p < end) {
+            const auto* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (nl == nullptr) {
+                carry_.assign(p, end);
+                return;
+            }
+            parse_record(p, nl, out);
+            p = nl + 1;
+        }
+    }
+
+    template <class Out>
+    void Ipv4Parser::finish_into(Out& out) {
+        if (carry_.empty()) return;
+        if (opt_.format == InputFormat::Binary) {
+            const std::string msg = "Truncated binary input: " + std::to_string(carry_.size()) + " trailing byte(s)";
+            TB_PROBE3(parse__error, line_no_, static_cast<unsigned>(opt_.format), msg.c_str());
+            throw InputError(msg);
+        }
+        ScopedStage stage{Stage::Parse};
+        const std::size_t before = out.size();
+        parse_record(carry_.data(), carry_.data() + carry_.size(), out);
+        carry_.clear();
+        stage.add(out.size() - before, 0);
+    }
+
+    template <class Out>
+    void Ipv4Parser::parse_record(const char* begin, const char* end, Out& out) {
+        ++line_no_;
+        try {
+            switch (opt_.format) {
+                case InputFormat::Text: {
+                    trim(begin, end);
+                    if (begin == end || *begin == '#') return;
+                    out.push_back(parse_field(begin, end));
+                    return;
+                }
+                case InputFormat::Log: {
+                    IPv4 ip = 0;
+                    if (find_dotted(begin, end, ip)) {
+                        out.push_back(ip);
+                    } else {
+                        ++skipped_;
+                    }
+                    return;
+                }
+                case InputFormat::Csv: {
+                    trim(begin, end);
+                    if (begin == end) return;
+                    const char* field = begin;
+                    for (std::size_t col = 0; col < opt_.csv_column; ++col) {
+                        const auto* d = static_cast<const char*>(
+                            std::memchr(field, opt_.csv_delimiter, static_cast<std::size_t>(end - field)));
+                        if (d == nullptr) {
+                            throw std::runtime_error("missing column " + std::to_string(opt_.csv_column));
+                        }
+                        field = d + 1;
+                    }
+                    const auto* d = static_cast<const char*>(
+                        std::memchr(field, opt_.csv_delimiter, static_cast<std::size_t>(end - field)));
+                    const char* field_end = d != nullptr ? d : end;
+                    trim(field, field_end);
+                    if (field_end - field >= 2 && *field == '"' && field_end[-1] == '"') {
+                        ++field;
+                        --field_end;
+                    }
+                    IPv4 ip = 0;
+                    if (parse_dotted(field, field_end, ip)) {
+                        out.push_back(ip);
+                    } else if (line_no_ == 1 && opt_.csv_header) {
+                        ++skipped_;   // intestazione
+                    } else {
+                        out.push_back(parse_ipv4(std::string(field, field_end)));
+                    }
+                    return;
+                }
+                case InputFormat::Binary:
+                    break;
+            }
+        } catch (const std::exception& e) {
+            std::ostringstream oss;
+            oss << "Error parsing IPv4 at line " << line_no_ << ": " << e.what();
+            TB_PROBE3(parse__error, line_no_, static_cast<unsigned>(opt_.format), e.what());
+            throw InputError(oss.str());
+        }
+    }
+
+    void Ipv4Parser::feed(const char* data, std::size_t n, std::vector<IPv4>& out) {
+        feed_into(data, n, out);
+    }
+
+    void Ipv4Parser::feed(const char* data, std::size_t n, std::pmr::vector<IPv4>& out) {
+        feed_into(data, n, out);
+    }
+
+    void Ipv4Parser::finish(std::vector<IPv4>& out) {
+        finish_into(out);
+    }
+
+    void Ipv4Parser::finish(std::pmr::vector<IPv4>& out) {
+        finish_into(out);
+    }
+
+    bool parse_ipv4_line(std::string& line, IPv4& out) {
+        // trim minimo
+        line.erase(line.begin(), std::find_if_not(line.begin(), line.end(), is_space));
+        line.erase(std::find_if_not(line.rbegin(), line.rend(), is_space).base(), line.end());
+
+        if (line.empty() || line[0] == '#') {
+            return false;
+        }
+        out = parse_ipv4(line);
+        return true;
+    }
+
+    std::vector<IPv4> read_ipv4_file(const std::string& path) {
+        return read_ipv4_file(path, IngestOptions{});
+    }
+
+    std::vector<IPv4> read_ipv4_file(const std::string& path, const IngestOptions& opt) {
+        InputReader reader{path};
+        Ipv4Parser parser{opt};
+
+        std::vector<IPv4> ips;
+        ips.reserve(1024);
+
+        counted_vector<char> buf(kReadBlock, CountingAllocator<char>{MemCategory::Buffers});
+        for (;;) {
+            const std::size_t n = reader.read(buf.data(), buf.size());
+            if (n == 0) break;
+            parser.feed(buf.data(), n, ips);
+        }
+        parser.finish(ips);
+        return ips;
+    }
+
+    std::pmr::vector<IPv4> read_ipv4_file(const std::string& path, const IngestOptions& opt,
+                                          std::pmr::memory_resource* mr, std::uint64_t expected) {
+        InputReader reader{path};
+        Ipv4Parser parser{opt};
+
+        std::pmr::vector<IPv4> ips(mr);
+        ips.reserve(static_cast<std::size_t>(std::max<std::uint64_t>(expected, 1024)));
+
+        counted_vector<char> buf(kReadBlock, CountingAllocator<char>{MemCategory::Buffers});
+        for (;;) {
+            const std::size_t n = reader.read(buf.data(), buf.size());
+            if (n == 0) break;
+            parser.feed(buf.data(), n, ips);
+        }
+        parser.finish(ips);
+        return ips;
+    }
+
+    std::optional<std::uint64_t> max_address_count(const std::string& path, const IngestOptions& opt) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open input file: " + path);
+        }
+        struct stat st{};
+        unsigned char magic[2] = {0, 0};
+        const bool ok = ::fstat(fd, &st) == 0;
+        const bool gz = ::pread(fd, magic, 2, 0) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+        ::close(fd);
+        if (!ok) {
+            throw std::runtime_error("Cannot stat input file: " + path);
+        }
+        if (gz) return std::nullopt;   // il rapporto di compressione non ha limite utile
+        const auto content = static_cast<std::uint64_t>(st.st_size);
+        if (opt.format == InputFormat::Binary) return content / 4;
+        return content / 8 + 1;   // l'ultima riga può non terminare con '\n'
+    }
+
+    Dataset ipv4_file_dataset(const std::string& path, const IngestOptions& opt, std::size_t chunk,
+                              std::uint64_t* file_bytes) {
+        // stato del decoder, condiviso dalle copie del lettore: il file resta aperto col dataset
+        struct State {
+            InputReader reader;
+            Ipv4Parser parser;
+            counted_vector<char> buf{kReadBlock, CountingAllocator<char>{MemCategory::Buffers}};
+            std::vector<IPv4> pending;   // indirizzi decodificati non ancora consegnati
+            std::size_t pos = 0;
+            std::uint64_t decoded = 0;     // indirizzi decodificati in tutto
+            std::uint64_t delivered = 0;   // indirizzi consegnati in tutto
+            bool eof = false;
+
+            State(const std::string& p, const IngestOptions& o) : reader{p}, parser{o} {}
+        };
+        auto state = std::make_shared<State>(path, opt);
+
+        return Dataset::stream([state, file_bytes](IPv4* ips, std::size_t*, std::size_t capacity) -> std::size_t {
+            State& s = *state;
+            // un blocco alla volta finché il chunk non è pieno: al più chunk + kReadBlock / 4 indirizzi
+            while (s.pending.size() - s.pos < capacity && !s.eof) {
+                s.pending.erase(s.pending.begin(), s.pending.begin() + static_cast<std::ptrdiff_t>(s.pos));
+                s.pos = 0;
+                const std::size_t before = s.pending.size();
+                const std::size_t n = s.reader.read(s.buf.data(), s.buf.size());
+                if (n == 0) {
+                    s.parser.finish(s.pending);
+                    s.eof = true;
+                } else {
+                    s.parser.feed(s.buf.data(), n, s.pending);
+                }
+                s.decoded += s.pending.size() - before;
+            }
+            const std::size_t n = std::min(capacity, s.pending.size() - s.pos);
+            std::copy_n(s.pending.data() + s.pos, n, ips);
+            s.pos += n;
+            s.delivered += n;
+            if (file_bytes != nullptr) {
+                // i byte delle righe consegnate, in proporzione: il blocco letto in anticipo non conta
+                const std::uint64_t read = s.reader.file_bytes();
+                *file_bytes = s.eof || s.decoded == 0
+                                  ? read
+                                  : static_cast<std::uint64_t>(static_cast<double>(read) *
+                                                               static_cast<double>(s.delivered) /
+                                                               static_cast<double>(s.decoded));
+            }
+            return n;
+        }, false, chunk);
+    }
+
+    std::uint64_t accumulate_ipv4_file(const std::string& path, const IngestOptions& opt,
+                                       const BucketEngine& engine, std::vector<std::size_t>& counts) {
+        if (counts.size() != engine.config().bucket_count()) {
+            throw std::invalid_argument("accumulate_ipv4_file: counts size does not match bucket count");
+        }
+        Dataset data = ipv4_file_dataset(path, opt);
+        return accumulate(engine, data, counts);
+    }
+
+    RangeCounts accumulate_ipv4_range(const std::string& path,
+                                      std::uint64_t begin, std::uint64_t end,
+                                      const BucketEngine& engine,
+                                      std::vector<std::size_t>& counts) {
+        if (counts.size() != engine.config().bucket_count()) {
+            throw std::invalid_argument("accumulate_ipv4_range: counts size does not match bucket count");
+        }
+        RangeCounts r;
+        if (end <= begin) return r;
+
+        std::ifstream in{path, std::ios::binary};
+        if (!in) {
+            throw std::runtime_error("Cannot open input file: " + path);
+        }
+
+        std::uint64_t pos = begin;
+        std::string line;
+        if (begin > 0) {
+            // la riga che contiene begin-1 appartiene al range precedente (a meno che finisca proprio lì)
+            in.seekg(static_cast<std::streamoff>(begin - 1));
+            char prev = 0;
+            if (!in.get(prev)) return r; // begin oltre EOF
+            if (prev != '\n') {
+                std::getline(in, line);
+                pos += line.size() + 1;
+            }
+        }
+
+        while (pos < end && std::getline(in, line)) {
+            const std::uint64_t line_start = pos;
+            pos += line.size() + 1;
+            r.bytes += line.size() + 1;
+            try {
+                IPv4 ip = 0;
+                if (parse_ipv4_line(line, ip)) {
+                    const auto b = engine.bucket_index(ip);
+                    if (b < counts.size()) {
+                        counts[b] += 1;
+                    }
+                    ++r.samples;
+                }
+            } catch (const std::exception& e) {
+                std::ostringstream oss;
+                oss << "Error parsing IPv4 at byte offset " << line_start << " of " << path << ": " << e.what();
+                TB_PROBE3(parse__error, line_start, static_cast<unsigned>(InputFormat::Text), e.what());
+                throw InputError(oss.str());
+            }
+        }
+        if (in.bad()) {
+            throw std::runtime_error("Read error on input file: " + path);
+        }
+        TB_PROBE3(histogram__flush, counts.data(), counts.size(), r.samples);
+        return r;
+    }
+
+}
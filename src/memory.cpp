@@ -0,0 +1,134 @@
+#include "tb/memory.hpp"
+#include "tb/ingest.hpp"
+
+#include <array>
+#include <atomic>
+
+namespace tb {
+
+    namespace {
+        struct Counters {
+            std::atomic<std::uint64_t> current{0};
+            std::atomic<std::uint64_t> peak{0};
+            std::atomic<std::uint64_t> allocations{0};
+        };
+
+        std::array<Counters, kMemCategoryCount> g_counters{};
+        Counters g_total{};
+
+        void raise_peak(std::atomic<std::uint64_t>& peak, std::uint64_t value) noexcept {
+            std::uint64_t seen = peak.load(std::memory_order_relaxed);
+            while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+            }
+        }
+
+        void add(Counters& c, std::size_t bytes) noexcept {
+            const std::uint64_t now = c.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            c.allocations.fetch_add(1, std::memory_order_relaxed);
+            raise_peak(c.peak, now);
+        }
+
+        class CountingResource final : public std::pmr::memory_resource {
+        public:
+            explicit CountingResource(MemCategory c) noexcept : category_{c} {}
+
+        private:
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+                void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+                detail::note_alloc(category_, bytes);
+                return p;
+            }
+            void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+                detail::note_free(category_, bytes);
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+            bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override {
+                return this == &o;
+            }
+
+            MemCategory category_;
+        };
+    }
+
+    const char* memory_category_name(MemCategory c) noexcept {
+        switch (c) {
+            case MemCategory::Histogram: return "histogram";
+            case MemCategory::Buffers: return "buffers";
+            case MemCategory::Arena: return "arena";
+            case MemCategory::Count: break;
+        }
+        return "?";
+    }
+
+    MemoryUsage memory_usage(MemCategory c) noexcept {
+        MemoryUsage u;
+        if (c == MemCategory::Count) return u;
+        const Counters& k = g_counters[static_cast<std::size_t>(c)];
+        u.current = k.current.load(std::memory_order_relaxed);
+        u.peak = k.peak.load(std::memory_order_relaxed);
+        u.allocations = k.allocations.load(std::memory_order_relaxed);
+        return u;
+    }
+
+    std::uint64_t memory_peak_total() noexcept {
+        return g_total.peak.load(std::memory_order_relaxed);
+    }
+
+    void reset_memory_peaks() noexcept {
+        for (Counters& c : g_counters) {
+            c.peak.store(c.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            c.allocations.store(0, std::memory_order_relaxed);
+        }
+        g_total.peak.store(g_total.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        g_total.allocations.store(0, std::memory_order_relaxed);
+    }
+
+    namespace detail {
+        void note_alloc(MemCategory c, std::size_t bytes) noexcept {
+            if (c == MemCategory::Count) return;
+            add(g_counters[static_cast<std::size_t>(c)], bytes);
+            add(g_total, bytes);
+        }
+
+        void note_free(MemCategory c, std::size_t bytes) noexcept {
+            if (c == MemCategory::Count) return;
+            g_counters[static_cast<std::size_t>(c)].current.fetch_sub(bytes, std::memory_order_relaxed);
+            g_total.current.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    std::pmr::memory_resource* counting_resource(MemCategory c) noexcept {
+        static CountingResource histogram{MemCategory::Histogram};
+        static CountingResource buffers{MemCategory::Buffers};
+        static CountingResource arena{MemCategory::Arena};
+        switch (c) {
+            case MemCategory::Histogram: return &histogram;
+            case MemCategory::Arena: return &arena;
+            default: return &buffers;
+        }
+    }
+
+    Footprint estimate_footprint(const Config& cfg, std::uint64_t addresses, unsigned threads, bool presized,
+                                 HistogramStrategy strategy) noexcept {
+        Footprint f;
+        f.addresses = addresses;
+        // crescita per raddoppio: alla riallocazione finale convivono il vecchio (c/2) e il nuovo
+        // buffer (c < 2n), quindi al più 3n elementi. Preallocato: n. In streaming: un blocco decodificato
+        const std::uint64_t copies = presized ? 1 : 3;
+        f.address_bytes = addresses > 0 ? copies * addresses * sizeof(IPv4) : kReadBlock;
+        const std::uint64_t histogram = static_cast<std::uint64_t>(cfg.bucket_count()) * sizeof(std::size_t);
+        f.histogram_bytes = histogram;
+        f.buffer_bytes = kReadBlock;
+        if (threads > 1 && strategy == HistogramStrategy::PerThread) {
+            f.histogram_bytes += histogram * threads;
+        } else if (threads > 1 && strategy == HistogramStrategy::SharedAtomic) {
+            f.histogram_bytes += histogram;   // contatori atomici condivisi
+        } else if (threads > 1 && strategy == HistogramStrategy::Partitioned) {
+            // buffer dimensionati esattamente da un passo di conteggio: un indice per indirizzo
+            const auto t = static_cast<std::uint64_t>(threads);
+            f.buffer_bytes += addresses * sizeof(BucketIndex) + t * t * sizeof(std::pmr::vector<BucketIndex>);
+        }
+        return f;
+    }
+
+}
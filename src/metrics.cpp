@@ -0,0 +1,124 @@
+#include "tb/metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+namespace tb {
+
+    BucketLoads top_buckets(const std::vector<std::size_t>& counts, std::size_t n) {
+        BucketLoads out;
+        n = std::min(n, counts.size());
+        if (n == 0) return out;
+
+        // min-heap dei migliori n: O(m log n), niente copia dell'istogramma completo
+        auto heavier = [](const std::pair<BucketIndex, std::size_t>& x,
+                          const std::pair<BucketIndex, std::size_t>& y) {
+            if (x.second != y.second) return x.second > y.second;
+            return x.first < y.first;
+        };
+        out.reserve(n);
+        for (std::size_t i = 0; i < counts.size(); ++i) {
+            const std::pair<BucketIndex, std::size_t> cand{static_cast<BucketIndex>(i), counts[i]};
+            if (out.size() < n) {
+                out.push_back(cand);
+                std::push_heap(out.begin(), out.end(), heavier);
+            } else if (heavier(cand, out.front())) {
+                std::pop_heap(out.begin(), out.end(), heavier);
+                out.back() = cand;
+                std::push_heap(out.begin(), out.end(), heavier);
+            }
+        }
+        std::sort_heap(out.begin(), out.end(), heavier);
+        return out;
+    }
+
+    namespace {
+        void family(std::ostringstream& os, const char* name, const char* type, const char* help,
+                    bool openmetrics) {
+            // in OpenMetrics il nome della famiglia counter non ha il suffisso _total
+            std::string fam = name;
+            const std::string suffix = "_total";
+            if (openmetrics && std::string(type) == "counter" && fam.size() > suffix.size() &&
+                fam.compare(fam.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                fam.resize(fam.size() - suffix.size());
+            }
+            os << "# HELP " << fam << ' ' << help << '\n'
+               << "# TYPE " << fam << ' ' << type << '\n';
+        }
+
+        std::string hex32(std::uint32_t v) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "0x%08X", v);
+            return buf;
+        }
+    }
+
+    std::string render_metrics(const MetricsSnapshot& s, bool openmetrics) {
+        std::ostringstream os;
+        os.precision(10);
+
+        family(os, "tb_config_info", "gauge", "Bucketizer parameters.", openmetrics);
+        os << "tb_config_info{a=\"" << hex32(s.cfg.a) << "\",b=\"" << hex32(s.cfg.b)
+           << "\",k=\"" << s.cfg.k << "\"} 1\n";
+
+        family(os, "tb_buckets", "gauge", "Number of buckets (2^k).", openmetrics);
+        os << "tb_buckets " << s.stats.bucket_count << '\n';
+
+        family(os, "tb_window_load", "gauge", "Total load of the last window.", openmetrics);
+        os << "tb_window_load " << s.stats.sample_count << '\n';
+        family(os, "tb_window_seconds", "gauge", "Length of the last window.", openmetrics);
+        os << "tb_window_seconds " << s.window_seconds << '\n';
+
+        family(os, "tb_stats_mean", "gauge", "Mean bucket load.", openmetrics);
+        os << "tb_stats_mean " << s.stats.mean << '\n';
+        family(os, "tb_stats_stddev", "gauge", "Standard deviation of bucket load.", openmetrics);
+        os << "tb_stats_stddev " << s.stats.stddev << '\n';
+        family(os, "tb_stats_chi2", "gauge", "Pearson chi-square against a uniform distribution.", openmetrics);
+        os << "tb_stats_chi2 " << s.stats.chi2 << '\n';
+        family(os, "tb_stats_uniformity_percent", "gauge", "Uniformity (100 = perfectly flat).", openmetrics);
+        os << "tb_stats_uniformity_percent " << s.stats.uniformity << '\n';
+        family(os, "tb_stats_max_load", "gauge", "Largest bucket load.", openmetrics);
+        os << "tb_stats_max_load " << s.stats.max_load << '\n';
+
+        family(os, "tb_bucket_load", "gauge", "Load of the heaviest buckets (top-N only).", openmetrics);
+        for (const auto& [bucket, load] : s.top_buckets) {
+            os << "tb_bucket_load{bucket=\"" << bucket << "\"} " << load << '\n';
+        }
+
+        family(os, "tb_windows_total", "counter", "Windows published.", openmetrics);
+        os << "tb_windows_total " << s.windows_total << '\n';
+        family(os, "tb_ingest_records_total", "counter", "Flow records ingested.", openmetrics);
+        os << "tb_ingest_records_total " << s.records_total << '\n';
+        family(os, "tb_ingest_datagrams_total", "counter", "Datagrams received.", openmetrics);
+        os << "tb_ingest_datagrams_total " << s.datagrams_total << '\n';
+        family(os, "tb_ingest_bytes_total", "counter", "Datagram payload bytes received.", openmetrics);
+        os << "tb_ingest_bytes_total " << s.payload_bytes_total << '\n';
+        family(os, "tb_ingest_decode_errors_total", "counter", "Datagrams that failed to decode.", openmetrics);
+        os << "tb_ingest_decode_errors_total " << s.decode_errors_total << '\n';
+        family(os, "tb_ingest_records_per_second", "gauge", "Ingest rate over the last window.", openmetrics);
+        os << "tb_ingest_records_per_second " << s.records_per_second << '\n';
+
+        if (openmetrics) {
+            os << "# EOF\n";
+        }
+        return os.str();
+    }
+
+    // ---------- SnapshotExchange ----------
+
+    void SnapshotExchange::publish(MetricsSnapshot s) {
+        slots_[back_] = std::move(s);
+        // il back buffer diventa "middle" (marcato fresh); riprendiamo il vecchio middle come back
+        back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & 0x3u;
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+
+    const MetricsSnapshot& SnapshotExchange::latest() {
+        if (middle_.load(std::memory_order_relaxed) & kFresh) {
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & 0x3u;
+        }
+        return slots_[front_];
+    }
+
+}
@@ -0,0 +1,164 @@
+#include "tb/metrics_server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace tb {
+
+    namespace {
+        constexpr std::size_t kMaxRequest = 8192;
+        constexpr int kClientTimeoutMs = 2000;
+
+        void send_all(int fd, const std::string& data) {
+            std::size_t off = 0;
+            while (off < data.size()) {
+                const auto n = ::send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return; // client sparito: niente da fare
+                }
+                off += static_cast<std::size_t>(n);
+            }
+        }
+
+        void respond(int fd, const char* status, const char* content_type, const std::string& body) {
+            std::string resp = std::string("HTTP/1.1 ") + status + "\r\n"
+                + "Content-Type: " + content_type + "\r\n"
+                + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                + "Connection: close\r\n\r\n";
+            resp += body;
+            send_all(fd, resp);
+        }
+
+        bool icontains(const std::string& haystack, const char* needle) {
+            std::string h = haystack;
+            std::string n = needle;
+            for (auto& c : h) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            for (auto& c : n) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            return h.find(n) != std::string::npos;
+        }
+    }
+
+    MetricsServer::MetricsServer(SnapshotExchange& exchange, const MetricsServerOptions& opt)
+    : exchange_{exchange} {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            throw std::runtime_error(std::string("Cannot create metrics socket: ") + std::strerror(errno));
+        }
+        const int one = 1;
+        ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(opt.port);
+        if (::inet_pton(AF_INET, opt.bind_address.c_str(), &addr.sin_addr) != 1) {
+            ::close(fd_);
+            throw std::runtime_error("Invalid metrics bind address: '" + opt.bind_address + "'");
+        }
+        if (::bind(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd_, 16) != 0) {
+            const std::string err = std::strerror(errno);
+            ::close(fd_);
+            throw std::runtime_error("Cannot listen on " + opt.bind_address + ":" + std::to_string(opt.port) + ": " + err);
+        }
+
+        sockaddr_in bound{};
+        socklen_t bound_len = sizeof(bound);
+        ::getsockname(fd_, reinterpret_cast<sockaddr*>(&bound), &bound_len);
+        port_ = ntohs(bound.sin_port);
+
+        thread_ = std::thread([this] { serve(); });
+    }
+
+    MetricsServer::~MetricsServer() {
+        stop();
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    void MetricsServer::stop() noexcept {
+        stop_.store(true, std::memory_order_relaxed);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void MetricsServer::serve() {
+        while (!stop_.load(std::memory_order_relaxed)) {
+            pollfd pfd{fd_, POLLIN, 0};
+            const int ready = ::poll(&pfd, 1, 100);
+            if (ready <= 0) continue;
+
+            const int client = ::accept(fd_, nullptr, nullptr);
+            if (client < 0) continue;
+            try {
+                handle(client);
+            } catch (const std::exception&) {
+                // errore su un singolo scrape (es. bad_alloc): il server resta su
+            }
+            ::close(client);
+        }
+    }
+
+    void MetricsServer::handle(int client) {
+        // legge fino a fine header (le GET non hanno body)
+        std::string req;
+        char buf[1024];
+        while (req.find("\r\n\r\n") == std::string::npos && req.size() < kMaxRequest) {
+            pollfd pfd{client, POLLIN, 0};
+            if (::poll(&pfd, 1, kClientTimeoutMs) <= 0) return;
+            const auto n = ::recv(client, buf, sizeof(buf), 0);
+            if (n <= 0) return;
+            req.append(buf, static_cast<std::size_t>(n));
+        }
+
+        const auto line_end = req.find("\r\n");
+        if (line_end == std::string::npos) {
+            respond(client, "400 Bad Request", "text/plain", "bad request\n");
+            return;
+        }
+        const std::string request_line = req.substr(0, line_end);
+        const auto sp1 = request_line.find(' ');
+        const auto sp2 = request_line.find(' ', sp1 == std::string::npos ? sp1 : sp1 + 1);
+        if (sp1 == std::string::npos || sp2 == std::string::npos) {
+            respond(client, "400 Bad Request", "text/plain", "bad request\n");
+            return;
+        }
+        const std::string method = request_line.substr(0, sp1);
+        std::string path = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+        path = path.substr(0, path.find('?'));
+
+        if (method != "GET") {
+            respond(client, "405 Method Not Allowed", "text/plain", "only GET is supported\n");
+            return;
+        }
+        if (path == "/") {
+            respond(client, "200 OK", "text/html",
+                    "<html><body><a href=\"/metrics\">/metrics</a></body></html>\n");
+            return;
+        }
+        if (path != "/metrics") {
+            respond(client, "404 Not Found", "text/plain", "not found\n");
+            return;
+        }
+
+        // negoziazione: OpenMetrics solo se lo scraper lo chiede esplicitamente
+        const bool openmetrics = icontains(req.substr(line_end), "application/openmetrics-text");
+        const std::string body = render_metrics(exchange_.latest(), openmetrics);
+        scrapes_.fetch_add(1, std::memory_order_relaxed);
+        respond(client, "200 OK",
+                openmetrics ? "application/openmetrics-text; version=1.0.0; charset=utf-8"
+                            : "text/plain; version=0.0.4; charset=utf-8",
+                body);
+    }
+
+}
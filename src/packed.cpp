@@ -0,0 +1,98 @@
+#include "tb/packed.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace tb {
+
+    namespace {
+        constexpr std::size_t kBlock = 64;   // indici per blocco: un blocco occupa esattamente `bits` parole
+
+        // kernel a shift costanti: dopo lo srotolamento restano solo shift/or su registri,
+        // che il compilatore può vettorizzare senza intrinseci
+        template <unsigned B>
+        void pack_block(const BucketIndex* in, std::uint64_t* out) noexcept {
+            constexpr std::uint64_t mask = (std::uint64_t{1} << B) - 1;
+            std::uint64_t words[B] = {};
+#pragma GCC unroll 64
+            for (unsigned i = 0; i < kBlock; ++i) {
+                const unsigned bit = i * B;
+                const std::uint64_t v = in[i] & mask;
+                words[bit / 64] |= v << (bit % 64);
+                if (bit % 64 + B > 64) words[bit / 64 + 1] |= v >> (64 - bit % 64);
+            }
+            for (unsigned w = 0; w < B; ++w) out[w] = words[w];
+        }
+
+        template <unsigned B>
+        void unpack_block(const std::uint64_t* in, BucketIndex* out) noexcept {
+            constexpr std::uint64_t mask = (std::uint64_t{1} << B) - 1;
+#pragma GCC unroll 64
+            for (unsigned i = 0; i < kBlock; ++i) {
+                const unsigned bit = i * B;
+                std::uint64_t v = in[bit / 64] >> (bit % 64);
+                if (bit % 64 + B > 64) v |= in[bit / 64 + 1] << (64 - bit % 64);
+                out[i] = static_cast<BucketIndex>(v & mask);
+            }
+        }
+
+        using PackFn = void (*)(const BucketIndex*, std::uint64_t*) noexcept;
+        using UnpackFn = void (*)(const std::uint64_t*, BucketIndex*) noexcept;
+
+        // tabelle indicizzate da bits - 1 (1..32)
+        template <std::size_t... I>
+        constexpr std::array<PackFn, sizeof...(I)> pack_table(std::index_sequence<I...>) {
+            return {&pack_block<static_cast<unsigned>(I + 1)>...};
+        }
+        template <std::size_t... I>
+        constexpr std::array<UnpackFn, sizeof...(I)> unpack_table(std::index_sequence<I...>) {
+            return {&unpack_block<static_cast<unsigned>(I + 1)>...};
+        }
+
+        constexpr auto kPack = pack_table(std::make_index_sequence<32>{});
+        constexpr auto kUnpack = unpack_table(std::make_index_sequence<32>{});
+
+        void check_range(std::size_t offset, std::size_t n, std::size_t size, const char* what) {
+            if (offset > size || n > size - offset) {
+                throw std::out_of_range(std::string(what) + ": range [" + std::to_string(offset) + ", +" +
+                                        std::to_string(n) + ") exceeds size " + std::to_string(size));
+            }
+        }
+    }
+
+    PackedBuckets::PackedBuckets(unsigned bits, std::size_t n) : bits_{bits}, size_{n} {
+        if (bits > 32) throw std::invalid_argument("PackedBuckets: bits must be <= 32");
+        words_.assign((n + kBlock - 1) / kBlock * bits, 0);
+    }
+
+    void PackedBuckets::pack(std::size_t offset, const BucketIndex* in, std::size_t n) {
+        check_range(offset, n, size_, "PackedBuckets::pack");
+        if (bits_ == 0) return;
+        std::size_t i = 0;
+        // testa fino al confine di blocco, blocchi interi, coda
+        for (; i < n && (offset + i) % kBlock != 0; ++i) set(offset + i, in[i]);
+        const PackFn kernel = kPack[bits_ - 1];
+        for (; n - i >= kBlock; i += kBlock) {
+            kernel(in + i, words_.data() + (offset + i) / kBlock * bits_);
+        }
+        for (; i < n; ++i) set(offset + i, in[i]);
+    }
+
+    void PackedBuckets::unpack(std::size_t offset, std::size_t n, BucketIndex* out) const {
+        check_range(offset, n, size_, "PackedBuckets::unpack");
+        if (bits_ == 0) {
+            for (std::size_t i = 0; i < n; ++i) out[i] = 0;
+            return;
+        }
+        std::size_t i = 0;
+        for (; i < n && (offset + i) % kBlock != 0; ++i) out[i] = (*this)[offset + i];
+        const UnpackFn kernel = kUnpack[bits_ - 1];
+        for (; n - i >= kBlock; i += kBlock) {
+            kernel(words_.data() + (offset + i) / kBlock * bits_, out + i);
+        }
+        for (; i < n; ++i) out[i] = (*this)[offset + i];
+    }
+
+}
@@ -0,0 +1,189 @@
+#include "tb/parallel.hpp"
+#include "tb/memory.hpp"
+#include "tb/probes.hpp"
+#include "tb/profile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace tb {
+
+    namespace {
+        // esegue fn(t) per t in [0, threads): il thread chiamante fa la sua parte.
+        // Ogni parte è una chiamata dello stadio histogram: il profilo somma i tempi dei thread
+        template <class Fn>
+        void run_threads(unsigned threads, Fn&& user_fn) {
+            auto fn = [&](unsigned t) {
+                ScopedStage stage{Stage::Histogram};
+                user_fn(t, stage);
+            };
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> pool;
+            pool.reserve(threads - 1);
+            for (unsigned t = 1; t < threads; ++t) {
+                pool.emplace_back([&, t] {
+                    try {
+                        fn(t);
+                    } catch (...) {
+                        errors[t] = std::current_exception();
+                    }
+                });
+            }
+            try {
+                fn(0u);
+            } catch (...) {
+                errors[0] = std::current_exception();
+            }
+            for (auto& th : pool) th.join();
+            for (const auto& e : errors) {
+                if (e) std::rethrow_exception(e);
+            }
+        }
+
+        // [lo, hi) della parte t di n elementi divisi in parti quasi uguali
+        std::size_t part_begin(std::size_t n, unsigned parts, unsigned t) noexcept {
+            return (n / parts) * t + (n % parts) * t / parts;   // = floor(n * t / parts), senza overflow
+        }
+    }
+
+    const char* histogram_strategy_name(HistogramStrategy s) noexcept {
+        switch (s) {
+            case HistogramStrategy::SharedAtomic: return "shared-atomic";
+            case HistogramStrategy::PerThread: return "per-thread";
+            case HistogramStrategy::Partitioned: return "partitioned";
+        }
+        return "?";
+    }
+
+    HistogramStrategy parse_histogram_strategy(const std::string& name) {
+        for (const auto s : {HistogramStrategy::SharedAtomic, HistogramStrategy::PerThread, HistogramStrategy::Partitioned}) {
+            if (name == histogram_strategy_name(s)) return s;
+        }
+        throw std::runtime_error("Unknown histogram strategy: '" + name +
+                                 "' (expected shared-atomic, per-thread or partitioned)");
+    }
+
+    std::vector<std::size_t> parallel_distribution(const BucketEngine& engine,
+                                                   const std::vector<IPv4>& ips,
+                                                   unsigned threads,
+                                                   HistogramStrategy strategy) {
+        std::vector<std::size_t> counts(engine.config().bucket_count(), 0);
+        parallel_accumulate(engine, ips.data(), ips.size(), counts.data(), counts.size(), threads, strategy);
+        return counts;
+    }
+
+    std::pmr::vector<std::size_t> parallel_distribution(const BucketEngine& engine, const IPv4* ips,
+                                                        std::size_t n, unsigned threads,
+                                                        HistogramStrategy strategy,
+                                                        std::pmr::memory_resource* mr) {
+        std::pmr::vector<std::size_t> counts(engine.config().bucket_count(), 0, mr);
+        parallel_accumulate(engine, ips, n, counts.data(), counts.size(), threads, strategy, mr);
+        return counts;
+    }
+
+    void parallel_accumulate(const BucketEngine& engine, const IPv4* ips, std::size_t n,
+                             std::size_t* counts, std::size_t counts_size,
+                             unsigned threads, HistogramStrategy strategy,
+                             std::pmr::memory_resource* scratch) {
+        const std::size_t m = engine.config().bucket_count();
+        if (counts_size != m) {
+            throw std::invalid_argument("parallel_accumulate: counts size does not match bucket count");
+        }
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, n)));
+        if (threads == 1) {
+            engine.accumulate(ips, n, counts, counts_size);
+            return;
+        }
+        std::pmr::memory_resource* histograms = scratch != nullptr ? scratch : counting_resource(MemCategory::Histogram);
+        std::pmr::memory_resource* buffers = scratch != nullptr ? scratch : counting_resource(MemCategory::Buffers);
+
+        TB_PROBE2(bucketize__start, n, engine.config().k);
+        switch (strategy) {
+            case HistogramStrategy::SharedAtomic: {
+                // contesa sulle righe di cache dei bucket caldi: peggiora con k piccolo
+                const auto shared = std::make_unique<std::atomic<std::size_t>[]>(m);
+                run_threads(threads, [&](unsigned t, ScopedStage&) {
+                    for (std::size_t i = part_begin(m, threads, t); i < part_begin(m, threads, t + 1); ++i) {
+                        shared[i].store(0, std::memory_order_relaxed);
+                    }
+                });
+                run_threads(threads, [&](unsigned t, ScopedStage& stage) {
+                    const std::size_t end = part_begin(n, threads, t + 1);
+                    stage.add(end - part_begin(n, threads, t), (end - part_begin(n, threads, t)) * sizeof(IPv4));
+                    for (std::size_t i = part_begin(n, threads, t); i < end; ++i) {
+                        shared[engine.bucket_index(ips[i])].fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+                for (std::size_t b = 0; b < m; ++b) counts[b] += shared[b].load(std::memory_order_relaxed);
+                break;
+            }
+            case HistogramStrategy::PerThread: {
+                // nessuna condivisione in scrittura; la riduzione costa threads * 2^k letture
+                std::vector<std::pmr::vector<std::size_t>> local;
+                local.reserve(threads);
+                for (unsigned t = 0; t < threads; ++t) local.emplace_back(histograms);
+                run_threads(threads, [&](unsigned t, ScopedStage& stage) {
+                    auto& c = local[t];
+                    c.assign(m, 0);
+                    const std::size_t end = part_begin(n, threads, t + 1);
+                    stage.add(end - part_begin(n, threads, t), (end - part_begin(n, threads, t)) * sizeof(IPv4));
+                    for (std::size_t i = part_begin(n, threads, t); i < end; ++i) {
+                        c[engine.bucket_index(ips[i])] += 1;
+                    }
+                });
+                run_threads(threads, [&](unsigned t, ScopedStage&) {
+                    const std::size_t end = part_begin(m, threads, t + 1);
+                    for (const auto& c : local) {
+                        for (std::size_t b = part_begin(m, threads, t); b < end; ++b) counts[b] += c[b];
+                    }
+                });
+                break;
+            }
+            case HistogramStrategy::Partitioned: {
+                // passo 1: indici smistati per proprietario (bucket contigui per thread);
+                // passo 2: ogni thread conta solo i suoi bucket, scrivendo direttamente nel risultato
+                const unsigned k = engine.config().k;
+                auto owner = [&](BucketIndex b) -> unsigned {
+                    return k >= 32 ? static_cast<unsigned>((static_cast<std::uint64_t>(b) * threads) >> 32)
+                                   : static_cast<unsigned>((static_cast<std::uint64_t>(b) * threads) >> k);
+                };
+                using Bucket = std::pmr::vector<BucketIndex>;
+                std::vector<std::vector<Bucket>> parts(threads);
+                run_threads(threads, [&](unsigned t, ScopedStage& stage) {
+                    const std::size_t begin = part_begin(n, threads, t);
+                    const std::size_t end = part_begin(n, threads, t + 1);
+                    stage.add(end - begin, (end - begin) * sizeof(IPv4));
+                    // passo di conteggio: buffer della misura esatta anche con distribuzioni sbilanciate,
+                    // niente crescita per raddoppio (in un'arena monotona le copie vecchie restano).
+                    // Ricalcolare l'indice costa meno della memoria risparmiata
+                    std::vector<std::size_t> sizes(threads, 0);
+                    for (std::size_t i = begin; i < end; ++i) ++sizes[owner(engine.bucket_index(ips[i]))];
+                    auto& out = parts[t];
+                    out.reserve(threads);
+                    for (unsigned o = 0; o < threads; ++o) {
+                        out.emplace_back(buffers);
+                        out.back().reserve(sizes[o]);
+                    }
+                    for (std::size_t i = begin; i < end; ++i) {
+                        const BucketIndex b = engine.bucket_index(ips[i]);
+                        out[owner(b)].push_back(b);
+                    }
+                });
+                run_threads(threads, [&](unsigned t, ScopedStage&) {
+                    for (const auto& from : parts) {
+                        for (const BucketIndex b : from[t]) counts[b] += 1;
+                    }
+                });
+                break;
+            }
+        }
+        TB_PROBE2(bucketize__end, n, engine.config().k);
+        TB_PROBE3(histogram__flush, counts, m, n);
+    }
+
+}
@@ -0,0 +1,156 @@
+#include "tb/pcap.hpp"
+
+#include <stdexcept>
+
+namespace tb {
+
+    namespace {
+        constexpr std::uint32_t kMagicMicros = 0xA1B2C3D4u;
+        constexpr std::uint32_t kMagicNanos  = 0xA1B23C4Du;
+
+        constexpr std::uint32_t kLinkNull     = 0;
+        constexpr std::uint32_t kLinkEthernet = 1;
+        constexpr std::uint32_t kLinkRawOld   = 12;
+        constexpr std::uint32_t kLinkRaw      = 101;
+        constexpr std::uint32_t kLinkLinuxSll = 113;
+
+        constexpr std::size_t kGlobalHeaderLen = 24;
+        constexpr std::size_t kRecordHeaderLen = 16;
+
+        // limite difensivo: un record più grande è quasi certamente un file corrotto
+        constexpr std::uint32_t kMaxRecordLen = 256u * 1024u;
+
+        inline std::uint32_t bswap32(std::uint32_t v) noexcept {
+            return (v >> 24) | ((v >> 8) & 0xFF00u) | ((v << 8) & 0xFF0000u) | (v << 24);
+        }
+
+        inline std::uint16_t be16(const std::uint8_t* p) noexcept {
+            return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+        }
+
+        inline std::uint32_t be32(const std::uint8_t* p) noexcept {
+            return (static_cast<std::uint32_t>(p[0]) << 24) |
+                (static_cast<std::uint32_t>(p[1]) << 16) |
+                (static_cast<std::uint32_t>(p[2]) << 8)  |
+                (static_cast<std::uint32_t>(p[3]));
+        }
+
+        inline std::uint32_t le32(const std::uint8_t* p) noexcept {
+            return (static_cast<std::uint32_t>(p[3]) << 24) |
+                (static_cast<std::uint32_t>(p[2]) << 16) |
+                (static_cast<std::uint32_t>(p[1]) << 8)  |
+                (static_cast<std::uint32_t>(p[0]));
+        }
+    }
+
+    PcapReader::PcapReader(const std::string& path)
+    : in_{path, std::ios::binary}, path_{path} {
+        if (!in_) {
+            throw std::runtime_error("Cannot open capture file: " + path);
+        }
+        std::uint8_t hdr[kGlobalHeaderLen];
+        if (!in_.read(reinterpret_cast<char*>(hdr), sizeof(hdr))) {
+            throw std::runtime_error("Truncated pcap global header: " + path);
+        }
+
+        const std::uint32_t magic = le32(hdr);
+        if (magic == kMagicMicros || magic == kMagicNanos) {
+            swapped_ = false;
+        } else if (bswap32(magic) == kMagicMicros || bswap32(magic) == kMagicNanos) {
+            swapped_ = true;
+        } else {
+            throw std::runtime_error("Not a pcap file (bad magic): " + path);
+        }
+        nanos_ = (swapped_ ? bswap32(magic) : magic) == kMagicNanos;
+        link_type_ = host32(hdr + 20) & 0x0FFFFFFFu; // i 4 bit alti sono FCS/flags
+
+        if (link_type_ != kLinkNull && link_type_ != kLinkEthernet && link_type_ != kLinkRawOld &&
+            link_type_ != kLinkRaw && link_type_ != kLinkLinuxSll) {
+            throw std::runtime_error("Unsupported pcap link type " + std::to_string(link_type_) + ": " + path);
+        }
+    }
+
+    std::uint32_t PcapReader::host32(const std::uint8_t* p) const noexcept {
+        const std::uint32_t v = le32(p);
+        return swapped_ ? bswap32(v) : v;
+    }
+
+    bool PcapReader::next(UdpDatagram& out) {
+        for (;;) {
+            std::uint8_t rh[kRecordHeaderLen];
+            if (!in_.read(reinterpret_cast<char*>(rh), sizeof(rh))) {
+                if (in_.gcount() == 0) return false;
+                throw std::runtime_error("Truncated pcap record header: " + path_);
+            }
+            const std::uint32_t incl_len = host32(rh + 8);
+            if (incl_len > kMaxRecordLen) {
+                throw std::runtime_error("Corrupt pcap record length " + std::to_string(incl_len) + ": " + path_);
+            }
+            record_.resize(incl_len);
+            if (incl_len > 0 && !in_.read(reinterpret_cast<char*>(record_.data()), incl_len)) {
+                throw std::runtime_error("Truncated pcap record: " + path_);
+            }
+
+            out.ts_sec = host32(rh);
+            out.ts_usec = nanos_ ? host32(rh + 4) / 1000u : host32(rh + 4);
+            if (extract(record_.data(), record_.size(), out)) {
+                return true;
+            }
+            ++skipped_;
+        }
+    }
+
+    bool PcapReader::extract(const std::uint8_t* p, std::size_t len, UdpDatagram& out) const {
+        // livello 2 -> offset dell'header IPv4
+        std::size_t off = 0;
+        switch (link_type_) {
+            case kLinkEthernet: {
+                if (len < 14) return false;
+                std::uint16_t ethertype = be16(p + 12);
+                off = 14;
+                while (ethertype == 0x8100u || ethertype == 0x88A8u) { // VLAN / QinQ
+                    if (len < off + 4) return false;
+                    ethertype = be16(p + off + 2);
+                    off += 4;
+                }
+                if (ethertype != 0x0800u) return false;
+                break;
+            }
+            case kLinkLinuxSll:
+                if (len < 16 || be16(p + 14) != 0x0800u) return false;
+                off = 16;
+                break;
+            case kLinkNull:
+                // famiglia AF_INET (2) nel byte order di chi ha catturato
+                if (len < 4 || (le32(p) != 2u && be32(p) != 2u)) return false;
+                off = 4;
+                break;
+            default: // raw IP
+                off = 0;
+                break;
+        }
+
+        if (len < off + 20) return false;
+        const std::uint8_t* ip = p + off;
+        if ((ip[0] >> 4) != 4) return false;
+        const std::size_t ihl = static_cast<std::size_t>(ip[0] & 0x0F) * 4;
+        if (ihl < 20 || len < off + ihl + 8) return false;
+        if (ip[9] != 17) return false;                       // solo UDP
+        if ((be16(ip + 6) & 0x3FFFu) != 0) return false;     // frammenti (MF o offset != 0)
+
+        const std::size_t ip_total = be16(ip + 2);
+        const std::uint8_t* udp = ip + ihl;
+        const std::size_t udp_len = be16(udp + 4);
+        if (udp_len < 8 || ihl + udp_len > ip_total) return false;
+        const std::size_t payload_len = udp_len - 8;
+        if (len < off + ihl + 8 + payload_len) return false; // snaplen troppo corto
+
+        out.src = be32(ip + 12);
+        out.dst = be32(ip + 16);
+        out.src_port = be16(udp);
+        out.dst_port = be16(udp + 2);
+        out.payload.assign(udp + 8, udp + 8 + payload_len);
+        return true;
+    }
+
+}
@@ -0,0 +1,149 @@
+#include "tb/perf_counters.hpp"
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace tb {
+
+    namespace {
+        struct EventSpec {
+            PerfEvent event;
+            std::uint32_t type;
+            std::uint64_t config;
+            std::size_t group;
+        };
+
+        constexpr std::uint64_t cache_event(std::uint64_t cache, std::uint64_t op, std::uint64_t result) {
+            return cache | (op << 8) | (result << 16);
+        }
+
+        // ordine = ordine di apertura: il primo evento aperto di ogni gruppo ne diventa il leader
+        constexpr EventSpec kSpecs[kPerfEventCount] = {
+            {PerfEvent::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 0},
+            {PerfEvent::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 0},
+            {PerfEvent::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 0},
+            {PerfEvent::L1DMisses, PERF_TYPE_HW_CACHE,
+             cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 1},
+            {PerfEvent::LLCMisses, PERF_TYPE_HW_CACHE,
+             cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 1},
+            {PerfEvent::DTLBMisses, PERF_TYPE_HW_CACHE,
+             cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 1},
+            {PerfEvent::PageFaults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, 2},
+        };
+
+        int open_event(const EventSpec& spec, int group_fd) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = spec.type;
+            attr.config = spec.config;
+            attr.disabled = (group_fd == -1) ? 1 : 0;   // i membri seguono il leader
+            attr.exclude_kernel = 1;                    // consentito con perf_event_paranoid <= 2
+            attr.exclude_hv = 1;
+            // anche i thread creati dopo l'apertura (parallel_accumulate, tb_bench): la lettura
+            // somma i figli. inherit esclude PERF_FORMAT_GROUP, quindi un read per evento
+            attr.inherit = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+        }
+
+        std::string paranoid_level() {
+            char buf[16] = {};
+            const int fd = ::open("/proc/sys/kernel/perf_event_paranoid", O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return "?";
+            const auto n = ::read(fd, buf, sizeof(buf) - 1);
+            ::close(fd);
+            std::string s = n > 0 ? std::string(buf, static_cast<std::size_t>(n)) : "?";
+            while (!s.empty() && (s.back() == '\n' || s.back() == ' ')) s.pop_back();
+            return s;
+        }
+    }
+
+    const char* perf_event_name(PerfEvent e) noexcept {
+        switch (e) {
+            case PerfEvent::Cycles: return "cycles";
+            case PerfEvent::Instructions: return "instructions";
+            case PerfEvent::BranchMisses: return "branch_misses";
+            case PerfEvent::L1DMisses: return "l1d_misses";
+            case PerfEvent::LLCMisses: return "llc_misses";
+            case PerfEvent::DTLBMisses: return "dtlb_misses";
+            case PerfEvent::PageFaults: return "page_faults";
+            case PerfEvent::Count: break;
+        }
+        return "?";
+    }
+
+    PerfCounters::PerfCounters() {
+        fds_.fill(-1);
+        leaders_.fill(-1);
+        for (const EventSpec& spec : kSpecs) {
+            const int fd = open_event(spec, leaders_[spec.group]);
+            if (fd < 0) {
+                if (status_.empty()) {
+                    status_ = std::string(perf_event_name(spec.event)) + ": perf_event_open: " + std::strerror(errno) +
+                              " (perf_event_paranoid=" + paranoid_level() + ")";
+                }
+                continue;
+            }
+            fds_[static_cast<std::size_t>(spec.event)] = fd;
+            if (leaders_[spec.group] == -1) leaders_[spec.group] = fd;
+        }
+    }
+
+    PerfCounters::~PerfCounters() {
+        for (const int fd : fds_) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+
+    bool PerfCounters::available() const noexcept {
+        for (const int fd : fds_) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    bool PerfCounters::hardware_available() const noexcept {
+        for (const EventSpec& spec : kSpecs) {
+            if (spec.type != PERF_TYPE_SOFTWARE && supported(spec.event)) return true;
+        }
+        return false;
+    }
+
+    bool PerfCounters::supported(PerfEvent e) const noexcept {
+        return e != PerfEvent::Count && fds_[static_cast<std::size_t>(e)] >= 0;
+    }
+
+    void PerfCounters::start() noexcept {
+        for (const int leader : leaders_) {
+            if (leader < 0) continue;
+            ::ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    PerfReading PerfCounters::stop() noexcept {
+        for (const int leader : leaders_) {
+            if (leader >= 0) ::ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        PerfReading r;
+        // layout TOTAL_TIME_*: value, enabled, running (somme su thread e figli)
+        std::uint64_t buf[3];
+        for (std::size_t e = 0; e < kPerfEventCount; ++e) {
+            if (fds_[e] < 0) continue;
+            if (::read(fds_[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) continue;
+            if (buf[2] == 0) continue;   // mai schedulato
+            const double scale = static_cast<double>(buf[1]) / static_cast<double>(buf[2]);
+            r.values[e] = static_cast<std::uint64_t>(static_cast<double>(buf[0]) * scale);
+            r.valid[e] = true;
+        }
+        return r;
+    }
+
+}
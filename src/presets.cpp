@@ -0,0 +1,31 @@
+#include "tb/presets.hpp"
+
+#include <stdexcept>
+
+namespace tb {
+
+    const std::vector<Preset>& presets() {
+        static const std::vector<Preset> kPresets = {
+            {"default", 0x9E3779B1u, 0x85EBCA77u, "golden-ratio multiplier (Knuth), murmur3 constant offset"},
+            {"wang", 0x27D4EB2Du, 0x165667B1u, "constants from Thomas Wang's integer hash"},
+        };
+        return kPresets;
+    }
+
+    const Preset* find_preset(const std::string& name) noexcept {
+        for (const Preset& p : presets()) {
+            if (p.name == name) return &p;
+        }
+        return nullptr;
+    }
+
+    void apply_preset(Config& cfg, const std::string& name) {
+        const Preset* p = find_preset(name);
+        if (p == nullptr) {
+            throw std::runtime_error("Unknown preset: '" + name + "'");
+        }
+        cfg.a = p->a;
+        cfg.b = p->b;
+    }
+
+}
@@ -0,0 +1,34 @@
+#include "tb/process_memory.hpp"
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+namespace tb {
+
+    ProcessMemory process_memory() noexcept {
+        ProcessMemory m;
+        rusage ru{};
+        if (::getrusage(RUSAGE_SELF, &ru) == 0) {
+            m.peak_rss = static_cast<std::uint64_t>(ru.ru_maxrss) * 1024u;   // Linux: KiB
+        }
+
+        // statm: size resident shared text lib data dt, in pagine
+        char buf[128] = {};
+        const int fd = ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return m;
+        const auto n = ::read(fd, buf, sizeof(buf) - 1);
+        ::close(fd);
+        unsigned long long size = 0;
+        unsigned long long resident = 0;
+        if (n > 0 && std::sscanf(buf, "%llu %llu", &size, &resident) == 2) {
+            m.rss = static_cast<std::uint64_t>(resident) * static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+        }
+        // ru_maxrss è aggiornato dal kernel in ritardo (contatori RSS per thread): può restare sotto statm
+        if (m.peak_rss < m.rss) m.peak_rss = m.rss;
+        return m;
+    }
+
+}
@@ -0,0 +1,83 @@
+#include "tb/profile.hpp"
+
+#include <ctime>
+
+namespace tb {
+
+    namespace {
+        std::uint64_t now_ns(clockid_t clock) noexcept {
+            timespec ts{};
+            ::clock_gettime(clock, &ts);
+            return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(ts.tv_nsec);
+        }
+    }
+
+    const char* stage_name(Stage s) noexcept {
+        switch (s) {
+            case Stage::Open: return "open";
+            case Stage::Read: return "read";
+            case Stage::Parse: return "parse";
+            case Stage::Bucketize: return "bucketize";
+            case Stage::Histogram: return "histogram";
+            case Stage::Stats: return "stats";
+            case Stage::Output: return "output";
+            case Stage::Count: break;
+        }
+        return "?";
+    }
+
+    void StageProfile::add(Stage s, const StageTotals& delta) noexcept {
+        if (s == Stage::Count) return;
+        Slot& slot = slots_[static_cast<std::size_t>(s)];
+        slot.calls.fetch_add(delta.calls, std::memory_order_relaxed);
+        slot.wall_ns.fetch_add(delta.wall_ns, std::memory_order_relaxed);
+        slot.cpu_ns.fetch_add(delta.cpu_ns, std::memory_order_relaxed);
+        slot.bytes.fetch_add(delta.bytes, std::memory_order_relaxed);
+        slot.items.fetch_add(delta.items, std::memory_order_relaxed);
+    }
+
+    StageTotals StageProfile::totals(Stage s) const noexcept {
+        StageTotals t;
+        if (s == Stage::Count) return t;
+        const Slot& slot = slots_[static_cast<std::size_t>(s)];
+        t.calls = slot.calls.load(std::memory_order_relaxed);
+        t.wall_ns = slot.wall_ns.load(std::memory_order_relaxed);
+        t.cpu_ns = slot.cpu_ns.load(std::memory_order_relaxed);
+        t.bytes = slot.bytes.load(std::memory_order_relaxed);
+        t.items = slot.items.load(std::memory_order_relaxed);
+        return t;
+    }
+
+    void StageProfile::reset() noexcept {
+        for (Slot& slot : slots_) {
+            slot.calls.store(0, std::memory_order_relaxed);
+            slot.wall_ns.store(0, std::memory_order_relaxed);
+            slot.cpu_ns.store(0, std::memory_order_relaxed);
+            slot.bytes.store(0, std::memory_order_relaxed);
+            slot.items.store(0, std::memory_order_relaxed);
+        }
+    }
+
+#if TB_PROFILING
+    // CLOCK_THREAD_CPUTIME_ID non passa dal vDSO: una syscall per lettura, solo con profilo attivo
+    void ScopedStage::start() noexcept {
+        wall0_ = trace_clock_ns();
+        if (profile_ != nullptr) cpu0_ = now_ns(CLOCK_THREAD_CPUTIME_ID);
+    }
+
+    void ScopedStage::stop() noexcept {
+        const std::uint64_t cpu1 = profile_ != nullptr ? now_ns(CLOCK_THREAD_CPUTIME_ID) : 0;
+        const std::uint64_t wall1 = trace_clock_ns();
+        if (tracing_) trace_event({stage_name(stage_), wall0_, wall1, items_, bytes_});
+        if (profile_ == nullptr) return;
+        StageTotals d;
+        d.cpu_ns = cpu1 - cpu0_;
+        d.wall_ns = wall1 - wall0_;
+        d.calls = 1;
+        d.items = items_;
+        d.bytes = bytes_;
+        profile_->add(stage_, d);
+    }
+#endif
+
+}
@@ -0,0 +1,274 @@
+#include "tb/sampling.hpp"
+#include "tb/stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace tb {
+
+    namespace {
+        constexpr std::uint64_t kMinPerBucket = 5;   // campione minimo prima di fermarsi: 5 attesi per bucket
+        constexpr std::uint64_t kFirstRound = 4096;
+
+        // Φ^-1(p) per bisezione su erfc: si calcola una volta per campionamento
+        double normal_quantile(double p) {
+            double lo = -40.0;
+            double hi = 40.0;
+            for (int i = 0; i < 200; ++i) {
+                const double mid = 0.5 * (lo + hi);
+                if (0.5 * std::erfc(-mid / std::sqrt(2.0)) < p) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            return 0.5 * (lo + hi);
+        }
+
+        double z_for(double confidence) {
+            if (!(confidence > 0.0 && confidence < 1.0)) {
+                throw std::invalid_argument("sampling: confidence must lie in (0, 1)");
+            }
+            return normal_quantile(1.0 - (1.0 - confidence) / 2.0);
+        }
+
+        // correzione per popolazione finita: (N - n) / (N - 1); 1 se N è ignota, 0 se il campione è tutto
+        double fpc(std::uint64_t n, std::uint64_t population) noexcept {
+            if (population == 0) return 1.0;
+            if (n >= population) return 0.0;
+            return static_cast<double>(population - n) / static_cast<double>(population - 1);
+        }
+
+        // semiampiezza di Wilson per la quota c / n, con n efficace n / f
+        void wilson(std::size_t c, std::uint64_t n, double f, double z, double& lower, double& upper) noexcept {
+            const double p = static_cast<double>(c) / static_cast<double>(n);
+            if (f <= 0.0) {
+                lower = upper = p;
+                return;
+            }
+            const double ne = static_cast<double>(n) / f;
+            const double z2 = z * z;
+            const double denom = 1.0 + z2 / ne;
+            const double center = (p + z2 / (2.0 * ne)) / denom;
+            const double half = z * std::sqrt(p * (1.0 - p) / ne + z2 / (4.0 * ne * ne)) / denom;
+            lower = std::max(0.0, center - half);
+            upper = std::min(1.0, center + half);
+        }
+
+        // semiampiezza relativa alla quota stessa, o alla quota uniforme per i bucket più piccoli:
+        // un bucket con un terzo del carico non deve essere noto al millesimo di 1/m
+        double relative_error(double share, double lower, double upper, std::size_t m) noexcept {
+            return 0.5 * (upper - lower) / std::max(share, 1.0 / static_cast<double>(m));
+        }
+
+        // solo max_error, senza allocare: controllato spesso durante la lettura
+        double max_error(const std::vector<std::size_t>& counts, std::uint64_t n, double f, double z) noexcept {
+            if (n == 0) return std::numeric_limits<double>::infinity();
+            double worst = 0.0;
+            for (const std::size_t c : counts) {
+                double lo = 0.0;
+                double hi = 0.0;
+                wilson(c, n, f, z, lo, hi);
+                const double p = static_cast<double>(c) / static_cast<double>(n);
+                worst = std::max(worst, relative_error(p, lo, hi, counts.size()));
+            }
+            return worst;
+        }
+
+        // finalizzatore di MurmurHash3: indipendente dalla funzione affine dei bucket
+        std::uint32_t sample_hash(IPv4 ip, std::uint64_t seed) noexcept {
+            std::uint32_t h = ip ^ static_cast<std::uint32_t>(seed ^ (seed >> 32));
+            h ^= h >> 16;
+            h *= 0x85EBCA6Bu;
+            h ^= h >> 13;
+            h *= 0xC2B2AE35u;
+            h ^= h >> 16;
+            return h;
+        }
+
+        // uniforme in (0, 1]: log() sempre finito
+        double unit(std::mt19937_64& rng) noexcept {
+            return static_cast<double>((rng() >> 11) + 1) * 0x1.0p-53;
+        }
+
+        // salto dell'algoritmo L (Li, 1994): righe da scartare prima della prossima sostituzione
+        std::uint64_t reservoir_skip(std::mt19937_64& rng, double w) noexcept {
+            const double s = std::floor(std::log(unit(rng)) / std::log1p(-w));
+            return s < 0x1.0p62 ? static_cast<std::uint64_t>(s) : std::uint64_t{1} << 62;
+        }
+
+        bool done(std::uint64_t sampled, std::uint64_t population, std::size_t m, double error, double tolerance) {
+            return error <= tolerance && (sampled >= kMinPerBucket * m || (population > 0 && sampled >= population));
+        }
+
+        struct Converged {};   // interrompe for_each_chunk su uno stream
+    }
+
+    const char* sample_method_name(SampleMethod m) noexcept {
+        switch (m) {
+            case SampleMethod::Stride: return "stride";
+            case SampleMethod::Hash: return "hash";
+            case SampleMethod::Reservoir: return "reservoir";
+        }
+        return "?";
+    }
+
+    SampleMethod parse_sample_method(const std::string& name) {
+        for (const auto m : {SampleMethod::Stride, SampleMethod::Hash, SampleMethod::Reservoir}) {
+            if (name == sample_method_name(m)) return m;
+        }
+        throw std::runtime_error("Unknown sampling method: '" + name + "' (expected stride, hash or reservoir)");
+    }
+
+    SampleEstimate estimate_from_sample(std::vector<std::size_t> sampled_counts, std::uint64_t population,
+                                        double confidence) {
+        const double z = z_for(confidence);
+        SampleEstimate r;
+        r.counts = std::move(sampled_counts);
+        const std::size_t m = r.counts.size();
+        for (const std::size_t c : r.counts) r.sampled += c;
+        if (population != 0 && population < r.sampled) {
+            throw std::invalid_argument("estimate_from_sample: population smaller than the sample");
+        }
+        const std::uint64_t n = r.sampled;
+        r.population = population != 0 ? population : n;
+        r.scanned = n;
+        r.fraction_read = r.population > 0 ? static_cast<double>(n) / static_cast<double>(r.population) : 0.0;
+        r.sample_stats = compute_stats(r.counts);
+        r.share.assign(m, 0.0);
+        r.lower.assign(m, 0.0);
+        r.upper.assign(m, 1.0);
+        if (n == 0 || m == 0) {
+            r.max_error = std::numeric_limits<double>::infinity();
+            return r;
+        }
+
+        const double f = fpc(n, population);
+        for (std::size_t b = 0; b < m; ++b) {
+            r.share[b] = static_cast<double>(r.counts[b]) / static_cast<double>(n);
+            wilson(r.counts[b], n, f, z, r.lower[b], r.upper[b]);
+            r.max_error = std::max(r.max_error, relative_error(r.share[b], r.lower[b], r.upper[b], m));
+        }
+
+        // E[X] ≈ (m - 1)·f + n·φ², con φ² = m·Σ(p_b - 1/m)²; Var[X] ≈ 2(m - 1)f² + 4nφ²f (chi² non centrale)
+        const double dof = static_cast<double>(m - 1);
+        const double nd = static_cast<double>(n);
+        const double phi2 = std::max(0.0, (r.sample_stats.chi2 - dof * f) / nd);
+        const double half = z * std::sqrt(2.0 * dof * f * f + 4.0 * nd * phi2 * f) / nd;
+        const double pop = static_cast<double>(r.population);
+        r.chi2 = pop * phi2;
+        r.chi2_lower = pop * std::max(0.0, phi2 - half);
+        r.chi2_upper = pop * (phi2 + half);
+        return r;
+    }
+
+    SampleEstimate sample_distribution(const BucketEngine& engine, Dataset& data, const SampleOptions& opt) {
+        if (data.weighted()) {
+            throw std::invalid_argument("sample_distribution: weighted datasets are not supported");
+        }
+        if (!(opt.rate > 0.0 && opt.rate <= 1.0)) {
+            throw std::invalid_argument("sample_distribution: rate must lie in (0, 1]");
+        }
+        if (opt.method == SampleMethod::Reservoir && opt.reservoir == 0) {
+            throw std::invalid_argument("sample_distribution: reservoir size must be > 0");
+        }
+        if (!(opt.tolerance >= 0.0)) {
+            throw std::invalid_argument("sample_distribution: tolerance must be >= 0");
+        }
+        const double z = z_for(opt.confidence);
+        const std::size_t m = static_cast<std::size_t>(engine.config().bucket_count());
+        const bool view = data.is_view();
+        const std::uint64_t known = view ? data.size() : 0;   // 0 = ignota
+
+        std::vector<std::size_t> counts(m, 0);
+        std::uint64_t sampled = 0;
+        std::uint64_t scanned = 0;
+
+        if (opt.method == SampleMethod::Stride && view) {
+            // round r: posizioni ≡ S/2^r (mod S/2^(r-1)); ogni round raddoppia il campione e
+            // l'unione dei round completati è un campione sistematico di tutta la vista
+            const std::uint64_t first_round = std::max<std::uint64_t>(kFirstRound, kMinPerBucket * m);
+            std::uint64_t top = 1;
+            while (top < known / first_round) top <<= 1;
+            for (std::uint64_t stride = top, offset = 0;;) {
+                data.for_each_chunk([&](const Chunk& c, unsigned) {
+                    const std::uint64_t end = c.first + c.size;
+                    std::uint64_t i = c.first + (offset + stride - c.first % stride) % stride;
+                    for (; i < end; i += stride) {
+                        counts[engine.bucket_index(c.ips[i - c.first])] += 1;
+                        ++sampled;
+                    }
+                }, 1);
+                scanned = sampled;
+                if (opt.tolerance > 0.0 &&
+                    done(sampled, known, m, max_error(counts, sampled, fpc(sampled, known), z), opt.tolerance)) {
+                    break;
+                }
+                if (stride == 1 || (offset != 0 && stride == 2)) break;   // vista letta tutta
+                if (offset != 0) stride /= 2;
+                offset = stride / 2;
+            }
+        } else if (opt.method == SampleMethod::Reservoir) {
+            std::mt19937_64 rng{opt.seed};
+            const std::uint64_t k = opt.reservoir;
+            std::vector<IPv4> reservoir;
+            reservoir.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(k, view ? known : kFirstRound)));
+            double w = std::exp(std::log(unit(rng)) / static_cast<double>(k));
+            std::uint64_t next = k + reservoir_skip(rng, w);   // prossima riga che entra
+            data.for_each_chunk([&](const Chunk& c, unsigned) {
+                const std::uint64_t end = c.first + c.size;
+                std::uint64_t i = c.first;
+                for (; i < end && reservoir.size() < k; ++i) reservoir.push_back(c.ips[i - c.first]);
+                // next >= i: il reservoir è pieno prima della prima sostituzione
+                while (next < end) {
+                    reservoir[static_cast<std::size_t>(rng() % k)] = c.ips[next - c.first];
+                    w *= std::exp(std::log(unit(rng)) / static_cast<double>(k));
+                    next += reservoir_skip(rng, w) + 1;
+                }
+                scanned = end;
+            }, 1);
+            for (const IPv4 ip : reservoir) counts[engine.bucket_index(ip)] += 1;
+            sampled = reservoir.size();
+        } else {
+            // lettura in ordine: stride sugli stream, hash su viste e stream
+            const auto every = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::llround(1.0 / opt.rate)));
+            const auto threshold = static_cast<std::uint64_t>(opt.rate * 4294967296.0);
+            std::uint64_t next_check = kMinPerBucket * m;
+            try {
+                data.for_each_chunk([&](const Chunk& c, unsigned) {
+                    if (opt.method == SampleMethod::Stride) {
+                        for (std::uint64_t i = (every - c.first % every) % every; i < c.size; i += every) {
+                            counts[engine.bucket_index(c.ips[i])] += 1;
+                            ++sampled;
+                        }
+                    } else {
+                        for (std::size_t i = 0; i < c.size; ++i) {
+                            if (sample_hash(c.ips[i], opt.seed) < threshold) {
+                                counts[engine.bucket_index(c.ips[i])] += 1;
+                                ++sampled;
+                            }
+                        }
+                    }
+                    scanned = c.first + c.size;
+                    // controllo a crescita geometrica: O(m) per controllo, O(log n) controlli
+                    if (opt.tolerance > 0.0 && sampled >= next_check) {
+                        if (max_error(counts, sampled, fpc(sampled, known), z) <= opt.tolerance) throw Converged{};
+                        next_check = sampled + sampled / 4;
+                    }
+                }, 1);
+            } catch (const Converged&) {
+            }
+        }
+
+        const std::uint64_t population = view ? known : scanned;
+        SampleEstimate r = estimate_from_sample(std::move(counts), population, opt.confidence);
+        r.scanned = scanned;
+        r.fraction_read = population > 0 ? static_cast<double>(scanned) / static_cast<double>(population) : 0.0;
+        r.converged = done(r.sampled, population, m, r.max_error, opt.tolerance);
+        return r;
+    }
+
+}
@@ -0,0 +1,325 @@
+#include "tb/snapshot.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace tb {
+
+    namespace {
+        // ---------- Layout header (64 byte, little-endian) ----------
+        //  0 magic "TBHS"        4 u16 version       6 u8 encoding     7 u8 counter bits
+        //  8 u32 a              12 u32 b            16 u32 k          20 u32 crc32(meta+pad+payload)
+        // 24 u64 fingerprint    32 u64 buckets      40 u64 total
+        // 48 u32 meta size      52 u32 reserved     56 u64 payload size
+        constexpr std::uint8_t kMagic[4] = {'T', 'B', 'H', 'S'};
+        constexpr std::uint16_t kVersion = 1;
+        constexpr std::size_t kHeaderLen = 64;
+
+        // identifica la famiglia di hash (affine mod 2^32, top-k bit)
+        constexpr std::uint64_t kHashFamilyAffine = 1;
+
+        std::size_t align8(std::size_t v) noexcept { return (v + 7u) & ~std::size_t{7}; }
+
+        void put_le(std::uint8_t* p, std::uint64_t v, unsigned bytes) noexcept {
+            for (unsigned i = 0; i < bytes; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+        }
+
+        std::uint64_t get_le(const std::uint8_t* p, unsigned bytes) noexcept {
+            std::uint64_t v = 0;
+            for (unsigned i = 0; i < bytes; ++i) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+            return v;
+        }
+
+        unsigned bit_width(std::uint64_t v) noexcept {
+            unsigned w = 0;
+            while (v != 0) { ++w; v >>= 1; }
+            return w;
+        }
+
+        std::uint64_t zigzag(std::int64_t v) noexcept {
+            return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+        }
+
+        std::int64_t unzigzag(std::uint64_t v) noexcept {
+            return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1u);
+        }
+
+        std::size_t varint_len(std::uint64_t v) noexcept {
+            std::size_t n = 1;
+            while (v >= 0x80u) { v >>= 7; ++n; }
+            return n;
+        }
+
+        // valore `bits` bit alla posizione di bit `pos` dello stream LSB-first
+        std::uint64_t get_bits(const std::uint8_t* p, std::size_t len, std::uint64_t pos, unsigned bits) noexcept {
+            if (bits == 0) return 0;
+            const std::size_t byte = static_cast<std::size_t>(pos >> 3);
+            const unsigned shift = static_cast<unsigned>(pos & 7u);
+            const unsigned avail = static_cast<unsigned>(std::min<std::size_t>(8, len - byte));
+            std::uint64_t v = get_le(p + byte, avail) >> shift;
+            if (shift + bits > 64) {
+                v |= static_cast<std::uint64_t>(p[byte + 8]) << (64 - shift);
+            }
+            return bits == 64 ? v : (v & ((std::uint64_t{1} << bits) - 1));
+        }
+
+        [[noreturn]] void corrupt(const std::string& what) {
+            throw std::runtime_error("Invalid histogram snapshot: " + what);
+        }
+
+        std::array<std::uint32_t, 256> make_crc_table() noexcept {
+            std::array<std::uint32_t, 256> t{};
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t c = i;
+                for (int j = 0; j < 8; ++j) c = (c & 1u) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                t[i] = c;
+            }
+            return t;
+        }
+    }
+
+    std::uint64_t config_fingerprint(const Config& cfg) noexcept {
+        // FNV-1a 64 su (famiglia, a, b, k)
+        std::uint64_t h = 0xCBF29CE484222325ULL;
+        auto mix = [&](std::uint64_t v) {
+            for (int i = 0; i < 8; ++i) {
+                h ^= (v >> (8 * i)) & 0xFFu;
+                h *= 0x100000001B3ULL;
+            }
+        };
+        mix(kHashFamilyAffine);
+        mix(cfg.a);
+        mix(cfg.b);
+        mix(cfg.k);
+        return h;
+    }
+
+    std::uint32_t crc32(const std::uint8_t* data, std::size_t len, std::uint32_t crc) noexcept {
+        static const std::array<std::uint32_t, 256> table = make_crc_table();
+        crc = ~crc;
+        for (std::size_t i = 0; i < len; ++i) {
+            crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    std::vector<std::uint8_t> encode_snapshot(const HistogramSnapshot& s, SnapshotEncoding enc) {
+        const auto& c = s.counts;
+        if (c.size() != s.cfg.bucket_count()) {
+            throw std::invalid_argument("encode_snapshot: counts size does not match 2^k");
+        }
+
+        const std::uint64_t max = c.empty() ? 0 : *std::max_element(c.begin(), c.end());
+        const std::uint64_t total = std::accumulate(c.begin(), c.end(), std::uint64_t{0});
+        const unsigned packed_bits = bit_width(max);
+        const unsigned raw_bytes = (max <= 0xFFu) ? 1u : (max <= 0xFFFFu) ? 2u : (max <= 0xFFFFFFFFu) ? 4u : 8u;
+
+        const std::size_t raw_size = c.size() * raw_bytes;
+        const std::size_t packed_size = (c.size() * packed_bits + 7u) / 8u;
+        auto varint_size = [&] {
+            std::size_t n = 0;
+            std::uint64_t prev = 0;
+            for (const std::size_t v : c) {
+                n += varint_len(zigzag(static_cast<std::int64_t>(v - prev)));
+                prev = v;
+            }
+            return n;
+        };
+
+        std::size_t payload_size = 0;
+        if (enc == SnapshotEncoding::Auto) {
+            // a parità di dimensione preferiamo l'accesso casuale (Raw, poi BitPacked)
+            enc = SnapshotEncoding::Raw;
+            payload_size = raw_size;
+            if (packed_size < payload_size) { enc = SnapshotEncoding::BitPacked; payload_size = packed_size; }
+            const std::size_t vs = varint_size();
+            if (vs < payload_size) { enc = SnapshotEncoding::DeltaVarint; payload_size = vs; }
+        } else if (enc == SnapshotEncoding::Raw) {
+            payload_size = raw_size;
+        } else if (enc == SnapshotEncoding::BitPacked) {
+            payload_size = packed_size;
+        } else if (enc == SnapshotEncoding::DeltaVarint) {
+            payload_size = varint_size();
+        } else {
+            throw std::invalid_argument("encode_snapshot: unknown encoding");
+        }
+
+        const std::size_t meta_len = s.metadata.size();
+        if (meta_len > 0xFFFFFFFFu) {
+            throw std::invalid_argument("encode_snapshot: metadata too large");
+        }
+        const std::size_t payload_off = align8(kHeaderLen + meta_len);
+        std::vector<std::uint8_t> out(payload_off + payload_size, 0);
+
+        std::memcpy(out.data(), kMagic, 4);
+        put_le(out.data() + 4, kVersion, 2);
+        out[6] = static_cast<std::uint8_t>(enc);
+        out[7] = static_cast<std::uint8_t>(enc == SnapshotEncoding::Raw ? raw_bytes * 8
+                                         : enc == SnapshotEncoding::BitPacked ? packed_bits : 0);
+        put_le(out.data() + 8, s.cfg.a, 4);
+        put_le(out.data() + 12, s.cfg.b, 4);
+        put_le(out.data() + 16, s.cfg.k, 4);
+        put_le(out.data() + 24, config_fingerprint(s.cfg), 8);
+        put_le(out.data() + 32, c.size(), 8);
+        put_le(out.data() + 40, total, 8);
+        put_le(out.data() + 48, meta_len, 4);
+        put_le(out.data() + 56, payload_size, 8);
+        std::memcpy(out.data() + kHeaderLen, s.metadata.data(), meta_len);
+
+        std::uint8_t* p = out.data() + payload_off;
+        if (enc == SnapshotEncoding::Raw) {
+            for (std::size_t i = 0; i < c.size(); ++i) put_le(p + i * raw_bytes, c[i], raw_bytes);
+        } else if (enc == SnapshotEncoding::BitPacked) {
+            // accumulatore a 64 bit: a ogni parola piena la scarichiamo nello stream
+            std::uint64_t acc = 0;
+            unsigned fill = 0;
+            std::size_t o = 0;
+            for (const std::size_t v64 : c) {
+                const std::uint64_t v = v64;
+                if (packed_bits == 0) break;
+                acc |= v << fill;
+                if (fill + packed_bits >= 64) {
+                    put_le(p + o, acc, 8);
+                    o += 8;
+                    acc = (fill == 0) ? 0 : (v >> (64 - fill));
+                    fill = fill + packed_bits - 64;
+                } else {
+                    fill += packed_bits;
+                }
+            }
+            put_le(p + o, acc, (fill + 7u) / 8u);
+        } else {
+            std::uint64_t prev = 0;
+            for (const std::size_t v : c) {
+                std::uint64_t z = zigzag(static_cast<std::int64_t>(v - prev));
+                prev = v;
+                while (z >= 0x80u) {
+                    *p++ = static_cast<std::uint8_t>(z | 0x80u);
+                    z >>= 7;
+                }
+                *p++ = static_cast<std::uint8_t>(z);
+            }
+        }
+
+        const std::uint32_t crc = crc32(out.data() + kHeaderLen, out.size() - kHeaderLen);
+        put_le(out.data() + 20, crc, 4);
+        return out;
+    }
+
+    // ---------- SnapshotView ----------
+
+    SnapshotView::SnapshotView(const std::uint8_t* data, std::size_t len) {
+        if (len < kHeaderLen || std::memcmp(data, kMagic, 4) != 0) {
+            corrupt("bad magic or truncated header");
+        }
+        if (get_le(data + 4, 2) != kVersion) {
+            corrupt("unsupported version " + std::to_string(get_le(data + 4, 2)));
+        }
+        enc_ = static_cast<SnapshotEncoding>(data[6]);
+        bits_ = data[7];
+        cfg_.a = static_cast<std::uint32_t>(get_le(data + 8, 4));
+        cfg_.b = static_cast<std::uint32_t>(get_le(data + 12, 4));
+        cfg_.k = static_cast<unsigned int>(get_le(data + 16, 4));
+        const auto crc = static_cast<std::uint32_t>(get_le(data + 20, 4));
+        fingerprint_ = get_le(data + 24, 8);
+        const std::uint64_t buckets = get_le(data + 32, 8);
+        total_ = get_le(data + 40, 8);
+        meta_len_ = static_cast<std::size_t>(get_le(data + 48, 4));
+        const std::uint64_t payload_len = get_le(data + 56, 8);
+
+        if (cfg_.k > 32 || buckets != cfg_.bucket_count()) {
+            corrupt("bucket count does not match k");
+        }
+        if (fingerprint_ != config_fingerprint(cfg_)) {
+            corrupt("config fingerprint mismatch");
+        }
+        buckets_ = static_cast<std::size_t>(buckets);
+
+        const std::size_t payload_off = align8(kHeaderLen + meta_len_);
+        if (payload_off > len || payload_len != len - payload_off) {
+            corrupt("payload size does not match file size");
+        }
+        payload_len_ = static_cast<std::size_t>(payload_len);
+
+        switch (enc_) {
+            case SnapshotEncoding::Raw:
+                if (bits_ != 8 && bits_ != 16 && bits_ != 32 && bits_ != 64) corrupt("bad raw counter width");
+                if (payload_len_ != buckets_ * (bits_ / 8)) corrupt("raw payload size mismatch");
+                break;
+            case SnapshotEncoding::BitPacked:
+                if (bits_ > 64) corrupt("bad packed counter width");
+                if (payload_len_ != (buckets_ * bits_ + 7u) / 8u) corrupt("packed payload size mismatch");
+                break;
+            case SnapshotEncoding::DeltaVarint:
+                break;
+            default:
+                corrupt("unknown encoding " + std::to_string(data[6]));
+        }
+
+        if (crc32(data + kHeaderLen, len - kHeaderLen) != crc) {
+            corrupt("checksum mismatch");
+        }
+        meta_ = data + kHeaderLen;
+        payload_ = data + payload_off;
+    }
+
+    std::string SnapshotView::metadata() const {
+        return std::string(reinterpret_cast<const char*>(meta_), meta_len_);
+    }
+
+    void SnapshotView::accumulate(std::vector<std::size_t>& acc, std::size_t begin, std::size_t end) const {
+        if (acc.size() != buckets_) {
+            throw std::invalid_argument("SnapshotView::accumulate: accumulator size mismatch");
+        }
+        end = std::min(end, buckets_);
+        if (begin >= end) return;
+
+        if (enc_ == SnapshotEncoding::Raw) {
+            const unsigned w = bits_ / 8;
+            const std::uint8_t* p = payload_ + begin * w;
+            for (std::size_t i = begin; i < end; ++i, p += w) {
+                acc[i] += static_cast<std::size_t>(get_le(p, w));
+            }
+        } else if (enc_ == SnapshotEncoding::BitPacked) {
+            std::uint64_t pos = static_cast<std::uint64_t>(begin) * bits_;
+            for (std::size_t i = begin; i < end; ++i, pos += bits_) {
+                acc[i] += static_cast<std::size_t>(get_bits(payload_, payload_len_, pos, bits_));
+            }
+        } else {
+            // varint: decodifica sequenziale obbligata dall'inizio
+            const std::uint8_t* p = payload_;
+            const std::uint8_t* const e = payload_ + payload_len_;
+            std::uint64_t prev = 0;
+            for (std::size_t i = 0; i < end; ++i) {
+                std::uint64_t z = 0;
+                unsigned shift = 0;
+                for (;;) {
+                    if (p == e || shift > 63) corrupt("truncated varint payload");
+                    const std::uint8_t byte = *p++;
+                    z |= static_cast<std::uint64_t>(byte & 0x7Fu) << shift;
+                    if ((byte & 0x80u) == 0) break;
+                    shift += 7;
+                }
+                prev = static_cast<std::uint64_t>(static_cast<std::int64_t>(prev) + unzigzag(z));
+                if (i >= begin) acc[i] += static_cast<std::size_t>(prev);
+            }
+        }
+    }
+
+    HistogramSnapshot SnapshotView::decode() const {
+        HistogramSnapshot s;
+        s.cfg = cfg_;
+        s.metadata = metadata();
+        s.counts.assign(buckets_, 0);
+        accumulate(s.counts);
+        return s;
+    }
+
+    HistogramSnapshot decode_snapshot(const std::uint8_t* data, std::size_t len) {
+        return SnapshotView{data, len}.decode();
+    }
+
+}
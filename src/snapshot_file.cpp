@@ -0,0 +1,210 @@
+#include "tb/snapshot_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace tb {
+
+    namespace {
+        std::runtime_error sys_error(const std::string& what) {
+            return std::runtime_error(what + ": " + std::strerror(errno));
+        }
+
+        unsigned resolve_threads(unsigned threads, std::size_t work_items) {
+            if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            return static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, work_items)));
+        }
+    }
+
+    void write_file_atomic(const std::string& path, const std::vector<std::uint8_t>& bytes) {
+        const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+        const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw sys_error("Cannot create " + tmp);
+        }
+        std::size_t off = 0;
+        while (off < bytes.size()) {
+            const auto n = ::write(fd, bytes.data() + off, bytes.size() - off);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                const auto err = sys_error("Cannot write " + tmp);
+                ::close(fd);
+                ::unlink(tmp.c_str());
+                throw err;
+            }
+            off += static_cast<std::size_t>(n);
+        }
+        // fsync prima del rename: dopo un crash troviamo il file vecchio o quello nuovo completo
+        if (::fsync(fd) != 0 || ::close(fd) != 0) {
+            const auto err = sys_error("Cannot flush " + tmp);
+            ::unlink(tmp.c_str());
+            throw err;
+        }
+        if (::rename(tmp.c_str(), path.c_str()) != 0) {
+            const auto err = sys_error("Cannot rename " + tmp + " to " + path);
+            ::unlink(tmp.c_str());
+            throw err;
+        }
+    }
+
+    void write_snapshot_file(const std::string& path, const HistogramSnapshot& s, SnapshotEncoding enc) {
+        write_file_atomic(path, encode_snapshot(s, enc));
+    }
+
+    // ---------- MappedSnapshot ----------
+
+    SnapshotView MappedSnapshot::map(const std::string& path, void*& addr, std::size_t& len) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw sys_error("Cannot open snapshot " + path);
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            const auto err = sys_error("Cannot stat snapshot " + path);
+            ::close(fd);
+            throw err;
+        }
+        len = static_cast<std::size_t>(st.st_size);
+        if (len == 0) {
+            ::close(fd);
+            throw std::runtime_error("Invalid histogram snapshot: empty file " + path);
+        }
+        addr = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            addr = nullptr;
+            throw sys_error("Cannot mmap snapshot " + path);
+        }
+        ::madvise(addr, len, MADV_SEQUENTIAL);
+
+        try {
+            return SnapshotView{static_cast<const std::uint8_t*>(addr), len};
+        } catch (const std::exception& e) {
+            ::munmap(addr, len);
+            addr = nullptr;
+            throw std::runtime_error(std::string(e.what()) + " (" + path + ")");
+        }
+    }
+
+    MappedSnapshot::MappedSnapshot(const std::string& path)
+    : path_{path}, view_{map(path, addr_, len_)} {}
+
+    MappedSnapshot::MappedSnapshot(MappedSnapshot&& other) noexcept
+    : path_{std::move(other.path_)}, addr_{other.addr_}, len_{other.len_}, view_{other.view_} {
+        other.addr_ = nullptr;
+        other.len_ = 0;
+    }
+
+    MappedSnapshot::~MappedSnapshot() {
+        if (addr_ != nullptr) {
+            ::munmap(addr_, len_);
+        }
+    }
+
+    HistogramSnapshot read_snapshot_file(const std::string& path) {
+        return MappedSnapshot{path}.view().decode();
+    }
+
+    // ---------- Merge ----------
+
+    HistogramSnapshot merge_snapshot_files(const std::vector<std::string>& paths, unsigned threads) {
+        if (paths.empty()) {
+            throw std::runtime_error("No snapshot files to merge");
+        }
+
+        std::vector<MappedSnapshot> inputs;
+        inputs.reserve(paths.size());
+        for (const auto& p : paths) {
+            inputs.emplace_back(p);
+            const SnapshotView& v = inputs.back().view();
+            const SnapshotView& first = inputs.front().view();
+            if (v.fingerprint() != first.fingerprint()) {
+                throw std::runtime_error("Incompatible snapshot config: " + p + " (k=" + std::to_string(v.config().k) +
+                                         ") vs " + paths.front() + " (k=" + std::to_string(first.config().k) + ")");
+            }
+        }
+
+        HistogramSnapshot out;
+        out.cfg = inputs.front().view().config();
+        const std::size_t m = inputs.front().view().bucket_count();
+        out.counts.assign(m, 0);
+
+        const bool random_access = std::all_of(inputs.begin(), inputs.end(),
+                                               [](const MappedSnapshot& s) { return s.view().random_access(); });
+
+        std::vector<std::thread> pool;
+        std::exception_ptr failure;
+        std::atomic<bool> failed{false};
+        auto guarded = [&](auto&& fn) {
+            return [&, fn]() {
+                try {
+                    fn();
+                } catch (...) {
+                    if (!failed.exchange(true)) failure = std::current_exception();
+                }
+            };
+        };
+
+        if (random_access) {
+            // ogni thread somma una fetta di bucket su tutti i file: nessuna memoria extra
+            const unsigned t = resolve_threads(threads, m);
+            const std::size_t slice = (m + t - 1) / t;
+            for (unsigned i = 0; i < t; ++i) {
+                const std::size_t begin = std::min(m, i * slice);
+                const std::size_t end = std::min(m, begin + slice);
+                pool.emplace_back(guarded([&, begin, end] {
+                    for (const auto& in : inputs) in.view().accumulate(out.counts, begin, end);
+                }));
+            }
+            for (auto& th : pool) th.join();
+        } else {
+            // varint: decodifica sequenziale per file; ogni thread ha il suo accumulatore
+            const unsigned t = resolve_threads(threads, inputs.size());
+            std::vector<std::vector<std::size_t>> partial(t);
+            std::atomic<std::size_t> next{0};
+            for (unsigned i = 0; i < t; ++i) {
+                pool.emplace_back(guarded([&, i] {
+                    partial[i].assign(m, 0);
+                    for (std::size_t f = next++; f < inputs.size(); f = next++) {
+                        inputs[f].view().accumulate(partial[i]);
+                    }
+                }));
+            }
+            for (auto& th : pool) th.join();
+            pool.clear();
+
+            if (!failed) {
+                // riduzione finale parallela per fette di bucket
+                const std::size_t slice = (m + t - 1) / t;
+                for (unsigned i = 0; i < t; ++i) {
+                    const std::size_t begin = std::min(m, i * slice);
+                    const std::size_t end = std::min(m, begin + slice);
+                    pool.emplace_back(guarded([&, begin, end] {
+                        for (const auto& part : partial) {
+                            for (std::size_t b = begin; b < end; ++b) out.counts[b] += part[b];
+                        }
+                    }));
+                }
+                for (auto& th : pool) th.join();
+            }
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+
+        for (const auto& p : paths) {
+            out.metadata += "merged=" + p + "\n";
+        }
+        return out;
+    }
+
+}
@@ -1,4 +1,6 @@
 #include "tb/stats.hpp"
+#include "tb/probes.hpp"
+#include "tb/profile.hpp"
 
 #include <algorithm>
 #include <numeric>
@@ -6,12 +8,65 @@
 
 namespace tb {
 
+    namespace {
+        constexpr int kMaxIterations = 100000;
+        constexpr double kEpsilon = 1e-15;
+        constexpr double kTiny = 1e-300;
+    }
+
+    double chi2_p_value(double chi2, double dof) noexcept {
+        if (!(dof > 0.0) || !(chi2 > 0.0)) return 1.0;
+        // Q(a, x) gamma incompleta regolarizzata, a = dof/2, x = chi2/2
+        const double a = dof / 2.0;
+        const double x = chi2 / 2.0;
+        const double prefix = std::exp(-x + a * std::log(x) - std::lgamma(a));
+
+        if (x < a + 1.0) {
+            // serie per P(a, x); qui Q >= ~0.5, la cancellazione in 1 - P non pesa
+            double ap = a;
+            double del = 1.0 / a;
+            double sum = del;
+            for (int i = 0; i < kMaxIterations; ++i) {
+                ap += 1.0;
+                del *= x / ap;
+                sum += del;
+                if (std::fabs(del) < std::fabs(sum) * kEpsilon) break;
+            }
+            return std::clamp(1.0 - sum * prefix, 0.0, 1.0);
+        }
+
+        // frazione continua per Q(a, x) (Lentz modificato)
+        double b = x + 1.0 - a;
+        double c = 1.0 / kTiny;
+        double d = 1.0 / b;
+        double h = d;
+        for (int i = 1; i < kMaxIterations; ++i) {
+            const double an = -i * (i - a);
+            b += 2.0;
+            d = an * d + b;
+            if (std::fabs(d) < kTiny) d = kTiny;
+            c = b + an / c;
+            if (std::fabs(c) < kTiny) c = kTiny;
+            d = 1.0 / d;
+            const double del = d * c;
+            h *= del;
+            if (std::fabs(del - 1.0) < kEpsilon) break;
+        }
+        return std::clamp(prefix * h, 0.0, 1.0);
+    }
+
     StatsResult compute_stats(const std::vector<std::size_t>& counts) {
+        return compute_stats(counts.data(), counts.size());
+    }
+
+    StatsResult compute_stats(const std::size_t* counts, std::size_t m) noexcept {
+        ScopedStage stage{Stage::Stats};
+        stage.add(m, m * sizeof(std::size_t));
         StatsResult r{};
-        const std::size_t m = counts.size();
         r.bucket_count = m;
+        const std::size_t* const end = counts + m;
 
-        const std::size_t n = std::accumulate(counts.begin(), counts.end(), std::size_t{0});
+        const std::size_t n = std::accumulate(counts, end, std::size_t{0});
         r.sample_count = n;
 
         if (m == 0 || n == 0) {
@@ -27,8 +82,8 @@ namespace tb {
         // poi stddev = sqrt(var)
         {
             long double acc = 0.0L;
-            for (const auto c : counts) {
-                const long double d = static_cast<long double>(c) - static_cast<long double>(mean);
+            for (const std::size_t* p = counts; p != end; ++p) {
+                const long double d = static_cast<long double>(*p) - static_cast<long double>(mean);
                 acc += d * d;
             }
             const long double var = acc / static_cast<long double>(m);
@@ -38,11 +93,12 @@ namespace tb {
         // Chi-quadro Pearson: sum( (ci - E)^2 / E ) con E=mean
         {
             long double chi = 0.0L;
-            for (const auto c : counts) {
-                const long double diff = static_cast<long double>(c) - static_cast<long double>(mean);
+            for (const std::size_t* p = counts; p != end; ++p) {
+                const long double diff = static_cast<long double>(*p) - static_cast<long double>(mean);
                 chi += (diff * diff) / static_cast<long double>(mean);
             }
             r.chi2 = static_cast<double>(chi);
+            r.p_value = chi2_p_value(r.chi2, static_cast<double>(m - 1));
         }
 
         // Uniformity % (intuitiva):
@@ -50,7 +106,8 @@ namespace tb {
         // 0% quando max deviation >= mean (clamp a [0,100])
         // È una metrica semplice, ben leggibile a colpo d'occhio.
         {
-            const auto [min_it, max_it] = std::minmax_element(counts.begin(), counts.end());
+            const auto [min_it, max_it] = std::minmax_element(counts, end);
+            r.max_load = *max_it;
             const double max_dev = std::max(std::abs(static_cast<double>(*max_it) - mean),
                                             std::abs(static_cast<double>(*min_it) - mean));
             double u = 1.0;
@@ -63,6 +120,7 @@ namespace tb {
             r.uniformity = u * 100.0;
         }
 
+        TB_PROBE4(stats__computed, m, n, r.max_load, static_cast<std::uint64_t>(r.uniformity * 10.0));
         return r;
     }
 
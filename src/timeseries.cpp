@@ -0,0 +1,527 @@
+#include "tb/timeseries.hpp"
+#include "tb/snapshot.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace tb {
+
+    namespace {
+        // ---------- Header segmento (64 byte, little-endian) ----------
+        //  0 magic "TBTS"     4 u16 version     6 u8 level       7 u8 reserved
+        //  8 u64 fingerprint 16 u32 k          20 u32 reserved
+        // 24 u64 seq         32 u64 used bytes (header incluso, aggiornato dopo ogni record)
+        // 40 u64 records     48..63 reserved
+        //
+        // ---------- Record (24 byte + payload) ----------
+        //  0 u32 payload len  4 u16 flags (1 = keyframe)  6 u16 reserved
+        //  8 u32 intervals   12 u32 crc32(payload)       16 i64 timestamp
+        // payload: LEB128 dei contatori (keyframe) o di zigzag(c[i] - prev[i]) (delta)
+        constexpr std::uint8_t kMagic[4] = {'T', 'B', 'T', 'S'};
+        constexpr std::uint16_t kVersion = 1;
+        constexpr std::size_t kSegHeader = 64;
+        constexpr std::size_t kRecHeader = 24;
+        constexpr std::uint16_t kKeyframe = 1;
+
+        constexpr std::int64_t kHour = 3600;
+        constexpr std::int64_t kDay = 86400;
+        constexpr std::int64_t kPeriods[3] = {0, kHour, kDay};
+        constexpr std::size_t kLevels = 3;
+
+        void put_le(std::uint8_t* p, std::uint64_t v, unsigned bytes) noexcept {
+            for (unsigned i = 0; i < bytes; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+        }
+
+        std::uint64_t get_le(const std::uint8_t* p, unsigned bytes) noexcept {
+            std::uint64_t v = 0;
+            for (unsigned i = 0; i < bytes; ++i) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+            return v;
+        }
+
+        void put_varint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+            while (v >= 0x80u) {
+                out.push_back(static_cast<std::uint8_t>(v | 0x80u));
+                v >>= 7;
+            }
+            out.push_back(static_cast<std::uint8_t>(v));
+        }
+
+        std::int64_t floor_div(std::int64_t a, std::int64_t p) noexcept {
+            std::int64_t q = a / p;
+            if ((a % p != 0) && (a < 0)) --q;
+            return q;
+        }
+
+        std::int64_t floor_to(std::int64_t a, std::int64_t p) noexcept { return floor_div(a, p) * p; }
+
+        std::int64_t ceil_to(std::int64_t a, std::int64_t p) noexcept {
+            return (floor_div(a, p) + ((a % p != 0) ? 1 : 0)) * p;
+        }
+
+        std::runtime_error sys_error(const std::string& what) {
+            return std::runtime_error(what + ": " + std::strerror(errno));
+        }
+
+        [[noreturn]] void corrupt(const std::string& path, const std::string& what) {
+            throw std::runtime_error("Corrupt time-series segment " + path + ": " + what);
+        }
+
+        std::string segment_name(std::size_t level, std::uint64_t seq) {
+            char buf[40];
+            std::snprintf(buf, sizeof(buf), "L%zu-%020llu.seg", level, static_cast<unsigned long long>(seq));
+            return buf;
+        }
+    }
+
+    struct TimeSeriesStore::Level {
+        struct Segment {
+            std::uint64_t seq = 0;
+            std::string path;
+            std::uint8_t* base = nullptr;
+            std::size_t size = 0;
+
+            [[nodiscard]] std::size_t used() const noexcept { return static_cast<std::size_t>(get_le(base + 32, 8)); }
+            [[nodiscard]] std::uint64_t records() const noexcept { return get_le(base + 40, 8); }
+        };
+
+        // ogni segmento inizia con un keyframe; l'indice ne contiene anche di intermedi
+        struct Keyframe {
+            std::int64_t ts = 0;
+            std::uint64_t seq = 0;
+            std::size_t offset = 0;
+        };
+
+        std::size_t index = 0;
+        std::int64_t period = 0;             // 0 = intervalli, altrimenti durata del rollup
+        std::size_t max_segments = 0;
+        std::deque<Segment> segments;
+        std::deque<Keyframe> keyframes;
+        std::uint64_t records = 0;
+
+        // stato dell'ultimo record (base del prossimo delta)
+        bool has_last = false;
+        std::int64_t last_ts = 0;
+        std::vector<std::size_t> last;
+        std::size_t since_keyframe = 0;
+
+        // rollup in corso (periodo non ancora chiuso)
+        bool has_pending = false;
+        std::int64_t pending_start = 0;
+        std::vector<std::size_t> pending;
+        std::uint64_t pending_intervals = 0;
+
+        ~Level() {
+            for (auto& s : segments) ::munmap(s.base, s.size);
+        }
+
+        [[nodiscard]] std::int64_t first_ts() const noexcept { return keyframes.front().ts; }
+
+        [[nodiscard]] std::size_t position(std::uint64_t seq) const noexcept {
+            return static_cast<std::size_t>(seq - segments.front().seq);
+        }
+
+        // visita i record con timestamp in [begin, end), decodificando dal keyframe precedente
+        void scan(std::int64_t begin, std::int64_t end, std::size_t buckets,
+                  const std::function<void(std::int64_t, const std::vector<std::size_t>&, std::uint32_t)>& fn) const {
+            if (keyframes.empty() || begin >= end) return;
+            auto kf = std::upper_bound(keyframes.begin(), keyframes.end(), begin,
+                                       [](std::int64_t t, const Keyframe& k) { return t < k.ts; });
+            if (kf != keyframes.begin()) --kf;
+
+            std::vector<std::size_t> state(buckets, 0);
+            std::size_t pos = position(kf->seq);
+            std::size_t off = kf->offset;
+            for (; pos < segments.size(); ++pos, off = kSegHeader) {
+                const auto& seg = segments[pos];
+                const std::size_t used = seg.used();
+                while (off < used) {
+                    const std::uint8_t* rec = seg.base + off;
+                    const auto len = static_cast<std::size_t>(get_le(rec, 4));
+                    const auto flags = static_cast<std::uint16_t>(get_le(rec + 4, 2));
+                    const auto intervals = static_cast<std::uint32_t>(get_le(rec + 8, 4));
+                    const auto crc = static_cast<std::uint32_t>(get_le(rec + 12, 4));
+                    const auto ts = static_cast<std::int64_t>(get_le(rec + 16, 8));
+                    if (ts >= end) return;
+                    if (len > used - off - kRecHeader) corrupt(seg.path, "record overruns segment");
+                    const std::uint8_t* p = rec + kRecHeader;
+                    if (crc32(p, len) != crc) corrupt(seg.path, "checksum mismatch");
+
+                    const bool key = (flags & kKeyframe) != 0;
+                    std::size_t j = 0;
+                    for (std::size_t i = 0; i < buckets; ++i) {
+                        std::uint64_t v = 0;
+                        for (unsigned shift = 0;; shift += 7) {
+                            if (j >= len || shift > 63) corrupt(seg.path, "truncated varint");
+                            const std::uint8_t byte = p[j++];
+                            v |= static_cast<std::uint64_t>(byte & 0x7Fu) << shift;
+                            if ((byte & 0x80u) == 0) break;
+                        }
+                        if (key) {
+                            state[i] = static_cast<std::size_t>(v);
+                        } else {
+                            const auto d = static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1u);
+                            state[i] = static_cast<std::size_t>(static_cast<std::uint64_t>(state[i]) +
+                                                                static_cast<std::uint64_t>(d));
+                        }
+                    }
+                    if (j != len) corrupt(seg.path, "payload size mismatch");
+                    if (ts >= begin) fn(ts, state, intervals);
+                    off += kRecHeader + len;
+                }
+            }
+        }
+
+        static Segment map_segment(const std::string& path, bool create, std::size_t create_size) {
+            const int flags = O_RDWR | O_CLOEXEC | (create ? (O_CREAT | O_EXCL) : 0);
+            const int fd = ::open(path.c_str(), flags, 0644);
+            if (fd < 0) {
+                throw sys_error("Cannot open time-series segment " + path);
+            }
+            std::size_t size = create_size;
+            if (create) {
+                if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                    const auto err = sys_error("Cannot size time-series segment " + path);
+                    ::close(fd);
+                    throw err;
+                }
+            } else {
+                struct stat st{};
+                if (::fstat(fd, &st) != 0) {
+                    const auto err = sys_error("Cannot stat time-series segment " + path);
+                    ::close(fd);
+                    throw err;
+                }
+                size = static_cast<std::size_t>(st.st_size);
+                if (size < kSegHeader) {
+                    ::close(fd);
+                    corrupt(path, "truncated header");
+                }
+            }
+            void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (addr == MAP_FAILED) {
+                throw sys_error("Cannot mmap time-series segment " + path);
+            }
+            Segment s;
+            s.path = path;
+            s.base = static_cast<std::uint8_t*>(addr);
+            s.size = size;
+            return s;
+        }
+    };
+
+    TimeSeriesStore::TimeSeriesStore(const std::string& dir, const Config& cfg, TimeSeriesOptions opt)
+    : cfg_{cfg}, opt_{opt}, dir_{dir} {
+        const std::size_t buckets = cfg_.bucket_count();
+        // caso peggiore: keyframe con tutti i contatori a 10 byte
+        if (opt_.segment_bytes < kSegHeader + kRecHeader + buckets * 10u) {
+            throw std::invalid_argument("TimeSeriesStore: segment_bytes too small for 2^k buckets");
+        }
+        if (opt_.max_segments == 0 || opt_.rollup_max_segments == 0 || opt_.keyframe_every == 0) {
+            throw std::invalid_argument("TimeSeriesStore: max_segments and keyframe_every must be > 0");
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+        if (ec) {
+            throw std::runtime_error("Cannot create time-series store " + dir_ + ": " + ec.message());
+        }
+
+        const std::uint64_t fp = config_fingerprint(cfg_);
+        for (std::size_t l = 0; l < kLevels; ++l) {
+            auto lv = std::make_unique<Level>();
+            lv->index = l;
+            lv->period = kPeriods[l];
+            lv->max_segments = (l == 0) ? opt_.max_segments : opt_.rollup_max_segments;
+            lv->last.assign(buckets, 0);
+
+            // segmenti esistenti, in ordine di sequenza
+            const std::string prefix = "L" + std::to_string(l) + "-";
+            std::vector<std::pair<std::uint64_t, std::string>> found;
+            for (const auto& e : std::filesystem::directory_iterator(dir_)) {
+                const std::string name = e.path().filename().string();
+                if (name.rfind(prefix, 0) != 0 || name.size() < prefix.size() + 5 ||
+                    name.compare(name.size() - 4, 4, ".seg") != 0) {
+                    continue;
+                }
+                found.emplace_back(std::stoull(name.substr(prefix.size(), name.size() - prefix.size() - 4)),
+                                   e.path().string());
+            }
+            std::sort(found.begin(), found.end());
+
+            for (const auto& [seq, path] : found) {
+                lv->segments.push_back(Level::map_segment(path, false, 0));
+                Level::Segment& seg = lv->segments.back();
+                seg.seq = seq;
+                const std::uint8_t* h = seg.base;
+                if (std::memcmp(h, kMagic, 4) != 0) corrupt(path, "bad magic");
+                if (get_le(h + 4, 2) != kVersion) corrupt(path, "unsupported version");
+                if (h[6] != l || get_le(h + 24, 8) != seq) corrupt(path, "level/sequence mismatch");
+                if (get_le(h + 8, 8) != fp || get_le(h + 16, 4) != cfg_.k) {
+                    throw std::runtime_error("Time-series store " + dir_ + " was created with a different config (k=" +
+                                             std::to_string(get_le(h + 16, 4)) + ")");
+                }
+                if (seq != lv->segments.front().seq + lv->segments.size() - 1) corrupt(path, "missing segment");
+                const std::size_t used = seg.used();
+                if (used < kSegHeader || used > seg.size) corrupt(path, "bad used size");
+
+                // indice: solo header dei record, il payload viene verificato in lettura
+                std::size_t off = kSegHeader;
+                std::size_t n = 0;
+                while (off < used) {
+                    if (used - off < kRecHeader) corrupt(path, "truncated record");
+                    const std::uint8_t* rec = seg.base + off;
+                    const auto len = static_cast<std::size_t>(get_le(rec, 4));
+                    const auto ts = static_cast<std::int64_t>(get_le(rec + 16, 8));
+                    if (len > used - off - kRecHeader) corrupt(path, "record overruns segment");
+                    if (lv->has_last && ts <= lv->last_ts) corrupt(path, "timestamps out of order");
+                    if ((get_le(rec + 4, 2) & kKeyframe) != 0) {
+                        lv->keyframes.push_back({ts, seq, off});
+                        lv->since_keyframe = 0;
+                    } else if (n == 0) {
+                        corrupt(path, "segment does not start with a keyframe");
+                    }
+                    ++lv->since_keyframe;
+                    lv->has_last = true;
+                    lv->last_ts = ts;
+                    off += kRecHeader + len;
+                    ++n;
+                }
+                if (n != seg.records()) corrupt(path, "record count mismatch");
+                lv->records += n;
+            }
+
+            // ripristina lo stato dell'ultimo record (base del prossimo delta)
+            if (lv->has_last) {
+                lv->scan(lv->keyframes.back().ts, lv->last_ts + 1, buckets,
+                           [&](std::int64_t, const std::vector<std::size_t>& c, std::uint32_t) { lv->last = c; });
+            }
+            levels_.push_back(std::move(lv));
+        }
+
+        // ricostruisce i rollup in corso dall'alto: prima i giorni dalle ore, poi le ore dagli intervalli
+        for (std::size_t l = kLevels - 1; l >= 1; --l) {
+            Level& lv = *levels_[l];
+            const std::int64_t from = lv.has_last ? lv.last_ts + lv.period : std::numeric_limits<std::int64_t>::min();
+            const Level& src = *levels_[l - 1];
+            if (!src.has_last) continue;
+            src.scan(std::max(from, src.first_ts()), src.last_ts + 1, buckets,
+                       [&](std::int64_t ts, const std::vector<std::size_t>& c, std::uint32_t n) {
+                           roll_up(l, ts, c, n);
+                       });
+        }
+    }
+
+    TimeSeriesStore::~TimeSeriesStore() = default;
+
+    void TimeSeriesStore::put(std::size_t level, std::int64_t ts, const std::vector<std::size_t>& counts,
+                              std::uint32_t intervals) {
+        Level& lv = *levels_[level];
+
+        std::vector<std::uint8_t> payload;
+        payload.reserve(counts.size() * 2);
+        auto encode = [&](bool key) {
+            payload.clear();
+            for (std::size_t i = 0; i < counts.size(); ++i) {
+                if (key) {
+                    put_varint(payload, counts[i]);
+                } else {
+                    const auto d = static_cast<std::int64_t>(static_cast<std::uint64_t>(counts[i]) -
+                                                             static_cast<std::uint64_t>(lv.last[i]));
+                    put_varint(payload, (static_cast<std::uint64_t>(d) << 1) ^ static_cast<std::uint64_t>(d >> 63));
+                }
+            }
+        };
+
+        bool key = !lv.has_last || lv.since_keyframe >= opt_.keyframe_every;
+        encode(key);
+        if (lv.segments.empty() || lv.segments.back().used() + kRecHeader + payload.size() > lv.segments.back().size) {
+            // nuovo segmento: deve essere decodificabile da solo
+            open_segment(level);
+            if (!key) {
+                key = true;
+                encode(key);
+            }
+        }
+
+        Level::Segment& seg = lv.segments.back();
+        const std::size_t off = seg.used();
+        std::uint8_t* rec = seg.base + off;
+        put_le(rec, payload.size(), 4);
+        put_le(rec + 4, key ? kKeyframe : 0, 2);
+        put_le(rec + 6, 0, 2);
+        put_le(rec + 8, intervals, 4);
+        put_le(rec + 12, crc32(payload.data(), payload.size()), 4);
+        put_le(rec + 16, static_cast<std::uint64_t>(ts), 8);
+        std::memcpy(rec + kRecHeader, payload.data(), payload.size());
+        // "used" per ultimo: dopo un crash il record parziale resta fuori dal segmento
+        put_le(seg.base + 40, seg.records() + 1, 8);
+        put_le(seg.base + 32, off + kRecHeader + payload.size(), 8);
+
+        if (key) {
+            lv.keyframes.push_back({ts, seg.seq, off});
+            lv.since_keyframe = 0;
+        }
+        ++lv.since_keyframe;
+        ++lv.records;
+        lv.has_last = true;
+        lv.last_ts = ts;
+        lv.last = counts;
+    }
+
+    void TimeSeriesStore::open_segment(std::size_t level) {
+        Level& lv = *levels_[level];
+        const std::uint64_t seq = lv.segments.empty() ? 0 : lv.segments.back().seq + 1;
+        if (!lv.segments.empty()) {
+            ::msync(lv.segments.back().base, lv.segments.back().size, MS_ASYNC);
+        }
+
+        const std::string path = dir_ + "/" + segment_name(level, seq);
+        Level::Segment seg = Level::map_segment(path, true, opt_.segment_bytes);
+        seg.seq = seq;
+        std::memset(seg.base, 0, kSegHeader);
+        std::memcpy(seg.base, kMagic, 4);
+        put_le(seg.base + 4, kVersion, 2);
+        seg.base[6] = static_cast<std::uint8_t>(level);
+        put_le(seg.base + 8, config_fingerprint(cfg_), 8);
+        put_le(seg.base + 16, cfg_.k, 4);
+        put_le(seg.base + 24, seq, 8);
+        put_le(seg.base + 32, kSegHeader, 8);
+        lv.segments.push_back(seg);
+
+        // anello: elimina i segmenti più vecchi
+        while (lv.segments.size() > lv.max_segments) {
+            Level::Segment& old = lv.segments.front();
+            lv.records -= old.records();
+            while (!lv.keyframes.empty() && lv.keyframes.front().seq == old.seq) lv.keyframes.pop_front();
+            ::munmap(old.base, old.size);
+            ::unlink(old.path.c_str());
+            lv.segments.pop_front();
+        }
+    }
+
+    void TimeSeriesStore::roll_up(std::size_t level, std::int64_t ts, const std::vector<std::size_t>& counts,
+                                  std::uint32_t intervals) {
+        Level& lv = *levels_[level];
+        const std::int64_t start = floor_to(ts, lv.period);
+        if (lv.has_pending && start != lv.pending_start) {
+            // periodo chiuso: scrive il rollup e lo propaga al livello superiore
+            put(level, lv.pending_start, lv.pending, static_cast<std::uint32_t>(lv.pending_intervals));
+            if (level + 1 < kLevels) {
+                roll_up(level + 1, lv.pending_start, lv.pending, static_cast<std::uint32_t>(lv.pending_intervals));
+            }
+            lv.has_pending = false;
+        }
+        if (!lv.has_pending) {
+            lv.has_pending = true;
+            lv.pending_start = start;
+            lv.pending.assign(counts.size(), 0);
+            lv.pending_intervals = 0;
+        }
+        for (std::size_t i = 0; i < counts.size(); ++i) lv.pending[i] += counts[i];
+        lv.pending_intervals += intervals;
+    }
+
+    void TimeSeriesStore::append(std::int64_t ts, const std::vector<std::size_t>& counts) {
+        if (counts.size() != cfg_.bucket_count()) {
+            throw std::invalid_argument("TimeSeriesStore::append: counts size does not match 2^k");
+        }
+        const Level& raw = *levels_[0];
+        if (raw.has_last && ts <= raw.last_ts) {
+            throw std::invalid_argument("TimeSeriesStore::append: timestamp " + std::to_string(ts) +
+                                        " not after " + std::to_string(raw.last_ts));
+        }
+        // prima i rollup dei periodi chiusi, poi l'intervallo: un crash tra i due non perde dati
+        roll_up(1, ts, counts, 1);
+        put(0, ts, counts, 1);
+    }
+
+    TimeSeriesRange TimeSeriesStore::query(std::int64_t begin, std::int64_t end) const {
+        TimeSeriesRange r;
+        const std::size_t buckets = cfg_.bucket_count();
+        r.counts.assign(buckets, 0);
+        if (!levels_[0]->has_last) return r;
+
+        // limita ai dati presenti: evita overflow negli arrotondamenti ai periodi
+        std::int64_t lo = levels_[0]->first_ts();
+        for (const auto& lv : levels_) {
+            if (lv->has_last) lo = std::min(lo, lv->first_ts());
+        }
+        begin = std::max(begin, lo);
+        end = std::min(end, levels_[0]->last_ts + 1);
+
+        auto add = [&](std::int64_t, const std::vector<std::size_t>& c, std::uint32_t n) {
+            for (std::size_t i = 0; i < buckets; ++i) r.counts[i] += c[i];
+            r.intervals += n;
+            ++r.records_read;
+        };
+
+        // giorni interi dal livello giornaliero, i bordi dal livello inferiore, ricorsivamente
+        std::function<void(std::size_t, std::int64_t, std::int64_t)> sum = [&](std::size_t l, std::int64_t b,
+                                                                                std::int64_t e) {
+            if (b >= e) return;
+            const Level& lv = *levels_[l];
+            if (l == 0) {
+                lv.scan(b, e, buckets, add);
+                return;
+            }
+            if (!lv.has_last) {
+                sum(l - 1, b, e);
+                return;
+            }
+            const std::int64_t pb = std::max(ceil_to(b, lv.period), lv.first_ts());
+            const std::int64_t pe = std::min(floor_to(e, lv.period), lv.last_ts + lv.period);
+            if (pb >= pe) {
+                sum(l - 1, b, e);
+                return;
+            }
+            lv.scan(pb, pe, buckets, add);
+            sum(l - 1, b, pb);
+            sum(l - 1, pe, e);
+        };
+        sum(kLevels - 1, begin, end);
+        return r;
+    }
+
+    std::int64_t TimeSeriesStore::first_timestamp() const noexcept {
+        std::int64_t first = 0;
+        bool any = false;
+        for (const auto& lv : levels_) {
+            if (!lv->has_last) continue;
+            first = any ? std::min(first, lv->first_ts()) : lv->first_ts();
+            any = true;
+        }
+        return first;
+    }
+
+    std::int64_t TimeSeriesStore::last_timestamp() const noexcept {
+        return levels_[0]->has_last ? levels_[0]->last_ts : 0;
+    }
+
+    std::uint64_t TimeSeriesStore::interval_count() const noexcept {
+        return levels_[0]->records;
+    }
+
+    void TimeSeriesStore::flush() {
+        for (const auto& lv : levels_) {
+            if (lv->segments.empty()) continue;
+            const auto& seg = lv->segments.back();
+            if (::msync(seg.base, seg.size, MS_SYNC) != 0) {
+                throw sys_error("Cannot msync time-series segment " + seg.path);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,159 @@
+#include "tb/trace.hpp"
+
+#include <unistd.h>
+
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace tb {
+
+    namespace {
+        struct ThreadBuffer {
+            std::uint32_t tid = 0;                     // traccia nel JSON, 1-based
+            std::unique_ptr<TraceEvent[]> events;
+            std::size_t capacity = 0;
+            std::atomic<std::size_t> size{0};          // scritto solo dal thread proprietario
+        };
+
+        struct Registry {
+            std::mutex mutex;                          // solo registrazione/rilascio/dump
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            std::vector<ThreadBuffer*> free;           // buffer di thread terminati, riusati
+            std::size_t capacity = std::size_t{1} << 16;
+            std::atomic<std::uint64_t> dropped{0};
+            std::uint64_t origin_ns = 0;
+        };
+
+        // mai distrutto: i thread_local dei thread ancora vivi all'uscita possono rilasciare dopo
+        Registry& registry() {
+            static Registry* r = new Registry;
+            return *r;
+        }
+
+        ThreadBuffer* acquire_buffer() noexcept {
+            Registry& r = registry();
+            try {
+                const std::lock_guard<std::mutex> lock{r.mutex};
+                if (!r.free.empty()) {
+                    ThreadBuffer* b = r.free.back();
+                    r.free.pop_back();
+                    return b;
+                }
+                auto b = std::make_unique<ThreadBuffer>();
+                b->tid = static_cast<std::uint32_t>(r.buffers.size() + 1);
+                b->events.reset(new TraceEvent[r.capacity]);   // non inizializzato: pagine toccate solo se usate
+                b->capacity = r.capacity;
+                r.buffers.push_back(std::move(b));
+                return r.buffers.back().get();
+            } catch (...) {
+                return nullptr;
+            }
+        }
+
+        // un thread che termina lascia i suoi eventi nel buffer; il prossimo thread continua sulla stessa traccia
+        struct ThreadSlot {
+            ThreadBuffer* buffer = nullptr;
+            ~ThreadSlot() {
+                if (buffer == nullptr) return;
+                Registry& r = registry();
+                const std::lock_guard<std::mutex> lock{r.mutex};
+                r.free.push_back(buffer);
+            }
+        };
+
+        thread_local ThreadSlot t_slot;
+
+        void write_us(std::ostream& os, std::uint64_t ns) {
+            const std::uint64_t frac = ns % 1000;
+            os << ns / 1000 << '.' << static_cast<char>('0' + frac / 100) << static_cast<char>('0' + frac / 10 % 10)
+               << static_cast<char>('0' + frac % 10);
+        }
+    }
+
+    std::uint64_t trace_clock_ns() noexcept {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    void start_tracing(std::size_t events_per_thread) {
+#if TB_TRACING
+        if (events_per_thread == 0) throw std::invalid_argument("start_tracing: events_per_thread must be > 0");
+        Registry& r = registry();
+        const std::lock_guard<std::mutex> lock{r.mutex};
+        r.capacity = events_per_thread;
+        for (auto& b : r.buffers) {
+            if (b->capacity != events_per_thread) {
+                b->events.reset(new TraceEvent[events_per_thread]);
+                b->capacity = events_per_thread;
+            }
+            b->size.store(0, std::memory_order_relaxed);
+        }
+        r.dropped.store(0, std::memory_order_relaxed);
+        r.origin_ns = trace_clock_ns();
+        detail::g_tracing.store(true, std::memory_order_release);
+#else
+        (void)events_per_thread;
+        throw std::logic_error("tracing is compiled out (TB_ENABLE_TRACING=OFF)");
+#endif
+    }
+
+    void stop_tracing() noexcept {
+        detail::g_tracing.store(false, std::memory_order_release);
+    }
+
+    std::uint64_t trace_dropped() noexcept {
+        return registry().dropped.load(std::memory_order_relaxed);
+    }
+
+    void trace_event(const TraceEvent& e) noexcept {
+#if TB_TRACING
+        ThreadBuffer* b = t_slot.buffer;
+        if (b == nullptr) {
+            b = acquire_buffer();
+            t_slot.buffer = b;
+        }
+        const std::size_t i = b != nullptr ? b->size.load(std::memory_order_relaxed) : 0;
+        if (b == nullptr || i == b->capacity) {
+            registry().dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        b->events[i] = e;
+        b->size.store(i + 1, std::memory_order_release);
+#else
+        (void)e;
+#endif
+    }
+
+    void write_chrome_trace(std::ostream& os) {
+        Registry& r = registry();
+        const std::lock_guard<std::mutex> lock{r.mutex};
+        const long pid = static_cast<long>(::getpid());
+        os << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"tool\":\"turbo-bucketizer\",\"dropped_events\":"
+           << r.dropped.load(std::memory_order_relaxed) << "},\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto& b : r.buffers) {
+            const std::size_t n = b->size.load(std::memory_order_acquire);
+            if (n == 0) continue;
+            os << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":"
+               << b->tid << ",\"args\":{\"name\":\"thread " << b->tid << "\"}}";
+            first = false;
+            for (std::size_t i = 0; i < n; ++i) {
+                const TraceEvent& e = b->events[i];
+                const std::uint64_t begin = e.begin_ns > r.origin_ns ? e.begin_ns - r.origin_ns : 0;
+                const std::uint64_t dur = e.end_ns > e.begin_ns ? e.end_ns - e.begin_ns : 0;
+                os << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"tb\",\"ph\":\"X\",\"pid\":" << pid
+                   << ",\"tid\":" << b->tid << ",\"ts\":";
+                write_us(os, begin);
+                os << ",\"dur\":";
+                write_us(os, dur);
+                os << ",\"args\":{\"items\":" << e.items << ",\"bytes\":" << e.bytes << "}}";
+            }
+        }
+        os << "\n]}\n";
+    }
+
+}
@@ -0,0 +1,203 @@
+#include "tb/tuning.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace tb {
+
+    namespace {
+        constexpr std::size_t kSequentialBelow = std::size_t{1} << 16;
+        constexpr std::size_t kPerThreadHistogramLimit = std::size_t{1} << 20;   // byte per istogramma privato
+        constexpr const char* kHeader = "tb-tuning 1";
+
+        unsigned hardware_threads() noexcept {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        unsigned k_distance(unsigned a, unsigned b) noexcept {
+            return a > b ? a - b : b - a;
+        }
+
+        [[noreturn]] void bad_line(std::size_t line_no, const std::string& line) {
+            throw std::runtime_error("Malformed tuning profile at line " + std::to_string(line_no) + ": '" + line + "'");
+        }
+
+        std::vector<std::size_t> run_choice(const BucketEngine& engine, const std::vector<IPv4>& ips,
+                                            const TuningChoice& c) {
+            return c.threads <= 1 ? engine.distribution(ips)
+                                  : parallel_distribution(engine, ips, c.threads, c.strategy);
+        }
+
+        // miglior tempo (ns) fra le ripetizioni che stanno in min_time_ms (almeno 2)
+        double best_ns(const BucketEngine& engine, const std::vector<IPv4>& ips, const TuningChoice& c,
+                       double min_time_ms) {
+            using clock = std::chrono::steady_clock;
+            double best = std::numeric_limits<double>::max();
+            double spent_ms = 0.0;
+            for (int rep = 0; rep < 2 || spent_ms < min_time_ms; ++rep) {
+                const auto t0 = clock::now();
+                const auto counts = run_choice(engine, ips, c);
+                const double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+                best = std::min(best, ns);
+                spent_ms += ns / 1e6;
+            }
+            return best;
+        }
+    }
+
+    TuningChoice default_tuning(unsigned k, std::size_t items) noexcept {
+        TuningChoice c;
+        if (items < kSequentialBelow) return c;
+        c.threads = hardware_threads();
+        const std::size_t histogram = (k >= 32 ? (std::size_t{1} << 32) : (std::size_t{1} << k)) * sizeof(std::size_t);
+        c.strategy = histogram > kPerThreadHistogramLimit ? HistogramStrategy::Partitioned : HistogramStrategy::PerThread;
+        return c;
+    }
+
+    TuningChoice TuningProfile::choose(unsigned k, std::size_t items) const noexcept {
+        if (entries.empty()) return default_tuning(k, items);
+        unsigned best_k = entries.front().k;
+        for (const auto& e : entries) {
+            if (k_distance(e.k, k) < k_distance(best_k, k)) best_k = e.k;
+        }
+        const TuningEntry* pick = nullptr;
+        const TuningEntry* smallest = nullptr;
+        for (const auto& e : entries) {
+            if (e.k != best_k) continue;
+            if (smallest == nullptr || e.min_items < smallest->min_items) smallest = &e;
+            if (e.min_items <= items && (pick == nullptr || e.min_items > pick->min_items)) pick = &e;
+        }
+        return (pick != nullptr ? pick : smallest)->choice;
+    }
+
+    std::string encode_tuning_profile(const TuningProfile& p) {
+        std::ostringstream os;
+        os << kHeader << '\n'
+           << "cpu " << p.cpu << '\n'
+           << "hardware_threads " << p.hardware_threads << '\n'
+           << "# k min_items threads strategy mitems_per_s\n";
+        for (const auto& e : p.entries) {
+            os << "entry " << e.k << ' ' << e.min_items << ' ' << e.choice.threads << ' '
+               << histogram_strategy_name(e.choice.strategy) << ' ' << std::fixed << std::setprecision(1)
+               << e.mitems_per_s << '\n';
+        }
+        return os.str();
+    }
+
+    TuningProfile decode_tuning_profile(const std::string& text) {
+        std::istringstream in{text};
+        std::string line;
+        if (!std::getline(in, line) || line != kHeader) {
+            throw std::runtime_error("Not a tuning profile (expected '" + std::string(kHeader) + "' header)");
+        }
+        TuningProfile p;
+        std::size_t line_no = 1;
+        while (std::getline(in, line)) {
+            ++line_no;
+            if (line.empty() || line[0] == '#') continue;
+            const auto space = line.find(' ');
+            const std::string key = line.substr(0, space);
+            const std::string rest = space == std::string::npos ? std::string{} : line.substr(space + 1);
+            if (key == "cpu") {
+                p.cpu = rest;
+            } else if (key == "hardware_threads") {
+                std::istringstream f{rest};
+                if (!(f >> p.hardware_threads)) bad_line(line_no, line);
+            } else if (key == "entry") {
+                std::istringstream f{rest};
+                TuningEntry e;
+                std::string strategy;
+                if (!(f >> e.k >> e.min_items >> e.choice.threads >> strategy >> e.mitems_per_s) ||
+                    e.k > 32 || e.choice.threads == 0) {
+                    bad_line(line_no, line);
+                }
+                try {
+                    e.choice.strategy = parse_histogram_strategy(strategy);
+                } catch (const std::runtime_error&) {
+                    bad_line(line_no, line);
+                }
+                p.entries.push_back(e);
+            } else {
+                bad_line(line_no, line);
+            }
+        }
+        return p;
+    }
+
+    TuningChoice choose_tuning(unsigned k, std::size_t items) noexcept {
+        const TuningProfile* p = tuning_profile();
+        return p != nullptr ? p->choose(k, items) : default_tuning(k, items);
+    }
+
+    std::vector<std::size_t> tuned_distribution(const BucketEngine& engine, const std::vector<IPv4>& ips) {
+        return run_choice(engine, ips, choose_tuning(engine.config().k, ips.size()));
+    }
+
+    void tuned_accumulate(const BucketEngine& engine, const IPv4* ips, std::size_t n,
+                          std::size_t* counts, std::size_t counts_size, std::pmr::memory_resource* scratch) {
+        const TuningChoice c = choose_tuning(engine.config().k, n);
+        parallel_accumulate(engine, ips, n, counts, counts_size, c.threads, c.strategy, scratch);
+    }
+
+    TuningProfile calibrate(const CalibrationOptions& opt, std::ostream* progress) {
+        if (opt.ks.empty() || opt.sizes.empty()) {
+            throw std::invalid_argument("calibrate: ks and sizes must not be empty");
+        }
+        TuningProfile p;
+        p.hardware_threads = hardware_threads();
+        const unsigned max_threads = opt.max_threads > 0 ? opt.max_threads : p.hardware_threads;
+
+        std::vector<TuningChoice> candidates{TuningChoice{}};
+        for (unsigned t = 2; t <= max_threads; t *= 2) {
+            for (const auto s : {HistogramStrategy::SharedAtomic, HistogramStrategy::PerThread, HistogramStrategy::Partitioned}) {
+                candidates.push_back(TuningChoice{t, s});
+            }
+        }
+
+        // indirizzi uniformi: la scelta dipende da k e dalla dimensione, non dalla distribuzione
+        const std::uint64_t largest = *std::max_element(opt.sizes.begin(), opt.sizes.end());
+        std::vector<IPv4> all(static_cast<std::size_t>(largest));
+        std::mt19937 rng{42};
+        for (auto& ip : all) ip = static_cast<IPv4>(rng());
+
+        for (const unsigned k : opt.ks) {
+            Config cfg;
+            cfg.k = k;
+            const BucketEngine engine{cfg};
+            for (const std::uint64_t n : opt.sizes) {
+                const std::vector<IPv4> ips(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(n));
+                TuningEntry best;
+                best.k = k;
+                best.min_items = n;
+                double best_time = std::numeric_limits<double>::max();
+                for (const auto& c : candidates) {
+                    if (c.threads > n) continue;
+                    const double ns = best_ns(engine, ips, c, opt.min_time_ms);
+                    if (ns < best_time) {
+                        best_time = ns;
+                        best.choice = c;
+                    }
+                }
+                best.mitems_per_s = static_cast<double>(n) / best_time * 1e3;
+                p.entries.push_back(best);
+                if (progress != nullptr) {
+                    *progress << "  k=" << std::setw(2) << k << "  n=" << std::setw(9) << n << "  -> ";
+                    if (best.choice.threads <= 1) {
+                        *progress << "sequential";
+                    } else {
+                        *progress << best.choice.threads << " threads, " << histogram_strategy_name(best.choice.strategy);
+                    }
+                    *progress << "  (" << std::fixed << std::setprecision(1) << best.mitems_per_s << " Mitems/s)\n";
+                }
+            }
+        }
+        return p;
+    }
+
+}
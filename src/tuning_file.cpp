@@ -0,0 +1,98 @@
+#include "tb/tuning_file.hpp"
+#include "tb/snapshot_file.hpp"
+
+#include <sys/stat.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace tb {
+
+    namespace {
+        std::string env(const char* name) {
+            const char* v = std::getenv(name);
+            return v != nullptr ? std::string{v} : std::string{};
+        }
+
+        std::string model_slug(const std::string& model) {
+            std::string slug;
+            for (const char ch : model) {
+                const auto c = static_cast<unsigned char>(ch);
+                if (std::isalnum(c) != 0) {
+                    slug += static_cast<char>(std::tolower(c));
+                } else if (!slug.empty() && slug.back() != '-') {
+                    slug += '-';
+                }
+            }
+            while (!slug.empty() && slug.back() == '-') slug.pop_back();
+            return slug.empty() ? "unknown" : slug;
+        }
+
+        // mkdir -p; EEXIST a ogni livello va bene
+        void make_dirs(const std::string& dir) {
+            for (std::size_t pos = 1; pos <= dir.size(); ++pos) {
+                if (pos < dir.size() && dir[pos] != '/') continue;
+                const std::string part = dir.substr(0, pos);
+                if (::mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) {
+                    throw std::runtime_error("Cannot create directory " + part + ": " + std::strerror(errno));
+                }
+            }
+        }
+    }
+
+    std::string cpu_model() {
+        std::ifstream cpuinfo{"/proc/cpuinfo"};
+        std::string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.rfind("model name", 0) == 0) {
+                const auto colon = line.find(':');
+                if (colon != std::string::npos && colon + 2 <= line.size()) return line.substr(colon + 2);
+            }
+        }
+        return "unknown";
+    }
+
+    std::string default_tuning_path() {
+        std::string dir = env("TB_TUNING_DIR");
+        if (dir.empty()) {
+            const std::string cache = env("XDG_CACHE_HOME");
+            if (!cache.empty()) {
+                dir = cache + "/turbo-bucketizer";
+            } else {
+                const std::string home = env("HOME");
+                if (home.empty()) return {};
+                dir = home + "/.cache/turbo-bucketizer";
+            }
+        }
+        return dir + "/tuning-" + model_slug(cpu_model()) + ".txt";
+    }
+
+    void save_tuning_profile(const std::string& path, const TuningProfile& p) {
+        const auto slash = path.rfind('/');
+        if (slash != std::string::npos && slash > 0) make_dirs(path.substr(0, slash));
+        const std::string text = encode_tuning_profile(p);
+        write_file_atomic(path, std::vector<std::uint8_t>(text.begin(), text.end()));
+    }
+
+    std::optional<TuningProfile> load_tuning_profile(const std::string& path) {
+        struct stat st{};
+        if (::stat(path.c_str(), &st) != 0 && errno == ENOENT) return std::nullopt;
+        std::ifstream in{path, std::ios::binary};
+        if (!in) {
+            throw std::runtime_error("Cannot open tuning profile: " + path);
+        }
+        std::ostringstream text;
+        text << in.rdbuf();
+        try {
+            return decode_tuning_profile(text.str());
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error(path + ": " + e.what());
+        }
+    }
+
+}
@@ -0,0 +1,161 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/arena.hpp"
+#include "tb/bucket_engine.hpp"
+#include "tb/dataset.hpp"
+#include "tb/ingest.hpp"
+#include "tb/memory.hpp"
+#include "tb/parallel.hpp"
+#include "tb/tuning.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<tb::IPv4> random_ips(std::size_t n, unsigned seed) {
+        std::mt19937 rng{seed};
+        std::vector<tb::IPv4> ips(n);
+        for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+        return ips;
+    }
+}
+
+TEST_CASE("Arena bumps, aligns, rolls back the last allocation and unmaps", "[arena]") {
+    const std::uint64_t before = tb::memory_usage(tb::MemCategory::Arena).current;
+    {
+        tb::ArenaOptions opt;
+        opt.block_bytes = 1u << 16;
+        opt.huge_pages = tb::HugePages::Off;
+        tb::Arena arena{opt};
+        REQUIRE(arena.block_count() == 0);   // nessuna mappatura prima del primo uso
+
+        void* a = arena.allocate(10, 1);
+        void* b = arena.allocate(64, 64);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(b) % 64 == 0);
+        REQUIRE(static_cast<char*>(b) >= static_cast<char*>(a) + 10);
+        REQUIRE(arena.allocated() == 74);
+
+        // solo l'ultima allocazione torna disponibile
+        arena.deallocate(a, 10, 1);
+        REQUIRE(arena.allocated() == 74);
+        arena.deallocate(b, 64, 64);
+        REQUIRE(arena.allocated() == 10);
+        REQUIRE(arena.allocate(64, 64) == b);
+        REQUIRE(arena.peak() == 74);
+
+        // reserve: quello che segue sta in un blocco solo, anche oltre block_bytes
+        arena.reserve(1u << 20);
+        REQUIRE(arena.block_count() == 2);
+        std::pmr::vector<std::uint32_t> big(&arena);
+        big.reserve((1u << 20) / sizeof(std::uint32_t));
+        REQUIRE(arena.block_count() == 2);
+        big.assign(big.capacity(), 7u);   // le pagine si scrivono davvero
+        REQUIRE(big.back() == 7u);
+
+        REQUIRE(arena.mapped() >= (1u << 20) + (1u << 16));
+        REQUIRE(tb::memory_usage(tb::MemCategory::Arena).current == before + arena.mapped());
+        REQUIRE(arena.is_equal(arena));
+        REQUIRE_FALSE(arena.is_equal(*std::pmr::new_delete_resource()));
+    }
+    REQUIRE(tb::memory_usage(tb::MemCategory::Arena).current == before);
+
+    // pagine enormi: esplicite senza pool riservato ripiegano su THP, mai un errore
+    tb::ArenaOptions huge;
+    huge.huge_pages = tb::HugePages::Explicit;
+    tb::Arena arena{huge};
+    std::pmr::vector<std::size_t> v(1000, 1, &arena);
+    REQUIRE(v[999] == 1);
+    REQUIRE(arena.mapped() % (std::size_t{2} << 20) == 0);
+
+    // un blocco più piccolo di una pagina enorme resta della sua misura (arrotondata alla pagina)
+    tb::ArenaOptions small;
+    small.block_bytes = 1u << 16;
+    small.huge_pages = tb::HugePages::Transparent;
+    tb::Arena small_arena{small};
+    std::pmr::vector<std::size_t> w(1000, 1, &small_arena);
+    REQUIRE(small_arena.mapped() < (std::size_t{2} << 20));
+    REQUIRE_FALSE(small_arena.huge_pages());
+
+    REQUIRE(tb::parse_huge_pages("thp") == tb::HugePages::Transparent);
+    REQUIRE(std::string{tb::huge_pages_name(tb::HugePages::Explicit)} == "explicit");
+    REQUIRE_THROWS_AS(tb::parse_huge_pages("always"), std::runtime_error);
+}
+
+TEST_CASE("std::pmr overloads match the heap APIs and allocate from the resource", "[arena]") {
+    const auto ips = random_ips(40'000, 5);
+    tb::Config cfg;
+    cfg.k = 9;
+    const tb::BucketEngine engine{cfg};
+    const auto expected = engine.distribution(ips);
+    tb::Arena arena;
+
+    const auto idx = engine.bucketize(ips.data(), ips.size(), &arena);
+    REQUIRE(idx.get_allocator().resource() == &arena);
+    REQUIRE(std::vector<tb::BucketIndex>(idx.begin(), idx.end()) == engine.bucketize(ips));
+    const auto counts = engine.distribution(ips.data(), ips.size(), &arena);
+    REQUIRE(std::vector<std::size_t>(counts.begin(), counts.end()) == expected);
+
+    // scratch condiviso da tutti i thread
+    for (const auto s : {tb::HistogramStrategy::SharedAtomic, tb::HistogramStrategy::PerThread,
+                         tb::HistogramStrategy::Partitioned}) {
+        INFO(tb::histogram_strategy_name(s));
+        const std::size_t used = arena.allocated();
+        const auto par = tb::parallel_distribution(engine, ips.data(), ips.size(), 4, s, &arena);
+        REQUIRE(std::vector<std::size_t>(par.begin(), par.end()) == expected);
+        REQUIRE(arena.allocated() > used);
+    }
+
+    // parallel_accumulate somma a un istogramma esistente
+    std::vector<std::size_t> twice = expected;
+    tb::parallel_accumulate(engine, ips.data(), ips.size(), twice.data(), twice.size(), 3,
+                            tb::HistogramStrategy::PerThread, &arena);
+    for (std::size_t b = 0; b < twice.size(); ++b) REQUIRE(twice[b] == 2 * expected[b]);
+    std::vector<std::size_t> tuned(cfg.bucket_count(), 0);
+    tb::tuned_accumulate(engine, ips.data(), ips.size(), tuned.data(), tuned.size(), &arena);
+    REQUIRE(tuned == expected);
+    REQUIRE_THROWS_AS(tb::parallel_accumulate(engine, ips.data(), ips.size(), tuned.data(), 3, 2,
+                                              tb::HistogramStrategy::PerThread),
+                      std::invalid_argument);
+
+    auto data = tb::Dataset::view(ips, 1024);
+    const auto parts = tb::partition(engine, data, 3, 2, &arena);
+    std::size_t total = 0;
+    for (const auto& p : parts) {
+        REQUIRE(p.get_allocator().resource() == &arena);
+        total += p.size();
+    }
+    REQUIRE(total == ips.size());
+}
+
+TEST_CASE("read_ipv4_file presized in an arena never reallocates", "[arena][ingest]") {
+    const auto ips = random_ips(30'000, 6);
+    const std::string path = "tb_test_arena.bin";
+    {
+        std::ofstream f{path, std::ios::binary};
+        for (const tb::IPv4 ip : ips) {
+            const char be[4] = {static_cast<char>(ip >> 24), static_cast<char>(ip >> 16),
+                                static_cast<char>(ip >> 8), static_cast<char>(ip)};
+            f.write(be, 4);
+        }
+    }
+    tb::IngestOptions opt;
+    opt.format = tb::InputFormat::Binary;
+    const std::uint64_t bound = tb::max_address_count(path, opt).value();
+
+    tb::ArenaOptions aopt;
+    aopt.block_bytes = 4096;
+    tb::Arena arena{aopt};
+    arena.reserve(bound * sizeof(tb::IPv4));
+    const auto read = tb::read_ipv4_file(path, opt, &arena, bound);
+    std::remove(path.c_str());
+
+    REQUIRE(std::vector<tb::IPv4>(read.begin(), read.end()) == ips);
+    REQUIRE(read.capacity() == bound);
+    REQUIRE(arena.allocated() == bound * sizeof(tb::IPv4));   // un'allocazione, nessuna copia
+    REQUIRE(arena.block_count() == 1);
+}
@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/bucket_engine_fixed.hpp"
+
+#include <random>
+#include <vector>
+
+namespace {
+    // formula di riferimento, indipendente da entrambi gli engine
+    tb::BucketIndex reference(const tb::Config& c, tb::IPv4 ip) {
+        const auto y = static_cast<std::uint32_t>(static_cast<std::uint64_t>(c.a) * ip + c.b);
+        if (c.k == 0) return 0;
+        if (c.k >= 32) return y;
+        return y >> (32 - c.k);
+    }
+
+    constexpr tb::BucketEngineFixed<12> kConstEngine{0x9E3779B1u, 0x85EBCA77u};
+    static_assert(kConstEngine.bucket_index(0) == (0x85EBCA77u >> 20));
+    static_assert(tb::BucketEngineFixed<0>{}.bucket_index(0xFFFFFFFFu) == 0);
+    static_assert(tb::BucketEngineFixed<32>{1u, 0u}.bucket_index(0xDEADBEEFu) == 0xDEADBEEFu);
+    static_assert(tb::BucketEngineFixed<16>::bucket_count == 65536);
+}
+
+TEST_CASE("BucketEngineFixed matches the runtime engine", "[bucket_engine_fixed]") {
+    std::mt19937 rng{5};
+    std::vector<tb::IPv4> ips(777);
+    for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+
+    tb::Config cfg;
+    cfg.a = 0x2545F491u;
+    cfg.b = 0x1234567u;
+    cfg.k = 12;
+    const tb::BucketEngineFixed<12> fixed{cfg};
+    const tb::BucketEngine engine{cfg};
+    REQUIRE(fixed.config().k == 12);
+    REQUIRE(fixed.config().a == cfg.a);
+
+    std::vector<tb::BucketIndex> out(ips.size());
+    fixed.bucketize(ips.data(), ips.size(), out.data());
+    REQUIRE(out == engine.bucketize(ips));
+
+    std::vector<std::size_t> counts(fixed.bucket_count, 0);
+    fixed.accumulate(ips.data(), ips.size(), counts.data());
+    REQUIRE(counts == engine.distribution(ips));
+
+    const std::vector<std::size_t> weights(ips.size(), 3);
+    std::vector<std::size_t> weighted(fixed.bucket_count, 0);
+    fixed.accumulate(ips.data(), weights.data(), ips.size(), weighted.data());
+    REQUIRE(weighted == engine.distribution(ips, weights));
+}
+
+TEST_CASE("Runtime engine dispatches to the right kernel for every k", "[bucket_engine_fixed][bucket_engine]") {
+    std::mt19937 rng{17};
+    std::vector<tb::IPv4> ips(300);
+    for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+    ips.push_back(0);
+    ips.push_back(0xFFFFFFFFu);
+
+    for (unsigned k = 0; k <= 33; ++k) {
+        INFO("k = " << k);
+        tb::Config cfg;
+        cfg.k = k;
+        const tb::BucketEngine engine{cfg};
+        const auto out = engine.bucketize(ips);
+        for (std::size_t i = 0; i < ips.size(); ++i) {
+            REQUIRE(engine.bucket_index(ips[i]) == reference(cfg, ips[i]));
+            REQUIRE(out[i] == reference(cfg, ips[i]));
+        }
+        if (k <= 20) {
+            std::vector<std::size_t> expected(cfg.bucket_count(), 0);
+            for (const auto ip : ips) expected[reference(cfg, ip)] += 1;
+            REQUIRE(engine.distribution(ips) == expected);
+        }
+    }
+}
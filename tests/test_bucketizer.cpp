@@ -2,9 +2,12 @@
 #include <catch2/catch_approx.hpp>
 
 #include "tb/bucket_engine.hpp"
+#include "tb/presets.hpp"
 #include "tb/stats.hpp"
 
+#include <array>
 #include <random>
+#include <stdexcept>
 #include <limits>
 #include <vector>
 
@@ -57,6 +60,32 @@ TEST_CASE("compute_stats on perfectly uniform synthetic data", "[stats]") {
     REQUIRE(stats.stddev == Approx(0.0).margin(1e-9));
     REQUIRE(stats.chi2 == Approx(0.0).margin(1e-9));
     REQUIRE(stats.uniformity == Approx(100.0).margin(1e-6));
+    REQUIRE(stats.p_value == Approx(1.0));
+}
+
+TEST_CASE("chi-square p-values match reference quantiles", "[stats]") {
+    // quantili al 5% e all'1% delle tavole
+    REQUIRE(tb::chi2_p_value(3.841459, 1) == Approx(0.05).epsilon(1e-4));
+    REQUIRE(tb::chi2_p_value(124.3421, 100) == Approx(0.05).epsilon(1e-4));
+    REQUIRE(tb::chi2_p_value(135.8067, 100) == Approx(0.01).epsilon(1e-4));
+    REQUIRE(tb::chi2_p_value(0.0, 10) == 1.0);
+
+    // tutto in un bucket: uniformità rifiutata
+    std::vector<std::size_t> skewed(64, 0);
+    skewed[0] = 6400;
+    REQUIRE(tb::compute_stats(skewed).p_value < 1e-12);
+}
+
+TEST_CASE("Presets are available from the library", "[presets]") {
+    REQUIRE(tb::presets().front().name == "default");
+    tb::Config cfg;
+    cfg.k = 16;
+    tb::apply_preset(cfg, "wang");
+    REQUIRE(cfg.a == 0x27D4EB2Du);
+    REQUIRE(cfg.b == 0x165667B1u);
+    REQUIRE(cfg.k == 16);
+    REQUIRE(tb::find_preset("nope") == nullptr);
+    REQUIRE_THROWS_AS(tb::apply_preset(cfg, "nope"), std::runtime_error);
 }
 
 TEST_CASE("Determinism: same IPs, same config -> same buckets", "[bucket_engine]") {
@@ -103,3 +132,40 @@ TEST_CASE("Determinism: same IPs, same config -> same buckets", "[bucket_engine]
     REQUIRE(stats.sample_count == ips.size());
     REQUIRE(stats.bucket_count == cfg.bucket_count());
 }
+
+TEST_CASE("Pointer + length batch APIs match the vector ones", "[bucket_engine]") {
+    tb::Config cfg;
+    cfg.k = 10;
+    tb::BucketEngine engine{cfg};
+
+    std::mt19937 rng{99};
+    std::vector<tb::IPv4> ips(5000);
+    for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+    std::vector<std::size_t> weights(ips.size());
+    for (auto& w : weights) w = 1 + rng() % 1500;
+
+    std::vector<tb::BucketIndex> out(ips.size());
+    engine.bucketize(ips.data(), ips.size(), out.data());
+    REQUIRE(out == engine.bucketize(ips));
+
+    // accumulate adds to what is already there, batch after batch
+    std::vector<std::size_t> counts(cfg.bucket_count(), 0);
+    engine.accumulate(ips.data(), 2000, counts.data(), counts.size());
+    engine.accumulate(ips.data() + 2000, ips.size() - 2000, counts.data(), counts.size());
+    REQUIRE(counts == engine.distribution(ips));
+
+    std::vector<std::size_t> weighted(cfg.bucket_count(), 0);
+    engine.accumulate(ips.data(), weights.data(), ips.size(), weighted.data(), weighted.size());
+    REQUIRE(weighted == engine.distribution(ips, weights));
+
+    // any contiguous storage, no copy into std::vector<IPv4>
+    const std::array<tb::IPv4, 3> arr = {ips[0], ips[1], ips[0]};
+    std::array<std::size_t, 1024> small{};
+    engine.accumulate(arr.data(), arr.size(), small.data(), small.size());
+    REQUIRE(small[engine.bucket_index(ips[0])] >= 2);
+
+    engine.accumulate(ips.data(), 0, counts.data(), counts.size());
+    REQUIRE(counts == engine.distribution(ips));
+    REQUIRE_THROWS_AS(engine.accumulate(ips.data(), ips.size(), counts.data(), counts.size() - 1),
+                      std::invalid_argument);
+}
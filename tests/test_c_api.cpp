@@ -0,0 +1,126 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/c_api.h"
+#include "tb/stats.hpp"
+
+#include <dlfcn.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<tb::IPv4> random_ips(std::size_t n, unsigned seed) {
+        std::mt19937 rng{seed};
+        std::vector<tb::IPv4> ips(n);
+        for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+        return ips;
+    }
+}
+
+TEST_CASE("C ABI matches BucketEngine and compute_stats", "[c_api]") {
+    REQUIRE(tb_abi_version() == TB_ABI_VERSION);
+    REQUIRE(std::string{tb_version()} != "");
+
+    tb_config cfg;
+    tb_config_default(&cfg);
+    const tb::Config defaults;
+    REQUIRE(cfg.a == defaults.a);
+    REQUIRE(cfg.b == defaults.b);
+    REQUIRE(cfg.k == defaults.k);
+    cfg.k = 10;
+
+    tb_engine* engine = nullptr;
+    REQUIRE(tb_engine_create(&cfg, &engine) == TB_OK);
+    REQUIRE(engine != nullptr);
+    tb::Config cxx_cfg;
+    cxx_cfg.a = cfg.a;
+    cxx_cfg.b = cfg.b;
+    cxx_cfg.k = cfg.k;
+    const tb::BucketEngine cxx{cxx_cfg};
+
+    tb_config back{};
+    REQUIRE(tb_engine_config(engine, &back) == TB_OK);
+    REQUIRE(back.k == 10);
+    REQUIRE(tb_engine_bucket_count(engine) == 1024);
+
+    const auto ips = random_ips(20'000, 11);
+    REQUIRE(tb_bucket_index(engine, ips[0]) == cxx.bucket_index(ips[0]));
+
+    std::vector<std::uint32_t> idx(ips.size());
+    REQUIRE(tb_bucketize(engine, ips.data(), ips.size(), idx.data()) == TB_OK);
+    REQUIRE(idx == cxx.bucketize(ips));
+
+    // accumulate somma a un istogramma esistente
+    const auto expected = cxx.distribution(ips);
+    std::vector<std::size_t> counts(1024, 0);
+    REQUIRE(tb_accumulate(engine, ips.data(), ips.size(), counts.data(), counts.size()) == TB_OK);
+    REQUIRE(counts == expected);
+    REQUIRE(tb_accumulate(engine, ips.data(), ips.size(), counts.data(), counts.size()) == TB_OK);
+    for (std::size_t b = 0; b < counts.size(); ++b) REQUIRE(counts[b] == 2 * expected[b]);
+
+    const std::vector<std::size_t> weights(ips.size(), 3);
+    std::vector<std::size_t> weighted(1024, 0);
+    REQUIRE(tb_accumulate_weighted(engine, ips.data(), weights.data(), ips.size(),
+                                   weighted.data(), weighted.size()) == TB_OK);
+    for (std::size_t b = 0; b < weighted.size(); ++b) REQUIRE(weighted[b] == 3 * expected[b]);
+
+    tb_stats st{};
+    REQUIRE(tb_stats_compute(expected.data(), expected.size(), &st) == TB_OK);
+    const tb::StatsResult r = tb::compute_stats(expected);
+    REQUIRE(st.sample_count == r.sample_count);
+    REQUIRE(st.bucket_count == r.bucket_count);
+    REQUIRE(st.chi2 == r.chi2);
+    REQUIRE(st.p_value == r.p_value);
+    REQUIRE(st.uniformity == r.uniformity);
+    REQUIRE(st.max_load == r.max_load);
+
+    tb_engine_destroy(engine);
+    tb_engine_destroy(nullptr);
+}
+
+TEST_CASE("C ABI reports errors as status codes and leaves outputs untouched", "[c_api]") {
+    tb_config cfg;
+    tb_config_default(&cfg);
+    tb_engine* engine = nullptr;
+    cfg.k = 33;
+    REQUIRE(tb_engine_create(&cfg, &engine) == TB_ERR_CONFIG);
+    REQUIRE(engine == nullptr);
+    REQUIRE(tb_engine_create(nullptr, &engine) == TB_ERR_NULL);
+    cfg.k = 4;
+    REQUIRE(tb_engine_create(&cfg, nullptr) == TB_ERR_NULL);
+    REQUIRE(tb_engine_create(&cfg, &engine) == TB_OK);
+
+    const std::uint32_t ip = 0x0A000001u;
+    std::vector<std::size_t> counts(15, 7);
+    REQUIRE(tb_accumulate(engine, &ip, 1, counts.data(), counts.size()) == TB_ERR_SIZE);
+    REQUIRE(counts == std::vector<std::size_t>(15, 7));
+    REQUIRE(tb_accumulate(engine, nullptr, 1, counts.data(), 16) == TB_ERR_NULL);
+    REQUIRE(tb_accumulate_weighted(engine, &ip, nullptr, 1, counts.data(), 16) == TB_ERR_NULL);
+    REQUIRE(tb_bucketize(nullptr, &ip, 1, nullptr) == TB_ERR_NULL);
+    // n == 0: i puntori ai dati possono mancare
+    REQUIRE(tb_bucketize(engine, nullptr, 0, nullptr) == TB_OK);
+    REQUIRE(tb_stats_compute(nullptr, 0, nullptr) == TB_ERR_NULL);
+    REQUIRE(tb_engine_bucket_count(nullptr) == 0);
+
+    REQUIRE(std::string{tb_status_string(TB_ERR_SIZE)}.find("bucket count") != std::string::npos);
+    tb_engine_destroy(engine);
+}
+
+TEST_CASE("the shared library exports only the tb_* C symbols", "[c_api]") {
+    void* lib = ::dlopen(TB_SHARED_LIB_PATH, RTLD_NOW | RTLD_LOCAL);
+    REQUIRE(lib != nullptr);
+
+    using AbiFn = std::uint32_t (*)();
+    const auto abi = reinterpret_cast<AbiFn>(::dlsym(lib, "tb_abi_version"));
+    REQUIRE(abi != nullptr);
+    REQUIRE(abi() == TB_ABI_VERSION);
+    REQUIRE(::dlvsym(lib, "tb_engine_create", "TB_1") != nullptr);
+
+    // l'API C++ resta interna: visibilità nascosta più lo script di versione
+    REQUIRE(::dlsym(lib, "_ZN2tb13compute_statsERKSt6vectorImSaImEE") == nullptr);
+    REQUIRE(::dlsym(lib, "_ZNK2tb12BucketEngine9bucketizeEPKjmPj") == nullptr);
+    ::dlclose(lib);
+}
@@ -0,0 +1,224 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/checkpoint.hpp"
+#include "tb/snapshot_file.hpp"
+
+#ifndef TB_HAVE_ZLIB
+#define TB_HAVE_ZLIB 0
+#endif
+#if TB_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    // ~3.6 MiB di testo: più blocchi di lettura da 1 MiB, righe a cavallo dei blocchi
+    std::string random_text(std::size_t lines, unsigned seed) {
+        std::mt19937 rng{seed};
+        std::string s;
+        for (std::size_t i = 0; i < lines; ++i) {
+            if (i % 1000 == 7) s += "# comment\n";
+            const std::uint32_t ip = rng();
+            s += std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 255) + "." +
+                 std::to_string((ip >> 8) & 255) + "." + std::to_string(ip & 255) + "\n";
+        }
+        return s;
+    }
+
+    void write_file(const std::string& path, const std::string& content) {
+        std::ofstream f{path, std::ios::binary};
+        f << content;
+    }
+
+    bool exists(const std::string& path) {
+        return std::ifstream{path}.good();
+    }
+
+    // esecuzione interrotta dopo `stop_after` checkpoint, come un processo ucciso
+    tb::ResumableRun run_until(const std::string& input, const tb::IngestOptions& opt, const tb::BucketEngine& engine,
+                               std::vector<std::size_t>& counts, const std::string& ck_path, bool resume,
+                               std::uint64_t stop_after, std::vector<tb::IngestCheckpoint>* seen = nullptr) {
+        tb::CheckpointOptions ck;
+        ck.path = ck_path;
+        ck.interval_seconds = 0;
+        ck.interval_bytes = 1;   // dopo ogni blocco letto
+        ck.resume = resume;
+        std::uint64_t written = 0;
+        ck.on_checkpoint = [&](const tb::IngestCheckpoint& c) {
+            if (seen != nullptr) seen->push_back(c);
+            return ++written < stop_after;
+        };
+        return tb::accumulate_ipv4_file_resumable(input, opt, engine, counts, ck);
+    }
+}
+
+TEST_CASE("interrupted runs resume and count every address exactly once", "[checkpoint]") {
+    const std::string input = "tb_test_checkpoint.txt";
+    const std::string ck_path = "tb_test_checkpoint.ckpt";
+    const std::string content = random_text(250'000, 1);
+    write_file(input, content);
+    std::remove(ck_path.c_str());
+
+    tb::Config cfg;
+    cfg.k = 10;
+    const tb::BucketEngine engine{cfg};
+    std::vector<std::size_t> expected(cfg.bucket_count(), 0);
+    const std::uint64_t total = tb::accumulate_ipv4_file(input, {}, engine, expected);
+
+    // una fermata per checkpoint: ogni ripresa parte dall'ultimo
+    std::vector<std::size_t> counts(cfg.bucket_count(), 0);
+    std::vector<tb::IngestCheckpoint> seen;
+    tb::ResumableRun run = run_until(input, {}, engine, counts, ck_path, false, 1, &seen);
+    std::size_t restarts = 0;
+    while (!run.complete) {
+        REQUIRE(exists(ck_path));
+        std::vector<std::size_t> fresh(cfg.bucket_count(), 0);   // il processo nuovo non ha niente in memoria
+        run = run_until(input, {}, engine, fresh, ck_path, true, 1, &seen);
+        REQUIRE(run.resumed);
+        REQUIRE(run.resumed_offset == seen[seen.size() - (run.complete ? 1 : 2)].offset);
+        counts = fresh;
+        ++restarts;
+    }
+    REQUIRE(restarts >= 3);
+    REQUIRE(counts == expected);
+    REQUIRE(run.samples == total);
+    REQUIRE(run.input_bytes == content.size());
+    REQUIRE_FALSE(exists(ck_path));   // rimosso a fine input
+
+    for (std::size_t i = 0; i < seen.size(); ++i) {
+        const auto& c = seen[i];
+        REQUIRE(c.sequence == i + 1);
+        REQUIRE(c.offset > 0);
+        REQUIRE(content[c.offset - 1] == '\n');   // sempre su un confine di record
+        std::uint64_t sum = 0;
+        for (const auto n : c.histogram.counts) sum += n;
+        REQUIRE(sum == c.samples);
+    }
+
+    // --resume senza checkpoint: esecuzione completa da zero
+    std::vector<std::size_t> again(cfg.bucket_count(), 0);
+    run = run_until(input, {}, engine, again, ck_path, true, 100);
+    REQUIRE_FALSE(run.resumed);
+    REQUIRE(run.complete);
+    REQUIRE(again == expected);
+    std::remove(input.c_str());
+}
+
+TEST_CASE("checkpoint files are snapshots and refuse mismatched resumes", "[checkpoint]") {
+    const std::string input = "tb_test_checkpoint_csv.csv";
+    const std::string ck_path = "tb_test_checkpoint_csv.ckpt";
+    std::string content = "ip,bytes\n";
+    {
+        std::mt19937 rng{2};
+        for (int i = 0; i < 150'000; ++i) {
+            content += "10." + std::to_string(rng() % 256) + "." + std::to_string(rng() % 256) + ".1,123\n";
+        }
+    }
+    content += "not-an-ip,0\n";   // riga 150'002
+    write_file(input, content);
+    std::remove(ck_path.c_str());
+
+    tb::IngestOptions opt;
+    opt.format = tb::InputFormat::Csv;
+    tb::Config cfg;
+    cfg.k = 8;
+    const tb::BucketEngine engine{cfg};
+    std::vector<std::size_t> counts(cfg.bucket_count(), 0);
+    REQUIRE_FALSE(run_until(input, opt, engine, counts, ck_path, false, 1).complete);
+
+    const tb::IngestCheckpoint ck = tb::read_checkpoint_file(ck_path);
+    REQUIRE(ck.input == input);
+    REQUIRE(ck.format == tb::InputFormat::Csv);
+    REQUIRE(ck.lines > 1);
+    REQUIRE(ck.histogram.cfg.k == 8);
+    const tb::MappedSnapshot snap{ck_path};   // formato snapshot: tb_merge lo legge
+    REQUIRE(snap.view().total() == ck.samples);
+
+    // la ripresa non rilegge l'intestazione e i numeri di riga proseguono
+    std::vector<std::size_t> resumed(cfg.bucket_count(), 0);
+    try {
+        run_until(input, opt, engine, resumed, ck_path, true, 100);
+        FAIL("invalid line not reported");
+    } catch (const std::runtime_error& e) {
+        REQUIRE(std::string{e.what()}.find("line 150002") != std::string::npos);
+    }
+
+    tb::Config other = cfg;
+    other.k = 9;
+    const tb::BucketEngine other_engine{other};
+    std::vector<std::size_t> other_counts(other.bucket_count(), 0);
+    REQUIRE_THROWS_AS(run_until(input, opt, other_engine, other_counts, ck_path, true, 100), std::runtime_error);
+    REQUIRE_THROWS_AS(run_until(input, {}, engine, resumed, ck_path, true, 100), std::runtime_error);
+
+    write_file(input, content + "10.0.0.1,1\n");   // input cambiato
+    REQUIRE_THROWS_AS(run_until(input, opt, engine, resumed, ck_path, true, 100), std::runtime_error);
+
+    tb::write_snapshot_file(ck_path, tb::HistogramSnapshot{cfg, counts, "source=demo\n"});
+    REQUIRE_THROWS_AS(tb::read_checkpoint_file(ck_path), std::runtime_error);
+    std::remove(ck_path.c_str());
+    std::remove(input.c_str());
+}
+
+TEST_CASE("binary and gzip input resume at the checkpointed offset", "[checkpoint]") {
+    tb::Config cfg;
+    cfg.k = 12;
+    const tb::BucketEngine engine{cfg};
+    const std::string ck_path = "tb_test_checkpoint_bin.ckpt";
+    std::remove(ck_path.c_str());
+
+    std::string bin;
+    std::mt19937 rng{3};
+    for (int i = 0; i < 700'000; ++i) {
+        const std::uint32_t ip = rng();
+        const char be[4] = {static_cast<char>(ip >> 24), static_cast<char>(ip >> 16),
+                            static_cast<char>(ip >> 8), static_cast<char>(ip)};
+        bin.append(be, 4);
+    }
+    const std::string bin_path = "tb_test_checkpoint.bin";
+    write_file(bin_path, bin);
+    tb::IngestOptions opt;
+    opt.format = tb::InputFormat::Binary;
+
+    std::vector<std::size_t> expected(cfg.bucket_count(), 0);
+    tb::accumulate_ipv4_file(bin_path, opt, engine, expected);
+    std::vector<std::size_t> counts(cfg.bucket_count(), 0);
+    REQUIRE_FALSE(run_until(bin_path, opt, engine, counts, ck_path, false, 2).complete);
+    counts.assign(counts.size(), 0);
+    const tb::ResumableRun run = run_until(bin_path, opt, engine, counts, ck_path, true, 100);
+    REQUIRE(run.complete);
+    REQUIRE(run.resumed_offset % 4 == 0);
+    REQUIRE(run.resumed_offset > 0);
+    REQUIRE(counts == expected);
+    std::remove(bin_path.c_str());
+
+    if (!tb::gzip_supported()) {
+        SUCCEED("gzip input not supported in this build");
+        return;
+    }
+#if TB_HAVE_ZLIB
+    const std::string text = random_text(200'000, 4);
+    const std::string gz_path = "tb_test_checkpoint.txt.gz";
+    {
+        gzFile gz = gzopen(gz_path.c_str(), "wb");
+        REQUIRE(gz != nullptr);
+        gzwrite(gz, text.data(), static_cast<unsigned>(text.size()));
+        gzclose(gz);
+    }
+    std::vector<std::size_t> gz_expected(cfg.bucket_count(), 0);
+    tb::accumulate_ipv4_file(gz_path, {}, engine, gz_expected);
+    std::vector<std::size_t> gz_counts(cfg.bucket_count(), 0);
+    REQUIRE_FALSE(run_until(gz_path, {}, engine, gz_counts, ck_path, false, 1).complete);
+    gz_counts.assign(gz_counts.size(), 0);
+    const tb::ResumableRun gz_run = run_until(gz_path, {}, engine, gz_counts, ck_path, true, 100);
+    REQUIRE(gz_run.resumed);
+    REQUIRE(text[gz_run.resumed_offset - 1] == '\n');   // offset sui byte decompressi
+    REQUIRE(gz_counts == gz_expected);
+    std::remove(gz_path.c_str());
+#endif
+}
@@ -0,0 +1,188 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/dataset.hpp"
+#include "tb/ingest.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<tb::IPv4> random_ips(std::size_t n, unsigned seed) {
+        std::mt19937 rng{seed};
+        std::vector<tb::IPv4> ips(n);
+        for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+        return ips;
+    }
+
+    // stream che consegna `ips` a pezzi irregolari (mai più di capacity)
+    tb::Dataset stream_of(const std::vector<tb::IPv4>& ips, std::size_t chunk) {
+        std::size_t pos = 0;
+        std::size_t step = 0;
+        return tb::Dataset::stream([&ips, pos, step](tb::IPv4* out, std::size_t*, std::size_t capacity) mutable {
+            step = step % 7 + 1;
+            const std::size_t n = std::min({capacity, capacity / step + 1, ips.size() - pos});
+            std::copy_n(ips.data() + pos, n, out);
+            pos += n;
+            return n;
+        }, false, chunk);
+    }
+}
+
+TEST_CASE("Dataset chunks cover every row once, aligned and in order", "[dataset]") {
+    const auto ips = random_ips(10'000, 1);
+    auto data = tb::Dataset::view(ips, 1000);
+    REQUIRE(data.chunk_size() == 1008);   // arrotondato a 16 righe
+    REQUIRE(data.is_view());
+    REQUIRE(data.size() == ips.size());
+    REQUIRE(data.worker_count(64) == 10);
+
+    std::uint64_t next = 0;
+    data.for_each_chunk([&](const tb::Chunk& c, unsigned t) {
+        REQUIRE(t == 0);
+        REQUIRE(c.first == next);
+        REQUIRE(c.ips == ips.data() + c.first);   // vista: nessuna copia
+        REQUIRE(c.weights == nullptr);
+        REQUIRE((c.size == data.chunk_size() || c.first + c.size == ips.size()));
+        next += c.size;
+    });
+    REQUIRE(next == ips.size());
+
+    auto stream = stream_of(ips, 1000);
+    REQUIRE_FALSE(stream.is_view());
+    next = 0;
+    stream.for_each_chunk([&](const tb::Chunk& c, unsigned) {
+        REQUIRE(c.first == next);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(c.ips) % 64 == 0);
+        REQUIRE(std::equal(c.ips, c.ips + c.size, ips.begin() + static_cast<std::ptrdiff_t>(c.first)));
+        next += c.size;
+    });
+    REQUIRE(next == ips.size());
+    REQUIRE(stream.size() == ips.size());
+    REQUIRE_THROWS_AS(stream.for_each_chunk([](const tb::Chunk&, unsigned) {}), std::logic_error);
+
+    REQUIRE_THROWS_AS(tb::Dataset::view(ips, 0), std::invalid_argument);
+}
+
+TEST_CASE("Dataset entry points match the vector APIs for views and streams, in parallel", "[dataset]") {
+    const auto ips = random_ips(50'000, 2);
+    tb::Config cfg;
+    cfg.k = 10;
+    const tb::BucketEngine engine{cfg};
+    const auto expected = engine.distribution(ips);
+    const auto expected_idx = engine.bucketize(ips);
+
+    for (const unsigned threads : {1u, 3u, 8u}) {
+        INFO("threads = " << threads);
+        auto view = tb::Dataset::view(ips, 4096);
+        REQUIRE(tb::distribution(engine, view, threads) == expected);
+        auto stream = stream_of(ips, 4096);
+        REQUIRE(tb::distribution(engine, stream, threads) == expected);
+        REQUIRE(stream.size() == ips.size());
+
+        std::vector<tb::BucketIndex> idx(ips.size());
+        auto s2 = stream_of(ips, 4096);
+        REQUIRE(tb::bucketize(engine, s2, idx.data(), idx.size(), threads) == ips.size());
+        REQUIRE(idx == expected_idx);
+
+        auto s3 = stream_of(ips, 4096);
+        const auto stats = tb::compute_stats(engine, s3, threads);
+        REQUIRE(stats.max_load == tb::compute_stats(expected).max_load);
+
+        auto s4 = stream_of(ips, 4096);
+        const auto parts = tb::partition(engine, s4, 5, threads);
+        REQUIRE(parts.size() == 5);
+        std::size_t total = 0;
+        for (unsigned p = 0; p < 5; ++p) {
+            for (const tb::IPv4 ip : parts[p]) {
+                REQUIRE(engine.bucket_index(ip) * 5 / cfg.bucket_count() == p);
+            }
+            total += parts[p].size();
+        }
+        REQUIRE(total == ips.size());
+        if (threads == 1) {
+            // un solo worker: ogni parte conserva l'ordine d'ingresso
+            std::vector<tb::IPv4> first;
+            for (const tb::IPv4 ip : ips) {
+                if (engine.bucket_index(ip) * 5 / cfg.bucket_count() == 0) first.push_back(ip);
+            }
+            REQUIRE(parts[0] == first);
+        }
+    }
+
+    // capacità insufficiente: le righe che stanno vengono scritte, poi out_of_range
+    std::vector<tb::BucketIndex> small(100);
+    auto view = tb::Dataset::view(ips, 64);
+    REQUIRE_THROWS_AS(tb::bucketize(engine, view, small.data(), small.size()), std::out_of_range);
+    REQUIRE(std::equal(small.begin(), small.end(), expected_idx.begin()));
+
+    std::vector<std::size_t> wrong(3);
+    REQUIRE_THROWS_AS(tb::accumulate(engine, view, wrong), std::invalid_argument);
+}
+
+TEST_CASE("Weighted datasets and reader errors", "[dataset]") {
+    const auto ips = random_ips(3000, 3);
+    std::vector<std::size_t> weights(ips.size());
+    for (std::size_t i = 0; i < weights.size(); ++i) weights[i] = i % 5;
+    tb::Config cfg;
+    cfg.k = 6;
+    const tb::BucketEngine engine{cfg};
+
+    const auto expected = engine.distribution(ips, weights);
+    auto view = tb::Dataset::view(ips, weights, 256);
+    REQUIRE(view.weighted());
+    REQUIRE(tb::distribution(engine, view, 4) == expected);
+
+    std::size_t pos = 0;
+    auto weighted = tb::Dataset::stream([&](tb::IPv4* out, std::size_t* w, std::size_t capacity) {
+        const std::size_t n = std::min(capacity, ips.size() - pos);
+        std::copy_n(ips.data() + pos, n, out);
+        std::copy_n(weights.data() + pos, n, w);
+        pos += n;
+        return n;
+    }, true, 256);
+    REQUIRE(tb::distribution(engine, weighted, 4) == expected);
+
+    REQUIRE_THROWS_AS(tb::Dataset::view(ips, std::vector<std::size_t>(2)), std::invalid_argument);
+
+    // l'eccezione del lettore ferma tutti i worker e arriva al chiamante
+    int calls = 0;
+    auto failing = tb::Dataset::stream([&](tb::IPv4* out, std::size_t*, std::size_t) -> std::size_t {
+        if (++calls == 3) throw std::runtime_error("decode failed");
+        out[0] = 1;
+        return 1;
+    });
+    REQUIRE_THROWS_AS(tb::distribution(engine, failing, 4), std::runtime_error);
+    REQUIRE(calls == 3);
+}
+
+TEST_CASE("File datasets decode lazily and match read_ipv4_file", "[dataset]") {
+    const auto ips = random_ips(20'000, 4);
+    const std::string path = "tb_test_dataset.txt";
+    {
+        std::ofstream f{path};
+        for (const tb::IPv4 ip : ips) {
+            f << (ip >> 24) << '.' << ((ip >> 16) & 255) << '.' << ((ip >> 8) & 255) << '.' << (ip & 255) << '\n';
+        }
+    }
+    tb::Config cfg;
+    cfg.k = 8;
+    const tb::BucketEngine engine{cfg};
+
+    auto data = tb::ipv4_file_dataset(path, tb::IngestOptions{}, 1000);
+    REQUIRE(tb::distribution(engine, data, 2) == engine.distribution(ips));
+    REQUIRE(data.size() == ips.size());
+
+    std::vector<std::size_t> counts(cfg.bucket_count(), 0);
+    REQUIRE(tb::accumulate_ipv4_file(path, tb::IngestOptions{}, engine, counts) == ips.size());
+    REQUIRE(counts == engine.distribution(ips));
+    std::remove(path.c_str());
+
+    REQUIRE_THROWS_AS(tb::ipv4_file_dataset("tb_test_dataset_missing.txt", tb::IngestOptions{}), std::runtime_error);
+}
@@ -0,0 +1,215 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/distributed.hpp"
+#include "tb/ingest.hpp"
+#include "tb/stats.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // file di prova con commenti, righe vuote e spazi: i confini dei range cadono ovunque
+    std::string write_sample_file(const std::string& path, std::size_t n) {
+        std::mt19937 rng{42};
+        std::ofstream f{path};
+        f << "# sample\n";
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::uint32_t v = rng();
+            if (i % 17 == 0) f << "\n";
+            if (i % 23 == 0) f << "  ";
+            f << (v >> 24) << '.' << ((v >> 16) & 0xFF) << '.' << ((v >> 8) & 0xFF) << '.' << (v & 0xFF) << "\n";
+        }
+        return path;
+    }
+}
+
+TEST_CASE("split_file tiles the file with bounded tasks", "[distributed]") {
+    const auto tasks = tb::split_file(1000, 300);
+    REQUIRE(tasks.size() == 4);
+    REQUIRE(tasks.front().begin == 0);
+    REQUIRE(tasks.back().end == 1000);
+    for (std::size_t i = 1; i < tasks.size(); ++i) {
+        REQUIRE(tasks[i].begin == tasks[i - 1].end);
+        REQUIRE(tasks[i].id == i);
+    }
+    REQUIRE(tb::split_file(0, 300).empty());
+}
+
+TEST_CASE("Byte ranges see every line exactly once", "[distributed][ingest]") {
+    const std::string path = write_sample_file("tb_test_ranges.txt", 400);
+    tb::Config cfg;
+    cfg.k = 5;
+    tb::BucketEngine engine{cfg};
+    const auto expected = engine.distribution(tb::read_ipv4_file(path));
+
+    std::ifstream probe{path, std::ios::binary | std::ios::ate};
+    const auto size = static_cast<std::uint64_t>(probe.tellg());
+
+    for (const std::uint64_t chunk : std::vector<std::uint64_t>{1, 7, 13, 100, 4096, size}) {
+        std::vector<std::size_t> counts(cfg.bucket_count(), 0);
+        std::uint64_t samples = 0;
+        for (const auto& t : tb::split_file(size, chunk)) {
+            samples += tb::accumulate_ipv4_range(path, t.begin, t.end, engine, counts).samples;
+        }
+        REQUIRE(samples == 400);
+        REQUIRE(counts == expected);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Coordinator merges worker results bit-identically, retrying lost tasks", "[distributed]") {
+    const std::string path = write_sample_file("tb_test_job.txt", 3000);
+    tb::Config cfg;
+    cfg.k = 8;
+    tb::BucketEngine engine{cfg};
+    const auto expected = engine.distribution(tb::read_ipv4_file(path));
+
+    tb::CoordinatorOptions copt;
+    copt.bind_address = "127.0.0.1";
+    copt.port = 0;
+    copt.path = path;
+    copt.chunk_bytes = 2048;
+    tb::Coordinator coordinator{cfg, copt};
+    auto job = std::async(std::launch::async, [&] { return coordinator.run(); });
+
+    // worker difettoso: prende un task e sparisce
+    {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(coordinator.port());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        REQUIRE(::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0);
+        const std::uint8_t hello[12] = {0, 0, 0, 1, 0, 0, 0, 4, 0, 0, 0, 2};
+        REQUIRE(::send(fd, hello, sizeof(hello), 0) == static_cast<ssize_t>(sizeof(hello)));
+        std::uint8_t hdr[8];
+        REQUIRE(::recv(fd, hdr, sizeof(hdr), MSG_WAITALL) == 8);
+        REQUIRE(hdr[3] == 2); // TASK
+        ::close(fd);
+    }
+
+    tb::WorkerOptions wopt;
+    wopt.host = "127.0.0.1";
+    wopt.port = coordinator.port();
+    auto w1 = std::async(std::launch::async, [&] { return tb::run_worker(wopt); });
+    auto w2 = std::async(std::launch::async, [&] { return tb::run_worker(wopt); });
+
+    const tb::JobResult res = job.get();
+    const auto s1 = w1.get();
+    const auto s2 = w2.get();
+
+    REQUIRE(res.counts == expected);
+    REQUIRE(res.samples == 3000);
+    REQUIRE(s1.samples + s2.samples == 3000);
+    REQUIRE(res.retries >= 1);
+    REQUIRE(res.workers == 3);
+
+    const tb::StatsResult single = tb::compute_stats(expected);
+    REQUIRE(res.stats.chi2 == single.chi2);
+    REQUIRE(res.stats.stddev == single.stddev);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Coordinator fails the job on invalid input lines", "[distributed]") {
+    const std::string path = "tb_test_bad_job.txt";
+    {
+        std::ofstream f{path};
+        f << "10.0.0.1\n10.0.0.300\n";
+    }
+    tb::Config cfg;
+    tb::CoordinatorOptions copt;
+    copt.bind_address = "127.0.0.1";
+    copt.port = 0;
+    copt.path = path;
+    tb::Coordinator coordinator{cfg, copt};
+    auto job = std::async(std::launch::async, [&] { return coordinator.run(); });
+
+    tb::WorkerOptions wopt;
+    wopt.port = coordinator.port();
+    auto worker = std::async(std::launch::async, [&] { return tb::run_worker(wopt); });
+
+    REQUIRE_THROWS_AS(job.get(), tb::InputError);
+    REQUIRE_THROWS_AS(worker.get(), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Coordinator retries tasks that fail on I/O errors", "[distributed]") {
+    const std::string path = write_sample_file("tb_test_io_job.txt", 500);
+    const std::string hidden = path + ".hidden";
+    tb::Config cfg;
+    cfg.k = 6;
+    tb::CoordinatorOptions copt;
+    copt.bind_address = "127.0.0.1";
+    copt.port = 0;
+    copt.path = path;
+    copt.max_attempts = 2;
+    tb::Coordinator coordinator{cfg, copt};
+    auto job = std::async(std::launch::async, [&] { return coordinator.run(); });
+
+    // file sparito dopo lo stat del coordinator: ogni lettura fallisce, il job esaurisce i tentativi
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    REQUIRE(std::rename(path.c_str(), hidden.c_str()) == 0);
+    tb::WorkerOptions wopt;
+    wopt.port = coordinator.port();
+    auto worker = std::async(std::launch::async, [&] { return tb::run_worker(wopt); });
+    try {
+        job.get();
+        FAIL("job succeeded without its input");
+    } catch (const tb::InputError&) {
+        FAIL("I/O error treated as invalid input");
+    } catch (const std::runtime_error& e) {
+        REQUIRE(std::string{e.what()}.find("after 2 attempts: Cannot open input file") != std::string::npos);
+    }
+    REQUIRE_THROWS_AS(worker.get(), std::runtime_error);
+    std::remove(hidden.c_str());
+}
+
+TEST_CASE("Coordinator refuses histograms too large for a result message", "[distributed]") {
+    tb::Config cfg;
+    cfg.k = 29;
+    tb::CoordinatorOptions copt;
+    copt.bind_address = "127.0.0.1";
+    copt.port = 0;
+    REQUIRE_THROWS_AS((tb::Coordinator{cfg, copt}), std::runtime_error);
+    cfg.k = 28;
+    REQUIRE_NOTHROW(tb::Coordinator{cfg, copt});
+}
+
+TEST_CASE("Coordinator refuses empty and gzip inputs up front", "[distributed]") {
+    tb::Config cfg;
+    tb::CoordinatorOptions copt;
+    copt.bind_address = "127.0.0.1";
+    copt.port = 0;
+    copt.path = "tb_test_empty_job.txt";
+    std::ofstream{copt.path}.close();
+    {
+        tb::Coordinator coordinator{cfg, copt};
+        REQUIRE_THROWS_AS(coordinator.run(), std::runtime_error);
+    }
+    std::remove(copt.path.c_str());
+
+    copt.path = "tb_test_job.txt.gz";
+    {
+        std::ofstream f{copt.path, std::ios::binary};
+        f << "\x1f\x8b" << std::string(64, '\0');
+    }
+    tb::Coordinator coordinator{cfg, copt};
+    try {
+        coordinator.run();
+        FAIL("gzip input split into byte ranges");
+    } catch (const std::runtime_error& e) {
+        REQUIRE(std::string{e.what()}.find("gzip") != std::string::npos);
+    }
+    std::remove(copt.path.c_str());
+}
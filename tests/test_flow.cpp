@@ -0,0 +1,299 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/collector.hpp"
+#include "tb/flow.hpp"
+#include "tb/pcap.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    using Bytes = std::vector<std::uint8_t>;
+
+    void put8(Bytes& b, std::uint8_t v)   { b.push_back(v); }
+    void put16(Bytes& b, std::uint16_t v) { b.push_back(static_cast<std::uint8_t>(v >> 8)); b.push_back(static_cast<std::uint8_t>(v)); }
+    void put32(Bytes& b, std::uint32_t v) { put16(b, static_cast<std::uint16_t>(v >> 16)); put16(b, static_cast<std::uint16_t>(v)); }
+    void set16(Bytes& b, std::size_t off, std::uint16_t v) { b[off] = static_cast<std::uint8_t>(v >> 8); b[off + 1] = static_cast<std::uint8_t>(v); }
+
+    Bytes netflow_v5(const std::vector<tb::FlowRecord>& recs) {
+        Bytes b;
+        put16(b, 5);
+        put16(b, static_cast<std::uint16_t>(recs.size()));
+        for (int i = 0; i < 5; ++i) put32(b, 0);  // uptime, secs, nsecs, sequence, engine+sampling
+        for (const auto& r : recs) {
+            put32(b, r.src);
+            put32(b, r.dst);
+            put32(b, 0);                          // nexthop
+            put32(b, 0);                          // input/output
+            put32(b, static_cast<std::uint32_t>(r.packets));
+            put32(b, static_cast<std::uint32_t>(r.bytes));
+            for (int i = 0; i < 6; ++i) put32(b, 0);
+        }
+        return b;
+    }
+
+    void ipfix_header(Bytes& b, std::uint32_t domain) {
+        put16(b, 10);
+        put16(b, 0); // length, patched by ipfix_finish
+        put32(b, 0);
+        put32(b, 0);
+        put32(b, domain);
+    }
+
+    void ipfix_finish(Bytes& b) { set16(b, 2, static_cast<std::uint16_t>(b.size())); }
+
+    // template 256: src(8), enterprise field, variable-length field, dst(12), octetDelta(1, reduced to 4 bytes)
+    void ipfix_template(Bytes& b) {
+        const std::size_t start = b.size();
+        put16(b, 2);
+        put16(b, 0);
+        put16(b, 256);
+        put16(b, 5);
+        put16(b, 8);  put16(b, 4);
+        put16(b, 0x8000u | 100); put16(b, 2); put32(b, 9999);
+        put16(b, 82); put16(b, 0xFFFF);
+        put16(b, 12); put16(b, 4);
+        put16(b, 1);  put16(b, 4);
+        set16(b, start + 2, static_cast<std::uint16_t>(b.size() - start));
+    }
+
+    void ipfix_data(Bytes& b, const std::vector<tb::FlowRecord>& recs) {
+        const std::size_t start = b.size();
+        put16(b, 256);
+        put16(b, 0);
+        for (const auto& r : recs) {
+            put32(b, r.src);
+            put16(b, 0xABCD);
+            put8(b, 3); put8(b, 'e'); put8(b, 't'); put8(b, 'h');
+            put32(b, r.dst);
+            put32(b, static_cast<std::uint32_t>(r.bytes));
+        }
+        put8(b, 0); // padding
+        set16(b, start + 2, static_cast<std::uint16_t>(b.size() - start));
+    }
+}
+
+TEST_CASE("NetFlow v5 datagram decodes every record", "[flow]") {
+    const std::vector<tb::FlowRecord> recs = {
+        {0xC0A80001u, 0x0A000001u, 1500, 3},
+        {0xC0A80002u, 0x0A000002u, 40, 1},
+    };
+    const Bytes dg = netflow_v5(recs);
+
+    tb::FlowDecoder dec;
+    std::vector<tb::FlowRecord> out;
+    REQUIRE(dec.decode(dg.data(), dg.size(), out) == 2);
+    REQUIRE(out.size() == 2);
+    for (std::size_t i = 0; i < recs.size(); ++i) {
+        REQUIRE(out[i].src == recs[i].src);
+        REQUIRE(out[i].dst == recs[i].dst);
+        REQUIRE(out[i].bytes == recs[i].bytes);
+        REQUIRE(out[i].packets == recs[i].packets);
+    }
+
+    // header dichiara più record di quelli presenti
+    Bytes truncated = dg;
+    truncated.resize(truncated.size() - 10);
+    REQUIRE_THROWS_AS(dec.decode(truncated.data(), truncated.size(), out), std::runtime_error);
+}
+
+TEST_CASE("IPFIX data sets need their template first", "[flow]") {
+    const std::vector<tb::FlowRecord> recs = {
+        {0x01020304u, 0x05060708u, 123456, 0},
+        {0x0A0B0C0Du, 0x0E0F1011u, 64, 0},
+    };
+
+    tb::FlowDecoder dec;
+    std::vector<tb::FlowRecord> out;
+
+    Bytes early;
+    ipfix_header(early, 7);
+    ipfix_data(early, recs);
+    ipfix_finish(early);
+    REQUIRE(dec.decode(early.data(), early.size(), out) == 0);
+    REQUIRE(dec.skipped_records() == 1);
+
+    Bytes msg;
+    ipfix_header(msg, 7);
+    ipfix_template(msg);
+    ipfix_data(msg, recs);
+    ipfix_finish(msg);
+    REQUIRE(dec.decode(msg.data(), msg.size(), out) == 2);
+    REQUIRE(dec.template_count() == 1);
+    REQUIRE(out[0].src == recs[0].src);
+    REQUIRE(out[0].dst == recs[0].dst);
+    REQUIRE(out[0].bytes == recs[0].bytes);
+    REQUIRE(out[1].src == recs[1].src);
+    REQUIRE(out[1].bytes == recs[1].bytes);
+
+    // stesso template id ma altro observation domain: sconosciuto
+    Bytes other;
+    ipfix_header(other, 8);
+    ipfix_data(other, recs);
+    ipfix_finish(other);
+    out.clear();
+    REQUIRE(dec.decode(other.data(), other.size(), out) == 0);
+}
+
+TEST_CASE("IPFIX records without a destination do not count 0.0.0.0", "[flow]") {
+    // template 257: solo src(8) e octetDelta(1)
+    Bytes msg;
+    ipfix_header(msg, 3);
+    put16(msg, 2);
+    put16(msg, 16);
+    put16(msg, 257);
+    put16(msg, 2);
+    put16(msg, 8); put16(msg, 4);
+    put16(msg, 1); put16(msg, 4);
+    put16(msg, 257);
+    put16(msg, 4 + 2 * 8);
+    put32(msg, 0xC0A80001u); put32(msg, 100);
+    put32(msg, 0xC0A80002u); put32(msg, 50);
+    ipfix_finish(msg);
+
+    tb::FlowDecoder dec;
+    std::vector<tb::FlowRecord> out;
+    REQUIRE(dec.decode(msg.data(), msg.size(), out) == 2);
+    REQUIRE(out[0].has_src);
+    REQUIRE_FALSE(out[0].has_dst);
+    REQUIRE(out[1].src == 0xC0A80002u);
+
+    tb::Config cfg;
+    cfg.k = 6;
+    tb::BucketEngine engine{cfg};
+
+    tb::FlowWindow dst{cfg, tb::FlowKey::Dst, tb::FlowWeight::Bytes};
+    dst.add(out);
+    const tb::WindowReport none = dst.flush(1.0);
+    REQUIRE(none.records == 2);
+    REQUIRE(none.stats.sample_count == 0);
+
+    tb::FlowWindow both{cfg, tb::FlowKey::Both, tb::FlowWeight::Bytes};
+    both.add(out);
+    const tb::WindowReport rep = both.flush(1.0);
+    REQUIRE(rep.counts == engine.distribution(std::vector<tb::IPv4>{0xC0A80001u, 0xC0A80002u},
+                                              std::vector<std::size_t>{100, 50}));
+}
+
+TEST_CASE("FlowWindow matches the weighted distribution", "[flow]") {
+    tb::Config cfg;
+    cfg.k = 6;
+    tb::BucketEngine engine{cfg};
+
+    std::vector<tb::FlowRecord> recs;
+    std::vector<tb::IPv4> ips;
+    std::vector<std::size_t> weights;
+    for (std::uint32_t i = 0; i < 500; ++i) {
+        tb::FlowRecord r{i * 2654435761u, i * 40503u + 7u, 100u + i % 13u, 1u + i % 3u};
+        recs.push_back(r);
+        ips.push_back(r.dst);
+        weights.push_back(r.bytes);
+    }
+
+    tb::FlowWindow window{cfg, tb::FlowKey::Dst, tb::FlowWeight::Bytes};
+    window.add(recs);
+    const tb::WindowReport rep = window.flush(1.0);
+
+    REQUIRE(rep.records == recs.size());
+    REQUIRE(rep.counts == engine.distribution(ips, weights));
+
+    // la finestra successiva riparte da zero
+    const tb::WindowReport next = window.flush(1.0);
+    REQUIRE(next.index == rep.index + 1);
+    REQUIRE(next.stats.sample_count == 0);
+
+    REQUIRE_THROWS_AS(engine.distribution(ips, std::vector<std::size_t>(3, 1)), std::invalid_argument);
+}
+
+TEST_CASE("PcapReader extracts UDP payloads from Ethernet captures", "[flow][pcap]") {
+    const Bytes payload = netflow_v5({{0x0A000001u, 0x0A000002u, 10, 1}});
+
+    Bytes frame;
+    for (int i = 0; i < 12; ++i) put8(frame, 0);    // MAC dst/src
+    put16(frame, 0x0800);
+    put8(frame, 0x45); put8(frame, 0);
+    put16(frame, static_cast<std::uint16_t>(20 + 8 + payload.size()));
+    put32(frame, 0);                                // id, flags, frag offset
+    put8(frame, 64); put8(frame, 17); put16(frame, 0);
+    put32(frame, 0xC0000201u);
+    put32(frame, 0xC0000202u);
+    put16(frame, 40000); put16(frame, 2055);
+    put16(frame, static_cast<std::uint16_t>(8 + payload.size())); put16(frame, 0);
+    frame.insert(frame.end(), payload.begin(), payload.end());
+
+    const std::string path = "tb_test_capture.pcap";
+    {
+        std::ofstream f{path, std::ios::binary};
+        const std::uint32_t gh[6] = {0xA1B2C3D4u, 0x00040002u, 0, 0, 65535, 1};
+        f.write(reinterpret_cast<const char*>(gh), sizeof(gh)); // host order == little endian sui target CI
+        const std::uint32_t rh[4] = {1, 2, static_cast<std::uint32_t>(frame.size()), static_cast<std::uint32_t>(frame.size())};
+        f.write(reinterpret_cast<const char*>(rh), sizeof(rh));
+        f.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+    }
+
+    tb::PcapReader reader{path};
+    tb::UdpDatagram dg;
+    REQUIRE(reader.next(dg));
+    REQUIRE(dg.dst_port == 2055);
+    REQUIRE(dg.src == 0xC0000201u);
+    REQUIRE(dg.payload == payload);
+    REQUIRE_FALSE(reader.next(dg));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("FlowCollector receives datagrams over loopback", "[flow][collector]") {
+    tb::Config cfg;
+    cfg.k = 4;
+    tb::CollectorOptions opt;
+    opt.bind_address = "127.0.0.1";
+    opt.port = 0;
+    opt.window = std::chrono::milliseconds(200);
+    opt.max_windows = 1;
+    opt.weight = tb::FlowWeight::Flows;
+    opt.key = tb::FlowKey::Src;
+
+    tb::FlowCollector collector{cfg, opt};
+    REQUIRE(collector.port() != 0);
+
+    const Bytes dg = netflow_v5({{1u, 2u, 10, 1}, {3u, 4u, 20, 2}, {5u, 6u, 30, 3}});
+    const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    REQUIRE(fd >= 0);
+    sockaddr_in dst{};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(collector.port());
+    dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(::sendto(fd, dg.data(), dg.size(), 0, reinterpret_cast<const sockaddr*>(&dst), sizeof(dst)) ==
+                static_cast<ssize_t>(dg.size()));
+    }
+    const Bytes junk = {0x00, 0x09, 0x01};
+    ::sendto(fd, junk.data(), junk.size(), 0, reinterpret_cast<const sockaddr*>(&dst), sizeof(dst));
+    // il primo data set si decodifica, il secondo è fuori dai limiti: nessun record va contato
+    Bytes partial;
+    ipfix_header(partial, 7);
+    ipfix_template(partial);
+    ipfix_data(partial, {{7u, 8u, 40, 1}});
+    put16(partial, 256);
+    put16(partial, 0xFFFF);
+    ipfix_finish(partial);
+    ::sendto(fd, partial.data(), partial.size(), 0, reinterpret_cast<const sockaddr*>(&dst), sizeof(dst));
+    ::close(fd);
+
+    std::vector<tb::WindowReport> reports;
+    collector.run([&](const tb::WindowReport& w) { reports.push_back(w); });
+
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].datagrams == 6);
+    REQUIRE(reports[0].decode_errors == 2);
+    REQUIRE(reports[0].records == 12);
+    REQUIRE(reports[0].stats.sample_count == 12);
+}
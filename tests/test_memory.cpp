@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/ingest.hpp"
+#include "tb/memory.hpp"
+#include "tb/process_memory.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+TEST_CASE("CountingAllocator accounts allocations per category", "[memory]") {
+    const tb::MemoryUsage before = tb::memory_usage(tb::MemCategory::Histogram);
+    const tb::MemoryUsage buffers = tb::memory_usage(tb::MemCategory::Buffers);
+    {
+        tb::counted_vector<std::size_t> v(1000, 0, tb::CountingAllocator<std::size_t>{tb::MemCategory::Histogram});
+        const tb::MemoryUsage during = tb::memory_usage(tb::MemCategory::Histogram);
+        REQUIRE(during.current == before.current + 1000 * sizeof(std::size_t));
+        REQUIRE(during.peak >= during.current);
+        REQUIRE(during.allocations == before.allocations + 1);
+        REQUIRE(tb::memory_peak_total() >= during.current);
+    }
+    REQUIRE(tb::memory_usage(tb::MemCategory::Histogram).current == before.current);
+    REQUIRE(tb::memory_usage(tb::MemCategory::Buffers).current == buffers.current);
+
+    tb::reset_memory_peaks();
+    REQUIRE(tb::memory_usage(tb::MemCategory::Histogram).peak == before.current);
+    REQUIRE(std::string{tb::memory_category_name(tb::MemCategory::Buffers)} == "buffers");
+}
+
+TEST_CASE("estimate_footprint scales with addresses, k and threads", "[memory]") {
+    tb::Config cfg;
+    cfg.k = 16;
+    const tb::Footprint one = tb::estimate_footprint(cfg, 1000, 1);
+    REQUIRE(one.address_bytes == 3 * 1000 * sizeof(tb::IPv4));
+    REQUIRE(one.histogram_bytes == (std::uint64_t{1} << 16) * sizeof(std::size_t));
+    REQUIRE(one.total() == one.address_bytes + one.histogram_bytes + one.buffer_bytes);
+
+    // preallocato (arena): una sola copia degli indirizzi
+    REQUIRE(tb::estimate_footprint(cfg, 1000, 1, true).address_bytes == 1000 * sizeof(tb::IPv4));
+
+    // risultato + un istogramma per thread
+    REQUIRE(tb::estimate_footprint(cfg, 1000, 4).histogram_bytes == 5 * one.histogram_bytes);
+    // partizionato: solo il risultato, più un indice per indirizzo nei buffer di smistamento
+    const tb::Footprint part = tb::estimate_footprint(cfg, 1000, 4, true, tb::HistogramStrategy::Partitioned);
+    REQUIRE(part.histogram_bytes == one.histogram_bytes);
+    REQUIRE(part.buffer_bytes >= one.buffer_bytes + 1000 * sizeof(tb::BucketIndex));
+
+    // streaming: un blocco al posto del vettore di indirizzi
+    const tb::Footprint streamed = tb::estimate_footprint(cfg, 0, 1);
+    REQUIRE(streamed.address_bytes > 0);
+    REQUIRE(streamed.total() < tb::estimate_footprint(cfg, 10'000'000, 1).total());
+}
+
+TEST_CASE("process_memory reports the resident set", "[memory]") {
+    const tb::ProcessMemory pm = tb::process_memory();
+    REQUIRE(pm.peak_rss > 0);
+    REQUIRE(pm.peak_rss >= pm.rss);
+}
+
+TEST_CASE("accumulate_ipv4_file matches distribution of read_ipv4_file", "[memory][ingest]") {
+    const std::string path = "tb_test_memory_input.txt";
+    {
+        std::ofstream f{path};
+        for (std::uint32_t i = 0; i < 5000; ++i) {
+            f << (i * 7919u) % 256 << '.' << i % 256 << '.' << (i / 3) % 256 << '.' << i % 7 << '\n';
+        }
+    }
+    tb::IngestOptions opt;
+    tb::Config cfg;
+    cfg.k = 10;
+    const tb::BucketEngine engine{cfg};
+
+    std::vector<std::size_t> counts(cfg.bucket_count(), 0);
+    REQUIRE(tb::accumulate_ipv4_file(path, opt, engine, counts) == 5000);
+    const auto ips = tb::read_ipv4_file(path, opt);
+    REQUIRE(counts == engine.distribution(ips));
+
+    // upper bound, not the exact count
+    const std::optional<std::uint64_t> bound = tb::max_address_count(path, opt);
+    REQUIRE(bound.has_value());
+    REQUIRE(*bound >= ips.size());
+    {
+        std::ofstream gz{"tb_test_memory.gz", std::ios::binary};
+        gz << "\x1f\x8b" << std::string(100, '\0');   // basta l'intestazione gzip
+    }
+    REQUIRE_FALSE(tb::max_address_count("tb_test_memory.gz", opt).has_value());   // rapporto ignoto
+    std::remove("tb_test_memory.gz");
+
+    std::vector<std::size_t> wrong(3, 0);
+    REQUIRE_THROWS_AS(tb::accumulate_ipv4_file(path, opt, engine, wrong), std::invalid_argument);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,119 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/metrics.hpp"
+#include "tb/metrics_server.hpp"
+#include "tb/stats.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+    std::string http_get(std::uint16_t port, const std::string& path, const std::string& accept = "") {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return {};
+        }
+        std::string req = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n";
+        if (!accept.empty()) req += "Accept: " + accept + "\r\n";
+        req += "\r\n";
+        ::send(fd, req.data(), req.size(), 0);
+
+        std::string resp;
+        char buf[4096];
+        for (;;) {
+            const auto n = ::recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            resp.append(buf, static_cast<std::size_t>(n));
+        }
+        ::close(fd);
+        return resp;
+    }
+}
+
+TEST_CASE("top_buckets returns the heaviest buckets in order", "[metrics]") {
+    const std::vector<std::size_t> counts = {5, 9, 1, 9, 7, 0, 3};
+    const tb::BucketLoads top = tb::top_buckets(counts, 3);
+    REQUIRE(top.size() == 3);
+    REQUIRE(top[0] == std::make_pair(tb::BucketIndex{1}, std::size_t{9}));
+    REQUIRE(top[1] == std::make_pair(tb::BucketIndex{3}, std::size_t{9}));
+    REQUIRE(top[2] == std::make_pair(tb::BucketIndex{4}, std::size_t{7}));
+
+    REQUIRE(tb::top_buckets(counts, 100).size() == counts.size());
+    REQUIRE(tb::top_buckets(counts, 0).empty());
+}
+
+TEST_CASE("render_metrics exposes stats and top-N series", "[metrics]") {
+    const std::vector<std::size_t> counts = {10, 30, 20, 40};
+    tb::MetricsSnapshot s;
+    s.cfg.k = 2;
+    s.stats = tb::compute_stats(counts);
+    s.top_buckets = tb::top_buckets(counts, 2);
+    s.records_total = 123;
+
+    const std::string text = tb::render_metrics(s, false);
+    REQUIRE(text.find("tb_stats_max_load 40\n") != std::string::npos);
+    REQUIRE(text.find("tb_bucket_load{bucket=\"3\"} 40\n") != std::string::npos);
+    REQUIRE(text.find("tb_bucket_load{bucket=\"1\"} 30\n") != std::string::npos);
+    REQUIRE(text.find("tb_bucket_load{bucket=\"0\"}") == std::string::npos);
+    REQUIRE(text.find("# TYPE tb_ingest_records_total counter\n") != std::string::npos);
+    REQUIRE(text.find("# EOF") == std::string::npos);
+
+    const std::string om = tb::render_metrics(s, true);
+    REQUIRE(om.find("# TYPE tb_ingest_records counter\n") != std::string::npos);
+    REQUIRE(om.find("tb_ingest_records_total 123\n") != std::string::npos);
+    REQUIRE(om.substr(om.size() - 6) == "# EOF\n");
+}
+
+TEST_CASE("SnapshotExchange hands over the latest snapshot", "[metrics]") {
+    tb::SnapshotExchange ex;
+    REQUIRE(ex.latest().records_total == 0);
+
+    tb::MetricsSnapshot s;
+    for (std::uint64_t i = 1; i <= 5; ++i) {
+        s.records_total = i;
+        ex.publish(s);
+    }
+    REQUIRE(ex.generation() == 5);
+    REQUIRE(ex.latest().records_total == 5);
+    // nessuna nuova pubblicazione: stesso snapshot
+    REQUIRE(ex.latest().records_total == 5);
+
+    s.records_total = 6;
+    ex.publish(s);
+    REQUIRE(ex.latest().records_total == 6);
+}
+
+TEST_CASE("MetricsServer answers scrapes over HTTP", "[metrics][server]") {
+    tb::SnapshotExchange ex;
+    tb::MetricsSnapshot s;
+    s.records_total = 42;
+    ex.publish(s);
+
+    tb::MetricsServerOptions opt;
+    opt.bind_address = "127.0.0.1";
+    opt.port = 0;
+    tb::MetricsServer server{ex, opt};
+    REQUIRE(server.port() != 0);
+
+    const std::string resp = http_get(server.port(), "/metrics");
+    REQUIRE(resp.rfind("HTTP/1.1 200 OK", 0) == 0);
+    REQUIRE(resp.find("text/plain; version=0.0.4") != std::string::npos);
+    REQUIRE(resp.find("tb_ingest_records_total 42\n") != std::string::npos);
+
+    const std::string om = http_get(server.port(), "/metrics", "application/openmetrics-text;version=1.0.0");
+    REQUIRE(om.find("application/openmetrics-text") != std::string::npos);
+    REQUIRE(om.find("# EOF") != std::string::npos);
+
+    REQUIRE(http_get(server.port(), "/nope").rfind("HTTP/1.1 404", 0) == 0);
+    REQUIRE(server.scrapes() == 2);
+}
@@ -0,0 +1,99 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/packed.hpp"
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    std::vector<tb::IPv4> random_ips(std::size_t n, unsigned seed) {
+        std::mt19937 rng{seed};
+        std::vector<tb::IPv4> ips(n);
+        for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+        return ips;
+    }
+}
+
+TEST_CASE("PackedBuckets random access and bulk pack/unpack agree", "[packed]") {
+    for (const unsigned bits : {0u, 1u, 3u, 7u, 8u, 12u, 17u, 31u, 32u}) {
+        INFO("bits = " << bits);
+        const std::size_t n = 1000;   // non multiplo di 64: blocco finale parziale
+        const std::uint64_t mask = bits == 0 ? 0 : (std::uint64_t{1} << bits) - 1;
+        std::vector<tb::BucketIndex> values = random_ips(n, bits);
+        for (auto& v : values) v = static_cast<tb::BucketIndex>(v & mask);
+
+        tb::PackedBuckets single{bits, n};
+        for (std::size_t i = 0; i < n; ++i) single.set(i, values[i]);
+        for (std::size_t i = 0; i < n; ++i) REQUIRE(single[i] == values[i]);
+
+        // bulk da un offset non allineato: testa, blocchi interi, coda
+        tb::PackedBuckets bulk{bits, n};
+        bulk.pack(0, values.data(), 5);
+        bulk.pack(5, values.data() + 5, n - 5);
+        for (std::size_t i = 0; i < n; ++i) REQUIRE(bulk[i] == values[i]);
+        REQUIRE(bulk.word_count() == single.word_count());
+        for (std::size_t w = 0; w < bulk.word_count(); ++w) REQUIRE(bulk.words()[w] == single.words()[w]);
+
+        std::vector<tb::BucketIndex> out(n - 70);
+        bulk.unpack(70, out.size(), out.data());
+        for (std::size_t i = 0; i < out.size(); ++i) REQUIRE(out[i] == values[70 + i]);
+
+        REQUIRE(bulk.bytes() <= (n + 63) / 64 * 8 * bits);
+        REQUIRE_THROWS_AS(bulk.unpack(n - 1, 2, out.data()), std::out_of_range);
+        REQUIRE_THROWS_AS(bulk.pack(n + 1, values.data(), 0), std::out_of_range);
+    }
+
+    // set lascia intatti i vicini (valori a cavallo di due parole)
+    tb::PackedBuckets p{12, 64};
+    p.set(5, 0xFFF);
+    p.set(6, 0xABC);
+    p.set(5, 0x001);
+    REQUIRE(p[5] == 0x001);
+    REQUIRE(p[6] == 0xABC);
+    REQUIRE(p[4] == 0);
+    REQUIRE_THROWS_AS(tb::PackedBuckets(33, 1), std::invalid_argument);
+}
+
+TEST_CASE("Narrow, in-place and packed bucketize match BucketIndex output", "[packed][bucket_engine]") {
+    const auto ips = random_ips(3000, 11);
+    for (const unsigned k : {0u, 5u, 8u, 13u, 16u, 20u, 32u}) {
+        INFO("k = " << k);
+        tb::Config cfg;
+        cfg.k = k;
+        const tb::BucketEngine engine{cfg};
+        const auto expected = engine.bucketize(ips);
+
+        if (k <= 8) {
+            std::vector<std::uint8_t> out(ips.size());
+            engine.bucketize(ips.data(), ips.size(), out.data());
+            for (std::size_t i = 0; i < ips.size(); ++i) REQUIRE(out[i] == expected[i]);
+        } else {
+            std::vector<std::uint8_t> out(ips.size());
+            REQUIRE_THROWS_AS(engine.bucketize(ips.data(), ips.size(), out.data()), std::invalid_argument);
+        }
+        if (k <= 16) {
+            std::vector<std::uint16_t> out(ips.size());
+            engine.bucketize(ips.data(), ips.size(), out.data());
+            for (std::size_t i = 0; i < ips.size(); ++i) REQUIRE(out[i] == expected[i]);
+        } else {
+            std::vector<std::uint16_t> out(ips.size());
+            REQUIRE_THROWS_AS(engine.bucketize(ips.data(), ips.size(), out.data()), std::invalid_argument);
+        }
+
+        std::vector<tb::IPv4> data = ips;
+        engine.bucketize_in_place(data.data(), data.size());
+        REQUIRE(data == expected);
+
+        tb::PackedBuckets packed{k, ips.size() + 10};
+        engine.bucketize(ips.data(), ips.size(), packed, 10);
+        for (std::size_t i = 0; i < ips.size(); ++i) REQUIRE(packed[10 + i] == expected[i]);
+        REQUIRE_THROWS_AS(engine.bucketize(ips.data(), ips.size(), packed, 11), std::out_of_range);
+        if (k > 0) {
+            tb::PackedBuckets narrow{k - 1, ips.size()};
+            REQUIRE_THROWS_AS(engine.bucketize(ips.data(), ips.size(), narrow), std::invalid_argument);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/parallel.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("Every strategy matches the sequential distribution", "[parallel]") {
+    std::mt19937 rng{9};
+    std::vector<tb::IPv4> ips(10007);
+    for (auto& ip : ips) ip = rng();
+
+    for (const unsigned k : {0u, 1u, 5u, 12u}) {
+        tb::Config cfg;
+        cfg.k = k;
+        const tb::BucketEngine engine{cfg};
+        const auto expected = engine.distribution(ips);
+        for (const auto s : {tb::HistogramStrategy::SharedAtomic, tb::HistogramStrategy::PerThread,
+                             tb::HistogramStrategy::Partitioned}) {
+            // più thread che bucket (k piccolo) e numero non potenza di due
+            for (const unsigned t : {1u, 2u, 3u, 8u}) {
+                INFO(tb::histogram_strategy_name(s) << " k=" << k << " t=" << t);
+                REQUIRE(tb::parallel_distribution(engine, ips, t, s) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("parallel_distribution edge cases", "[parallel]") {
+    const tb::BucketEngine engine{tb::Config{}};
+    const std::vector<tb::IPv4> none;
+    const auto empty = tb::parallel_distribution(engine, none, 4, tb::HistogramStrategy::Partitioned);
+    REQUIRE(empty.size() == 4096);
+
+    const std::vector<tb::IPv4> two{1u, 2u};
+    REQUIRE(tb::parallel_distribution(engine, two, 0, tb::HistogramStrategy::SharedAtomic) == engine.distribution(two));
+
+    REQUIRE(tb::parse_histogram_strategy("per-thread") == tb::HistogramStrategy::PerThread);
+    REQUIRE_THROWS_AS(tb::parse_histogram_strategy("lockfree"), std::runtime_error);
+}
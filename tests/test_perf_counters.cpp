@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/perf_counters.hpp"
+
+#include <sys/mman.h>
+
+#include <cstring>
+#include <thread>
+#include <string>
+#include <vector>
+
+TEST_CASE("Perf counters degrade gracefully", "[perf]") {
+    tb::PerfCounters pc;
+    // senza PMU o con perf vietato: nessuna eccezione, motivo disponibile
+    if (!pc.hardware_available()) {
+        REQUIRE_FALSE(pc.status().empty());
+    }
+    for (std::size_t e = 0; e < tb::kPerfEventCount; ++e) {
+        REQUIRE(std::string(tb::perf_event_name(static_cast<tb::PerfEvent>(e))) != "?");
+    }
+
+    pc.start();
+    const tb::PerfReading r = pc.stop();
+    for (std::size_t e = 0; e < tb::kPerfEventCount; ++e) {
+        const auto ev = static_cast<tb::PerfEvent>(e);
+        if (!pc.supported(ev)) {
+            REQUIRE_FALSE(r.has(ev));
+        }
+    }
+    REQUIRE(r.per(tb::PerfEvent::Cycles, 0) == 0.0);
+}
+
+TEST_CASE("Perf counters measure work between start and stop", "[perf]") {
+    tb::PerfCounters pc;
+    if (!pc.available()) {
+        SKIP("perf_event_open not permitted: " + pc.status());
+    }
+
+    pc.start();
+    // memoria nuova: almeno qualche page fault, e lavoro misurabile per i contatori hardware.
+    // mmap diretto: malloc può riusare pagine già toccate da test precedenti
+    constexpr std::size_t kBytes = 8u * 1024u * 1024u;
+    void* buf = ::mmap(nullptr, kBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(buf != MAP_FAILED);
+    std::memset(buf, 1, kBytes);
+    std::vector<tb::IPv4> ips(1u << 16);
+    for (std::size_t i = 0; i < ips.size(); ++i) ips[i] = static_cast<tb::IPv4>(i * 2654435761u);
+    const auto counts = tb::BucketEngine{tb::Config{}}.distribution(ips);
+    const tb::PerfReading r = pc.stop();
+    ::munmap(buf, kBytes);
+
+    REQUIRE(counts.size() == 4096);
+    if (pc.supported(tb::PerfEvent::PageFaults)) {
+        REQUIRE(r.has(tb::PerfEvent::PageFaults));
+        REQUIRE(r.get(tb::PerfEvent::PageFaults) > 0);
+    }
+    if (r.has(tb::PerfEvent::Instructions)) {
+        REQUIRE(r.get(tb::PerfEvent::Instructions) > ips.size());
+    }
+
+    // stop() seguito da un nuovo start() riparte da zero
+    pc.start();
+    const tb::PerfReading idle = pc.stop();
+    if (idle.has(tb::PerfEvent::PageFaults)) {
+        REQUIRE(idle.get(tb::PerfEvent::PageFaults) < r.get(tb::PerfEvent::PageFaults));
+    }
+}
+
+TEST_CASE("Perf counters include threads started after construction", "[perf]") {
+    tb::PerfCounters pc;
+    if (!pc.supported(tb::PerfEvent::PageFaults)) {
+        SKIP("page fault counter not available: " + pc.status());
+    }
+
+    // tutte le pagine toccate da altri thread: senza inherit il conteggio resterebbe ~0
+    constexpr std::size_t kPages = 512;
+    constexpr std::size_t kPage = 4096;
+    void* buf = ::mmap(nullptr, kPages * kPage, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(buf != MAP_FAILED);
+    ::madvise(buf, kPages * kPage, MADV_NOHUGEPAGE);   // un fault per pagina
+    pc.start();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([buf, t] {
+            auto* p = static_cast<char*>(buf);
+            for (std::size_t i = t; i < kPages; i += 4) p[i * kPage] = 1;
+        });
+    }
+    for (auto& th : threads) th.join();
+    const tb::PerfReading r = pc.stop();
+    ::munmap(buf, kPages * kPage);
+
+    REQUIRE(r.has(tb::PerfEvent::PageFaults));
+    REQUIRE(r.get(tb::PerfEvent::PageFaults) >= kPages);
+}
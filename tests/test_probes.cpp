@@ -0,0 +1,44 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/probes.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+    // provider e nome consecutivi nella nota .note.stapsdt
+    bool has_probe_note(const std::string& image, const char* name) {
+        const std::string needle = std::string("tb") + '\0' + name + '\0';
+        return image.find(needle) != std::string::npos;
+    }
+}
+
+TEST_CASE("Probe macros evaluate to nothing observable", "[probes]") {
+    tb::Config cfg;
+    cfg.k = 4;
+    const tb::BucketEngine engine{cfg};
+    const std::vector<tb::IPv4> ips = {1, 2, 3, 4, 5};
+    const auto counts = engine.distribution(ips);
+    std::size_t total = 0;
+    for (const auto c : counts) total += c;
+    REQUIRE(total == ips.size());
+
+    const char* msg = "message";
+    TB_PROBE3(parse__error, 7, 0, msg);
+}
+
+#if TB_PROBES_ENABLED
+TEST_CASE("The binary carries a USDT note for every library probe", "[probes]") {
+    std::ifstream in{"/proc/self/exe", std::ios::binary};
+    REQUIRE(in);
+    const std::string image{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    REQUIRE(image.find(std::string("stapsdt") + '\0') != std::string::npos);
+    for (const char* name : {"bucketize__start", "bucketize__end", "histogram__flush", "stats__computed", "parse__error"}) {
+        INFO(name);
+        REQUIRE(has_probe_note(image, name));
+    }
+}
+#endif
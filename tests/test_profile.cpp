@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/ingest.hpp"
+#include "tb/parallel.hpp"
+#include "tb/profile.hpp"
+#include "tb/stats.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    // installa il profilo solo per la durata del test
+    struct Installed {
+        explicit Installed(tb::StageProfile& p) { tb::set_stage_profile(&p); }
+        ~Installed() { tb::set_stage_profile(nullptr); }
+    };
+}
+
+TEST_CASE("Stage names", "[profile]") {
+    for (std::size_t s = 0; s < tb::kStageCount; ++s) {
+        REQUIRE(std::string(tb::stage_name(static_cast<tb::Stage>(s))) != "?");
+    }
+}
+
+TEST_CASE("Nothing is recorded without an installed profile", "[profile]") {
+    tb::StageProfile profile;
+    REQUIRE(tb::stage_profile() == nullptr);
+    const tb::BucketEngine engine{tb::Config{}};
+    const std::vector<tb::IPv4> ips{1u, 2u, 3u};
+    (void)tb::compute_stats(engine.distribution(ips));
+    for (std::size_t s = 0; s < tb::kStageCount; ++s) {
+        REQUIRE(profile.totals(static_cast<tb::Stage>(s)).calls == 0);
+    }
+}
+
+TEST_CASE("Engine and stats calls are timed per stage", "[profile]") {
+    if (!TB_PROFILING) SKIP("stage timers compiled out");
+    tb::StageProfile profile;
+    {
+        const Installed installed{profile};
+        const tb::BucketEngine engine{tb::Config{}};
+        std::vector<tb::IPv4> ips(1000);
+        for (std::size_t i = 0; i < ips.size(); ++i) ips[i] = static_cast<tb::IPv4>(i * 2654435761u);
+        const auto counts = engine.distribution(ips);
+        (void)engine.bucketize(ips);
+        (void)engine.distribution(0u, 500u);
+        (void)tb::compute_stats(counts);
+        // due thread: una chiamata per parte e per passata, elementi contati una volta
+        (void)tb::parallel_distribution(engine, ips, 2, tb::HistogramStrategy::PerThread);
+    }
+
+    const auto hist = profile.totals(tb::Stage::Histogram);
+    REQUIRE(hist.calls == 2 + 4);
+    REQUIRE(hist.items == 1000 + 500 + 1000);
+    REQUIRE(hist.bytes == 2 * 1000 * sizeof(tb::IPv4));
+
+    const auto bucketize = profile.totals(tb::Stage::Bucketize);
+    REQUIRE(bucketize.calls == 1);
+    REQUIRE(bucketize.items == 1000);
+
+    const auto stats = profile.totals(tb::Stage::Stats);
+    REQUIRE(stats.calls == 1);
+    REQUIRE(stats.items == 4096);
+    REQUIRE(profile.totals(tb::Stage::Read).calls == 0);
+
+    profile.reset();
+    REQUIRE(profile.totals(tb::Stage::Histogram).calls == 0);
+}
+
+TEST_CASE("Ingestion records open, read and parse", "[profile]") {
+    if (!TB_PROFILING) SKIP("stage timers compiled out");
+    const std::string path = "tb_test_profile.txt";
+    const std::string content = "10.0.0.1\n# comment\n192.168.1.20\n8.8.8.8";
+    {
+        std::ofstream f{path, std::ios::binary};
+        f << content;
+    }
+
+    tb::StageProfile profile;
+    std::vector<tb::IPv4> ips;
+    {
+        const Installed installed{profile};
+        ips = tb::read_ipv4_file(path);
+    }
+    std::remove(path.c_str());
+
+    REQUIRE(ips.size() == 3);
+    REQUIRE(profile.totals(tb::Stage::Open).calls == 1);
+    REQUIRE(profile.totals(tb::Stage::Read).bytes == content.size());
+    const auto parse = profile.totals(tb::Stage::Parse);
+    REQUIRE(parse.items == 3);                      // l'ultima riga arriva da finish()
+    REQUIRE(parse.bytes == content.size());
+}
@@ -0,0 +1,188 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/dataset.hpp"
+#include "tb/sampling.hpp"
+#include "tb/stats.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<tb::IPv4> random_ips(std::size_t n, unsigned seed) {
+        std::mt19937 rng{seed};
+        std::vector<tb::IPv4> ips(n);
+        for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+        return ips;
+    }
+
+    tb::Dataset stream_of(const std::vector<tb::IPv4>& ips, std::size_t chunk = tb::Dataset::kDefaultChunk) {
+        std::size_t pos = 0;
+        return tb::Dataset::stream([&ips, pos](tb::IPv4* out, std::size_t*, std::size_t cap) mutable {
+            const std::size_t n = std::min(cap, ips.size() - pos);
+            std::copy_n(ips.data() + pos, n, out);
+            pos += n;
+            return n;
+        }, false, chunk);
+    }
+
+    // quote vere dentro gli intervalli: al livello di confidenza, con margine per m piccolo
+    double coverage(const tb::SampleEstimate& est, const std::vector<std::size_t>& truth, std::uint64_t total) {
+        std::size_t inside = 0;
+        for (std::size_t b = 0; b < truth.size(); ++b) {
+            const double p = static_cast<double>(truth[b]) / static_cast<double>(total);
+            if (p >= est.lower[b] && p <= est.upper[b]) ++inside;
+        }
+        return static_cast<double>(inside) / static_cast<double>(truth.size());
+    }
+}
+
+TEST_CASE("estimate_from_sample: intervals, exact full samples, chi² projection", "[sampling]") {
+    const auto ips = random_ips(200'000, 1);
+    tb::Config cfg;
+    cfg.k = 6;
+    const tb::BucketEngine engine{cfg};
+    const auto counts = engine.distribution(ips);
+    const tb::StatsResult stats = tb::compute_stats(counts);
+
+    // il campione è tutta la popolazione: nessuna incertezza
+    const tb::SampleEstimate full = tb::estimate_from_sample(counts, ips.size(), 0.95);
+    REQUIRE(full.sampled == ips.size());
+    REQUIRE(full.max_error == 0.0);
+    REQUIRE(full.lower == full.upper);
+    REQUIRE(std::abs(full.chi2 - stats.chi2) < 1e-6 * stats.chi2);
+    REQUIRE(full.chi2_lower == full.chi2);
+
+    // popolazione ignota: intervalli più larghi con più confidenza
+    const tb::SampleEstimate e95 = tb::estimate_from_sample(counts, 0, 0.95);
+    const tb::SampleEstimate e99 = tb::estimate_from_sample(counts, 0, 0.99);
+    REQUIRE(e95.population == ips.size());
+    REQUIRE(e99.max_error > e95.max_error);
+    for (std::size_t b = 0; b < counts.size(); ++b) {
+        REQUIRE(e95.lower[b] <= e95.share[b]);
+        REQUIRE(e95.share[b] <= e95.upper[b]);
+    }
+    REQUIRE(e95.chi2_lower <= e95.chi2);
+    REQUIRE(e95.chi2 <= e95.chi2_upper);
+
+    REQUIRE_THROWS_AS(tb::estimate_from_sample(counts, 0, 1.0), std::invalid_argument);
+    REQUIRE_THROWS_AS(tb::estimate_from_sample(counts, 10, 0.95), std::invalid_argument);
+    const tb::SampleEstimate empty = tb::estimate_from_sample(std::vector<std::size_t>(64, 0), 0, 0.95);
+    REQUIRE(empty.sampled == 0);
+    REQUIRE(std::isinf(empty.max_error));
+}
+
+TEST_CASE("stride sampling of a view stops early within tolerance", "[sampling]") {
+    const auto ips = random_ips(3'000'000, 2);
+    tb::Config cfg;
+    cfg.k = 8;
+    const tb::BucketEngine engine{cfg};
+    const auto truth = engine.distribution(ips);
+
+    auto data = tb::Dataset::view(ips);
+    tb::SampleOptions opt;
+    opt.tolerance = 0.1;
+    const tb::SampleEstimate est = tb::sample_distribution(engine, data, opt);
+    REQUIRE(est.converged);
+    REQUIRE(est.max_error <= 0.1);
+    REQUIRE(est.population == ips.size());
+    REQUIRE(est.scanned == est.sampled);          // solo le righe campionate si leggono
+    REQUIRE(est.fraction_read < 0.5);
+    REQUIRE(est.sampled >= 5 * cfg.bucket_count());
+    REQUIRE(coverage(est, truth, ips.size()) >= 0.85);
+
+    const double true_chi2 = tb::compute_stats(truth).chi2;
+    REQUIRE(est.chi2_upper >= true_chi2 * 0.5);   // ordine di grandezza: dati uniformi, chi² ≈ m - 1
+    REQUIRE(est.chi2_lower <= true_chi2 * 1.5);
+
+    // tolleranza 0: tutti i round, risultato esatto
+    opt.tolerance = 0.0;
+    auto again = tb::Dataset::view(ips);
+    const tb::SampleEstimate all = tb::sample_distribution(engine, again, opt);
+    REQUIRE(all.counts == truth);
+    REQUIRE(all.fraction_read == 1.0);
+    REQUIRE(all.max_error == 0.0);
+}
+
+TEST_CASE("skewed distributions are flagged with a large chi² estimate", "[sampling]") {
+    // un terzo delle righe è lo stesso indirizzo: un bucket riceve un terzo del carico
+    auto ips = random_ips(1'500'000, 3);
+    for (std::size_t i = 0; i < ips.size(); i += 3) ips[i] = 0x0A000001u;
+    tb::Config cfg;
+    cfg.k = 10;
+    const tb::BucketEngine engine{cfg};
+    const double true_chi2 = tb::compute_stats(engine.distribution(ips)).chi2;
+
+    auto data = tb::Dataset::view(ips);
+    tb::SampleOptions opt;
+    opt.tolerance = 0.25;
+    const tb::SampleEstimate est = tb::sample_distribution(engine, data, opt);
+    REQUIRE(est.fraction_read < 1.0);
+    REQUIRE(est.sample_stats.p_value < 1e-6);
+    REQUIRE(est.chi2_lower <= true_chi2);
+    REQUIRE(est.chi2_upper >= true_chi2);
+    REQUIRE(std::abs(est.chi2 - true_chi2) < 0.05 * true_chi2);
+}
+
+TEST_CASE("stream, hash and reservoir sampling", "[sampling]") {
+    const auto ips = random_ips(2'000'000, 4);
+    tb::Config cfg;
+    cfg.k = 7;
+    const tb::BucketEngine engine{cfg};
+    const auto truth = engine.distribution(ips);
+
+    tb::SampleOptions opt;
+    opt.tolerance = 0.15;
+    opt.rate = 1.0 / 8;
+    auto stream = stream_of(ips, 4096);
+    const tb::SampleEstimate s = tb::sample_distribution(engine, stream, opt);
+    REQUIRE(s.converged);
+    REQUIRE(s.scanned < ips.size());              // lettura interrotta
+    REQUIRE(s.population == s.scanned);
+    REQUIRE(s.sampled * 8 <= s.scanned + 8);
+    REQUIRE(coverage(s, truth, ips.size()) >= 0.85);
+
+    // hash: gli stessi indirizzi per ogni configurazione
+    opt.method = tb::SampleMethod::Hash;
+    opt.tolerance = 0.0;
+    auto h1 = tb::Dataset::view(ips);
+    const tb::SampleEstimate a = tb::sample_distribution(engine, h1, opt);
+    tb::Config other;
+    other.k = 5;
+    other.a = 0x2545F491u;
+    auto h2 = tb::Dataset::view(ips);
+    const tb::SampleEstimate b = tb::sample_distribution(tb::BucketEngine{other}, h2, opt);
+    REQUIRE(a.sampled == b.sampled);
+    REQUIRE(a.scanned == ips.size());
+    REQUIRE(std::abs(static_cast<double>(a.sampled) / ips.size() - opt.rate) < 0.01);
+
+    opt.method = tb::SampleMethod::Reservoir;
+    opt.reservoir = 50'000;
+    opt.tolerance = 0.15;
+    auto r = stream_of(ips);
+    const tb::SampleEstimate res = tb::sample_distribution(engine, r, opt);
+    REQUIRE(res.sampled == 50'000);
+    REQUIRE(res.scanned == ips.size());
+    REQUIRE(res.fraction_read == 1.0);
+    REQUIRE(coverage(res, truth, ips.size()) >= 0.85);
+
+    // reservoir più grande dell'input: tutto, esatto
+    opt.reservoir = 4'000'000;
+    auto whole = tb::Dataset::view(ips);
+    REQUIRE(tb::sample_distribution(engine, whole, opt).counts == truth);
+
+    REQUIRE(tb::parse_sample_method("hash") == tb::SampleMethod::Hash);
+    REQUIRE(std::string{tb::sample_method_name(tb::SampleMethod::Reservoir)} == "reservoir");
+    REQUIRE_THROWS_AS(tb::parse_sample_method("bernoulli"), std::runtime_error);
+
+    opt.rate = 0.0;
+    auto bad = tb::Dataset::view(ips);
+    REQUIRE_THROWS_AS(tb::sample_distribution(engine, bad, opt), std::invalid_argument);
+    const std::vector<std::size_t> weights(ips.size(), 1);
+    auto weighted = tb::Dataset::view(ips, weights);
+    REQUIRE_THROWS_AS(tb::sample_distribution(engine, weighted, tb::SampleOptions{}), std::invalid_argument);
+}
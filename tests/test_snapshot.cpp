@@ -0,0 +1,177 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/snapshot.hpp"
+#include "tb/snapshot_file.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    tb::HistogramSnapshot sample_snapshot(unsigned k, std::uint32_t seed, std::size_t n) {
+        tb::Config cfg{};
+        cfg.k = k;
+        std::mt19937 rng{seed};
+        std::vector<tb::IPv4> ips(n);
+        for (auto& ip : ips) ip = rng();
+        tb::HistogramSnapshot s;
+        s.cfg = cfg;
+        s.counts = tb::BucketEngine{cfg}.distribution(ips);
+        s.metadata = "source=test\nseed=" + std::to_string(seed) + "\n";
+        return s;
+    }
+
+    std::string temp_path(const std::string& name) {
+        return "/tmp/tb_test_" + std::to_string(::getpid()) + "_" + name;
+    }
+}
+
+TEST_CASE("Snapshots round-trip in every encoding", "[snapshot]") {
+    const tb::HistogramSnapshot s = sample_snapshot(10, 1, 50000);
+
+    for (const auto enc : {tb::SnapshotEncoding::Raw, tb::SnapshotEncoding::DeltaVarint,
+                           tb::SnapshotEncoding::BitPacked, tb::SnapshotEncoding::Auto}) {
+        const auto bytes = tb::encode_snapshot(s, enc);
+        const tb::SnapshotView v{bytes.data(), bytes.size()};
+        REQUIRE(v.config().k == 10u);
+        REQUIRE(v.fingerprint() == tb::config_fingerprint(s.cfg));
+        REQUIRE(v.total() == 50000u);
+        REQUIRE(v.metadata() == s.metadata);
+        if (enc != tb::SnapshotEncoding::Auto) {
+            REQUIRE(v.encoding() == enc);
+        }
+
+        const tb::HistogramSnapshot d = v.decode();
+        REQUIRE(d.counts == s.counts);
+        REQUIRE(d.cfg.a == s.cfg.a);
+        REQUIRE(d.cfg.b == s.cfg.b);
+    }
+
+    // Auto sceglie la codifica più compatta
+    const auto autob = tb::encode_snapshot(s, tb::SnapshotEncoding::Auto);
+    REQUIRE(autob.size() <= tb::encode_snapshot(s, tb::SnapshotEncoding::Raw).size());
+    REQUIRE(autob.size() <= tb::encode_snapshot(s, tb::SnapshotEncoding::BitPacked).size());
+    REQUIRE(autob.size() <= tb::encode_snapshot(s, tb::SnapshotEncoding::DeltaVarint).size());
+}
+
+TEST_CASE("Snapshots handle empty and wide counters", "[snapshot]") {
+    tb::HistogramSnapshot s;
+    s.cfg.k = 4;
+    s.counts.assign(16, 0);
+
+    for (const auto enc : {tb::SnapshotEncoding::Raw, tb::SnapshotEncoding::DeltaVarint,
+                           tb::SnapshotEncoding::BitPacked}) {
+        const auto bytes = tb::encode_snapshot(s, enc);
+        REQUIRE(tb::decode_snapshot(bytes.data(), bytes.size()).counts == s.counts);
+    }
+
+    s.counts[3] = 0xFFFFFFFFFFFFFFFFull;
+    s.counts[7] = 1;
+    for (const auto enc : {tb::SnapshotEncoding::Raw, tb::SnapshotEncoding::DeltaVarint,
+                           tb::SnapshotEncoding::BitPacked}) {
+        const auto bytes = tb::encode_snapshot(s, enc);
+        REQUIRE(tb::decode_snapshot(bytes.data(), bytes.size()).counts == s.counts);
+    }
+
+    s.counts.pop_back();
+    REQUIRE_THROWS_AS(tb::encode_snapshot(s), std::invalid_argument);
+}
+
+TEST_CASE("Corrupted or truncated snapshots are rejected", "[snapshot]") {
+    const tb::HistogramSnapshot s = sample_snapshot(8, 2, 1000);
+    const auto bytes = tb::encode_snapshot(s, tb::SnapshotEncoding::BitPacked);
+
+    auto flipped = bytes;
+    flipped.back() ^= 0x01;
+    REQUIRE_THROWS_AS(tb::decode_snapshot(flipped.data(), flipped.size()), std::runtime_error);
+
+    auto bad_magic = bytes;
+    bad_magic[0] = 'X';
+    REQUIRE_THROWS_AS(tb::decode_snapshot(bad_magic.data(), bad_magic.size()), std::runtime_error);
+
+    REQUIRE_THROWS_AS(tb::decode_snapshot(bytes.data(), bytes.size() - 1), std::runtime_error);
+    REQUIRE_THROWS_AS(tb::decode_snapshot(bytes.data(), 10), std::runtime_error);
+}
+
+TEST_CASE("Bucket slices accumulate independently", "[snapshot]") {
+    const tb::HistogramSnapshot s = sample_snapshot(9, 3, 20000);
+
+    for (const auto enc : {tb::SnapshotEncoding::Raw, tb::SnapshotEncoding::DeltaVarint,
+                           tb::SnapshotEncoding::BitPacked}) {
+        const auto bytes = tb::encode_snapshot(s, enc);
+        const tb::SnapshotView v{bytes.data(), bytes.size()};
+
+        std::vector<std::size_t> acc(v.bucket_count(), 0);
+        v.accumulate(acc, 0, 100);
+        v.accumulate(acc, 100, 317);
+        v.accumulate(acc, 317, v.bucket_count());
+        v.accumulate(acc, 5, 5);
+        REQUIRE(acc == s.counts);
+
+        std::vector<std::size_t> small(3, 0);
+        REQUIRE_THROWS_AS(v.accumulate(small), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Snapshot files merge across encodings and threads", "[snapshot]") {
+    const std::vector<tb::SnapshotEncoding> encs{tb::SnapshotEncoding::Raw, tb::SnapshotEncoding::DeltaVarint,
+                                                 tb::SnapshotEncoding::BitPacked, tb::SnapshotEncoding::Auto};
+    std::vector<std::string> paths;
+    std::vector<std::size_t> expected(std::size_t{1} << 11, 0);
+    for (std::size_t i = 0; i < encs.size(); ++i) {
+        const auto s = sample_snapshot(11, static_cast<std::uint32_t>(10 + i), 30000 + i * 1000);
+        for (std::size_t b = 0; b < expected.size(); ++b) expected[b] += s.counts[b];
+        paths.push_back(temp_path("merge_" + std::to_string(i) + ".tbh"));
+        tb::write_snapshot_file(paths.back(), s, encs[i]);
+    }
+
+    REQUIRE(tb::read_snapshot_file(paths.front()).metadata == "source=test\nseed=10\n");
+
+    for (const unsigned threads : {1u, 3u, 0u}) {
+        const tb::HistogramSnapshot merged = tb::merge_snapshot_files(paths, threads);
+        REQUIRE(merged.counts == expected);
+        REQUIRE(merged.metadata.find("merged=" + paths.back()) != std::string::npos);
+    }
+
+    // solo file ad accesso casuale: merge per fette di bucket
+    const std::vector<std::string> ra{paths[0], paths[2]};
+    const auto merged_ra = tb::merge_snapshot_files(ra, 4);
+    const auto a = tb::read_snapshot_file(paths[0]);
+    const auto b = tb::read_snapshot_file(paths[2]);
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(merged_ra.counts[i] == a.counts[i] + b.counts[i]);
+    }
+
+    // il merge può essere a sua volta riunito
+    const std::string out = temp_path("merged.tbh");
+    tb::write_snapshot_file(out, tb::merge_snapshot_files(paths, 2));
+    REQUIRE(tb::read_snapshot_file(out).counts == expected);
+
+    for (const auto& p : paths) std::remove(p.c_str());
+    std::remove(out.c_str());
+}
+
+TEST_CASE("Merging snapshots with different configs fails", "[snapshot]") {
+    const std::string p1 = temp_path("cfg_a.tbh");
+    const std::string p2 = temp_path("cfg_b.tbh");
+    const std::string p3 = temp_path("cfg_c.tbh");
+    tb::write_snapshot_file(p1, sample_snapshot(8, 1, 100));
+    tb::write_snapshot_file(p2, sample_snapshot(9, 1, 100));
+    auto other = sample_snapshot(8, 1, 100);
+    other.cfg.a = 0x27D4EB2Du;
+    tb::write_snapshot_file(p3, other);
+
+    REQUIRE(tb::config_fingerprint(other.cfg) != tb::config_fingerprint(sample_snapshot(8, 1, 1).cfg));
+    REQUIRE_THROWS_AS(tb::merge_snapshot_files({p1, p2}), std::runtime_error);
+    REQUIRE_THROWS_AS(tb::merge_snapshot_files({p1, p3}), std::runtime_error);
+    REQUIRE_THROWS_AS(tb::merge_snapshot_files({p1, temp_path("missing.tbh")}), std::runtime_error);
+
+    std::remove(p1.c_str());
+    std::remove(p2.c_str());
+    std::remove(p3.c_str());
+}
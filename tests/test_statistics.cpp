@@ -0,0 +1,94 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "statistics.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using Catch::Approx;
+
+TEST_CASE("Mann-Whitney: identical samples are not significant", "[bench][stats]") {
+    const std::vector<double> a{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    const tb::bench::MannWhitney r = tb::bench::mann_whitney(a, a);
+    REQUIRE(r.u == Approx(50.0));
+    REQUIRE(r.z == Approx(0.0).margin(1e-12));
+    REQUIRE(r.p == Approx(1.0));
+
+    // tutti pari: varianza nulla, nessuna evidenza
+    const std::vector<double> flat(8, 3.0);
+    REQUIRE(tb::bench::mann_whitney(flat, flat).p == 1.0);
+
+    // meno di 3 campioni per lato: il test non si applica
+    REQUIRE(tb::bench::mann_whitney({1.0, 2.0}, {5.0, 6.0, 7.0}).p == 1.0);
+}
+
+TEST_CASE("Mann-Whitney: fully separated samples", "[bench][stats]") {
+    const std::vector<double> fast{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    const std::vector<double> slow{11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+
+    // U = 0, z = -(50 - 0.5) / sqrt(175), p = erfc(|z| / sqrt(2))
+    const tb::bench::MannWhitney r = tb::bench::mann_whitney(fast, slow);
+    REQUIRE(r.u == Approx(0.0).margin(1e-12));
+    REQUIRE(r.z == Approx(-3.7418483).epsilon(1e-6));
+    REQUIRE(r.p == Approx(1.8267179e-4).epsilon(1e-5));
+
+    // simmetrico: scambiando i lati cambia solo il segno di z
+    const tb::bench::MannWhitney s = tb::bench::mann_whitney(slow, fast);
+    REQUIRE(s.u == Approx(100.0));
+    REQUIRE(s.z == Approx(-r.z));
+    REQUIRE(s.p == Approx(r.p));
+}
+
+TEST_CASE("Mann-Whitney: ties get the average rank", "[bench][stats]") {
+    // U conta le coppie (x > y) più mezza coppia per ogni pareggio: 6.5 su 25
+    const tb::bench::MannWhitney r = tb::bench::mann_whitney({1, 2, 2, 3, 5}, {2, 3, 4, 4, 6});
+    REQUIRE(r.u == Approx(6.5));
+    REQUIRE(r.z == Approx(-1.1703894).epsilon(1e-6));
+    REQUIRE(r.p == Approx(0.2418443).epsilon(1e-6));
+}
+
+TEST_CASE("HdrHistogram percentiles at bucket boundaries", "[bench][stats]") {
+    // 3 cifre: unità esatte fino a 2047, poi risoluzione 2 fino a 4095, 4 fino a 8191, ...
+    tb::bench::HdrHistogram h{std::uint64_t{1} << 20, 3};
+    REQUIRE(h.percentile(50.0) == 0);
+
+    for (const std::uint64_t v : {2047u, 2048u, 4096u, 10000u}) h.record(v);
+    REQUIRE(h.count() == 4);
+    REQUIRE(h.min() == 2047);
+    REQUIRE(h.max() == 10000);
+    REQUIRE(h.mean() == Approx((2047.0 + 2048.0 + 4096.0 + 10000.0) / 4.0));
+
+    REQUIRE(h.percentile(0.0) == 2047);      // almeno un valore
+    REQUIRE(h.percentile(25.0) == 2047);     // ultimo valore a risoluzione unitaria
+    REQUIRE(h.percentile(25.1) == 2049);     // 2048..2049 sono equivalenti
+    REQUIRE(h.percentile(50.0) == 2049);
+    REQUIRE(h.percentile(75.0) == 4099);     // 4096..4099
+    REQUIRE(h.percentile(100.0) == 10000);   // mai oltre il massimo registrato
+    REQUIRE(h.percentile(250.0) == 10000);
+
+    // sotto 2048 ogni valore ha il suo bucket
+    tb::bench::HdrHistogram exact{std::uint64_t{1} << 20, 3};
+    for (std::uint64_t v = 0; v < 2048; ++v) exact.record(v);
+    REQUIRE(exact.percentile(50.0) == 1023);
+    REQUIRE(exact.percentile(99.9) == 2045);
+}
+
+TEST_CASE("HdrHistogram clamps to highest and merges equal layouts", "[bench][stats]") {
+    tb::bench::HdrHistogram h{100000, 3};
+    h.record(5000000);
+    REQUIRE(h.max() == 5000000);
+    // contato nel bucket di 100000 (65536..131071, risoluzione 64)
+    REQUIRE(h.percentile(100.0) == 100031);
+
+    tb::bench::HdrHistogram other{100000, 3};
+    other.record(7);
+    h.merge(other);
+    REQUIRE(h.count() == 2);
+    REQUIRE(h.min() == 7);
+    REQUIRE(h.percentile(50.0) == 7);
+
+    REQUIRE_THROWS_AS(h.merge(tb::bench::HdrHistogram{100000, 2}), std::invalid_argument);
+    REQUIRE_THROWS_AS(tb::bench::HdrHistogram(100000, 0), std::invalid_argument);
+}
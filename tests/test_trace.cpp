@@ -0,0 +1,78 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/bucket_engine.hpp"
+#include "tb/parallel.hpp"
+#include "tb/trace.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::size_t count_of(const std::string& s, const std::string& what) {
+        std::size_t n = 0;
+        for (auto pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + 1)) ++n;
+        return n;
+    }
+
+    std::string dump() {
+        std::ostringstream os;
+        tb::write_chrome_trace(os);
+        return os.str();
+    }
+}
+
+TEST_CASE("No events are recorded while tracing is off", "[trace]") {
+    if (!TB_TRACING) SKIP("tracing compiled out");
+    tb::start_tracing();
+    tb::stop_tracing();
+    REQUIRE_FALSE(tb::tracing_enabled());
+    {
+        tb::ScopedTrace t{"ignored"};
+    }
+    const tb::BucketEngine engine{tb::Config{}};
+    (void)engine.distribution(std::vector<tb::IPv4>{1u, 2u});
+    const std::string json = dump();
+    REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(json.find("\"ph\":\"X\"") == std::string::npos);
+}
+
+TEST_CASE("Stage calls of every thread become complete events", "[trace]") {
+    if (!TB_TRACING) SKIP("tracing compiled out");
+    std::vector<tb::IPv4> ips(4000);
+    for (std::size_t i = 0; i < ips.size(); ++i) ips[i] = static_cast<tb::IPv4>(i * 2654435761u);
+    const tb::BucketEngine engine{tb::Config{}};
+
+    tb::start_tracing();
+    REQUIRE(tb::tracing_enabled());
+    {
+        tb::ScopedTrace run{"run"};
+        run.add(ips.size(), 0);
+        // 3 thread x 2 passate = 6 eventi histogram
+        (void)tb::parallel_distribution(engine, ips, 3, tb::HistogramStrategy::PerThread);
+    }
+    tb::stop_tracing();
+
+    const std::string json = dump();
+    REQUIRE(count_of(json, "\"name\":\"histogram\"") == 6);
+    REQUIRE(count_of(json, "\"name\":\"run\"") == 1);
+    REQUIRE(json.find("\"items\":4000") != std::string::npos);
+    // i buffer dei thread terminati vengono riusati: almeno chiamante + un thread avviato
+    REQUIRE(count_of(json, "\"name\":\"thread_name\"") >= 2);
+    REQUIRE(tb::trace_dropped() == 0);
+}
+
+TEST_CASE("Full thread buffers drop events instead of blocking", "[trace]") {
+    if (!TB_TRACING) SKIP("tracing compiled out");
+    tb::start_tracing(4);
+    std::thread th{[] {
+        for (int i = 0; i < 10; ++i) tb::ScopedTrace t{"tick"};
+    }};
+    th.join();
+    tb::stop_tracing();
+    REQUIRE(tb::trace_dropped() == 6);
+    REQUIRE(count_of(dump(), "\"name\":\"tick\"") == 4);
+    tb::start_tracing();   // capacità predefinita per i test successivi
+    tb::stop_tracing();
+}
@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "tb/tuning.hpp"
+#include "tb/tuning_file.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    tb::TuningProfile sample_profile() {
+        tb::TuningProfile p;
+        p.cpu = "Test CPU @ 3.00GHz";
+        p.hardware_threads = 8;
+        p.entries = {
+            {12, 1u << 14, {1, tb::HistogramStrategy::PerThread}, 900.0},
+            {12, 1u << 20, {4, tb::HistogramStrategy::PerThread}, 2500.0},
+            {20, 1u << 14, {1, tb::HistogramStrategy::PerThread}, 400.0},
+            {20, 1u << 20, {8, tb::HistogramStrategy::Partitioned}, 1800.5},
+        };
+        return p;
+    }
+
+    std::vector<tb::IPv4> random_ips(std::size_t n) {
+        std::mt19937 rng{3};
+        std::vector<tb::IPv4> ips(n);
+        for (auto& ip : ips) ip = static_cast<tb::IPv4>(rng());
+        return ips;
+    }
+}
+
+TEST_CASE("Tuning profiles survive a text round trip", "[tuning]") {
+    const tb::TuningProfile p = sample_profile();
+    const tb::TuningProfile q = tb::decode_tuning_profile(tb::encode_tuning_profile(p));
+    REQUIRE(q.cpu == p.cpu);
+    REQUIRE(q.hardware_threads == 8);
+    REQUIRE(q.entries.size() == p.entries.size());
+    REQUIRE(q.entries[3].k == 20);
+    REQUIRE(q.entries[3].min_items == (1u << 20));
+    REQUIRE(q.entries[3].choice.threads == 8);
+    REQUIRE(q.entries[3].choice.strategy == tb::HistogramStrategy::Partitioned);
+    REQUIRE(q.entries[3].mitems_per_s == 1800.5);
+
+    REQUIRE_THROWS_AS(tb::decode_tuning_profile("not a profile\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(tb::decode_tuning_profile("tb-tuning 1\nentry 12 100 0 per-thread 1.0\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(tb::decode_tuning_profile("tb-tuning 1\nentry 12 100 2 fastest 1.0\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(tb::decode_tuning_profile("tb-tuning 1\nbogus 1\n"), std::runtime_error);
+}
+
+TEST_CASE("TuningProfile::choose picks the closest k and size class", "[tuning]") {
+    const tb::TuningProfile p = sample_profile();
+    REQUIRE(p.choose(12, 100).threads == 1);                   // sotto la classe più piccola
+    REQUIRE(p.choose(12, 1u << 19).threads == 1);
+    REQUIRE(p.choose(12, 1u << 24).threads == 4);
+    REQUIRE(p.choose(10, 1u << 24).threads == 4);              // k più vicino: 12
+    REQUIRE(p.choose(24, 1u << 21).strategy == tb::HistogramStrategy::Partitioned);
+
+    const tb::TuningProfile empty;
+    REQUIRE(empty.choose(12, 10).threads == tb::default_tuning(12, 10).threads);
+    REQUIRE(tb::default_tuning(12, 100).threads == 1);
+    REQUIRE(tb::default_tuning(24, 1u << 24).strategy == tb::HistogramStrategy::Partitioned);
+}
+
+TEST_CASE("tuned_distribution follows the installed profile and matches distribution", "[tuning]") {
+    tb::Config cfg;
+    cfg.k = 12;
+    const tb::BucketEngine engine{cfg};
+    const auto ips = random_ips(1u << 20);
+    const auto expected = engine.distribution(ips);
+
+    REQUIRE(tb::tuning_profile() == nullptr);
+    REQUIRE(tb::tuned_distribution(engine, ips) == expected);
+
+    const tb::TuningProfile p = sample_profile();
+    tb::set_tuning_profile(&p);
+    REQUIRE(tb::choose_tuning(12, ips.size()).threads == 4);
+    REQUIRE(tb::tuned_distribution(engine, ips) == expected);
+    tb::set_tuning_profile(nullptr);
+}
+
+TEST_CASE("calibrate measures one entry per k and size", "[tuning]") {
+    tb::CalibrationOptions opt;
+    opt.ks = {8, 16};
+    opt.sizes = {1000, 5000};
+    opt.max_threads = 2;
+    opt.min_time_ms = 0.0;
+    const tb::TuningProfile p = tb::calibrate(opt);
+    REQUIRE(p.entries.size() == 4);
+    for (const auto& e : p.entries) {
+        REQUIRE(e.choice.threads >= 1);
+        REQUIRE(e.choice.threads <= 2);
+        REQUIRE(e.mitems_per_s > 0.0);
+    }
+    REQUIRE(p.entries[2].k == 16);
+    REQUIRE(p.entries[2].min_items == 1000);
+
+    opt.sizes.clear();
+    REQUIRE_THROWS_AS(tb::calibrate(opt), std::invalid_argument);
+}
+
+TEST_CASE("Tuning profile files", "[tuning]") {
+    const std::string dir = "tb_test_tuning_dir";
+    const std::string path = dir + "/nested/profile.txt";
+    REQUIRE_FALSE(tb::load_tuning_profile(path).has_value());
+
+    tb::save_tuning_profile(path, sample_profile());
+    const auto loaded = tb::load_tuning_profile(path);
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->entries.size() == 4);
+
+    { std::ofstream{path} << "garbage\n"; }
+    REQUIRE_THROWS_AS(tb::load_tuning_profile(path), std::runtime_error);
+    std::remove(path.c_str());
+    std::remove((dir + "/nested").c_str());
+    std::remove(dir.c_str());
+
+    REQUIRE_FALSE(tb::cpu_model().empty());
+}